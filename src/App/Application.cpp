@@ -52,6 +52,7 @@
 
 #include "Application.h"
 #include "Document.h"
+#include "RecomputeProfiler.h"
 
 // FreeCAD Base header
 #include <Base/Interpreter.h>
@@ -868,6 +869,7 @@ void Application::destruct(void)
     // not initialized or doubel destruct!
     assert(_pcSingleton);
     delete _pcSingleton;
+    RecomputeProfiler::destruct();
 
     // We must detach from console and delete the observer to save our file
     destructObserver();
@@ -1179,6 +1181,13 @@ void Application::initApplication(void)
        ("User parameter:BaseApp/Preferences/Units");
     UnitsApi::setSchema((UnitSystem)hGrp->GetInt("UserSchema",0));
 
+    // set up the recompute profiler
+    hGrp = App::GetApplication().GetParameterGroupByPath
+       ("User parameter:BaseApp/Preferences/Document");
+    RecomputeProfiler& profiler = RecomputeProfiler::instance();
+    profiler.setHistorySize(hGrp->GetInt("RecomputeProfilerHistory",1000));
+    profiler.setEnabled(hGrp->GetBool("RecomputeProfiler",false));
+
     // starting the init script
     Interpreter().runString(Base::ScriptFactory().ProduceScript("FreeCADInit"));
 }
@@ -293,6 +293,12 @@ private:
     static PyObject* sListDocuments     (PyObject *self,PyObject *args,PyObject *kwd);
     static PyObject* sAddDocObserver    (PyObject *self,PyObject *args,PyObject *kwd);
     static PyObject* sRemoveDocObserver (PyObject *self,PyObject *args,PyObject *kwd);
+
+    static PyObject* sSetRecomputeProfiler   (PyObject *self,PyObject *args,PyObject *kwd);
+    static PyObject* sGetRecomputeProfile    (PyObject *self,PyObject *args,PyObject *kwd);
+    static PyObject* sExportRecomputeProfile (PyObject *self,PyObject *args,PyObject *kwd);
+    static PyObject* sClearRecomputeProfile  (PyObject *self,PyObject *args,PyObject *kwd);
+
     static PyObject* sTranslateUnit     (PyObject *self,PyObject *args,PyObject *kwd);
 
     static PyMethodDef    Methods[]; 
@@ -35,6 +35,7 @@
 #include "Document.h"
 #include "DocumentPy.h"
 #include "DocumentObserverPython.h"
+#include "RecomputeProfiler.h"
 
 // FreeCAD Base header
 #include <Base/Interpreter.h>
@@ -43,6 +44,7 @@
 #include <Base/Console.h>
 #include <Base/Factory.h>
 #include <Base/FileInfo.h>
+#include <Base/Stream.h>
 #include <Base/UnitsApi.h>
 
 #define new DEBUG_CLIENTBLOCK
@@ -130,6 +132,21 @@ PyMethodDef Application::Methods[] = {
     {"removeDocumentObserver",  (PyCFunction) Application::sRemoveDocObserver  ,1,
      "removeDocumentObserver() -> None\n\n"
      "Remove an added document observer."},
+    {"setRecomputeProfiler",  (PyCFunction) Application::sSetRecomputeProfiler  ,1,
+     "setRecomputeProfiler(bool, [int]) -> None\n\n"
+     "Enable or disable measuring the recompute of every object and\n"
+     "optionally set the number of measurements to keep."},
+    {"getRecomputeProfile",  (PyCFunction) Application::sGetRecomputeProfile  ,1,
+     "getRecomputeProfile() -> list\n\n"
+     "Return the kept measurements as a list of dicts, the oldest first.\n"
+     "The times are in seconds and the memory change in kB."},
+    {"exportRecomputeProfile",  (PyCFunction) Application::sExportRecomputeProfile  ,1,
+     "exportRecomputeProfile([string]) -> string or None\n\n"
+     "Write the kept measurements as timeline in the Chrome trace event format\n"
+     "to the given file or return it as string."},
+    {"clearRecomputeProfile",  (PyCFunction) Application::sClearRecomputeProfile  ,1,
+     "clearRecomputeProfile() -> None\n\n"
+     "Remove all kept measurements."},
 
     {NULL, NULL, 0, NULL}		/* Sentinel */
 };
@@ -579,3 +596,87 @@ PyObject* Application::sRemoveDocObserver(PyObject * /*self*/, PyObject *args,Py
         Py_Return;
     } PY_CATCH;
 }
+
+PyObject* Application::sSetRecomputeProfiler(PyObject * /*self*/, PyObject *args,PyObject * /*kwd*/)
+{
+    PyObject* on;
+    int size=-1;
+    if (!PyArg_ParseTuple(args, "O!|i",&PyBool_Type,&on,&size))
+        return NULL;
+    PY_TRY {
+        RecomputeProfiler& profiler = RecomputeProfiler::instance();
+        if (size >= 0)
+            profiler.setHistorySize(size);
+        profiler.setEnabled(PyObject_IsTrue(on) ? true : false);
+        Py_Return;
+    } PY_CATCH;
+}
+
+PyObject* Application::sGetRecomputeProfile(PyObject * /*self*/, PyObject *args,PyObject * /*kwd*/)
+{
+    if (!PyArg_ParseTuple(args, ""))
+        return NULL;
+    PY_TRY {
+        std::vector<RecomputeSample> samples = RecomputeProfiler::instance().getHistory();
+        Py::List list;
+        for (std::vector<RecomputeSample>::const_iterator it = samples.begin(); it != samples.end(); ++it) {
+            Py::Dict dict;
+            dict.setItem("Document", Py::String(it->Document));
+            dict.setItem("Object", Py::String(it->Object));
+            dict.setItem("Type", Py::String(it->Type));
+            dict.setItem("Start", Py::Float(it->Start));
+            dict.setItem("Wall", Py::Float(it->Wall));
+            dict.setItem("Cpu", Py::Float(it->Cpu));
+            dict.setItem("Memory", Py::Int(it->Memory));
+            dict.setItem("Thread", Py::Int(it->Thread));
+            switch (it->Result) {
+            case RecomputeSample::Failed:
+                dict.setItem("Status", Py::String("Failed"));
+                break;
+            case RecomputeSample::Exception:
+                dict.setItem("Status", Py::String("Exception"));
+                break;
+            default:
+                dict.setItem("Status", Py::String("Succeeded"));
+                break;
+            }
+            list.append(dict);
+        }
+        return Py::new_reference_to(list);
+    } PY_CATCH;
+}
+
+PyObject* Application::sExportRecomputeProfile(PyObject * /*self*/, PyObject *args,PyObject * /*kwd*/)
+{
+    char* fn=0;
+    if (!PyArg_ParseTuple(args, "|s",&fn))
+        return NULL;
+    PY_TRY {
+        if (fn) {
+            Base::FileInfo fi(fn);
+            Base::ofstream str(fi);
+            if (!str) {
+                PyErr_Format(PyExc_IOError, "Cannot open file '%s'", fn);
+                return NULL;
+            }
+            RecomputeProfiler::instance().writeTimeline(str);
+            str.close();
+            Py_Return;
+        }
+        else {
+            std::stringstream str;
+            RecomputeProfiler::instance().writeTimeline(str);
+            return PyString_FromString(str.str().c_str());
+        }
+    } PY_CATCH;
+}
+
+PyObject* Application::sClearRecomputeProfile(PyObject * /*self*/, PyObject *args,PyObject * /*kwd*/)
+{
+    if (!PyArg_ParseTuple(args, ""))
+        return NULL;
+    PY_TRY {
+        RecomputeProfiler::instance().clear();
+        Py_Return;
+    } PY_CATCH;
+}
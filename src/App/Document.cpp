@@ -68,6 +68,12 @@ recompute path. Also enables more complicated dependencies beyond trees.
 
 #include <QCoreApplication>
 #include <QCryptographicHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QWaitCondition>
 
 
 #include "Document.h"
@@ -129,6 +135,233 @@ typedef Traits::edge_descriptor Edge;
 
 namespace App {
 
+typedef std::vector<std::pair<const DocumentObject*, const Property*> > PropertyChanges;
+
+/** The outcome of the execution of an object.
+ * Exceptions are caught and kept together with the return value, so that an
+ * object can be executed by a worker thread and reported by the main thread.
+ */
+struct RecomputeResult
+{
+    enum Failure { NoException, AbortException, MemoryException, BaseException, StdException, UnknownException };
+
+    RecomputeResult() : Return(0), Caught(NoException)
+    {
+    }
+
+    void execute(DocumentObject* Feat)
+    {
+        try {
+            Return = Feat->recompute();
+        }
+        catch (const Base::AbortException& e) {
+            Caught = AbortException;
+            Why = e.what();
+        }
+        catch (const Base::MemoryException& e) {
+            Caught = MemoryException;
+            Why = e.what();
+        }
+        catch (const Base::PyException& e) {
+            Caught = BaseException;
+            Why = e.what();
+            // keep the traceback the exception would report
+            Trace = e.getStackTrace() + e.getErrorType();
+        }
+        catch (const Base::Exception& e) {
+            Caught = BaseException;
+            Why = e.what();
+        }
+        catch (const std::exception& e) {
+            Caught = StdException;
+            Why = e.what();
+        }
+#ifndef FC_DEBUG
+        catch (...) {
+            Caught = UnknownException;
+        }
+#endif
+    }
+
+    /** Reports the result to the console and the recompute log \a log.
+     * Returns true if the recompute must be stopped.
+     */
+    bool report(DocumentObject* Feat, std::vector<DocumentObjectExecReturn*>& log) const
+    {
+        switch (Caught) {
+        case AbortException:
+            Base::Console().Error("Exception (%s): %s \n",Base::Console().Time(),Why.c_str());
+            log.push_back(new DocumentObjectExecReturn("User abort",Feat));
+            Feat->setError();
+            return true;
+        case MemoryException:
+            Base::Console().Error("Memory exception in feature '%s' thrown: %s\n",Feat->getNameInDocument(),Why.c_str());
+            log.push_back(new DocumentObjectExecReturn("Out of memory exception",Feat));
+            Feat->setError();
+            return true;
+        case BaseException:
+            if (Trace.empty())
+                Base::Console().Error("Exception (%s): %s \n",Base::Console().Time(),Why.c_str());
+            else
+                Base::Console().Error("%s: %s\n",Trace.c_str(),Why.c_str());
+            log.push_back(new DocumentObjectExecReturn(Why,Feat));
+            Feat->setError();
+            return false;
+        case StdException:
+            Base::Console().Warning("exception in Feature \"%s\" thrown: %s\n",Feat->getNameInDocument(),Why.c_str());
+            log.push_back(new DocumentObjectExecReturn(Why,Feat));
+            Feat->setError();
+            return false;
+        case UnknownException:
+            Base::Console().Error("App::Document::_RecomputeFeature(): Unknown exception in Feature \"%s\" thrown\n",Feat->getNameInDocument());
+            log.push_back(new DocumentObjectExecReturn("Unknown exeption!"));
+            Feat->setError();
+            return true;
+        default:
+            break;
+        }
+
+        // error code
+        if (Return == DocumentObject::StdReturn) {
+            Feat->resetError();
+        }
+        else {
+            Return->Which = Feat;
+            log.push_back(Return);
+            Base::Console().Error("%s\n",Return->Why.c_str());
+            Feat->setError();
+        }
+        return false;
+    }
+
+    DocumentObjectExecReturn* Return;
+    Failure Caught;
+    std::string Why;
+    std::string Trace;
+};
+
+class RecomputeJob;
+
+/** Shared data of a parallel recompute.
+ * The worker threads append their finished jobs and the main thread waits for
+ * them. Property changes are collected as well because the observers of the
+ * document must only be notified by the main thread. The changes of an object
+ * executed by a worker are kept by its job, so that they are only emitted
+ * after the main thread has reported the job, all others are kept here.
+ */
+struct RecomputeQueue
+{
+    QMutex mutex;
+    QWaitCondition finished;
+    std::list<RecomputeJob*> jobs;
+    std::map<const DocumentObject*, RecomputeJob*> running;
+    PropertyChanges changes;
+
+    /// registers a job before it is started
+    void add(RecomputeJob* job);
+    /// called by the worker when the job is finished
+    void push(RecomputeJob* job);
+    /// returns the next finished job or 0 if there is none and \a wait is false
+    RecomputeJob* pop(bool wait);
+    /// records a change, the mutex must be locked
+    void addChange(const DocumentObject* Who, const Property* What);
+    /// appends the changes which don't belong to a job to \a list
+    void takeChanges(PropertyChanges& list)
+    {
+        QMutexLocker locker(&mutex);
+        list.insert(list.end(), changes.begin(), changes.end());
+        changes.clear();
+    }
+};
+
+/// Executes a single object in a worker thread
+class RecomputeJob : public QRunnable
+{
+public:
+    RecomputeJob(DocumentObject* obj, Vertex v, RecomputeQueue& q)
+      : Object(obj), Index(v), Name(obj->getNameInDocument()), Time(0.0f), queue(q)
+    {
+        setAutoDelete(false);
+    }
+
+    void run()
+    {
+        Base::TimeInfo start;
+        // exceptions must not leave the thread
+        try {
+            Result.execute(Object);
+        }
+        catch (...) {
+            Result.Caught = RecomputeResult::UnknownException;
+        }
+        Time = Base::TimeInfo::diffTimeF(start);
+        queue.push(this);
+    }
+
+    DocumentObject* Object;
+    Vertex Index;
+    std::string Name;
+    float Time;
+    RecomputeResult Result;
+    /// the changes of the object which are emitted once the job is reported
+    PropertyChanges Changes;
+
+private:
+    RecomputeQueue& queue;
+};
+
+void RecomputeQueue::add(RecomputeJob* job)
+{
+    QMutexLocker locker(&mutex);
+    running[job->Object] = job;
+}
+
+void RecomputeQueue::push(RecomputeJob* job)
+{
+    QMutexLocker locker(&mutex);
+    jobs.push_back(job);
+    finished.wakeOne();
+}
+
+RecomputeJob* RecomputeQueue::pop(bool wait)
+{
+    QMutexLocker locker(&mutex);
+    while (wait && jobs.empty())
+        finished.wait(&mutex);
+    if (jobs.empty())
+        return 0;
+    RecomputeJob* job = jobs.front();
+    jobs.pop_front();
+    running.erase(job->Object);
+    return job;
+}
+
+void RecomputeQueue::addChange(const DocumentObject* Who, const Property* What)
+{
+    std::map<const DocumentObject*, RecomputeJob*>::iterator it = running.find(Who);
+    if (it != running.end())
+        it->second->Changes.push_back(std::make_pair(Who,What));
+    else
+        changes.push_back(std::make_pair(Who,What));
+}
+
+/// Measures the wall-clock time of a recompute
+class RecomputeTimer
+{
+public:
+    RecomputeTimer(float& t) : time(t)
+    {
+    }
+    ~RecomputeTimer()
+    {
+        time = Base::TimeInfo::diffTimeF(start);
+    }
+
+private:
+    Base::TimeInfo start;
+    float& time;
+};
+
 // Pimpl class
 struct DocumentP
 {
@@ -149,6 +382,9 @@ struct DocumentP
     unsigned int UndoMaxStackSize;
     DependencyList DepList;
     std::map<DocumentObject*,Vertex> VertexObjectList;
+    // the objects linking to an object of the document
+    std::map<const DocumentObject*, std::vector<DocumentObject*> > ObjectInList;
+    RecomputeQueue* recomputeQueue;
 
     DocumentP() {
         activeObject = 0;
@@ -161,6 +397,7 @@ struct DocumentP
         iUndoMode = 0;
         UndoMemSize = 0;
         UndoMaxStackSize = 20;
+        recomputeQueue = 0;
     }
 };
 
@@ -485,15 +722,22 @@ void Document::onChanged(const Property* prop)
 
 void Document::onBeforeChangeProperty(const DocumentObject *Who, const Property *What)
 {
+    // while a parallel recompute is running the transactions are shared by several threads
+    QMutexLocker locker(d->recomputeQueue ? &d->recomputeQueue->mutex : 0);
     if (d->activeUndoTransaction && !d->rollback)
         d->activeUndoTransaction->addObjectChange(Who,What);
 }
 
 void Document::onChangedProperty(const DocumentObject *Who, const Property *What)
 {
+    QMutexLocker locker(d->recomputeQueue ? &d->recomputeQueue->mutex : 0);
     if (d->activeTransaction && !d->rollback)
         d->activeTransaction->addObjectChange(Who,What);
-    signalChangedObject(*Who, *What);
+    // the observers get notified later on by the main thread
+    if (d->recomputeQueue)
+        d->recomputeQueue->addChange(Who,What);
+    else
+        signalChangedObject(*Who, *What);
 }
 
 void Document::setTransactionMode(int iMode)
@@ -943,8 +1187,10 @@ bool Document::saveAs(const char* file)
 // Save the document under the name it has been opened
 bool Document::save (void)
 {
-    int compression = App::GetApplication().GetParameterGroupByPath
-        ("User parameter:BaseApp/Preferences/Document")->GetInt("CompressionLevel",3);
+    ParameterGrp::handle hGrp = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Document");
+    int compression = hGrp->GetInt("CompressionLevel",3);
+    int numThreads = hGrp->GetInt("SaveThreads",0);
 
     if (*(FileName.getValue()) != '\0') {
         LastModifiedDate.setValue(Base::TimeInfo::currentDateTimeString());
@@ -963,6 +1209,11 @@ bool Document::save (void)
 
             writer.setComment("FreeCAD Document");
             writer.setLevel(compression);
+            // images are already compressed
+            writer.setLevel("png", 0);
+            writer.setLevel("jpg", 0);
+            if (numThreads > 0)
+                writer.setThreads(numThreads);
             writer.putNextEntry("Document.xml");
 
             Document::Save(writer);
@@ -1051,6 +1302,7 @@ void Document::restore (void)
     }
     d->objectArray.clear();
     d->objectMap.clear();
+    d->ObjectInList.clear();
     d->activeObject = 0;
 
     Base::FileInfo fi(FileName.getValue());
@@ -1159,62 +1411,49 @@ int Document::countObjects(void) const
 
 std::vector<App::DocumentObject*> Document::getInList(const DocumentObject* me) const
 {
-    // result list
-    std::vector<App::DocumentObject*> result;
-    // go through all objects
-    for (std::map<std::string,DocumentObject*>::const_iterator It = d->objectMap.begin(); It != d->objectMap.end();++It) {
-        // get the outList and search if me is in that list
-        std::vector<DocumentObject*> OutList = It->second->getOutList();
-        for (std::vector<DocumentObject*>::const_iterator It2=OutList.begin();It2!=OutList.end();++It2)
-            if (*It2 && *It2 == me)
-                // add the parent object
-                result.push_back(It->second);
+    QMutexLocker locker(d->recomputeQueue ? &d->recomputeQueue->mutex : 0);
+    std::map<const DocumentObject*, std::vector<DocumentObject*> >::const_iterator it = d->ObjectInList.find(me);
+    if (it != d->ObjectInList.end())
+        return it->second;
+    return std::vector<App::DocumentObject*>();
+}
+
+namespace App {
+// depth-first search for a cycle in the links starting at the given object
+static bool hasCyclicLinks(DocumentObject* obj,
+    const std::map<const DocumentObject*, std::vector<DocumentObject*> >& objects,
+    std::map<DocumentObject*, bool>& visited)
+{
+    // the flag is true as long as the object is on the current path
+    std::map<DocumentObject*, bool>::iterator it = visited.find(obj);
+    if (it != visited.end())
+        return it->second;
+    visited[obj] = true;
+    std::vector<DocumentObject*> OutList = obj->getOutList();
+    for (std::vector<DocumentObject*>::iterator jt = OutList.begin(); jt != OutList.end(); ++jt) {
+        if (objects.find(*jt) != objects.end() && hasCyclicLinks(*jt, objects, visited))
+            return true;
     }
-    return result;
+    visited[obj] = false;
+    return false;
+}
 }
 
 std::vector<App::DocumentObject*>
 Document::getDependencyList(const std::vector<App::DocumentObject*>& objs) const
 {
-    DependencyList DepList;
-    std::map<DocumentObject*,Vertex> ObjectMap;
-    std::map<Vertex,DocumentObject*> VertexMap;
-
-    // Filling up the adjacency List
-    for (std::map<std::string,DocumentObject*>::const_iterator It = d->objectMap.begin(); It != d->objectMap.end();++It) {
-        // add the object as Vertex and remember the index
-        Vertex v = add_vertex(DepList);
-        ObjectMap[It->second] = v;
-        VertexMap[v] = It->second;
-    }
-    // add the edges
-    for (std::map<std::string,DocumentObject*>::const_iterator It = d->objectMap.begin(); It != d->objectMap.end();++It) {
-        std::vector<DocumentObject*> OutList = It->second->getOutList();
-        for (std::vector<DocumentObject*>::const_iterator It2=OutList.begin();It2!=OutList.end();++It2) {
-            if (*It2)
-                add_edge(ObjectMap[It->second],ObjectMap[*It2],DepList);
-        }
-    }
-
-    std::list<Vertex> make_order;
-    DependencyList::out_edge_iterator j, jend;
-
-    try {
-        // this sort gives the execute
-        boost::topological_sort(DepList, std::front_inserter(make_order));
-    }
-    catch (const std::exception&) {
-        return std::vector<App::DocumentObject*>();
-    }
-
-    //std::vector<App::DocumentObject*> out;
+    // only the objects reachable from the given objects are examined
+    std::map<DocumentObject*, bool> visited;
     boost::unordered_set<App::DocumentObject*> out;
     for (std::vector<App::DocumentObject*>::const_iterator it = objs.begin(); it != objs.end(); ++it) {
-        std::map<DocumentObject*,Vertex>::iterator jt = ObjectMap.find(*it);
-        // ok, object is part of this graph
-        if (jt != ObjectMap.end()) {
-            for (boost::tie(j, jend) = boost::out_edges(jt->second, DepList); j != jend; ++j) {
-                out.insert(VertexMap[boost::target(*j, DepList)]);
+        // ok, object is part of this document
+        if (d->ObjectInList.find(*it) != d->ObjectInList.end()) {
+            if (hasCyclicLinks(*it, d->ObjectInList, visited))
+                return std::vector<App::DocumentObject*>();
+            std::vector<DocumentObject*> OutList = (*it)->getOutList();
+            for (std::vector<DocumentObject*>::iterator jt = OutList.begin(); jt != OutList.end(); ++jt) {
+                if (d->ObjectInList.find(*jt) != d->ObjectInList.end())
+                    out.insert(*jt);
             }
             out.insert(*it);
         }
@@ -1225,31 +1464,108 @@ Document::getDependencyList(const std::vector<App::DocumentObject*>& objs) const
     return ary;
 }
 
+void Document::_addBackLink(DocumentObject* owner, DocumentObject* target)
+{
+    // while a parallel recompute is running the links are changed by several threads
+    QMutexLocker locker(d->recomputeQueue ? &d->recomputeQueue->mutex : 0);
+    // only links between objects of this document are of interest
+    std::map<const DocumentObject*, std::vector<DocumentObject*> >::iterator it = d->ObjectInList.find(target);
+    if (it != d->ObjectInList.end() && d->ObjectInList.find(owner) != d->ObjectInList.end())
+        it->second.push_back(owner);
+}
+
+void Document::_removeBackLink(DocumentObject* owner, DocumentObject* target)
+{
+    QMutexLocker locker(d->recomputeQueue ? &d->recomputeQueue->mutex : 0);
+    // the target is not dereferenced as it might be already destroyed
+    std::map<const DocumentObject*, std::vector<DocumentObject*> >::iterator it = d->ObjectInList.find(target);
+    if (it != d->ObjectInList.end()) {
+        std::vector<DocumentObject*>::iterator jt = std::find(it->second.begin(), it->second.end(), owner);
+        if (jt != it->second.end())
+            it->second.erase(jt);
+    }
+}
+
+void Document::_addToDependencyList(DocumentObject* pcObject, bool searchLinks)
+{
+    std::vector<DocumentObject*>& InList = d->ObjectInList[pcObject];
+    InList.clear();
+    if (searchLinks) {
+        // objects of the document may already link to this one, e.g. on undo
+        for (std::vector<DocumentObject*>::iterator it = d->objectArray.begin(); it != d->objectArray.end(); ++it) {
+            if (*it == pcObject)
+                continue;
+            std::vector<DocumentObject*> OutList = (*it)->getOutList();
+            for (std::vector<DocumentObject*>::iterator jt = OutList.begin(); jt != OutList.end(); ++jt) {
+                if (*jt == pcObject)
+                    InList.push_back(*it);
+            }
+        }
+    }
+
+    std::vector<DocumentObject*> OutList = pcObject->getOutList();
+    for (std::vector<DocumentObject*>::iterator it = OutList.begin(); it != OutList.end(); ++it)
+        _addBackLink(pcObject, *it);
+}
+
+void Document::_removeFromDependencyList(DocumentObject* pcObject)
+{
+    std::vector<DocumentObject*> OutList = pcObject->getOutList();
+    for (std::vector<DocumentObject*>::iterator it = OutList.begin(); it != OutList.end(); ++it)
+        _removeBackLink(pcObject, *it);
+    d->ObjectInList.erase(pcObject);
+}
+
 void Document::_rebuildDependencyList(void)
 {
     d->VertexObjectList.clear();
     d->DepList.clear();
-    // Filling up the adjacency List
-    for (std::map<std::string,DocumentObject*>::const_iterator It = d->objectMap.begin(); It != d->objectMap.end();++It) {
-        // add the object as Vertex and remember the index
-        d->VertexObjectList[It->second] = add_vertex(d->DepList);
+
+    // Only the touched objects and the objects depending on them can change, so
+    // start with the touched objects and follow the recorded links downstream.
+    std::vector<DocumentObject*> objects;
+    for (std::vector<DocumentObject*>::const_iterator It = d->objectArray.begin(); It != d->objectArray.end(); ++It) {
+        if ((*It)->isTouched()) {
+            d->VertexObjectList[*It] = add_vertex(d->DepList);
+            objects.push_back(*It);
+        }
     }
-    // add the edges
-    for (std::map<std::string,DocumentObject*>::const_iterator It = d->objectMap.begin(); It != d->objectMap.end();++It) {
-        std::vector<DocumentObject*> OutList = It->second->getOutList();
-        for (std::vector<DocumentObject*>::const_iterator It2=OutList.begin();It2!=OutList.end();++It2) {
-            if (*It2)
-                add_edge(d->VertexObjectList[It->second],d->VertexObjectList[*It2],d->DepList);
+    _RecomputeStats.Touched = static_cast<int>(objects.size());
+
+    for (std::size_t i = 0; i < objects.size(); i++) {
+        const std::vector<DocumentObject*>& InList = d->ObjectInList[objects[i]];
+        for (std::vector<DocumentObject*>::const_iterator It = InList.begin(); It != InList.end(); ++It) {
+            if (d->VertexObjectList.find(*It) == d->VertexObjectList.end()) {
+                d->VertexObjectList[*It] = add_vertex(d->DepList);
+                objects.push_back(*It);
+            }
         }
     }
+    _RecomputeStats.Visited = static_cast<int>(objects.size());
+
+    // add the edges between these objects
+    for (std::vector<DocumentObject*>::const_iterator It = objects.begin(); It != objects.end(); ++It) {
+        const std::vector<DocumentObject*>& InList = d->ObjectInList[*It];
+        for (std::vector<DocumentObject*>::const_iterator It2=InList.begin();It2!=InList.end();++It2)
+            add_edge(d->VertexObjectList[*It2],d->VertexObjectList[*It],d->DepList);
+    }
 }
 
 void Document::recompute()
 {
+    ParameterGrp::handle hGrp = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Document");
+    if (hGrp->GetBool("ParallelRecompute",false)) {
+        recomputeParallel();
+        return;
+    }
+
     // delete recompute log
     for( std::vector<App::DocumentObjectExecReturn*>::iterator it=_RecomputeLog.begin();it!=_RecomputeLog.end();++it)
         delete *it;
     _RecomputeLog.clear();
+    _RecomputeStats = RecomputeStatistics();
+    RecomputeTimer timer(_RecomputeStats.Time);
 
     // updates the dependency graph
     _rebuildDependencyList();
@@ -1307,7 +1623,12 @@ void Document::recompute()
 #ifdef FC_LOGFEATUREUPDATE
             std::clog << "Recompute" << std::endl;
 #endif
-            if (_recomputeFeature(Cur)) {
+            std::string name = Cur->getNameInDocument();
+            Base::TimeInfo start;
+            bool abort = _recomputeFeature(Cur);
+            _RecomputeStats.Executed++;
+            _RecomputeStats.ObjectTimes.push_back(std::make_pair(name, Base::TimeInfo::diffTimeF(start)));
+            if (abort) {
                 // if somthing happen break execution of recompute
                 d->vertexMap.clear();
                 return;
@@ -1323,6 +1644,172 @@ void Document::recompute()
     d->vertexMap.clear();
 }
 
+void Document::recomputeParallel()
+{
+    // delete recompute log
+    for( std::vector<App::DocumentObjectExecReturn*>::iterator it=_RecomputeLog.begin();it!=_RecomputeLog.end();++it)
+        delete *it;
+    _RecomputeLog.clear();
+    _RecomputeStats = RecomputeStatistics();
+    RecomputeTimer timer(_RecomputeStats.Time);
+
+    // updates the dependency graph
+    _rebuildDependencyList();
+
+    std::list<Vertex> make_order;
+    DependencyList::out_edge_iterator j, jend;
+
+    try {
+        // the sort is only used to detect cyclic dependencies and to have
+        // the same start order as the serial recompute
+        boost::topological_sort(d->DepList, std::front_inserter(make_order));
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Document::recomputeParallel: " << e.what() << std::endl;
+        return;
+    }
+
+    // caching vertex to DocObject
+    for (std::map<DocumentObject*,Vertex>::const_iterator It1= d->VertexObjectList.begin();It1 != d->VertexObjectList.end(); ++It1)
+        d->vertexMap[It1->second] = It1->first;
+
+    // for every object count the dependencies which are not up-to-date yet and
+    // remember the objects depending on it
+    std::vector<int> pending(num_vertices(d->DepList), 0);
+    std::vector< std::vector<Vertex> > dependents(num_vertices(d->DepList));
+    Traits::edge_iterator ei, ei_end;
+    for (boost::tie(ei, ei_end) = edges(d->DepList); ei != ei_end; ++ei) {
+        pending[source(*ei, d->DepList)]++;
+        dependents[target(*ei, d->DepList)].push_back(source(*ei, d->DepList));
+    }
+
+    std::list<Vertex> ready;
+    for (std::list<Vertex>::reverse_iterator i = make_order.rbegin();i != make_order.rend(); ++i) {
+        if (pending[*i] == 0)
+            ready.push_back(*i);
+    }
+
+    int numThreads = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Document")->GetInt("RecomputeThreads",0);
+    QThreadPool pool;
+    if (numThreads > 0)
+        pool.setMaxThreadCount(numThreads);
+
+    RecomputeQueue queue;
+    std::list<Vertex> mainThread;
+    PropertyChanges changes;
+    int running = 0;
+    bool abort = false;
+    d->recomputeQueue = &queue;
+
+    while (!ready.empty() || !mainThread.empty() || running > 0) {
+        Vertex done;
+        if (!ready.empty()) {
+            // all dependencies of this object are up-to-date now
+            Vertex v = ready.front();
+            ready.pop_front();
+            DocumentObject* Cur = d->vertexMap[v];
+            bool NeedUpdate = false;
+            if (Cur) {
+                // ask the object if it should be recomputed
+                if (Cur->mustExecute() == 1)
+                    NeedUpdate = true;
+                else {
+                    // update if one of the dependencies is touched
+                    for (boost::tie(j, jend) = out_edges(v, d->DepList); j != jend; ++j) {
+                        DocumentObject* Test = d->vertexMap[target(*j, d->DepList)];
+                        if (Test && Test->isTouched()) {
+                            NeedUpdate = true;
+                            break;
+                        }
+                    }
+                }
+            }
+
+            if (!NeedUpdate) {
+                done = v;
+            }
+            else if (Cur->isThreadSafe()) {
+                RecomputeJob* job = new RecomputeJob(Cur, v, queue);
+                queue.add(job);
+                pool.start(job);
+                running++;
+                continue;
+            }
+            else {
+                mainThread.push_back(v);
+                continue;
+            }
+        }
+        else {
+            // handle finished jobs first to keep the workers busy and only block
+            // if there is nothing the main thread could do meanwhile
+            RecomputeJob* job = queue.pop(mainThread.empty());
+            if (job) {
+                running--;
+                abort = job->Result.report(job->Object, _RecomputeLog);
+                _RecomputeStats.Executed++;
+                _RecomputeStats.ObjectTimes.push_back(std::make_pair(job->Name, job->Time));
+                done = job->Index;
+                // the changes of the object are emitted after its result has been reported
+                changes.swap(job->Changes);
+                delete job;
+            }
+            else {
+                done = mainThread.front();
+                mainThread.pop_front();
+                DocumentObject* Cur = d->vertexMap[done];
+                if (Cur) {
+                    std::string name = Cur->getNameInDocument();
+                    Base::TimeInfo start;
+                    abort = _recomputeFeature(Cur);
+                    _RecomputeStats.Executed++;
+                    _RecomputeStats.ObjectTimes.push_back(std::make_pair(name, Base::TimeInfo::diffTimeF(start)));
+                }
+            }
+
+            queue.takeChanges(changes);
+            for (PropertyChanges::iterator it = changes.begin(); it != changes.end(); ++it)
+                signalChangedObject(*it->first, *it->second);
+            changes.clear();
+            if (abort)
+                break;
+        }
+
+        // release the objects waiting for this one
+        for (std::vector<Vertex>::iterator it = dependents[done].begin(); it != dependents[done].end(); ++it) {
+            if (--pending[*it] == 0)
+                ready.push_back(*it);
+        }
+    }
+
+    if (abort) {
+        // if somthing happen break execution of recompute but let the running jobs finish
+        pool.waitForDone();
+        while (RecomputeJob* job = queue.pop(false)) {
+            job->Result.report(job->Object, _RecomputeLog);
+            _RecomputeStats.Executed++;
+            _RecomputeStats.ObjectTimes.push_back(std::make_pair(job->Name, job->Time));
+            changes.insert(changes.end(), job->Changes.begin(), job->Changes.end());
+            delete job;
+        }
+    }
+
+    d->recomputeQueue = 0;
+    queue.takeChanges(changes);
+    for (PropertyChanges::iterator it = changes.begin(); it != changes.end(); ++it)
+        signalChangedObject(*it->first, *it->second);
+
+    if (!abort) {
+        // reset all touched
+        for (std::map<Vertex,DocumentObject*>::iterator it = d->vertexMap.begin(); it != d->vertexMap.end(); ++it) {
+            if (it->second)
+                it->second->purgeTouched();
+        }
+    }
+    d->vertexMap.clear();
+}
+
 const char * Document::getErrorDescription(const App::DocumentObject*Obj) const
 {
     for (std::vector<App::DocumentObjectExecReturn*>::const_iterator it=_RecomputeLog.begin();it!=_RecomputeLog.end();++it)
@@ -1338,54 +1825,9 @@ bool Document::_recomputeFeature(DocumentObject* Feat)
     std::clog << "Solv: Executing Feature: " << Feat->getNameInDocument() << std::endl;;
 #endif
 
-    DocumentObjectExecReturn  *returnCode = 0;
-    try {
-        returnCode = Feat->recompute();
-    }
-    catch(Base::AbortException &e){
-        e.ReportException();
-        _RecomputeLog.push_back(new DocumentObjectExecReturn("User abort",Feat));
-        Feat->setError();
-        return true;
-    }
-    catch (const Base::MemoryException& e) {
-        Base::Console().Error("Memory exception in feature '%s' thrown: %s\n",Feat->getNameInDocument(),e.what());
-        _RecomputeLog.push_back(new DocumentObjectExecReturn("Out of memory exception",Feat));
-        Feat->setError();
-        return true;
-    }
-    catch (Base::Exception &e) {
-        e.ReportException();
-        _RecomputeLog.push_back(new DocumentObjectExecReturn(e.what(),Feat));
-        Feat->setError();
-        return false;
-    }
-    catch (std::exception &e) {
-        Base::Console().Warning("exception in Feature \"%s\" thrown: %s\n",Feat->getNameInDocument(),e.what());
-        _RecomputeLog.push_back(new DocumentObjectExecReturn(e.what(),Feat));
-        Feat->setError();
-        return false;
-    }
-#ifndef FC_DEBUG
-    catch (...) {
-        Base::Console().Error("App::Document::_RecomputeFeature(): Unknown exception in Feature \"%s\" thrown\n",Feat->getNameInDocument());
-        _RecomputeLog.push_back(new DocumentObjectExecReturn("Unknown exeption!"));
-        Feat->setError();
-        return true;
-    }
-#endif
-
-    // error code
-    if (returnCode == DocumentObject::StdReturn) {
-        Feat->resetError();
-    }
-    else {
-        returnCode->Which = Feat;
-        _RecomputeLog.push_back(returnCode);
-        Base::Console().Error("%s\n",returnCode->Why.c_str());
-        Feat->setError();
-    }
-    return false;
+    RecomputeResult result;
+    result.execute(Feat);
+    return result.report(Feat, _RecomputeLog);
 }
 
 void Document::recomputeFeature(DocumentObject* Feat)
@@ -1440,8 +1882,8 @@ DocumentObject * Document::addObject(const char* sType, const char* pObjectName)
     pcObject->pcNameInDocument = &(d->objectMap.find(ObjectName)->first);
     // insert in the vector
     d->objectArray.push_back(pcObject);
-    // insert in the adjacence list and referenc through the ConectionMap
-    //_DepConMap[pcObject] = add_vertex(_DepList);
+    // a new object cannot be linked by others yet
+    _addToDependencyList(pcObject, false);
 
     pcObject->Label.setValue( ObjectName );
 
@@ -1460,6 +1902,7 @@ void Document::_addObject(DocumentObject* pcObject, const char* pObjectName)
     d->objectArray.push_back(pcObject);
     // cache the pointer to the name string in the Object (for performance of DocumentObject::getNameInDocument())
     pcObject->pcNameInDocument = &(d->objectMap.find(pObjectName)->first);
+    _addToDependencyList(pcObject, true);
 
     // do no transactions if we do a rollback!
     if(!d->rollback){
@@ -1501,6 +1944,7 @@ void Document::remObject(const char* sName)
 
     // Before deleting we must nullify all dependant objects
     breakDependency(pos->second, true);
+    _removeFromDependencyList(pos->second);
 
     // do no transactions if we do a rollback!
     if(!d->rollback){
@@ -1527,9 +1971,6 @@ void Document::remObject(const char* sName)
             break;
         }
     }
-    // remove from adjancy list
-    //remove_vertex(_DepConMap[pos->second],_DepList);
-    //_DepConMap.erase(pos->second);
     d->objectMap.erase(pos);
 }
 
@@ -1544,6 +1985,7 @@ void Document::_remObject(DocumentObject* pcObject)
         d->activeObject = 0;
 
     signalDeletedObject(*pcObject);
+    _removeFromDependencyList(pcObject);
 
     // do no transactions if we do a rollback!
     if(!d->rollback){
@@ -1570,10 +2012,15 @@ void Document::_remObject(DocumentObject* pcObject)
 
 void Document::breakDependency(DocumentObject* pcObject, bool clear)
 {
-    // Nullify all dependant objects
-    for (std::map<std::string,DocumentObject*>::iterator it = d->objectMap.begin(); it != d->objectMap.end(); ++it) {
+    // Nullify all dependant objects, only the objects linking to it need to be checked
+    std::set<DocumentObject*> owners;
+    std::vector<DocumentObject*> InList = getInList(pcObject);
+    owners.insert(InList.begin(), InList.end());
+    if (clear)
+        owners.insert(pcObject);
+    for (std::set<DocumentObject*>::iterator it = owners.begin(); it != owners.end(); ++it) {
         std::map<std::string,App::Property*> Map;
-        it->second->getPropertyMap(Map);
+        (*it)->getPropertyMap(Map);
         // search for all properties that could have a link to the object
         for (std::map<std::string,App::Property*>::iterator pt = Map.begin(); pt != Map.end(); ++pt) {
             if (pt->second->getTypeId().isDerivedFrom(PropertyLink::getClassTypeId())) {
@@ -56,6 +56,22 @@ namespace App
 namespace App
 {
 
+/// Statistics about the last recompute of a document
+struct RecomputeStatistics
+{
+    RecomputeStatistics() : Touched(0), Visited(0), Executed(0), Time(0.0f) {}
+    /// number of objects touched before the recompute
+    int Touched;
+    /// number of touched objects and objects depending on them
+    int Visited;
+    /// number of executed objects
+    int Executed;
+    /// wall-clock time of the recompute in seconds
+    float Time;
+    /// wall-clock time in seconds of the executed objects in order of execution
+    std::vector<std::pair<std::string, float> > ObjectTimes;
+};
+
 /// The document class
 class AppExport Document : public App::PropertyContainer
 {
@@ -208,10 +224,16 @@ public:
     bool isClosable() const;
     /// Recompute all touched features
     void recompute();
+    /** Recompute all touched features, objects which don't depend on each other
+     * are executed concurrently by a pool of worker threads.
+     */
+    void recomputeParallel();
     /// Recompute only one feature
     void recomputeFeature(DocumentObject* Feat);
     /// get the error log from the recompute run
     const std::vector<App::DocumentObjectExecReturn*> &getRecomputeLog(void)const{return _RecomputeLog;}
+    /// get the statistics of the last recompute
+    const RecomputeStatistics &getRecomputeStatistics(void)const{return _RecomputeStats;}
     /// get the text of the error of a spezified object
     const char* getErrorDescription(const App::DocumentObject*) const;
     //@}
@@ -269,6 +291,10 @@ public:
     /// also contains the given objects!
     std::vector<App::DocumentObject*> getDependencyList
         (const std::vector<App::DocumentObject*>&) const;
+    /// called by the link properties if \a owner starts linking to \a target
+    void _addBackLink(DocumentObject* owner, DocumentObject* target);
+    /// called by the link properties if \a owner stops linking to \a target
+    void _removeBackLink(DocumentObject* owner, DocumentObject* target);
     // set Changed
     //void setChanged(DocumentObject* change);
     //@}
@@ -306,8 +332,12 @@ protected:
     /// helper which Recompute only this feature
     bool _recomputeFeature(DocumentObject* Feat);
     void _clearRedos();
-    /// refresh the internal dependency graph
+    /// build the dependency graph of the touched objects and the objects depending on them
     void _rebuildDependencyList(void);
+    /// records the links from and to an object which gets part of the document
+    void _addToDependencyList(DocumentObject* pcObject, bool searchLinks);
+    /// removes the links from and to an object which leaves the document
+    void _removeFromDependencyList(DocumentObject* pcObject);
     std::string getTransientDirectoryName(const std::string& uuid, const std::string& filename) const;
 
 
@@ -317,6 +347,7 @@ private:
     std::list<Transaction*> mRedoTransactions;
     // recompute log
     std::vector<App::DocumentObjectExecReturn*> _RecomputeLog;
+    RecomputeStatistics _RecomputeStats;
 
     // pointer to the python class
     Py::Object DocumentPythonObject;
@@ -32,6 +32,7 @@
 #include "DocumentObject.h"
 #include "DocumentObjectPy.h"
 #include "PropertyLinks.h"
+#include "RecomputeProfiler.h"
 #define new DEBUG_CLIENTBLOCK
 using namespace App;
 
@@ -82,7 +83,12 @@ App::DocumentObjectExecReturn *DocumentObject::recompute(void)
 {
     // set/unset the execution bit
     ObjectExecution exe(this);
-    return this->execute();
+    // measure the execution if the profiler is enabled
+    RecomputeProfiler::Scope profile(this);
+    DocumentObjectExecReturn* ret = this->execute();
+    if (ret != StdReturn)
+        profile.setResult(RecomputeSample::Failed);
+    return ret;
 }
 
 DocumentObjectExecReturn *DocumentObject::execute(void)
@@ -95,6 +101,11 @@ short DocumentObject::mustExecute(void) const
     return (isTouched() ? 1 : 0);
 }
 
+bool DocumentObject::isThreadSafe(void) const
+{
+    return false;
+}
+
 const char* DocumentObject::getStatusString(void) const
 {
     if (isError()) {
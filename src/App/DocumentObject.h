@@ -134,6 +134,13 @@ public:
      * -1: the document examine all links of this object and if one is touched -> recompute
      */
     virtual short mustExecute(void) const;
+    /** isThreadSafe
+     *  A parallel recompute executes independent objects in worker threads.
+     *  By default objects are executed in the main thread, a class may only
+     *  return true if its execute() doesn't run Python code, doesn't access
+     *  the GUI and only changes its own properties.
+     */
+    virtual bool isThreadSafe(void) const;
 
     /// get the status Message
     const char *getStatusString(void) const;
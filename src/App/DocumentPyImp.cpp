@@ -444,6 +444,26 @@ Py::List DocumentPy::getRedoNames(void) const
     return res;
 }
 
+Py::Dict DocumentPy::getRecomputeStatistics(void) const
+{
+    const RecomputeStatistics& stats = getDocumentPtr()->getRecomputeStatistics();
+    Py::Dict dict;
+    dict.setItem("Touched", Py::Int(stats.Touched));
+    dict.setItem("Visited", Py::Int(stats.Visited));
+    dict.setItem("Executed", Py::Int(stats.Executed));
+    dict.setItem("Time", Py::Float(stats.Time));
+
+    Py::List times;
+    for (std::vector<std::pair<std::string, float> >::const_iterator It = stats.ObjectTimes.begin();It!=stats.ObjectTimes.end();++It) {
+        Py::Tuple item(2);
+        item.setItem(0, Py::String(It->first));
+        item.setItem(1, Py::Float(It->second));
+        times.append(item);
+    }
+    dict.setItem("Objects", times);
+    return dict;
+}
+
 Py::String  DocumentPy::getDependencyGraph(void) const
 {
     std::stringstream out;
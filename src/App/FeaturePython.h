@@ -81,6 +81,10 @@ public:
             return 1;
         return FeatureT::mustExecute();
     }
+    /// the Python interpreter must only be accessed by the main thread
+    bool isThreadSafe() const {
+        return false;
+    }
     /// recalculate the Feature
     virtual DocumentObjectExecReturn *execute(void) {
         return imp->execute();
@@ -28,6 +28,7 @@
 
 #include <Base/Console.h>
 #include <Base/Exception.h>
+#include <Base/TimeInfo.h>
 #include <Base/Unit.h>
 #include "FeatureTest.h"
 #include "Material.h"
@@ -87,6 +88,7 @@ FeatureTest::FeatureTest()
   ADD_PROPERTY_TYPE(ExecResult    ,("empty"),group,Prop_None,"Result of the execution");
   ADD_PROPERTY_TYPE(ExceptionType ,(0),group,Prop_None,"The type of exception the execution method throws");
   ADD_PROPERTY_TYPE(ExecCount     ,(0),group,Prop_None,"Number of executions");
+  ADD_PROPERTY_TYPE(ExecTime      ,(0),group,Prop_None,"Milliseconds the execution keeps the processor busy");
   
   // properties with types
   ADD_PROPERTY_TYPE(TypeHidden  ,(4711),group,Prop_Hidden,"An example property which has the type 'Hidden'"  );
@@ -119,6 +121,13 @@ DocumentObjectExecReturn *FeatureTest::execute(void)
     case 1: throw "Test Exeption";
     case 2: throw Base::Exception("FeatureTestException::execute(): Testexception");
   }
+
+  // simulate an expensive computation, e.g. to measure the parallel recompute
+  if (ExecTime.getValue() > 0) {
+    Base::TimeInfo start;
+    float duration = ExecTime.getValue() / 1000.0f;
+    while (Base::TimeInfo::diffTimeF(start) < duration);
+  }
   ExecCount.setValue(ExecCount.getValue() + 1);
 
   ExecResult.setValue("Exec");
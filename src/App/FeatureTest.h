@@ -86,6 +86,7 @@ public:
   App::PropertyString   ExecResult;
   App::PropertyInteger  ExceptionType;
   App::PropertyInteger  ExecCount;
+  App::PropertyInteger  ExecTime;
   
   App::PropertyInteger   TypeHidden;
   App::PropertyInteger   TypeReadOnly;
@@ -101,6 +102,10 @@ public:
   //@{
   /// recalculate the Feature
   virtual DocumentObjectExecReturn *execute(void);
+  /// the execution only changes the own properties
+  virtual bool isThreadSafe(void) const {
+    return true;
+  }
   /// returns the type name of the ViewProvider
   //FIXME: Propably it makes sense to have a view provider for unittests (e.g. Gui::ViewProviderTest)
   virtual const char* getViewProviderName(void) const {
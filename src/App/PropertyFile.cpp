@@ -401,6 +401,11 @@ void PropertyFileIncluded::SaveDocFile (Base::Writer &writer) const
     }
 }
 
+bool PropertyFileIncluded::isSaveDocFileThreadSafe (void) const
+{
+    return true;
+}
+
 void PropertyFileIncluded::RestoreDocFile(Base::Reader &reader)
 {
     Base::FileInfo fi(_cValue.c_str());
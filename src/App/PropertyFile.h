@@ -91,6 +91,7 @@ public:
     virtual void Restore(Base::XMLReader &reader);
 
     virtual void SaveDocFile (Base::Writer &writer) const;
+    virtual bool isSaveDocFileThreadSafe (void) const;
     virtual void RestoreDocFile(Base::Reader &reader);
 
     virtual Property *Copy(void) const;
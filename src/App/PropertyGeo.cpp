@@ -311,6 +311,11 @@ void PropertyVectorList::SaveDocFile (Base::Writer &writer) const
     }
 }
 
+bool PropertyVectorList::isSaveDocFileThreadSafe (void) const
+{
+    return true;
+}
+
 void PropertyVectorList::RestoreDocFile(Base::Reader &reader)
 {
     Base::InputStream str(reader);
@@ -628,9 +633,8 @@ Property *PropertyPlacementLink::Copy(void) const
 
 void PropertyPlacementLink::Paste(const Property &from)
 {
-    aboutToSetValue();
-    _pcLink = dynamic_cast<const PropertyPlacementLink&>(from)._pcLink;
-    hasSetValue();
+    // keeps the back links of the document up to date
+    setValue(dynamic_cast<const PropertyPlacementLink&>(from)._pcLink);
 }
 
 // ------------------------------------------------------------
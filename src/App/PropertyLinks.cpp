@@ -44,6 +44,49 @@ using namespace App;
 using namespace Base;
 using namespace std;
 
+namespace App {
+/** Tells the document of the owning object about changed links.
+ * This way the document knows the objects linking to an object without
+ * searching all objects.
+ */
+class BackLinks
+{
+public:
+    BackLinks(const Property* prop) : owner(0), doc(0)
+    {
+        PropertyContainer* father = prop->getContainer();
+        if (father && father->isDerivedFrom(DocumentObject::getClassTypeId())) {
+            owner = static_cast<DocumentObject*>(father);
+            doc = owner->getDocument();
+        }
+    }
+    void add(DocumentObject* obj) const
+    {
+        if (doc && obj)
+            doc->_addBackLink(owner, obj);
+    }
+    void remove(DocumentObject* obj) const
+    {
+        if (doc && obj)
+            doc->_removeBackLink(owner, obj);
+    }
+    void add(const std::vector<DocumentObject*>& objs) const
+    {
+        for (std::vector<DocumentObject*>::const_iterator it = objs.begin(); it != objs.end(); ++it)
+            add(*it);
+    }
+    void remove(const std::vector<DocumentObject*>& objs) const
+    {
+        for (std::vector<DocumentObject*>::const_iterator it = objs.begin(); it != objs.end(); ++it)
+            remove(*it);
+    }
+
+private:
+    DocumentObject* owner;
+    Document* doc;
+};
+}
+
 
 
 
@@ -67,7 +110,7 @@ PropertyLink::PropertyLink()
 
 PropertyLink::~PropertyLink()
 {
-
+    BackLinks(this).remove(_pcLink);
 }
 
 //**************************************************************************
@@ -76,7 +119,10 @@ PropertyLink::~PropertyLink()
 void PropertyLink::setValue(App::DocumentObject * lValue)
 {
     aboutToSetValue();
+    BackLinks links(this);
+    links.remove(_pcLink);
     _pcLink=lValue;
+    links.add(_pcLink);
     hasSetValue();
 }
 
@@ -158,7 +204,10 @@ Property *PropertyLink::Copy(void) const
 void PropertyLink::Paste(const Property &from)
 {
     aboutToSetValue();
+    BackLinks links(this);
+    links.remove(_pcLink);
     _pcLink = dynamic_cast<const PropertyLink&>(from)._pcLink;
+    links.add(_pcLink);
     hasSetValue();
 }
 
@@ -181,7 +230,7 @@ PropertyLinkSub::PropertyLinkSub()
 
 PropertyLinkSub::~PropertyLinkSub()
 {
-
+    BackLinks(this).remove(_pcLinkSub);
 }
 
 //**************************************************************************
@@ -190,7 +239,10 @@ PropertyLinkSub::~PropertyLinkSub()
 void PropertyLinkSub::setValue(App::DocumentObject * lValue, const std::vector<std::string> &SubList)
 {
     aboutToSetValue();
+    BackLinks links(this);
+    links.remove(_pcLinkSub);
     _pcLinkSub=lValue;
+    links.add(_pcLinkSub);
     _cSubList = SubList;
     hasSetValue();
 }
@@ -339,7 +391,10 @@ Property *PropertyLinkSub::Copy(void) const
 void PropertyLinkSub::Paste(const Property &from)
 {
     aboutToSetValue();
+    BackLinks links(this);
+    links.remove(_pcLinkSub);
     _pcLinkSub = dynamic_cast<const PropertyLinkSub&>(from)._pcLinkSub;
+    links.add(_pcLinkSub);
     _cSubList = dynamic_cast<const PropertyLinkSub&>(from)._cSubList;
     hasSetValue();
 }
@@ -361,11 +416,14 @@ PropertyLinkList::PropertyLinkList()
 
 PropertyLinkList::~PropertyLinkList()
 {
-
+    BackLinks(this).remove(_lValueList);
 }
 
 void PropertyLinkList::setSize(int newSize)
 {
+    BackLinks links(this);
+    for (int i = newSize; i < getSize(); i++)
+        links.remove(_lValueList[i]);
     _lValueList.resize(newSize);
 }
 
@@ -378,8 +436,11 @@ void PropertyLinkList::setValue(DocumentObject* lValue)
 {
     if (lValue){
         aboutToSetValue();
+        BackLinks links(this);
+        links.remove(_lValueList);
         _lValueList.resize(1);
         _lValueList[0]=lValue;
+        links.add(lValue);
         hasSetValue();
     }
 }
@@ -387,7 +448,10 @@ void PropertyLinkList::setValue(DocumentObject* lValue)
 void PropertyLinkList::setValues(const std::vector<DocumentObject*>& lValue)
 {
     aboutToSetValue();
+    BackLinks links(this);
+    links.remove(_lValueList);
     _lValueList=lValue;
+    links.add(_lValueList);
     hasSetValue();
 }
 
@@ -490,7 +554,10 @@ Property *PropertyLinkList::Copy(void) const
 void PropertyLinkList::Paste(const Property &from)
 {
     aboutToSetValue();
+    BackLinks links(this);
+    links.remove(_lValueList);
     _lValueList = dynamic_cast<const PropertyLinkList&>(from)._lValueList;
+    links.add(_lValueList);
     hasSetValue();
 }
 
@@ -515,11 +582,14 @@ PropertyLinkSubList::PropertyLinkSubList()
 
 PropertyLinkSubList::~PropertyLinkSubList()
 {
-
+    BackLinks(this).remove(_lValueList);
 }
 
 void PropertyLinkSubList::setSize(int newSize)
 {
+    BackLinks links(this);
+    for (int i = newSize; i < getSize(); i++)
+        links.remove(_lValueList[i]);
     _lValueList.resize(newSize);
     _lSubList  .resize(newSize);
 }
@@ -533,8 +603,11 @@ void PropertyLinkSubList::setValue(DocumentObject* lValue,const char* SubName)
 {
     if (lValue){
         aboutToSetValue();
+        BackLinks links(this);
+        links.remove(_lValueList);
         _lValueList.resize(1);
         _lValueList[0]=lValue;
+        links.add(lValue);
         _lSubList.resize(1);
         _lSubList[0]=SubName;
         hasSetValue();
@@ -544,7 +617,10 @@ void PropertyLinkSubList::setValue(DocumentObject* lValue,const char* SubName)
 void PropertyLinkSubList::setValues(const std::vector<DocumentObject*>& lValue,const std::vector<const char*>& lSubNames)
 {
     aboutToSetValue();
+    BackLinks links(this);
+    links.remove(_lValueList);
     _lValueList = lValue;
+    links.add(_lValueList);
     _lSubList.resize(lSubNames.size());
     int i = 0;
     for (std::vector<const char*>::const_iterator it = lSubNames.begin();it!=lSubNames.end();++it)
@@ -555,7 +631,10 @@ void PropertyLinkSubList::setValues(const std::vector<DocumentObject*>& lValue,c
 void PropertyLinkSubList::setValues(const std::vector<DocumentObject*>& lValue,const std::vector<std::string>& lSubNames)
 {
     aboutToSetValue();
+    BackLinks links(this);
+    links.remove(_lValueList);
     _lValueList = lValue;
+    links.add(_lValueList);
     _lSubList   = lSubNames;
     hasSetValue();
 }
@@ -684,7 +763,10 @@ Property *PropertyLinkSubList::Copy(void) const
 void PropertyLinkSubList::Paste(const Property &from)
 {
     aboutToSetValue();
+    BackLinks links(this);
+    links.remove(_lValueList);
     _lValueList = dynamic_cast<const PropertyLinkSubList&>(from)._lValueList;
+    links.add(_lValueList);
     _lSubList   = dynamic_cast<const PropertyLinkSubList&>(from)._lSubList;
     hasSetValue();
 }
@@ -1158,6 +1158,11 @@ void PropertyFloatList::SaveDocFile (Base::Writer &writer) const
     }
 }
 
+bool PropertyFloatList::isSaveDocFileThreadSafe (void) const
+{
+    return true;
+}
+
 void PropertyFloatList::RestoreDocFile(Base::Reader &reader)
 {
     Base::InputStream str(reader);
@@ -2131,6 +2136,11 @@ void PropertyColorList::SaveDocFile (Base::Writer &writer) const
     }
 }
 
+bool PropertyColorList::isSaveDocFileThreadSafe (void) const
+{
+    return true;
+}
+
 void PropertyColorList::RestoreDocFile(Base::Reader &reader)
 {
     Base::InputStream str(reader);
@@ -540,6 +540,7 @@ public:
     virtual void Restore(Base::XMLReader &reader);
     
     virtual void SaveDocFile (Base::Writer &writer) const;
+    virtual bool isSaveDocFileThreadSafe (void) const;
     virtual void RestoreDocFile(Base::Reader &reader);
     
     virtual Property *Copy(void) const;
@@ -833,6 +834,7 @@ public:
     virtual void Restore(Base::XMLReader &reader);
     
     virtual void SaveDocFile (Base::Writer &writer) const;
+    virtual bool isSaveDocFileThreadSafe (void) const;
     virtual void RestoreDocFile(Base::Reader &reader);
     
     virtual Property *Copy(void) const;
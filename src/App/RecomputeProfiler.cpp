@@ -0,0 +1,339 @@
+/***************************************************************************
+ *   Copyright (c) 2013 Werner Mayer <wmayer[at]users.sourceforge.net>     *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <algorithm>
+# include <cstdio>
+# include <exception>
+# include <iomanip>
+# include <map>
+#endif
+
+#if defined(FC_OS_WIN32)
+# include <windows.h>
+# include <psapi.h>
+#else
+# include <sys/time.h>
+# include <sys/resource.h>
+# include <unistd.h>
+#endif
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
+#include "RecomputeProfiler.h"
+#include "Document.h"
+#include "DocumentObject.h"
+
+using namespace App;
+
+namespace {
+
+/// wall-clock time in seconds
+double wallTime()
+{
+#if defined(FC_OS_WIN32)
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return double(count.QuadPart) / double(freq.QuadPart);
+#else
+    struct timeval tv;
+    gettimeofday(&tv, 0);
+    return double(tv.tv_sec) + double(tv.tv_usec) * 1e-6;
+#endif
+}
+
+/// CPU time of the calling thread in seconds
+double cpuTime()
+{
+#if defined(FC_OS_WIN32)
+    FILETIME creation, exit, kernel, user;
+    if (!GetThreadTimes(GetCurrentThread(), &creation, &exit, &kernel, &user))
+        return 0.0;
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime;
+    k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime;
+    u.HighPart = user.dwHighDateTime;
+    // units of 100 nanoseconds
+    return double(k.QuadPart + u.QuadPart) * 1e-7;
+#else
+    struct rusage usage;
+# if defined(RUSAGE_THREAD)
+    if (getrusage(RUSAGE_THREAD, &usage) != 0)
+# else
+    // no per-thread times, e.g. on Mac OS X
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+# endif
+        return 0.0;
+    return double(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           double(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+#endif
+}
+
+/// resident memory of the process in kB, 0 if unknown
+long residentMemory()
+{
+#if defined(FC_OS_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+        return static_cast<long>(pmc.WorkingSetSize / 1024);
+    return 0;
+#elif defined(FC_OS_LINUX)
+    long pages = 0, resident = 0;
+    FILE* file = fopen("/proc/self/statm", "r");
+    if (!file)
+        return 0;
+    if (fscanf(file, "%ld %ld", &pages, &resident) != 2)
+        resident = 0;
+    fclose(file);
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+    return 0;
+#endif
+}
+
+const char* statusName(RecomputeSample::Status status)
+{
+    switch (status) {
+    case RecomputeSample::Failed:
+        return "Failed";
+    case RecomputeSample::Exception:
+        return "Exception";
+    default:
+        return "Succeeded";
+    }
+}
+
+void writeString(std::ostream& str, const std::string& s)
+{
+    str << '"';
+    for (std::string::const_iterator it = s.begin(); it != s.end(); ++it) {
+        unsigned char c = static_cast<unsigned char>(*it);
+        if (c == '"' || c == '\\')
+            str << '\\' << *it;
+        else if (c < 0x20)
+            str << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c)
+                << std::dec << std::setfill(' ');
+        else
+            str << *it;
+    }
+    str << '"';
+}
+
+}
+
+struct RecomputeProfiler::Private
+{
+    QMutex mutex;
+    /// ring buffer of the samples
+    std::vector<RecomputeSample> samples;
+    std::size_t size;
+    /// position of the oldest sample once the buffer is full
+    std::size_t next;
+    double origin;
+    std::map<Qt::HANDLE, int> threads;
+
+    Private() : size(1000), next(0), origin(wallTime())
+    {
+    }
+    std::vector<RecomputeSample> history() const
+    {
+        std::vector<RecomputeSample> list;
+        list.reserve(samples.size());
+        list.insert(list.end(), samples.begin() + next, samples.end());
+        list.insert(list.end(), samples.begin(), samples.begin() + next);
+        return list;
+    }
+};
+
+RecomputeProfiler* RecomputeProfiler::_instance = 0;
+
+RecomputeProfiler& RecomputeProfiler::instance()
+{
+    if (!_instance)
+        _instance = new RecomputeProfiler();
+    return *_instance;
+}
+
+void RecomputeProfiler::destruct()
+{
+    delete _instance;
+    _instance = 0;
+}
+
+RecomputeProfiler::RecomputeProfiler() : d(new Private), enabled(false)
+{
+}
+
+RecomputeProfiler::~RecomputeProfiler()
+{
+    delete d;
+}
+
+void RecomputeProfiler::setEnabled(bool on)
+{
+    enabled = on;
+}
+
+void RecomputeProfiler::setHistorySize(std::size_t size)
+{
+    QMutexLocker locker(&d->mutex);
+    std::vector<RecomputeSample> list = d->history();
+    if (list.size() > size)
+        list.erase(list.begin(), list.end() - size);
+    d->samples.swap(list);
+    d->size = size;
+    d->next = 0;
+}
+
+std::size_t RecomputeProfiler::getHistorySize() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->size;
+}
+
+std::vector<RecomputeSample> RecomputeProfiler::getHistory() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->history();
+}
+
+void RecomputeProfiler::clear()
+{
+    QMutexLocker locker(&d->mutex);
+    d->samples.clear();
+    d->next = 0;
+    d->origin = wallTime();
+    d->threads.clear();
+}
+
+void RecomputeProfiler::addSample(RecomputeSample& sample)
+{
+    QMutexLocker locker(&d->mutex);
+    if (d->size == 0)
+        return;
+
+    sample.Start -= d->origin;
+    std::map<Qt::HANDLE, int>::iterator it = d->threads.find(QThread::currentThreadId());
+    if (it == d->threads.end())
+        it = d->threads.insert(std::make_pair(QThread::currentThreadId(), (int)d->threads.size() + 1)).first;
+    sample.Thread = it->second;
+
+    if (d->samples.size() < d->size) {
+        d->samples.push_back(sample);
+    }
+    else {
+        d->samples[d->next] = sample;
+        d->next = (d->next + 1) % d->size;
+    }
+}
+
+void RecomputeProfiler::writeTimeline(std::ostream& str) const
+{
+    std::vector<RecomputeSample> list = getHistory();
+    int numThreads = 0;
+    std::ios::fmtflags flags = str.flags();
+    std::streamsize precision = str.precision();
+
+    // times of the trace event format are in microseconds
+    str << "{\"traceEvents\":[";
+    str << std::fixed << std::setprecision(3);
+    for (std::vector<RecomputeSample>::const_iterator it = list.begin(); it != list.end(); ++it) {
+        if (it != list.begin())
+            str << ',';
+        str << "\n{\"name\":";
+        writeString(str, it->Object);
+        str << ",\"cat\":";
+        writeString(str, it->Type);
+        str << ",\"ph\":\"X\",\"ts\":" << it->Start * 1e6
+            << ",\"dur\":" << it->Wall * 1e6
+            << ",\"pid\":1,\"tid\":" << it->Thread
+            << ",\"args\":{\"document\":";
+        writeString(str, it->Document);
+        str << ",\"cpu\":" << it->Cpu * 1e3
+            << ",\"memory\":" << it->Memory
+            << ",\"status\":\"" << statusName(it->Result) << "\"}}";
+        numThreads = std::max<int>(numThreads, it->Thread);
+    }
+
+    // name the threads in the viewer
+    for (int i = 1; i <= numThreads; i++) {
+        if (i > 1 || !list.empty())
+            str << ',';
+        str << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << i
+            << ",\"args\":{\"name\":\"Thread " << i << "\"}}";
+    }
+    str << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    str.flags(flags);
+    str.precision(precision);
+}
+
+// ----------------------------------------------------------------------------
+
+RecomputeProfiler::Scope::Scope(const DocumentObject* obj)
+  : object(0), result(RecomputeSample::Succeeded), wall(0.0), cpu(0.0), memory(0)
+{
+    if (RecomputeProfiler::instance().isEnabled()) {
+        object = obj;
+        memory = residentMemory();
+        cpu = cpuTime();
+        wall = wallTime();
+    }
+}
+
+RecomputeProfiler::Scope::~Scope()
+{
+    if (!object)
+        return;
+
+    double end = wallTime();
+    RecomputeSample sample;
+    sample.Start = wall;
+    sample.Wall = end - wall;
+    sample.Cpu = cpuTime() - cpu;
+    sample.Memory = residentMemory() - memory;
+    sample.Result = std::uncaught_exception() ? RecomputeSample::Exception : result;
+
+    // a destructor must not throw
+    try {
+        const char* name = object->getNameInDocument();
+        if (name)
+            sample.Object = name;
+        sample.Type = object->getTypeId().getName();
+        if (object->getDocument())
+            sample.Document = object->getDocument()->getName();
+        RecomputeProfiler::instance().addSample(sample);
+    }
+    catch (...) {
+    }
+}
+
+void RecomputeProfiler::Scope::setResult(RecomputeSample::Status status)
+{
+    result = status;
+}
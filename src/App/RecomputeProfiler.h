@@ -0,0 +1,129 @@
+/***************************************************************************
+ *   Copyright (c) 2013 Werner Mayer <wmayer[at]users.sourceforge.net>     *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef APP_RECOMPUTEPROFILER_H
+#define APP_RECOMPUTEPROFILER_H
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+namespace App
+{
+
+class DocumentObject;
+
+/** Measurement of the recompute of a single object.
+ */
+struct AppExport RecomputeSample
+{
+    enum Status {
+        Succeeded, /**< execute() returned without error */
+        Failed,    /**< execute() returned an error */
+        Exception  /**< execute() has thrown an exception */
+    };
+
+    RecomputeSample() : Start(0.0), Wall(0.0), Cpu(0.0), Memory(0), Thread(0), Result(Succeeded) {}
+
+    std::string Document;
+    std::string Object;
+    std::string Type;
+    /// start time in seconds since the profiler was created or cleared
+    double Start;
+    /// wall-clock time in seconds
+    double Wall;
+    /// CPU time of the executing thread in seconds
+    double Cpu;
+    /** Change of the resident memory of the process in kB.
+     * If objects are recomputed in parallel it includes the allocations of the
+     * other threads.
+     */
+    long Memory;
+    /// number of the executing thread, the first thread that recomputed an object is 1
+    int Thread;
+    Status Result;
+};
+
+/** The RecomputeProfiler records the time and memory every object takes to recompute.
+ * It is disabled by default and can be switched on with the parameter
+ * "User parameter:BaseApp/Preferences/Document/RecomputeProfiler" or from Python.
+ * The last samples are kept in a ring buffer whose size is set by the parameter
+ * "RecomputeProfilerHistory" and can be written as a timeline in the trace event
+ * format of Chrome (chrome://tracing).
+ * @author Werner Mayer
+ */
+class AppExport RecomputeProfiler
+{
+public:
+    static RecomputeProfiler& instance();
+    static void destruct();
+
+    void setEnabled(bool);
+    bool isEnabled() const
+    { return enabled; }
+    /// Sets the maximum number of kept samples, the oldest samples are dropped
+    void setHistorySize(std::size_t);
+    std::size_t getHistorySize() const;
+    /// Returns the kept samples, the oldest first
+    std::vector<RecomputeSample> getHistory() const;
+    void clear();
+    /// Writes the kept samples as JSON in the trace event format
+    void writeTimeline(std::ostream&) const;
+
+    /** Measures the recompute of an object between construction and destruction.
+     * If the scope is left by an exception the sample is marked as such.
+     */
+    class AppExport Scope
+    {
+    public:
+        Scope(const DocumentObject*);
+        ~Scope();
+        void setResult(RecomputeSample::Status);
+
+    private:
+        const DocumentObject* object;
+        RecomputeSample::Status result;
+        double wall;
+        double cpu;
+        long memory;
+    };
+
+private:
+    RecomputeProfiler();
+    ~RecomputeProfiler();
+    /// Adds a sample measured in the calling thread with an absolute start time
+    void addSample(RecomputeSample&);
+
+    friend class Scope;
+
+    static RecomputeProfiler* _instance;
+
+    struct Private;
+    Private* d;
+    bool enabled;
+};
+
+} //namespace App
+
+
+#endif // APP_RECOMPUTEPROFILER_H
@@ -116,6 +116,13 @@ public:
      * In this method you can simply stream your content to the file (Base::Writer inheriting from ostream).
      */
     virtual void SaveDocFile (Writer &/*writer*/) const;
+    /** Returns true if SaveDocFile() may be called from a worker thread while
+     * the main thread writes other files. This is only possible if SaveDocFile()
+     * doesn't touch global or shared data, e.g. Python objects, temporary files
+     * with a fixed name or the GUI, and doesn't add further files to the writer.
+     * The default returns false.
+     */
+    virtual bool isSaveDocFileThreadSafe (void) const;
     /** This method is used to restore large amounts of data from a file
      * In this method you simply stream in your with SaveDocFile() saved data.
      * Again you have to apply for the call of this method in the Restore() call:
@@ -36,7 +36,15 @@
 #include "Tools.h"
 
 #include <algorithm>
+#include <cctype>
+#include <list>
 #include <locale>
+#include <zlib.h>
+
+#include <QRunnable>
+#include <QSemaphore>
+#include <QThread>
+#include <QThreadPool>
 
 using namespace Base;
 using namespace std;
@@ -178,8 +186,213 @@ void Writer::decInd(void)
     }
 }
 
+namespace Base {
+
+/// A streambuf appending the written data to a string
+class ZipEntryBuffer : public std::streambuf
+{
+public:
+    ZipEntryBuffer(std::string& s) : str(s)
+    {
+        setp(buf, buf + sizeof(buf));
+    }
+    ~ZipEntryBuffer()
+    {
+        sync();
+    }
+
+protected:
+    int_type overflow(int_type c)
+    {
+        sync();
+        if (!traits_type::eq_int_type(c, traits_type::eof())) {
+            *pptr() = traits_type::to_char_type(c);
+            pbump(1);
+        }
+        return traits_type::not_eof(c);
+    }
+    std::streamsize xsputn(const char* s, std::streamsize n)
+    {
+        if (n < epptr() - pptr()) {
+            std::copy(s, s + n, pptr());
+            pbump(n);
+        }
+        else {
+            sync();
+            str.append(s, n);
+        }
+        return n;
+    }
+    int sync()
+    {
+        str.append(pbase(), pptr() - pbase());
+        setp(buf, buf + sizeof(buf));
+        return 0;
+    }
+
+private:
+    std::string& str;
+    char buf[4096];
+};
+
+/// A writer serialising a single file into memory
+class ZipEntryWriter : public Writer
+{
+public:
+    ZipEntryWriter(std::string& data, const std::ios& format)
+      : buffer(data), stream(&buffer)
+    {
+        stream.copyfmt(format);
+    }
+    ~ZipEntryWriter()
+    {
+        stream.flush();
+    }
+    virtual std::ostream &Stream(void){return stream;}
+    virtual void writeFiles(void){assert(0);}
+
+private:
+    ZipEntryBuffer buffer;
+    std::ostream stream;
+};
+
+/** Serialises and compresses a file of a ZipWriter in a worker thread.
+ * If the object cannot be saved in a worker thread the data must be set
+ * before and the job only compresses it.
+ */
+class ZipEntryJob : public QRunnable
+{
+public:
+    ZipEntryJob(const std::string& name, const Persistence* obj, int level,
+                const std::ios& format, int version)
+      : FileName(name), Object(obj), Level(level), Format(0), FileVersion(version)
+      , Serialised(false), Deflated(false), Buffered(0), Size(0), Crc(0), Failed(false)
+    {
+        setAutoDelete(false);
+        Format.copyfmt(format);
+    }
+
+    void run()
+    {
+        try {
+            if (!Serialised) {
+                ZipEntryWriter writer(Data, Format);
+                writer.setFileVersion(FileVersion);
+                Object->SaveDocFile(writer);
+            }
+            compress();
+        }
+        catch (const Base::Exception& e) {
+            Failed = true;
+            Why = e.what();
+        }
+        catch (const std::exception& e) {
+            Failed = true;
+            Why = e.what();
+        }
+        catch (...) {
+            Failed = true;
+            Why = "Unknown exception while saving ";
+            Why += FileName;
+        }
+        finished.release();
+    }
+
+    void wait()
+    {
+        finished.acquire();
+    }
+
+    /// returns true if the job is done, only then its data may be accessed
+    bool isFinished() const
+    {
+        return finished.available() > 0;
+    }
+
+    /// the number of bytes kept in memory, of a running job only known if it was serialised before
+    std::size_t bufferSize() const
+    {
+        return isFinished() ? Data.size() : Buffered;
+    }
+
+    std::string FileName;
+    const Persistence* Object;
+    int Level;
+    std::ios Format;
+    int FileVersion;
+    bool Serialised;
+    bool Deflated;
+    std::string Data;
+    std::size_t Buffered;
+    zipios::uint32 Size;
+    zipios::uint32 Crc;
+    bool Failed;
+    std::string Why;
+
+private:
+    void compress()
+    {
+        Size = static_cast<zipios::uint32>(Data.size());
+        Crc = crc32(crc32(0, Z_NULL, 0), reinterpret_cast<const Bytef*>(Data.data()), Size);
+        if (Level == 0)
+            return;
+
+        z_stream zs;
+        zs.zalloc = Z_NULL;
+        zs.zfree  = Z_NULL;
+        zs.opaque = Z_NULL;
+        // no zlib header, like zipios::DeflateOutputStreambuf
+        if (deflateInit2(&zs, Level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            throw Base::Exception("ZipWriter: Cannot initialize deflate");
+        std::string deflated;
+        deflated.resize(deflateBound(&zs, Size));
+        zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(Data.data()));
+        zs.avail_in = Size;
+        zs.next_out = reinterpret_cast<Bytef*>(&deflated[0]);
+        zs.avail_out = static_cast<uInt>(deflated.size());
+        int err = deflate(&zs, Z_FINISH);
+        deflated.resize(zs.total_out);
+        deflateEnd(&zs);
+        if (err != Z_STREAM_END)
+            throw Base::Exception("ZipWriter: Deflation failed");
+
+        // keep the data uncompressed if deflating doesn't pay off
+        if (deflated.size() < Data.size()) {
+            Data.swap(deflated);
+            Deflated = true;
+        }
+    }
+
+    QSemaphore finished;
+};
+
+/// the number of bytes of files kept in memory until they are written
+static const std::size_t MaxBufferSize = 128 * 1024 * 1024;
+
+/** Returns true if another file may be processed while the files of \a jobs
+ * are not written yet. At most \a threads files are processed at the same
+ * time and the data of the others must not exceed MaxBufferSize, but a single
+ * file is always processed however large it is.
+ */
+static bool canStartJob(const std::list<ZipEntryJob*>& jobs, int threads)
+{
+    if (jobs.empty())
+        return true;
+    std::size_t bytes = 0;
+    int running = 0;
+    for (std::list<ZipEntryJob*>::const_iterator it = jobs.begin(); it != jobs.end(); ++it) {
+        bytes += (*it)->bufferSize();
+        if (!(*it)->isFinished())
+            running++;
+    }
+    return running < threads && bytes < MaxBufferSize;
+}
+
+}
+
 ZipWriter::ZipWriter(const char* FileName) 
-  : ZipStream(FileName)
+  : ZipStream(FileName), Level(ZipOutputStreambuf::DEFAULT_COMPRESSION)
+  , Threads(QThread::idealThreadCount())
 {
 #ifdef _MSC_VER
     ZipStream.imbue(std::locale::empty());
@@ -192,7 +405,8 @@ ZipWriter::ZipWriter(const char* FileName)
 }
 
 ZipWriter::ZipWriter(std::ostream& os) 
-  : ZipStream(os)
+  : ZipStream(os), Level(ZipOutputStreambuf::DEFAULT_COMPRESSION)
+  , Threads(QThread::idealThreadCount())
 {
 #ifdef _MSC_VER
     ZipStream.imbue(std::locale::empty());
@@ -204,19 +418,111 @@ ZipWriter::ZipWriter(std::ostream& os)
     ZipStream.setf(ios::fixed,ios::floatfield);
 }
 
+void ZipWriter::setLevel(const char* extension, int level)
+{
+    std::string ext = extension;
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    ExtensionLevels[ext] = level;
+}
+
+int ZipWriter::getLevel(const std::string& FileName) const
+{
+    std::string ext = FileInfo(FileName).extension(false);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    std::map<std::string, int>::const_iterator it = ExtensionLevels.find(ext);
+    if (it != ExtensionLevels.end())
+        return it->second;
+    return Level;
+}
+
 void ZipWriter::writeFiles(void)
 {
+#if !defined(FC_USE_EXTERNAL_ZIPIOS)
+    if (Threads > 1) {
+        writeFilesParallel();
+        return;
+    }
+#endif
+
     // use a while loop because it is possible that while
     // processing the files new ones can be added
     size_t index = 0;
     while (index < FileList.size()) {
         FileEntry entry = FileList.begin()[index];
+        ZipStream.setLevel(getLevel(entry.FileName));
         ZipStream.putNextEntry(entry.FileName);
         entry.Object->SaveDocFile(*this);
         index++;
     }
 }
 
+#if !defined(FC_USE_EXTERNAL_ZIPIOS)
+void ZipWriter::writeFilesParallel(void)
+{
+    QThreadPool pool;
+    pool.setMaxThreadCount(Threads);
+    std::list<ZipEntryJob*> jobs;
+
+    try {
+        // use a while loop because it is possible that while
+        // processing the files new ones can be added
+        size_t index = 0;
+        while (index < FileList.size() || !jobs.empty()) {
+            while (index < FileList.size() && canStartJob(jobs, Threads)) {
+                FileEntry entry = FileList.begin()[index];
+                ZipEntryJob* job = new ZipEntryJob(entry.FileName, entry.Object,
+                    getLevel(entry.FileName), ZipStream, fileVersion);
+                jobs.push_back(job);
+                index++;
+
+                if (!entry.Object->isSaveDocFileThreadSafe()) {
+                    // serialise in this thread by redirecting the stream into the buffer of the job
+                    ZipEntryBuffer buffer(job->Data);
+                    std::streambuf* zip = ZipStream.rdbuf(&buffer);
+                    try {
+                        entry.Object->SaveDocFile(*this);
+                        ZipStream.flush();
+                    }
+                    catch (...) {
+                        ZipStream.rdbuf(zip);
+                        throw;
+                    }
+                    ZipStream.rdbuf(zip);
+                    job->Serialised = true;
+                    job->Buffered = job->Data.size();
+                }
+                pool.start(job);
+            }
+
+            // write the files in the order they were added
+            ZipEntryJob* job = jobs.front();
+            jobs.pop_front();
+            job->wait();
+            if (job->Failed) {
+                std::string why = job->Why;
+                delete job;
+                throw Base::Exception(why);
+            }
+
+            ZipCDirEntry ent(job->FileName);
+            ent.setMethod(job->Deflated ? DEFLATED : STORED);
+            ent.setSize(job->Size);
+            ent.setCrc(job->Crc);
+            ent.setCompressedSize(static_cast<zipios::uint32>(job->Data.size()));
+            ZipStream.putCompressedEntry(ent, job->Data.data());
+            delete job;
+        }
+    }
+    catch (...) {
+        // the running jobs must finish before they can be deleted
+        pool.waitForDone();
+        for (std::list<ZipEntryJob*>::iterator it = jobs.begin(); it != jobs.end(); ++it)
+            delete *it;
+        throw;
+    }
+}
+#endif
+
 ZipWriter::~ZipWriter()
 {
     ZipStream.close();
@@ -25,6 +25,7 @@
 
 
 #include <string>
+#include <map>
 #include <sstream>
 #include <vector>
 #include <cassert>
@@ -115,6 +116,10 @@ protected:
 /** The ZipWriter class 
  * This is an important helper class implementation for the store and retrieval system
  * of persistent objects in FreeCAD. 
+ * The additional files are serialised and compressed in memory on worker threads
+ * and written in the order they were added. Objects which don't allow to call
+ * Persistence::SaveDocFile() from a worker thread are serialised by the calling
+ * thread but still compressed in parallel.
  * \see Base::Persistence
  * \author Juergen Riegel
  */
@@ -131,11 +136,25 @@ public:
     virtual std::ostream &Stream(void){return ZipStream;}
 
     void setComment(const char* str){ZipStream.setComment(str);}
-    void setLevel(int level){ZipStream.setLevel( level );}
+    void setLevel(int level){ZipStream.setLevel( level );Level = level;}
+    /** Sets the compression level for the files with the given extension.
+     * Level 0 stores the files uncompressed, e.g. if they are compressed already.
+     */
+    void setLevel(const char* extension, int level);
+    /** Sets the number of threads serialising and compressing the files.
+     * By default the number of cores is used, 1 writes the files serially.
+     */
+    void setThreads(int num){Threads = num;}
     void putNextEntry(const char* str){ZipStream.putNextEntry(str);}
 
 private:
+    int getLevel(const std::string& FileName) const;
+    void writeFilesParallel(void);
+
     zipios::ZipOutputStream ZipStream;
+    int Level;
+    int Threads;
+    std::map<std::string, int> ExtensionLevels;
 };
 
 /** The StringWriter class 
@@ -0,0 +1,197 @@
+/***************************************************************************
+ *   Copyright (c) 2012 Imetric 3D GmbH                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <cstddef>
+# ifdef FC_OS_WIN32
+# include <windows.h>
+# endif
+# ifdef FC_OS_MACOSX
+# include <OpenGL/gl.h>
+# else
+# include <GL/gl.h>
+# endif
+# include <Inventor/SbVec3f.h>
+# include <Inventor/elements/SoGLCacheContextElement.h>
+# include <Inventor/misc/SoState.h>
+#endif
+
+#include <Inventor/C/glue/gl.h>
+
+#include "SoFCVertexCache.h"
+
+#ifndef GL_ARRAY_BUFFER
+# define GL_ARRAY_BUFFER 0x8892
+#endif
+#ifndef GL_STATIC_DRAW
+# define GL_STATIC_DRAW 0x88E4
+#endif
+
+using namespace Gui;
+
+
+SoFCVertexCache::SoFCVertexCache() : revision(1)
+{
+    geometryIds[0] = 0;
+    geometryIds[1] = 0;
+    geometryIds[2] = 0;
+}
+
+SoFCVertexCache::~SoFCVertexCache()
+{
+    // the buffers can only be deleted when their context is current
+    for (std::map<uint32_t, Buffer>::iterator it = buffers.begin(); it != buffers.end(); ++it) {
+        if (it->second.id != 0) {
+            SoGLCacheContextElement::scheduleDeleteCallback(it->first, deleteBuffer,
+                reinterpret_cast<void*>(static_cast<size_t>(it->second.id)));
+        }
+    }
+}
+
+void SoFCVertexCache::deleteBuffer(void * closure, uint32_t contextid)
+{
+    const cc_glglue * glue = cc_glglue_instance(static_cast<int>(contextid));
+    GLuint id = static_cast<GLuint>(reinterpret_cast<size_t>(closure));
+    cc_glglue_glDeleteBuffers(glue, 1, &id);
+}
+
+bool SoFCVertexCache::isSupported(SoState * state)
+{
+    const cc_glglue * glue = cc_glglue_instance(SoGLCacheContextElement::get(state));
+    return cc_glglue_has_vertex_buffer_object(glue) ? true : false;
+}
+
+void SoFCVertexCache::fillTriangles(const SbVec3f * points, int numPoints,
+                                    const int32_t * coordIndices, int numIndices,
+                                    const SbVec3f * normals, const int32_t * normalIndices,
+                                    std::vector<float>& data)
+{
+    data.reserve(data.size() + (numIndices / 4) * 18);
+    for (int i=0; i+2 < numIndices; i+=4) {
+        int32_t v[3] = { coordIndices[i], coordIndices[i+1], coordIndices[i+2] };
+        for (int j=0; j<3; j++) {
+            if (v[j] < 0 || v[j] >= numPoints)
+                return;
+        }
+
+        SbVec3f n;
+        if (!normals) {
+            n = (points[v[1]] - points[v[0]]).cross(points[v[2]] - points[v[0]]);
+        }
+
+        for (int j=0; j<3; j++) {
+            const SbVec3f& p = points[v[j]];
+            if (normals)
+                n = normals[normalIndices[i+j]];
+            data.push_back(p[0]);
+            data.push_back(p[1]);
+            data.push_back(p[2]);
+            data.push_back(n[0]);
+            data.push_back(n[1]);
+            data.push_back(n[2]);
+        }
+    }
+}
+
+void SoFCVertexCache::setGeometryIds(unsigned long id1, unsigned long id2, unsigned long id3)
+{
+    if (geometryIds[0] != id1 || geometryIds[1] != id2 || geometryIds[2] != id3) {
+        geometryIds[0] = id1;
+        geometryIds[1] = id2;
+        geometryIds[2] = id3;
+        invalidate();
+    }
+}
+
+void SoFCVertexCache::invalidate()
+{
+    revision++;
+}
+
+bool SoFCVertexCache::needsUpload(SoState * state) const
+{
+    if (!isSupported(state))
+        return false;
+    std::map<uint32_t, Buffer>::const_iterator it = buffers.find(SoGLCacheContextElement::get(state));
+    return (it == buffers.end() || it->second.revision != this->revision);
+}
+
+bool SoFCVertexCache::upload(SoState * state, const std::vector<float>& data)
+{
+    uint32_t context = SoGLCacheContextElement::get(state);
+    const cc_glglue * glue = cc_glglue_instance(context);
+
+    Buffer& buf = buffers[context];
+    if (buf.id == 0)
+        cc_glglue_glGenBuffers(glue, 1, &buf.id);
+    buf.revision = this->revision;
+    buf.numVertices = -1;
+    if (buf.id == 0)
+        return false;
+
+    // clear pending errors so that we only see those of the upload
+    while (glGetError() != GL_NO_ERROR);
+    cc_glglue_glBindBuffer(glue, GL_ARRAY_BUFFER, buf.id);
+    cc_glglue_glBufferData(glue, GL_ARRAY_BUFFER, data.size() * sizeof(float),
+                           data.empty() ? 0 : &data[0], GL_STATIC_DRAW);
+    cc_glglue_glBindBuffer(glue, GL_ARRAY_BUFFER, 0);
+    if (glGetError() != GL_NO_ERROR)
+        return false;
+
+    buf.numVertices = static_cast<int>(data.size() / 6);
+    return true;
+}
+
+bool SoFCVertexCache::render(SoState * state, SbBool normals) const
+{
+    if (!isSupported(state))
+        return false;
+    uint32_t context = SoGLCacheContextElement::get(state);
+    std::map<uint32_t, Buffer>::const_iterator it = buffers.find(context);
+    if (it == buffers.end() || it->second.revision != this->revision || it->second.numVertices < 0)
+        return false;
+
+    const cc_glglue * glue = cc_glglue_instance(context);
+    const GLsizei stride = 6 * sizeof(float);
+    cc_glglue_glBindBuffer(glue, GL_ARRAY_BUFFER, it->second.id);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    glVertexPointer(3, GL_FLOAT, stride, 0);
+    if (normals) {
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glNormalPointer(GL_FLOAT, stride, reinterpret_cast<const GLvoid*>(3 * sizeof(float)));
+    }
+
+    glDrawArrays(GL_TRIANGLES, 0, it->second.numVertices);
+
+    if (normals)
+        glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
+    cc_glglue_glBindBuffer(glue, GL_ARRAY_BUFFER, 0);
+
+    // the buffer is drawn directly and must not end up in a render cache
+    SoGLCacheContextElement::shouldAutoCache(state, SoGLCacheContextElement::DONT_AUTO_CACHE);
+    return true;
+}
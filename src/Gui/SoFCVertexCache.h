@@ -0,0 +1,125 @@
+/***************************************************************************
+ *   Copyright (c) 2012 Imetric 3D GmbH                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef GUI_SOFCVERTEXCACHE_H
+#define GUI_SOFCVERTEXCACHE_H
+
+#include <map>
+#include <vector>
+#include <Inventor/SbBasic.h>
+
+class SbVec3f;
+class SoState;
+
+namespace Gui {
+
+/**
+ * The SoFCVertexCache class keeps the triangles of a shape node in an OpenGL vertex buffer
+ * object. This way the geometry is uploaded to the graphics card only once and redrawn from
+ * there until it changes instead of sending it in immediate mode for each frame.
+ *
+ * The geometry is passed as a plain triangle list where each vertex consists of six floats:
+ * the point and its normal. A buffer is created for each OpenGL context the node is rendered
+ * in. The owner identifies the geometry by up to three ids that change whenever the geometry
+ * does, e.g. the ids of the coordinate and the normal node or the revision of a mesh kernel;
+ * whenever these ids differ from the previous ones or invalidate() is called the revision of
+ * the cache is increased and each context uploads the data again on the next call of
+ * needsUpload()/upload().
+ *
+ * If the OpenGL implementation doesn't support vertex buffer objects or the upload failed
+ * render() returns false and the owner must render the geometry itself.
+ *
+ * \code
+ * vertexCache.setGeometryIds(coords->getNodeId(), normals->getNodeId());
+ * if (vertexCache.needsUpload(state)) {
+ *     std::vector<float> data;
+ *     ... // fill in the triangles
+ *     vertexCache.upload(state, data);
+ * }
+ * if (!vertexCache.render(state, needNormals))
+ *     ... // render in immediate mode
+ * \endcode
+ */
+class GuiExport SoFCVertexCache
+{
+public:
+    SoFCVertexCache();
+    ~SoFCVertexCache();
+
+    /** Returns true if the OpenGL context of \a state supports vertex buffer objects. */
+    static bool isSupported(SoState * state);
+    /**
+     * Appends the triangles of an indexed face set to \a data. Each triangle in
+     * \a coordIndices must be terminated by -1. If \a normals is null the normals of the
+     * triangles are used, otherwise \a normalIndices holds the index of a normal for each
+     * entry of \a coordIndices. Like the immediate mode rendering of the face sets it
+     * stops at the first triangle with an invalid point index.
+     */
+    static void fillTriangles(const SbVec3f * points, int numPoints,
+                              const int32_t * coordIndices, int numIndices,
+                              const SbVec3f * normals, const int32_t * normalIndices,
+                              std::vector<float>& data);
+
+    /**
+     * Sets the ids that identify the current geometry, e.g. the ids of the nodes it is
+     * taken from. If they differ from the ids set before the cache gets invalid.
+     */
+    void setGeometryIds(unsigned long id1, unsigned long id2 = 0, unsigned long id3 = 0);
+    /** Marks the buffers of all contexts as outdated. */
+    void invalidate();
+    /**
+     * Returns true if the buffer of the current context doesn't hold the current revision
+     * of the geometry. If vertex buffer objects are not supported or the last upload of
+     * this revision failed false is returned.
+     */
+    bool needsUpload(SoState * state) const;
+    /**
+     * Uploads the triangles in \a data to the buffer of the current context. Returns false
+     * if the data couldn't be uploaded, e.g. if the graphics card runs out of memory.
+     */
+    bool upload(SoState * state, const std::vector<float>& data);
+    /**
+     * Renders the triangles of the current context with or without normals. Returns false
+     * if there is no valid buffer.
+     */
+    bool render(SoState * state, SbBool normals) const;
+
+private:
+    SoFCVertexCache(const SoFCVertexCache&);
+    SoFCVertexCache& operator=(const SoFCVertexCache&);
+
+    static void deleteBuffer(void * closure, uint32_t contextid);
+
+    struct Buffer {
+        unsigned int id;
+        unsigned long revision;
+        int numVertices; /**< -1 if the upload failed */
+    };
+    std::map<uint32_t, Buffer> buffers;
+    unsigned long revision;
+    unsigned long geometryIds[3];
+};
+
+} // namespace Gui
+
+#endif // GUI_SOFCVERTEXCACHE_H
@@ -195,19 +195,17 @@ namespace Inspection {
                     for (ulY = ulY1; ulY <= ulY2; ulY++) {
                         for (ulZ = ulZ1; ulZ <= ulZ2; ulZ++) {
                             if (rclFacet.IntersectBoundingBox(GetBoundBox(ulX, ulY, ulZ)))
-                                _aulGrid[ulX][ulY][ulZ].insert(ulFacetIndex);
+                                AddElement(ulX, ulY, ulZ, ulFacetIndex);
                         }
                     }
                 }
             }
             else
-                _aulGrid[ulX1][ulY1][ulZ1].insert(ulFacetIndex);
+                AddElement(ulX1, ulY1, ulZ1, ulFacetIndex);
         }
 
         void InitGrid (void)
         {
-            unsigned long i, j;
-
             Base::BoundBox3f clBBMesh = _pclMesh->GetBoundBox().Transformed(_transform);
 
             float fLengthX = clBBMesh.LengthX(); 
@@ -223,13 +221,10 @@ namespace Inspection {
             _fGridLenZ = (1.0f + fLengthZ) / float(_ulCtGridsZ);
             _fMinZ = clBBMesh.MinZ - 0.5f;
 
-            _aulGrid.clear();
-            _aulGrid.resize(_ulCtGridsX);
-            for (i = 0; i < _ulCtGridsX; i++) {
-                _aulGrid[i].resize(_ulCtGridsY);
-                for (j = 0; j < _ulCtGridsY; j++)
-                    _aulGrid[i][j].resize(_ulCtGridsZ);
-            }
+            _aulGridIndices.clear();
+            _aulGridOffsets.clear();
+            _aulGridOffsets.resize(_ulCtGridsX * _ulCtGridsY * _ulCtGridsZ + 1, 0);
+            _bFillGrid = false;
         }
 
         void RebuildGrid (void)
@@ -237,12 +232,17 @@ namespace Inspection {
             _ulCtElements = _pclMesh->CountFacets();
             InitGrid();
  
-            unsigned long i = 0;
             MeshCore::MeshFacetIterator clFIter(*_pclMesh);
             clFIter.Transform(_transform);
-            for (clFIter.Init(); clFIter.More(); clFIter.Next()) {
-                AddFacet(*clFIter, i++);
+            for (int iPass = 0; iPass < 2; iPass++) {
+                if (iPass == 1)
+                    BeginFill();
+                unsigned long i = 0;
+                for (clFIter.Init(); clFIter.More(); clFIter.Next()) {
+                    AddFacet(*clFIter, i++);
+                }
             }
+            EndFill();
         }
 
     private:
@@ -554,6 +554,11 @@ void PropertyDistanceList::SaveDocFile (Base::Writer &writer) const
     }
 }
 
+bool PropertyDistanceList::isSaveDocFileThreadSafe (void) const
+{
+    return true;
+}
+
 void PropertyDistanceList::RestoreDocFile(Base::Reader &reader)
 {
     Base::InputStream str(reader);
@@ -28,6 +28,7 @@
 
 #include <Base/Console.h>
 #include <Base/Interpreter.h>
+#include <App/Application.h>
 
 #include "Mesh.h"
 #include "MeshPy.h"
@@ -39,6 +40,7 @@
 #include "FeatureMeshTransform.h"
 #include "FeatureMeshTransformDemolding.h"
 #include "FeatureMeshCurvature.h"
+#include "FeatureMeshDecimation.h"
 #include "FeatureMeshSegmentByMesh.h"
 #include "FeatureMeshSetOperations.h"
 #include "FeatureMeshDefects.h"
@@ -82,6 +84,12 @@ void MeshExport initMesh()
 
     Mesh::MeshObject            ::init();
 
+    // The aligned binary format can't be read by older versions, so it must
+    // be enabled explicitly
+    ParameterGrp::handle hGrp = App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Mod/Mesh");
+    Mesh::MeshObject::setAlignedBinaryFormat(hGrp->GetBool("AlignedBinaryFormat", false));
+
     Mesh::Feature               ::init();
     Mesh::FeaturePython         ::init();
     Mesh::Import                ::init();
@@ -89,6 +97,7 @@ void MeshExport initMesh()
     Mesh::Transform             ::init();
     Mesh::TransformDemolding    ::init();
     Mesh::Curvature             ::init();
+    Mesh::Decimation            ::init();
     Mesh::SegmentByMesh         ::init();
     Mesh::SetOperations         ::init();
     Mesh::FixDefects            ::init();
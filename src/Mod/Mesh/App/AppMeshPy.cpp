@@ -27,11 +27,14 @@
 #include <Base/Console.h>
 #include <Base/Interpreter.h>
 #include <Base/FileInfo.h>
+#include <Base/Stream.h>
 #include <App/Application.h>
 #include <App/Document.h>
 #include <App/DocumentObjectPy.h>
 #include <App/Property.h>
 #include <Base/PlacementPy.h>
+#include <Base/MatrixPy.h>
+#include <Base/BoundBoxPy.h>
 
 #include <CXX/Objects.hxx>
 #include <Base/VectorPy.h>
@@ -430,6 +433,108 @@ calculateEigenTransform(PyObject *self, PyObject *args)
 	Py_Return;
 }
 
+static PyObject *
+processSTL(PyObject *self, PyObject *args, PyObject *kwds)
+{
+    const char* input;
+    const char* output=0;
+    PyObject* trf=0;
+    PyObject* box=0;
+    PyObject* inside=Py_True;
+    PyObject* normal=0;
+    double angle=D_PI/2.0;
+    double cellSize=0.0;
+    PyObject* ascii=Py_False;
+    static char* keywords[] = {"input","output","transform","box","inside","normal",
+                               "angle","cellSize","ascii",NULL};
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "s|zOO!O!O!ddO!", keywords,
+        &input, &output, &trf, &(Base::BoundBoxPy::Type), &box, &PyBool_Type, &inside,
+        &(Base::VectorPy::Type), &normal, &angle, &cellSize, &PyBool_Type, &ascii))
+        return NULL;
+
+    Base::Matrix4D mat;
+    if (trf) {
+        if (PyObject_TypeCheck(trf, &(Base::MatrixPy::Type))) {
+            mat = *static_cast<Base::MatrixPy*>(trf)->getMatrixPtr();
+        }
+        else if (PyObject_TypeCheck(trf, &(Base::PlacementPy::Type))) {
+            mat = static_cast<Base::PlacementPy*>(trf)->getPlacementPtr()->toMatrix();
+        }
+        else {
+            PyErr_SetString(PyExc_TypeError, "transform must be a matrix or placement");
+            return NULL;
+        }
+    }
+    if (cellSize < 0.0) {
+        PyErr_SetString(PyExc_ValueError, "cell size must not be negative");
+        return NULL;
+    }
+
+    PY_TRY {
+        Base::FileInfo fi(input);
+        if (!fi.exists() || !fi.isFile())
+            throw Base::FileException("File does not exist",input);
+        Base::ifstream str(fi, std::ios::in | std::ios::binary);
+
+        // the stages are chained in a fixed order
+        MeshCore::MeshStreamPipeline pipe;
+        std::auto_ptr<MeshCore::MeshTransformStage> transformStage;
+        if (trf) {
+            transformStage.reset(new MeshCore::MeshTransformStage(mat));
+            pipe.AddStage(transformStage.get());
+        }
+        std::auto_ptr<MeshCore::MeshBoundBoxStage> boxStage;
+        if (box) {
+            Base::BoundBox3d* bb = static_cast<Base::BoundBoxPy*>(box)->getBoundBoxPtr();
+            Base::BoundBox3f bbf((float)bb->MinX, (float)bb->MinY, (float)bb->MinZ,
+                                 (float)bb->MaxX, (float)bb->MaxY, (float)bb->MaxZ);
+            boxStage.reset(new MeshCore::MeshBoundBoxStage(bbf, PyObject_IsTrue(inside) ? true : false));
+            pipe.AddStage(boxStage.get());
+        }
+        std::auto_ptr<MeshCore::MeshNormalStage> normalStage;
+        if (normal) {
+            Base::Vector3d* dir = static_cast<Base::VectorPy*>(normal)->getVectorPtr();
+            normalStage.reset(new MeshCore::MeshNormalStage(Base::Vector3f((float)dir->x, (float)dir->y, (float)dir->z), (float)angle));
+            pipe.AddStage(normalStage.get());
+        }
+        std::auto_ptr<MeshCore::MeshClusterStage> clusterStage;
+        if (cellSize > 0.0) {
+            clusterStage.reset(new MeshCore::MeshClusterStage((float)cellSize));
+            pipe.AddStage(clusterStage.get());
+        }
+        MeshCore::MeshStatisticsStage statStage;
+        pipe.AddStage(&statStage);
+
+        std::auto_ptr<Base::ofstream> out;
+        std::auto_ptr<MeshCore::MeshSTLWriterStage> writerStage;
+        if (output) {
+            Base::FileInfo fo(output);
+            out.reset(new Base::ofstream(fo, std::ios::out | std::ios::binary));
+            writerStage.reset(new MeshCore::MeshSTLWriterStage(*out, PyObject_IsTrue(ascii) ? true : false));
+            pipe.AddStage(writerStage.get());
+        }
+
+        if (!pipe.Process(str)) {
+            PyErr_SetString(PyExc_Exception, "Failed to process STL file");
+            return NULL;
+        }
+
+        const Base::BoundBox3f& bbox = statStage.GetBoundBox();
+        Py::Dict dict;
+        dict.setItem("Input", Py::Int((long)pipe.CountFacets()));
+        dict.setItem("Facets", Py::Int((long)statStage.CountFacets()));
+        dict.setItem("Degenerated", Py::Int((long)statStage.CountDegenerated()));
+        dict.setItem("Area", Py::Float(statStage.GetArea()));
+        dict.setItem("BoundBox", Py::Object(new Base::BoundBoxPy(new Base::BoundBox3d(
+            bbox.MinX, bbox.MinY, bbox.MinZ, bbox.MaxX, bbox.MaxY, bbox.MaxZ)), true));
+        if (clusterStage.get())
+            dict.setItem("Clusters", Py::Int((long)clusterStage->CountClusters()));
+        return Py::new_reference_to(dict);
+    } PY_CATCH;
+
+    Py_Return;
+}
+
 
 PyDoc_STRVAR(open_doc,
 "open(string) -- Create a new document and a Mesh::Import feature to load the file into the document.");
@@ -440,6 +545,17 @@ PyDoc_STRVAR(inst_doc,
 PyDoc_STRVAR(export_doc,
 "export(list,string) -- Export a list of objects into a single file.");
 
+PyDoc_STRVAR(processSTL_doc,
+"processSTL(input, [output, transform, box, inside, normal, angle, cellSize, ascii]) -- Stream the facets of an STL file.\n"
+"The facets are read one after another and passed through the given stages without\n"
+"loading the whole mesh, so even huge files need only a small amount of memory:\n"
+"transform -- a matrix or placement to move the facets\n"
+"box -- keep only the facets with the center inside the bounding box (or outside if inside=False)\n"
+"normal, angle -- keep only the facets whose normal deviates at most angle (radian) from normal\n"
+"cellSize -- decimate by merging all points inside cubes of this size\n"
+"output, ascii -- write the resulting facets to an STL file\n"
+"Returns a dict with the number of input facets and some numbers of the resulting facets.");
+
 PyDoc_STRVAR(calculateEigenTransform_doc,
 "calculateEigenTransform(seq(Base.Vector)) -- Calculates the eigen Transformation from a list of points.\n"
 "calculate the point's local coordinate system with the center\n"
@@ -464,5 +580,6 @@ struct PyMethodDef Mesh_Import_methods[] = {
     {"createCone",createCone, Py_NEWARGS,   "Create a tessellated cone"},
     {"createTorus",createTorus, Py_NEWARGS,   "Create a tessellated torus"},
     {"calculateEigenTransform",calculateEigenTransform, METH_VARARGS,   calculateEigenTransform_doc},
+    {"processSTL" ,(PyCFunction)processSTL, METH_VARARGS|METH_KEYWORDS, processSTL_doc},
     {NULL, NULL}  /* sentinel */
 };
@@ -27,8 +27,14 @@
 # include <algorithm>
 #endif
 
+#include <QFuture>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+
 #include "Algorithm.h"
 #include "Approximation.h"
+#include "BVH.h"
 #include "Elements.h"
 #include "Iterator.h"
 #include "Grid.h"
@@ -143,6 +149,12 @@ bool MeshAlgorithm::NearestFacetOnRay (const Base::Vector3f &rclPt, const Base::
     return false;
 }
 
+bool MeshAlgorithm::NearestFacetOnRay (const Base::Vector3f &rclPt, const Base::Vector3f &rclDir, const MeshFacetBVH &rclBVH,
+                                       Base::Vector3f &rclRes, unsigned long &rulFacet) const
+{
+    return rclBVH.NearestFacetOnRay(rclPt, rclDir, rclRes, rulFacet);
+}
+
 bool MeshAlgorithm::NearestFacetOnRay (const Base::Vector3f &rclPt, const Base::Vector3f &rclDir, const std::vector<unsigned long> &raulFacets,
                                        Base::Vector3f &rclRes, unsigned long &rulFacet) const
 {
@@ -286,6 +298,82 @@ void MeshAlgorithm::GetMeshBorders (std::list<std::vector<unsigned long> > &rclB
     GetFacetBorders(aulAllFacets, rclBorders, true);
 }
 
+void MeshAlgorithm::GetBoundaryLoops (std::list<std::vector<unsigned long> > &rclBorders) const
+{
+    const MeshFacetArray &rclFAry = _rclMesh._aclFacetArray;
+
+    // collect all open edges and sort them by both of their points
+    std::vector<std::pair<unsigned long, unsigned long> > aclEdges;
+    for (MeshFacetArray::_TConstIterator it = rclFAry.begin(); it != rclFAry.end(); ++it) {
+        for (int i = 0; i < 3; i++) {
+            if (it->_aulNeighbours[i] == ULONG_MAX)
+                aclEdges.push_back(it->GetEdge(i));
+        }
+    }
+
+    std::vector<std::pair<unsigned long, unsigned long> > aclPointEdges;
+    aclPointEdges.reserve(2 * aclEdges.size());
+    for (unsigned long i = 0; i < aclEdges.size(); i++) {
+        aclPointEdges.push_back(std::make_pair(aclEdges[i].first, i));
+        aclPointEdges.push_back(std::make_pair(aclEdges[i].second, i));
+    }
+    std::sort(aclPointEdges.begin(), aclPointEdges.end());
+
+    std::vector<bool> abUsed(aclEdges.size(), false);
+    for (unsigned long i = 0; i < aclEdges.size(); i++) {
+        if (abUsed[i])
+            continue;
+        abUsed[i] = true;
+        std::list<unsigned long> clBorder;
+        unsigned long ulFirst = aclEdges[i].first;
+        unsigned long ulLast  = aclEdges[i].second;
+        clBorder.push_back(ulFirst);
+        clBorder.push_back(ulLast);
+
+        // append edges to the end and, if the boundary cannot be closed, to the front
+        for (int iDir = 0; iDir < 2 && ulFirst != ulLast; iDir++) {
+            for (;;) {
+                unsigned long ulEnd = iDir == 0 ? ulLast : ulFirst;
+                std::vector<std::pair<unsigned long, unsigned long> >::iterator pB, pE;
+                pB = std::lower_bound(aclPointEdges.begin(), aclPointEdges.end(), std::make_pair(ulEnd, 0ul));
+                pE = std::lower_bound(pB, aclPointEdges.end(), std::make_pair(ulEnd, ULONG_MAX));
+
+                // prefer an edge with the right orientation
+                unsigned long ulNext = ULONG_MAX;
+                for (std::vector<std::pair<unsigned long, unsigned long> >::iterator pI = pB; pI != pE; ++pI) {
+                    if (abUsed[pI->second])
+                        continue;
+                    const std::pair<unsigned long, unsigned long>& rclEdge = aclEdges[pI->second];
+                    bool bOriented = iDir == 0 ? rclEdge.first == ulEnd : rclEdge.second == ulEnd;
+                    if (bOriented || ulNext == ULONG_MAX)
+                        ulNext = pI->second;
+                    if (bOriented)
+                        break;
+                }
+
+                if (ulNext == ULONG_MAX)
+                    break;
+                abUsed[ulNext] = true;
+                const std::pair<unsigned long, unsigned long>& rclEdge = aclEdges[ulNext];
+                unsigned long ulPoint = rclEdge.first == ulEnd ? rclEdge.second : rclEdge.first;
+                if (iDir == 0) {
+                    ulLast = ulPoint;
+                    clBorder.push_back(ulLast);
+                }
+                else {
+                    ulFirst = ulPoint;
+                    clBorder.push_front(ulFirst);
+                }
+
+                if (ulFirst == ulLast)
+                    break; // closed polyline
+            }
+        }
+
+        rclBorders.push_back(std::vector<unsigned long>(clBorder.begin(), clBorder.end()));
+    }
+}
+
 void MeshAlgorithm::GetFacetBorders (const std::vector<unsigned long> &raulInd, std::list<std::vector<Base::Vector3f> > &rclBorders) const
 {
 #if 1
@@ -1401,6 +1489,12 @@ bool MeshAlgorithm::NearestPointFromPoint (const Base::Vector3f &rclPt, const Me
   return true;
 }
 
+bool MeshAlgorithm::NearestPointFromPoint (const Base::Vector3f &rclPt, const MeshFacetBVH& rclBVH,
+                                           unsigned long &rclResFacetIndex, Base::Vector3f &rclResPoint) const
+{
+  return rclBVH.NearestPointFromPoint(rclPt, rclResFacetIndex, rclResPoint);
+}
+
 bool MeshAlgorithm::CutWithPlane (const Base::Vector3f &clBase, const Base::Vector3f &clNormal, const MeshFacetGrid &rclGrid,
                                   std::list<std::vector<Base::Vector3f> > &rclResult, float fMinEps, bool bConnectPolygons) const
 {
@@ -1965,3 +2059,271 @@ MeshRefNormalToPoints::operator[] (unsigned long pos) const
 {
     return _norm[pos];
 }
+
+//----------------------------------------------------------------------------
+
+void MeshAdjacencyTable::BuildRows (unsigned long ulCount)
+{
+    std::vector<RowRange> ranges;
+    int threads = QThread::idealThreadCount();
+    if (ulCount < MESH_CT_PARALLEL_ADJACENCY || threads <= 1) {
+        RowRange range;
+        range.ulBegin = 0;
+        range.ulEnd = ulCount;
+        ranges.push_back(range);
+        CollectRows(ranges.front());
+    }
+    else {
+        // use more ranges than threads to balance the work load
+        unsigned long ulCtRanges = 4 * (unsigned long)threads;
+        unsigned long ulStep = (ulCount + ulCtRanges - 1) / ulCtRanges;
+        for (unsigned long i = 0; i < ulCount; i += ulStep) {
+            RowRange range;
+            range.ulBegin = i;
+            range.ulEnd = std::min<unsigned long>(i + ulStep, ulCount);
+            ranges.push_back(range);
+        }
+
+        QFuture<void> future = QtConcurrent::map(ranges, boost::bind(&MeshAdjacencyTable::CollectRows, this, _1));
+        future.waitForFinished();
+    }
+
+    // the offsets of all rows, then copy the rows to their place
+    _aulOffsets.resize(ulCount + 1);
+    _aulOffsets[0] = 0;
+    for (std::vector<RowRange>::iterator it = ranges.begin(); it != ranges.end(); ++it) {
+        for (unsigned long i = it->ulBegin; i < it->ulEnd; i++)
+            _aulOffsets[i + 1] = _aulOffsets[i] + it->aulCounts[i - it->ulBegin];
+    }
+    _aulNeighbours.resize(_aulOffsets.back());
+
+    if (ranges.size() == 1) {
+        StoreRows(ranges.front());
+    }
+    else {
+        QFuture<void> future = QtConcurrent::map(ranges, boost::bind(&MeshAdjacencyTable::StoreRows, this, _1));
+        future.waitForFinished();
+    }
+}
+
+void MeshAdjacencyTable::StoreRows (RowRange &rclRange)
+{
+    std::copy(rclRange.aulNeighbours.begin(), rclRange.aulNeighbours.end(),
+              _aulNeighbours.begin() + _aulOffsets[rclRange.ulBegin]);
+    std::vector<unsigned long>().swap(rclRange.aulNeighbours);
+}
+
+//----------------------------------------------------------------------------
+
+void MeshCompactPointToFacets::Rebuild (void)
+{
+    // A counting sort of the corners by their points. Since the facets are
+    // visited in ascending order the rows are already sorted.
+    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
+    unsigned long ulCtPoints = _rclMesh.CountPoints();
+    _aulOffsets.assign(ulCtPoints + 1, 0);
+    for (MeshFacetArray::_TConstIterator pFIter = rFacets.begin(); pFIter != rFacets.end(); ++pFIter) {
+        _aulOffsets[pFIter->_aulPoints[0] + 1]++;
+        _aulOffsets[pFIter->_aulPoints[1] + 1]++;
+        _aulOffsets[pFIter->_aulPoints[2] + 1]++;
+    }
+    for (unsigned long i = 0; i < ulCtPoints; i++)
+        _aulOffsets[i + 1] += _aulOffsets[i];
+
+    _aulNeighbours.resize(_aulOffsets.back());
+    std::vector<unsigned long> fill(_aulOffsets.begin(), _aulOffsets.end() - 1);
+    MeshFacetArray::_TConstIterator pFBegin = rFacets.begin();
+    for (MeshFacetArray::_TConstIterator pFIter = rFacets.begin(); pFIter != rFacets.end(); ++pFIter) {
+        for (int i = 0; i < 3; i++) {
+            unsigned long& pos = fill[pFIter->_aulPoints[i]];
+            // a point referenced twice by a facet
+            if (pos > _aulOffsets[pFIter->_aulPoints[i]] && _aulNeighbours[pos - 1] == (unsigned long)(pFIter - pFBegin))
+                continue;
+            _aulNeighbours[pos++] = pFIter - pFBegin;
+        }
+    }
+
+    // remove the gaps left by corrupted facets
+    bool gaps = false;
+    for (unsigned long i = 0; i < ulCtPoints && !gaps; i++)
+        gaps = fill[i] != _aulOffsets[i + 1];
+    if (gaps) {
+        unsigned long pos = 0;
+        for (unsigned long i = 0; i < ulCtPoints; i++) {
+            unsigned long begin = _aulOffsets[i];
+            _aulOffsets[i] = pos;
+            for (unsigned long j = begin; j < fill[i]; j++)
+                _aulNeighbours[pos++] = _aulNeighbours[j];
+        }
+        _aulOffsets[ulCtPoints] = pos;
+        _aulNeighbours.resize(pos);
+    }
+}
+
+Base::Vector3f MeshCompactPointToFacets::GetNormal(unsigned long pos) const
+{
+    MeshNeighbourRange n = (*this)[pos];
+    Base::Vector3f normal;
+    MeshGeomFacet f;
+    for (MeshNeighbourRange::const_iterator it = n.begin(); it != n.end(); ++it) {
+        f = _rclMesh.GetFacet(*it);
+        normal += f.Area() * f.GetNormal();
+    }
+
+    normal.Normalize();
+    return normal;
+}
+
+std::set<unsigned long> MeshCompactPointToFacets::NeighbourPoints(const std::vector<unsigned long>& pt, int level) const
+{
+    std::set<unsigned long> cp,nb,lp;
+    cp.insert(pt.begin(), pt.end());
+    lp.insert(pt.begin(), pt.end());
+    MeshFacetArray::_TConstIterator f_it = _rclMesh.GetFacets().begin();
+    for (int i=0; i < level; i++) {
+        std::set<unsigned long> cur;
+        for (std::set<unsigned long>::iterator it = lp.begin(); it != lp.end(); ++it) {
+            MeshNeighbourRange ft = (*this)[*it];
+            for (MeshNeighbourRange::const_iterator jt = ft.begin(); jt != ft.end(); ++jt) {
+                for (int j = 0; j < 3; j++) {
+                    unsigned long index = f_it[*jt]._aulPoints[j];
+                    if (cp.find(index) == cp.end() && nb.find(index) == nb.end()) {
+                        nb.insert(index);
+                        cur.insert(index);
+                    }
+                }
+            }
+        }
+
+        lp = cur;
+        if (lp.empty())
+            break;
+    }
+    return nb;
+}
+
+void MeshCompactPointToFacets::Neighbours (unsigned long ulFacetInd, float fMaxDist, MeshCollector& collect) const
+{
+    std::set<unsigned long> visited;
+    Base::Vector3f  clCenter = _rclMesh.GetFacet(ulFacetInd).GetGravityPoint();
+
+    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
+    SearchNeighbours(rFacets, ulFacetInd, clCenter, fMaxDist * fMaxDist, visited, collect);
+}
+
+void MeshCompactPointToFacets::SearchNeighbours(const MeshFacetArray& rFacets, unsigned long index, const Base::Vector3f &rclCenter,
+                                                float fMaxDist2, std::set<unsigned long>& visited, MeshCollector& collect) const
+{
+    if (visited.find(index) != visited.end())
+        return;
+
+    const MeshFacet& face = rFacets[index];
+    if (Base::DistanceP2(rclCenter, _rclMesh.GetFacet(face).GetGravityPoint()) > fMaxDist2)
+        return;
+
+    visited.insert(index);
+    collect.Append(_rclMesh, index);
+    for (int i = 0; i < 3; i++) {
+        MeshNeighbourRange f = (*this)[face._aulPoints[i]];
+
+        for (MeshNeighbourRange::const_iterator j = f.begin(); j != f.end(); ++j) {
+            SearchNeighbours(rFacets, *j, rclCenter, fMaxDist2, visited, collect);
+        }
+    }
+}
+
+MeshFacetArray::_TConstIterator
+MeshCompactPointToFacets::GetFacet (unsigned long index) const
+{
+    return _rclMesh.GetFacets().begin() + index;
+}
+
+//----------------------------------------------------------------------------
+
+void MeshCompactFacetToFacets::Rebuild (void)
+{
+    MeshCompactPointToFacets vertexFace(_rclMesh);
+    _pclPointToFacets = &vertexFace;
+    BuildRows(_rclMesh.CountFacets());
+    _pclPointToFacets = 0;
+}
+
+void MeshCompactFacetToFacets::CollectRows (RowRange &rclRange) const
+{
+    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
+    std::vector<unsigned long> row;
+    rclRange.aulCounts.resize(rclRange.ulEnd - rclRange.ulBegin);
+    for (unsigned long index = rclRange.ulBegin; index < rclRange.ulEnd; index++) {
+        const MeshFacet& face = rFacets[index];
+        row.clear();
+        for (int i = 0; i < 3; i++) {
+            MeshNeighbourRange faces = (*_pclPointToFacets)[face._aulPoints[i]];
+            row.insert(row.end(), faces.begin(), faces.end());
+        }
+        std::sort(row.begin(), row.end());
+        row.erase(std::unique(row.begin(), row.end()), row.end());
+        rclRange.aulCounts[index - rclRange.ulBegin] = row.size();
+        rclRange.aulNeighbours.insert(rclRange.aulNeighbours.end(), row.begin(), row.end());
+    }
+}
+
+//----------------------------------------------------------------------------
+
+void MeshCompactPointToPoints::Rebuild (void)
+{
+    MeshCompactPointToFacets vertexFace(_rclMesh);
+    _pclPointToFacets = &vertexFace;
+    BuildRows(_rclMesh.CountPoints());
+    _pclPointToFacets = 0;
+}
+
+void MeshCompactPointToPoints::CollectRows (RowRange &rclRange) const
+{
+    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
+    std::vector<unsigned long> row;
+    rclRange.aulCounts.resize(rclRange.ulEnd - rclRange.ulBegin);
+    for (unsigned long index = rclRange.ulBegin; index < rclRange.ulEnd; index++) {
+        MeshNeighbourRange faces = (*_pclPointToFacets)[index];
+        row.clear();
+        for (MeshNeighbourRange::const_iterator it = faces.begin(); it != faces.end(); ++it) {
+            const MeshFacet& face = rFacets[*it];
+            for (int i = 0; i < 3; i++) {
+                if (face._aulPoints[i] != index)
+                    row.push_back(face._aulPoints[i]);
+            }
+        }
+        std::sort(row.begin(), row.end());
+        row.erase(std::unique(row.begin(), row.end()), row.end());
+        rclRange.aulCounts[index - rclRange.ulBegin] = row.size();
+        rclRange.aulNeighbours.insert(rclRange.aulNeighbours.end(), row.begin(), row.end());
+    }
+}
+
+Base::Vector3f MeshCompactPointToPoints::GetNormal(unsigned long pos) const
+{
+    const MeshPointArray& rPoints = _rclMesh.GetPoints();
+    MeshCore::PlaneFit pf;
+    pf.AddPoint(rPoints[pos]);
+    MeshNeighbourRange cv = (*this)[pos];
+    for (MeshNeighbourRange::const_iterator cv_it = cv.begin(); cv_it !=cv.end(); ++cv_it) {
+        pf.AddPoint(rPoints[*cv_it]);
+    }
+
+    pf.Fit();
+
+    Base::Vector3f normal = pf.GetNormal();
+    normal.Normalize();
+    return normal;
+}
+
+float MeshCompactPointToPoints::GetAverageEdgeLength(unsigned long index) const
+{
+    const MeshPointArray& rPoints = _rclMesh.GetPoints();
+    float len=0.0f;
+    MeshNeighbourRange n = (*this)[index];
+    const Base::Vector3f& p = rPoints[index];
+    for (MeshNeighbourRange::const_iterator it = n.begin(); it != n.end(); ++it) {
+        len += Base::Distance(p, rPoints[*it]);
+    }
+    return (len/n.size());
+}
@@ -32,6 +32,8 @@
 #include "Elements.h"
 #include <Base/Vector3D.h>
 
+#define  MESH_CT_PARALLEL_ADJACENCY 100000  // Minimum number of elements to build an adjacency table in parallel
+
 // forward declarations
 
 namespace Base{
@@ -45,6 +47,7 @@ class MeshGeomFacet;
 class MeshGeomEdge;
 class MeshKernel;
 class MeshFacetGrid;
+class MeshFacetBVH;
 class MeshFacetArray;
 class MeshRefPointToFacets;
 class AbstractPolygonTriangulator;
@@ -100,6 +103,14 @@ public:
    */
   bool NearestFacetOnRay (const Base::Vector3f &rclPt, const Base::Vector3f &rclDir, float fMaxSearchArea,
                           const MeshFacetGrid &rclGrid, Base::Vector3f &rclRes, unsigned long &rulFacet) const;
+  /**
+   * Searches for the nearest facet to the ray defined by (\a rclPt, \a rclDir) in direction of \a rclDir.
+   * The point \a rclRes holds the intersection point with the ray and the nearest facet with index \a rulFacet.
+   * \note This method is optimized by using a bounding volume hierarchy. Unlike the grid its performance
+   * doesn't depend on the facet density of the mesh.
+   */
+  bool NearestFacetOnRay (const Base::Vector3f &rclPt, const Base::Vector3f &rclDir, const MeshFacetBVH &rclBVH,
+                          Base::Vector3f &rclRes, unsigned long &rulFacet) const;
   /**
    * Searches for the first facet of the grid element (\a rclGrid) in that the point \a rclPt lies into which is a distance not
    * higher than \a fMaxDistance. Of no such facet is found \a rulFacet is undefined and false is returned, otherwise true.
@@ -128,6 +139,14 @@ public:
    * of the boundaries.
    */
   void GetMeshBorders (std::list<std::vector<unsigned long> > &rclBorders) const;
+  /**
+   * Returns all boundaries of the mesh as point indices. In contrast to GetMeshBorders() the
+   * open edges are looked up by their points instead of searching the list of all open edges
+   * for each boundary point. So, this method is also fast for meshes with thousands of holes.
+   * Like GetMeshBorders() this method ignores the orientation of facets and it doesn't split
+   * boundaries passing a point twice.
+   */
+  void GetBoundaryLoops (std::list<std::vector<unsigned long> > &rclBorders) const;
   /**
    * Returns all boundaries of a subset the mesh defined by \a raulInd.
    */
@@ -276,6 +295,8 @@ public:
                               unsigned long &rclResFacetIndex, Base::Vector3f &rclResPoint) const;
   bool NearestPointFromPoint (const Base::Vector3f &rclPt, const MeshFacetGrid& rclGrid, float fMaxSearchArea,
                               unsigned long &rclResFacetIndex, Base::Vector3f &rclResPoint) const;
+  bool NearestPointFromPoint (const Base::Vector3f &rclPt, const MeshFacetBVH& rclBVH,
+                              unsigned long &rclResFacetIndex, Base::Vector3f &rclResPoint) const;
   /** Cuts the mesh with a plane. The result is a list of polylines. */
   bool CutWithPlane (const Base::Vector3f &clBase, const Base::Vector3f &clNormal, const MeshFacetGrid &rclGrid,
                      std::list<std::vector<Base::Vector3f> > &rclResult, float fMinEps = 1.0e-2f, bool bConnectPolygons = false) const;
@@ -506,6 +527,145 @@ protected:
     std::vector<Base::Vector3f> _norm;
 };
 
+/**
+ * The MeshNeighbourRange class gives access to the neighbours of an element in
+ * one of the compact adjacency tables. The neighbours are sorted ascending.
+ */
+class MeshExport MeshNeighbourRange
+{
+public:
+    typedef const unsigned long* const_iterator;
+
+    MeshNeighbourRange (const_iterator pBegin, const_iterator pEnd)
+      : _pBegin(pBegin), _pEnd(pEnd) { }
+
+    const_iterator begin (void) const { return _pBegin; }
+    const_iterator end (void) const { return _pEnd; }
+    std::size_t size (void) const { return _pEnd - _pBegin; }
+    bool empty (void) const { return _pBegin == _pEnd; }
+
+private:
+    const_iterator _pBegin, _pEnd;
+};
+
+/**
+ * The MeshAdjacencyTable class is the base of the compact variants of the
+ * MeshRef... classes. Instead of a std::set per element all neighbours are
+ * stored in one array and each element references its part of the array by
+ * an offset (compressed sparse rows). This needs a fraction of the memory and
+ * no allocation per element. The tables that are derived from the points of
+ * the facets are built on all cores.
+ * \note The tables cannot be modified, if the underlying mesh kernel gets
+ * changed they become invalid and must be rebuilt.
+ */
+class MeshExport MeshAdjacencyTable
+{
+public:
+    /// Construction
+    MeshAdjacencyTable (const MeshKernel &rclM) : _rclMesh(rclM) { }
+    /// Destruction
+    virtual ~MeshAdjacencyTable (void) { }
+
+    /// Rebuilds up data structure
+    virtual void Rebuild (void) = 0;
+    /// Returns the neighbours of the element with index \a ulIndex.
+    MeshNeighbourRange operator[] (unsigned long ulIndex) const
+    {
+        const unsigned long* pData = _aulNeighbours.empty() ? 0 : &(_aulNeighbours[0]);
+        return MeshNeighbourRange(pData + _aulOffsets[ulIndex], pData + _aulOffsets[ulIndex + 1]);
+    }
+    /// Returns the number of elements.
+    unsigned long Count (void) const
+    { return _aulOffsets.empty() ? 0 : (unsigned long)(_aulOffsets.size() - 1); }
+    /// Returns the number of required memory in bytes
+    std::size_t GetMemSize (void) const
+    { return (_aulOffsets.size() + _aulNeighbours.size()) * sizeof(unsigned long); }
+
+protected:
+    /** The rows of a range of elements. */
+    struct RowRange
+    {
+        unsigned long ulBegin, ulEnd;
+        std::vector<unsigned long> aulCounts, aulNeighbours;
+    };
+
+    /** Fills in the rows of \a rclRange, called in parallel by BuildRows(). */
+    virtual void CollectRows (RowRange &) const { }
+    /** Builds the table of \a ulCount elements with CollectRows(). */
+    void BuildRows (unsigned long ulCount);
+    /** Copies the rows of \a rclRange to the table. */
+    void StoreRows (RowRange &rclRange);
+
+protected:
+    const MeshKernel  &_rclMesh; /**< The mesh kernel. */
+    std::vector<unsigned long> _aulOffsets;    /**< Start of the neighbours of each element, plus the end. */
+    std::vector<unsigned long> _aulNeighbours; /**< The neighbours of all elements. */
+};
+
+/**
+ * The MeshCompactPointToFacets class is the compact variant of MeshRefPointToFacets.
+ */
+class MeshExport MeshCompactPointToFacets : public MeshAdjacencyTable
+{
+public:
+    /// Construction
+    MeshCompactPointToFacets (const MeshKernel &rclM) : MeshAdjacencyTable(rclM)
+    { Rebuild(); }
+
+    /// Rebuilds up data structure
+    void Rebuild (void);
+    MeshFacetArray::_TConstIterator GetFacet (unsigned long) const;
+    std::set<unsigned long> NeighbourPoints(const std::vector<unsigned long>& , int level) const;
+    void Neighbours (unsigned long ulFacetInd, float fMaxDist, MeshCollector& collect) const;
+    Base::Vector3f GetNormal(unsigned long) const;
+
+protected:
+    void SearchNeighbours(const MeshFacetArray& rFacets, unsigned long index, const Base::Vector3f &rclCenter, 
+        float fMaxDist, std::set<unsigned long> &visit, MeshCollector& collect) const;
+};
+
+/**
+ * The MeshCompactFacetToFacets class is the compact variant of MeshRefFacetToFacets.
+ */
+class MeshExport MeshCompactFacetToFacets : public MeshAdjacencyTable
+{
+public:
+    /// Construction
+    MeshCompactFacetToFacets (const MeshKernel &rclM) : MeshAdjacencyTable(rclM)
+    { Rebuild(); }
+
+    /// Rebuilds up data structure
+    void Rebuild (void);
+
+protected:
+    void CollectRows (RowRange &rclRange) const;
+
+private:
+    const MeshCompactPointToFacets* _pclPointToFacets;
+};
+
+/**
+ * The MeshCompactPointToPoints class is the compact variant of MeshRefPointToPoints.
+ */
+class MeshExport MeshCompactPointToPoints : public MeshAdjacencyTable
+{
+public:
+    /// Construction
+    MeshCompactPointToPoints (const MeshKernel &rclM) : MeshAdjacencyTable(rclM)
+    { Rebuild(); }
+
+    /// Rebuilds up data structure
+    void Rebuild (void);
+    Base::Vector3f GetNormal(unsigned long) const;
+    float GetAverageEdgeLength(unsigned long) const;
+
+protected:
+    void CollectRows (RowRange &rclRange) const;
+
+private:
+    const MeshCompactPointToFacets* _pclPointToFacets;
+};
+
 }; // namespace MeshCore 
 
 #endif  // MESH_ALGORITHM_H 
@@ -0,0 +1,889 @@
+/***************************************************************************
+ *   Copyright (c) 2012 Imetric 3D GmbH                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <algorithm>
+#endif
+
+#include <QFuture>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+
+#include "BVH.h"
+#include "Elements.h"
+#include "MeshKernel.h"
+
+using namespace MeshCore;
+
+namespace MeshCore {
+
+/** Surface area of a box, used as probability measure of the SAH. */
+static inline float HalfArea (const Base::BoundBox3f &rclBox)
+{
+  if (!rclBox.IsValid())
+    return 0.0f;
+  float fX = rclBox.LengthX(), fY = rclBox.LengthY(), fZ = rclBox.LengthZ();
+  return fX * fY + fY * fZ + fZ * fX;
+}
+
+/** Predicate to partition the facets at a bin boundary. */
+struct BVHBinPredicate
+{
+  BVHBinPredicate (const std::vector<Base::Vector3f> &rclCentroids, int iAxis,
+                   float fMin, float fScale, int iSplit)
+    : _rclCentroids(rclCentroids), _iAxis(iAxis), _fMin(fMin), _fScale(fScale), _iSplit(iSplit)
+  {
+  }
+  int Bin (unsigned long ulFacet) const
+  {
+    int iBin = int((_rclCentroids[ulFacet][_iAxis] - _fMin) * _fScale);
+    return std::min<int>(iBin, MESH_BVH_CT_BINS - 1);
+  }
+  bool operator () (unsigned long ulFacet) const
+  {
+    return Bin(ulFacet) < _iSplit;
+  }
+
+  const std::vector<Base::Vector3f> &_rclCentroids;
+  int _iAxis;
+  float _fMin, _fScale;
+  int _iSplit;
+};
+
+}
+
+MeshFacetBVH::MeshFacetBVH (const MeshKernel &rclM)
+  : _pclMesh(&rclM)
+{
+  Rebuild();
+}
+
+MeshFacetBVH::MeshFacetBVH (void)
+  : _pclMesh(NULL)
+{
+}
+
+void MeshFacetBVH::Attach (const MeshKernel &rclM)
+{
+  _pclMesh = &rclM;
+  Rebuild();
+}
+
+void MeshFacetBVH::SetBounds (Node &rclNode, const std::vector<Base::BoundBox3f> &raclBoxes) const
+{
+  Base::BoundBox3f clBox;
+  for (unsigned long i = rclNode.uiIndex; i < rclNode.uiIndex + rclNode.uiCount; i++)
+    clBox.Add(raclBoxes[_aulFacets[i]]);
+
+  rclNode.afMin[0] = clBox.MinX; rclNode.afMin[1] = clBox.MinY; rclNode.afMin[2] = clBox.MinZ;
+  rclNode.afMax[0] = clBox.MaxX; rclNode.afMax[1] = clBox.MaxY; rclNode.afMax[2] = clBox.MaxZ;
+}
+
+void MeshFacetBVH::Rebuild (void)
+{
+  _aclNodes.clear();
+  _aulFacets.clear();
+  _aclVertices.clear();
+
+  if (!_pclMesh || _pclMesh->CountFacets() == 0)
+    return;
+
+  const MeshPointArray& rclPoints = _pclMesh->GetPoints();
+  const MeshFacetArray& rclFacets = _pclMesh->GetFacets();
+  unsigned long ulCtFacets = rclFacets.size();
+
+  // bounding boxes and centroids of all facets
+  std::vector<Base::BoundBox3f> aclBoxes(ulCtFacets);
+  std::vector<Base::Vector3f> aclCentroids(ulCtFacets);
+  for (unsigned long i = 0; i < ulCtFacets; i++) {
+    const MeshFacet& rclFacet = rclFacets[i];
+    Base::BoundBox3f& rclBox = aclBoxes[i];
+    rclBox.Add(rclPoints[rclFacet._aulPoints[0]]);
+    rclBox.Add(rclPoints[rclFacet._aulPoints[1]]);
+    rclBox.Add(rclPoints[rclFacet._aulPoints[2]]);
+    aclCentroids[i] = rclBox.CalcCenter();
+  }
+
+  _aulFacets.resize(ulCtFacets);
+  for (unsigned long i = 0; i < ulCtFacets; i++)
+    _aulFacets[i] = i;
+
+  // top-down build, the children of a node get allocated in pairs
+  _aclNodes.reserve(2 * ulCtFacets / MESH_BVH_MAX_LEAF_SIZE + 1);
+  Node clRoot;
+  clRoot.uiIndex = 0;
+  clRoot.uiCount = (unsigned int)ulCtFacets;
+  SetBounds(clRoot, aclBoxes);
+  _aclNodes.push_back(clRoot);
+
+  std::vector<unsigned long> aulStack;
+  aulStack.push_back(0);
+  while (!aulStack.empty()) {
+    unsigned long ulNode = aulStack.back();
+    aulStack.pop_back();
+
+    unsigned long ulBegin = _aclNodes[ulNode].uiIndex;
+    unsigned long ulEnd = ulBegin + _aclNodes[ulNode].uiCount;
+    unsigned long ulMid;
+    if (ulEnd - ulBegin <= MESH_BVH_MAX_LEAF_SIZE ||
+        !Split(ulBegin, ulEnd, aclCentroids, aclBoxes, ulMid))
+      continue; // keep as leaf
+
+    Node clLeft, clRight;
+    clLeft.uiIndex = (unsigned int)ulBegin;
+    clLeft.uiCount = (unsigned int)(ulMid - ulBegin);
+    clRight.uiIndex = (unsigned int)ulMid;
+    clRight.uiCount = (unsigned int)(ulEnd - ulMid);
+    SetBounds(clLeft, aclBoxes);
+    SetBounds(clRight, aclBoxes);
+
+    unsigned long ulChild = _aclNodes.size();
+    _aclNodes[ulNode].uiIndex = (unsigned int)ulChild;
+    _aclNodes[ulNode].uiCount = 0;
+    _aclNodes.push_back(clLeft);
+    _aclNodes.push_back(clRight);
+    aulStack.push_back(ulChild);
+    aulStack.push_back(ulChild + 1);
+  }
+
+  // copy the vertices in leaf order
+  _aclVertices.resize(3 * ulCtFacets);
+  for (unsigned long i = 0; i < ulCtFacets; i++) {
+    const MeshFacet& rclFacet = rclFacets[_aulFacets[i]];
+    _aclVertices[3*i  ] = rclPoints[rclFacet._aulPoints[0]];
+    _aclVertices[3*i+1] = rclPoints[rclFacet._aulPoints[1]];
+    _aclVertices[3*i+2] = rclPoints[rclFacet._aulPoints[2]];
+  }
+}
+
+bool MeshFacetBVH::Split (unsigned long ulBegin, unsigned long ulEnd, const std::vector<Base::Vector3f> &raclCentroids,
+                          const std::vector<Base::BoundBox3f> &raclBoxes, unsigned long &rulMid)
+{
+  // bounds of the centroids, the bins are distributed over this range
+  Base::BoundBox3f clCenterBox, clNodeBox;
+  for (unsigned long i = ulBegin; i < ulEnd; i++) {
+    clCenterBox.Add(raclCentroids[_aulFacets[i]]);
+    clNodeBox.Add(raclBoxes[_aulFacets[i]]);
+  }
+
+  float afMin[3] = { clCenterBox.MinX, clCenterBox.MinY, clCenterBox.MinZ };
+  float afLen[3] = { clCenterBox.LengthX(), clCenterBox.LengthY(), clCenterBox.LengthZ() };
+
+  float fBestCost = FLOAT_MAX;
+  int iBestAxis = -1, iBestSplit = 0;
+  for (int iAxis = 0; iAxis < 3; iAxis++) {
+    if (afLen[iAxis] <= 0.0f)
+      continue;
+
+    float fScale = float(MESH_BVH_CT_BINS) / afLen[iAxis];
+    BVHBinPredicate clBins(raclCentroids, iAxis, afMin[iAxis], fScale, 0);
+
+    unsigned long aulCount[MESH_BVH_CT_BINS];
+    Base::BoundBox3f aclBinBox[MESH_BVH_CT_BINS];
+    for (int j = 0; j < MESH_BVH_CT_BINS; j++)
+      aulCount[j] = 0;
+    for (unsigned long i = ulBegin; i < ulEnd; i++) {
+      int iBin = clBins.Bin(_aulFacets[i]);
+      aulCount[iBin]++;
+      aclBinBox[iBin].Add(raclBoxes[_aulFacets[i]]);
+    }
+
+    // sweep from the right to get the cost of all right sides
+    float afRightArea[MESH_BVH_CT_BINS];
+    unsigned long aulRightCount[MESH_BVH_CT_BINS];
+    Base::BoundBox3f clBox;
+    unsigned long ulCount = 0;
+    for (int j = MESH_BVH_CT_BINS - 1; j > 0; j--) {
+      clBox.Add(aclBinBox[j]);
+      ulCount += aulCount[j];
+      afRightArea[j] = HalfArea(clBox);
+      aulRightCount[j] = ulCount;
+    }
+
+    // sweep from the left and evaluate the split after bin j-1
+    clBox = Base::BoundBox3f();
+    ulCount = 0;
+    for (int j = 1; j < MESH_BVH_CT_BINS; j++) {
+      clBox.Add(aclBinBox[j-1]);
+      ulCount += aulCount[j-1];
+      if (ulCount == 0 || aulRightCount[j] == 0)
+        continue;
+      float fCost = HalfArea(clBox) * ulCount + afRightArea[j] * aulRightCount[j];
+      if (fCost < fBestCost) {
+        fBestCost = fCost;
+        iBestAxis = iAxis;
+        iBestSplit = j;
+      }
+    }
+  }
+
+  // all centroids coincide
+  if (iBestAxis < 0)
+    return false;
+
+  // compare with the cost of a leaf, a traversal step is assumed to be as
+  // expensive as one facet test
+  float fArea = HalfArea(clNodeBox);
+  float fLeafCost = float(ulEnd - ulBegin);
+  if (fArea > 0.0f && 1.0f + fBestCost / fArea >= fLeafCost)
+    return false;
+
+  float fScale = float(MESH_BVH_CT_BINS) / afLen[iBestAxis];
+  BVHBinPredicate clPred(raclCentroids, iBestAxis, afMin[iBestAxis], fScale, iBestSplit);
+  std::vector<unsigned long>::iterator it = std::partition
+    (_aulFacets.begin() + ulBegin, _aulFacets.begin() + ulEnd, clPred);
+  rulMid = it - _aulFacets.begin();
+  return true;
+}
+
+Base::BoundBox3f MeshFacetBVH::GetBoundBox (void) const
+{
+  if (_aclNodes.empty())
+    return Base::BoundBox3f();
+  const Node& rclRoot = _aclNodes.front();
+  return Base::BoundBox3f(rclRoot.afMin[0], rclRoot.afMin[1], rclRoot.afMin[2],
+                          rclRoot.afMax[0], rclRoot.afMax[1], rclRoot.afMax[2]);
+}
+
+namespace MeshCore {
+
+/** Slab test of a ray with the box of a node. Returns the entry parameter
+ * or FLOAT_MAX if the box is missed or farther than \a fMaxT. */
+static inline float RayBoxEntry (const float afMin[3], const float afMax[3], const float afOrg[3],
+                                 const float afInvDir[3], float fMaxT)
+{
+  float fNear = 0.0f, fFar = fMaxT;
+  for (int i = 0; i < 3; i++) {
+    float fT0 = (afMin[i] - afOrg[i]) * afInvDir[i];
+    float fT1 = (afMax[i] - afOrg[i]) * afInvDir[i];
+    if (fT0 > fT1)
+      std::swap(fT0, fT1);
+    fNear = std::max<float>(fNear, fT0);
+    fFar = std::min<float>(fFar, fT1);
+    if (fNear > fFar)
+      return FLOAT_MAX;
+  }
+  return fNear;
+}
+
+/** Squared distance of a point to the box of a node. */
+static inline float PointBoxDistance2 (const float afMin[3], const float afMax[3], const Base::Vector3f &rclPt)
+{
+  float fDist2 = 0.0f;
+  for (int i = 0; i < 3; i++) {
+    float fD = 0.0f;
+    if (rclPt[i] < afMin[i])
+      fD = afMin[i] - rclPt[i];
+    else if (rclPt[i] > afMax[i])
+      fD = rclPt[i] - afMax[i];
+    fDist2 += fD * fD;
+  }
+  return fDist2;
+}
+
+}
+
+bool MeshFacetBVH::TraceRay (const Base::Vector3f &rclPt, const Base::Vector3f &rclDir, Base::Vector3f &rclRes,
+                             unsigned long &rulFacet, std::vector<unsigned int> &rauiStack) const
+{
+  if (_aclNodes.empty())
+    return false;
+
+  float afOrg[3] = { rclPt.x, rclPt.y, rclPt.z };
+  float afInvDir[3];
+  for (int i = 0; i < 3; i++) {
+    if (rclDir[i] != 0.0f)
+      afInvDir[i] = 1.0f / rclDir[i];
+    else // avoids 0*inf if the origin lies on a slab
+      afInvDir[i] = FLOAT_MAX;
+  }
+
+  float fBestT = FLOAT_MAX;
+  unsigned long ulBest = ULONG_MAX;
+
+  rauiStack.clear();
+  if (RayBoxEntry(_aclNodes[0].afMin, _aclNodes[0].afMax, afOrg, afInvDir, fBestT) == FLOAT_MAX)
+    return false;
+  rauiStack.push_back(0);
+
+  while (!rauiStack.empty()) {
+    const Node& rclNode = _aclNodes[rauiStack.back()];
+    rauiStack.pop_back();
+
+    if (rclNode.uiCount > 0) {
+      // Moeller-Trumbore test of all facets of the leaf
+      for (unsigned long i = rclNode.uiIndex; i < rclNode.uiIndex + rclNode.uiCount; i++) {
+        const Base::Vector3f& rclV0 = _aclVertices[3*i];
+        Base::Vector3f clE1 = _aclVertices[3*i+1] - rclV0;
+        Base::Vector3f clE2 = _aclVertices[3*i+2] - rclV0;
+        Base::Vector3f clP = rclDir % clE2;
+        float fDet = clE1 * clP;
+        if (fDet * fDet <= 1.0e-12f * (clE1 * clE1) * (clE2 * clE2) * (rclDir * rclDir))
+          continue; // parallel or degenerated
+        float fInv = 1.0f / fDet;
+        Base::Vector3f clS = rclPt - rclV0;
+        float fU = (clS * clP) * fInv;
+        if (fU < 0.0f || fU > 1.0f)
+          continue;
+        Base::Vector3f clQ = clS % clE1;
+        float fV = (rclDir * clQ) * fInv;
+        if (fV < 0.0f || fU + fV > 1.0f)
+          continue;
+        float fT = (clE2 * clQ) * fInv;
+        if (fT >= 0.0f && fT < fBestT) {
+          fBestT = fT;
+          ulBest = i;
+        }
+      }
+    }
+    else {
+      // visit the nearer child first
+      unsigned int uiLeft = rclNode.uiIndex, uiRight = uiLeft + 1;
+      float fLeft  = RayBoxEntry(_aclNodes[uiLeft ].afMin, _aclNodes[uiLeft ].afMax, afOrg, afInvDir, fBestT);
+      float fRight = RayBoxEntry(_aclNodes[uiRight].afMin, _aclNodes[uiRight].afMax, afOrg, afInvDir, fBestT);
+      if (fLeft > fRight) {
+        std::swap(fLeft, fRight);
+        std::swap(uiLeft, uiRight);
+      }
+      if (fRight != FLOAT_MAX)
+        rauiStack.push_back(uiRight);
+      if (fLeft != FLOAT_MAX)
+        rauiStack.push_back(uiLeft);
+    }
+  }
+
+  if (ulBest == ULONG_MAX)
+    return false;
+
+  rclRes = rclPt + fBestT * rclDir;
+  rulFacet = _aulFacets[ulBest];
+  return true;
+}
+
+bool MeshFacetBVH::SearchNearest (const Base::Vector3f &rclPt, float fMaxDistance, Base::Vector3f &rclRes,
+                                  unsigned long &rulFacet, std::vector<unsigned int> &rauiStack) const
+{
+  if (_aclNodes.empty())
+    return false;
+
+  float fBestDist = fMaxDistance;
+  float fBestDist2 = fMaxDistance < FLOAT_MAX ? fMaxDistance * fMaxDistance : FLOAT_MAX;
+  unsigned long ulBest = ULONG_MAX;
+  Base::Vector3f clBestPt, clPt;
+
+  rauiStack.clear();
+  rauiStack.push_back(0);
+  while (!rauiStack.empty()) {
+    const Node& rclNode = _aclNodes[rauiStack.back()];
+    rauiStack.pop_back();
+
+    // the nearest facet might have been found in the meantime
+    if (PointBoxDistance2(rclNode.afMin, rclNode.afMax, rclPt) >= fBestDist2)
+      continue;
+
+    if (rclNode.uiCount > 0) {
+      for (unsigned long i = rclNode.uiIndex; i < rclNode.uiIndex + rclNode.uiCount; i++) {
+        MeshGeomFacet clFacet(_aclVertices[3*i], _aclVertices[3*i+1], _aclVertices[3*i+2]);
+        float fDist = clFacet.DistanceToPoint(rclPt, clPt);
+        if (fDist < fBestDist) {
+          fBestDist = fDist;
+          fBestDist2 = fDist * fDist;
+          clBestPt = clPt;
+          ulBest = i;
+        }
+      }
+    }
+    else {
+      // visit the nearer child first
+      unsigned int uiLeft = rclNode.uiIndex, uiRight = uiLeft + 1;
+      float fLeft  = PointBoxDistance2(_aclNodes[uiLeft ].afMin, _aclNodes[uiLeft ].afMax, rclPt);
+      float fRight = PointBoxDistance2(_aclNodes[uiRight].afMin, _aclNodes[uiRight].afMax, rclPt);
+      if (fLeft > fRight) {
+        std::swap(fLeft, fRight);
+        std::swap(uiLeft, uiRight);
+      }
+      if (fRight < fBestDist2)
+        rauiStack.push_back(uiRight);
+      if (fLeft < fBestDist2)
+        rauiStack.push_back(uiLeft);
+    }
+  }
+
+  if (ulBest == ULONG_MAX)
+    return false;
+
+  rclRes = clBestPt;
+  rulFacet = _aulFacets[ulBest];
+  return true;
+}
+
+bool MeshFacetBVH::NearestFacetOnRay (const Base::Vector3f &rclPt, const Base::Vector3f &rclDir,
+                                      Base::Vector3f &rclRes, unsigned long &rulFacet) const
+{
+  std::vector<unsigned int> auiStack;
+  return TraceRay(rclPt, rclDir, rclRes, rulFacet, auiStack);
+}
+
+bool MeshFacetBVH::NearestPointFromPoint (const Base::Vector3f &rclPt, float fMaxDistance,
+                                          unsigned long &rulFacet, Base::Vector3f &rclRes) const
+{
+  std::vector<unsigned int> auiStack;
+  return SearchNearest(rclPt, fMaxDistance, rclRes, rulFacet, auiStack);
+}
+
+bool MeshFacetBVH::NearestPointFromPoint (const Base::Vector3f &rclPt,
+                                          unsigned long &rulFacet, Base::Vector3f &rclRes) const
+{
+  return NearestPointFromPoint(rclPt, FLOAT_MAX, rulFacet, rclRes);
+}
+
+void MeshFacetBVH::TraceRange (QueryRange &rclRange) const
+{
+  std::vector<unsigned int> auiStack;
+  auiStack.reserve(64);
+  for (unsigned long i = rclRange.ulBegin; i < rclRange.ulEnd; i++) {
+    unsigned long& rulFacet = (*rclRange.paulFacets)[i];
+    if (!TraceRay((*rclRange.pclPts)[i], (*rclRange.pclDirs)[i], (*rclRange.pclRes)[i], rulFacet, auiStack))
+      rulFacet = ULONG_MAX;
+  }
+}
+
+void MeshFacetBVH::SearchRange (QueryRange &rclRange) const
+{
+  std::vector<unsigned int> auiStack;
+  auiStack.reserve(64);
+  for (unsigned long i = rclRange.ulBegin; i < rclRange.ulEnd; i++) {
+    unsigned long& rulFacet = (*rclRange.paulFacets)[i];
+    if (!SearchNearest((*rclRange.pclPts)[i], rclRange.fMaxDistance, (*rclRange.pclRes)[i], rulFacet, auiStack))
+      rulFacet = ULONG_MAX;
+  }
+}
+
+void MeshFacetBVH::ProcessBatch (unsigned long ulCtQueries, QueryRange &rclTemplate, bool bRays) const
+{
+  int iThreads = QThread::idealThreadCount();
+  if (ulCtQueries < MESH_CT_PARALLEL_QUERY || iThreads <= 1) {
+    rclTemplate.ulBegin = 0;
+    rclTemplate.ulEnd = ulCtQueries;
+    if (bRays)
+      TraceRange(rclTemplate);
+    else
+      SearchRange(rclTemplate);
+    return;
+  }
+
+  // use more ranges than threads to balance the work load
+  unsigned long ulCtRanges = std::min<unsigned long>(4 * iThreads, ulCtQueries);
+  unsigned long ulStep = (ulCtQueries + ulCtRanges - 1) / ulCtRanges;
+  std::vector<QueryRange> aclRanges;
+  for (unsigned long i = 0; i < ulCtQueries; i += ulStep) {
+    QueryRange clRange = rclTemplate;
+    clRange.ulBegin = i;
+    clRange.ulEnd = std::min<unsigned long>(i + ulStep, ulCtQueries);
+    aclRanges.push_back(clRange);
+  }
+
+  QFuture<void> future;
+  if (bRays)
+    future = QtConcurrent::map(aclRanges, boost::bind(&MeshFacetBVH::TraceRange, this, _1));
+  else
+    future = QtConcurrent::map(aclRanges, boost::bind(&MeshFacetBVH::SearchRange, this, _1));
+  future.waitForFinished();
+}
+
+void MeshFacetBVH::NearestFacetsOnRays (const std::vector<Base::Vector3f> &rclPts, const std::vector<Base::Vector3f> &rclDirs,
+                                        std::vector<Base::Vector3f> &rclRes, std::vector<unsigned long> &raulFacets) const
+{
+  unsigned long ulCtQueries = std::min<unsigned long>(rclPts.size(), rclDirs.size());
+  rclRes.resize(ulCtQueries);
+  raulFacets.resize(ulCtQueries);
+
+  QueryRange clRange;
+  clRange.fMaxDistance = FLOAT_MAX;
+  clRange.pclPts = &rclPts;
+  clRange.pclDirs = &rclDirs;
+  clRange.pclRes = &rclRes;
+  clRange.paulFacets = &raulFacets;
+  ProcessBatch(ulCtQueries, clRange, true);
+}
+
+void MeshFacetBVH::NearestPointsFromPoints (const std::vector<Base::Vector3f> &rclPts, float fMaxDistance,
+                                            std::vector<unsigned long> &raulFacets, std::vector<Base::Vector3f> &rclRes) const
+{
+  unsigned long ulCtQueries = rclPts.size();
+  rclRes.resize(ulCtQueries);
+  raulFacets.resize(ulCtQueries);
+
+  QueryRange clRange;
+  clRange.fMaxDistance = fMaxDistance;
+  clRange.pclPts = &rclPts;
+  clRange.pclDirs = NULL;
+  clRange.pclRes = &rclRes;
+  clRange.paulFacets = &raulFacets;
+  ProcessBatch(ulCtQueries, clRange, false);
+}
+
+// ----------------------------------------------------------------------------
+
+bool MeshFacetBVH::Overlap (const Node &rclNode1, const Node &rclNode2) const
+{
+  for (int i = 0; i < 3; i++) {
+    if (rclNode1.afMin[i] > rclNode2.afMax[i] || rclNode2.afMin[i] > rclNode1.afMax[i])
+      return false;
+  }
+  return true;
+}
+
+namespace MeshCore {
+
+/** Checks if the bounding boxes of the triangles \a v and \a w overlap. */
+static inline bool FacetBoxesOverlap (const Base::Vector3f *v, const Base::Vector3f *w)
+{
+  for (int i = 0; i < 3; i++) {
+    float fMin1 = std::min<float>(v[0][i], std::min<float>(v[1][i], v[2][i]));
+    float fMax1 = std::max<float>(v[0][i], std::max<float>(v[1][i], v[2][i]));
+    float fMin2 = std::min<float>(w[0][i], std::min<float>(w[1][i], w[2][i]));
+    float fMax2 = std::max<float>(w[0][i], std::max<float>(w[1][i], w[2][i]));
+    if (fMin1 > fMax2 || fMin2 > fMax1)
+      return false;
+  }
+  return true;
+}
+
+/** Returns the sum of the side lengths of the box of a node. */
+static inline float NodeExtent (const float afMin[3], const float afMax[3])
+{
+  return (afMax[0] - afMin[0]) + (afMax[1] - afMin[1]) + (afMax[2] - afMin[2]);
+}
+
+}
+
+void MeshFacetBVH::CollideFacets (unsigned long ulPos1, unsigned long ulPos2,
+                                  std::vector<std::pair<unsigned long, unsigned long> > &raclPairs) const
+{
+  unsigned long ulFacet1 = _aulFacets[ulPos1];
+  unsigned long ulFacet2 = _aulFacets[ulPos2];
+  const MeshFacetArray& rclFacets = _pclMesh->GetFacets();
+  const unsigned long* p = rclFacets[ulFacet1]._aulPoints;
+  const unsigned long* q = rclFacets[ulFacet2]._aulPoints;
+
+  // Facets sharing a common vertex are not checked because they usually do
+  // not intersect but the triangle test tends to give false-positives here.
+  for (int i = 0; i < 3; i++) {
+    if (p[i] == q[0] || p[i] == q[1] || p[i] == q[2])
+      return;
+  }
+
+  const Base::Vector3f* v = &_aclVertices[3 * ulPos1];
+  const Base::Vector3f* w = &_aclVertices[3 * ulPos2];
+  if (!FacetBoxesOverlap(v, w))
+    return;
+
+  MeshGeomFacet clFacet1(v[0], v[1], v[2]);
+  MeshGeomFacet clFacet2(w[0], w[1], w[2]);
+  Base::Vector3f clPt1, clPt2;
+  if (clFacet1.IntersectWithFacet(clFacet2, clPt1, clPt2) == 2) {
+    raclPairs.push_back(std::make_pair(std::min<unsigned long>(ulFacet1, ulFacet2),
+                                       std::max<unsigned long>(ulFacet1, ulFacet2)));
+  }
+}
+
+bool MeshFacetBVH::SplitTask (unsigned int uiNode1, unsigned int uiNode2, std::vector<CollisionTask> &raclTasks) const
+{
+  const Node& rclNode1 = _aclNodes[uiNode1];
+  const Node& rclNode2 = _aclNodes[uiNode2];
+  CollisionTask clTask;
+
+  if (uiNode1 == uiNode2) {
+    if (rclNode1.uiCount > 0) {
+      clTask.uiNode1 = clTask.uiNode2 = uiNode1;
+      raclTasks.push_back(clTask);
+      return false;
+    }
+    unsigned int uiLeft = rclNode1.uiIndex, uiRight = rclNode1.uiIndex + 1;
+    clTask.uiNode1 = clTask.uiNode2 = uiLeft;
+    raclTasks.push_back(clTask);
+    clTask.uiNode1 = clTask.uiNode2 = uiRight;
+    raclTasks.push_back(clTask);
+    if (Overlap(_aclNodes[uiLeft], _aclNodes[uiRight])) {
+      clTask.uiNode1 = uiLeft;
+      clTask.uiNode2 = uiRight;
+      raclTasks.push_back(clTask);
+    }
+    return true;
+  }
+
+  if (rclNode1.uiCount > 0 && rclNode2.uiCount > 0) {
+    clTask.uiNode1 = uiNode1;
+    clTask.uiNode2 = uiNode2;
+    raclTasks.push_back(clTask);
+    return false;
+  }
+
+  // descend into an inner node
+  unsigned int uiInner = rclNode1.uiCount == 0 ? uiNode1 : uiNode2;
+  unsigned int uiOther = uiInner == uiNode1 ? uiNode2 : uiNode1;
+  unsigned int uiChild = _aclNodes[uiInner].uiIndex;
+  for (unsigned int i = uiChild; i < uiChild + 2; i++) {
+    if (Overlap(_aclNodes[i], _aclNodes[uiOther])) {
+      clTask.uiNode1 = i;
+      clTask.uiNode2 = uiOther;
+      raclTasks.push_back(clTask);
+    }
+  }
+  return true;
+}
+
+void MeshFacetBVH::CollideTask (CollisionTask &rclTask) const
+{
+  std::vector<std::pair<unsigned int, unsigned int> > aclStack;
+  aclStack.push_back(std::make_pair(rclTask.uiNode1, rclTask.uiNode2));
+
+  while (!aclStack.empty()) {
+    // another task has found an intersection already
+    if (rclTask.pbFound && *rclTask.pbFound)
+      return;
+    unsigned int uiNode1 = aclStack.back().first;
+    unsigned int uiNode2 = aclStack.back().second;
+    aclStack.pop_back();
+    const Node& rclNode1 = _aclNodes[uiNode1];
+    const Node& rclNode2 = _aclNodes[uiNode2];
+
+    if (uiNode1 == uiNode2) {
+      if (rclNode1.uiCount > 0) {
+        unsigned long ulEnd = rclNode1.uiIndex + rclNode1.uiCount;
+        for (unsigned long i = rclNode1.uiIndex; i < ulEnd; i++) {
+          for (unsigned long j = i + 1; j < ulEnd; j++)
+            CollideFacets(i, j, rclTask.aclPairs);
+          if (rclTask.pbFound && !rclTask.aclPairs.empty()) {
+            *rclTask.pbFound = true;
+            return;
+          }
+        }
+      }
+      else {
+        unsigned int uiLeft = rclNode1.uiIndex;
+        aclStack.push_back(std::make_pair(uiLeft, uiLeft));
+        aclStack.push_back(std::make_pair(uiLeft + 1, uiLeft + 1));
+        aclStack.push_back(std::make_pair(uiLeft, uiLeft + 1));
+      }
+      continue;
+    }
+
+    if (!Overlap(rclNode1, rclNode2))
+      continue;
+
+    if (rclNode1.uiCount > 0 && rclNode2.uiCount > 0) {
+      unsigned long ulEnd1 = rclNode1.uiIndex + rclNode1.uiCount;
+      unsigned long ulEnd2 = rclNode2.uiIndex + rclNode2.uiCount;
+      for (unsigned long i = rclNode1.uiIndex; i < ulEnd1; i++) {
+        for (unsigned long j = rclNode2.uiIndex; j < ulEnd2; j++)
+          CollideFacets(i, j, rclTask.aclPairs);
+        if (rclTask.pbFound && !rclTask.aclPairs.empty()) {
+          *rclTask.pbFound = true;
+          return;
+        }
+      }
+    }
+    else if (rclNode1.uiCount == 0) {
+      aclStack.push_back(std::make_pair(rclNode1.uiIndex, uiNode2));
+      aclStack.push_back(std::make_pair(rclNode1.uiIndex + 1, uiNode2));
+    }
+    else {
+      aclStack.push_back(std::make_pair(uiNode1, rclNode2.uiIndex));
+      aclStack.push_back(std::make_pair(uiNode1, rclNode2.uiIndex + 1));
+    }
+  }
+}
+
+void MeshFacetBVH::Collide (volatile bool *pbFound, std::vector<CollisionTask> &raclTasks) const
+{
+  raclTasks.resize(1);
+  raclTasks[0].pbFound = pbFound;
+
+  int iThreads = QThread::idealThreadCount();
+  if (_aulFacets.size() < MESH_CT_PARALLEL_COLLISION || iThreads <= 1) {
+    CollideTask(raclTasks[0]);
+    return;
+  }
+
+  // Split the traversal of the upper levels into independent tasks. There
+  // are more tasks than threads because the work of the tasks differs a lot.
+  unsigned long ulCtTasks = 16 * (unsigned long)iThreads;
+  bool bSplit = true;
+  while (bSplit && raclTasks.size() < ulCtTasks) {
+    std::vector<CollisionTask> aclNext;
+    bSplit = false;
+    for (std::vector<CollisionTask>::iterator it = raclTasks.begin(); it != raclTasks.end(); ++it) {
+      if (SplitTask(it->uiNode1, it->uiNode2, aclNext))
+        bSplit = true;
+    }
+    raclTasks.swap(aclNext);
+  }
+  for (std::vector<CollisionTask>::iterator it = raclTasks.begin(); it != raclTasks.end(); ++it)
+    it->pbFound = pbFound;
+
+  QFuture<void> future = QtConcurrent::map(raclTasks, boost::bind(&MeshFacetBVH::CollideTask, this, _1));
+  future.waitForFinished();
+}
+
+void MeshFacetBVH::SelfIntersections (std::vector<std::pair<unsigned long, unsigned long> > &raclPairs) const
+{
+  raclPairs.clear();
+  if (_aclNodes.empty())
+    return;
+
+  std::vector<CollisionTask> aclTasks;
+  Collide(0, aclTasks);
+  for (std::vector<CollisionTask>::iterator it = aclTasks.begin(); it != aclTasks.end(); ++it)
+    raclPairs.insert(raclPairs.end(), it->aclPairs.begin(), it->aclPairs.end());
+
+  std::sort(raclPairs.begin(), raclPairs.end());
+}
+
+bool MeshFacetBVH::HasSelfIntersections () const
+{
+  if (_aclNodes.empty())
+    return false;
+
+  volatile bool bFound = false;
+  std::vector<CollisionTask> aclTasks;
+  Collide(&bFound, aclTasks);
+  return bFound;
+}
+
+// ----------------------------------------------------------------------------
+
+bool MeshFacetBVH::SplitTask (const MeshFacetBVH &rclOther, unsigned int uiNode1, unsigned int uiNode2,
+                              std::vector<CollisionTask> &raclTasks) const
+{
+  const Node& rclNode1 = _aclNodes[uiNode1];
+  const Node& rclNode2 = rclOther._aclNodes[uiNode2];
+  CollisionTask clTask;
+  clTask.uiNode1 = uiNode1;
+  clTask.uiNode2 = uiNode2;
+
+  if (rclNode1.uiCount > 0 && rclNode2.uiCount > 0) {
+    raclTasks.push_back(clTask);
+    return false;
+  }
+
+  // descend into the larger node
+  if (rclNode2.uiCount > 0 || (rclNode1.uiCount == 0 &&
+      NodeExtent(rclNode1.afMin, rclNode1.afMax) >= NodeExtent(rclNode2.afMin, rclNode2.afMax))) {
+    for (unsigned int i = rclNode1.uiIndex; i < rclNode1.uiIndex + 2; i++) {
+      if (Overlap(_aclNodes[i], rclNode2)) {
+        clTask.uiNode1 = i;
+        raclTasks.push_back(clTask);
+      }
+    }
+  }
+  else {
+    for (unsigned int i = rclNode2.uiIndex; i < rclNode2.uiIndex + 2; i++) {
+      if (Overlap(rclNode1, rclOther._aclNodes[i])) {
+        clTask.uiNode2 = i;
+        raclTasks.push_back(clTask);
+      }
+    }
+  }
+  return true;
+}
+
+void MeshFacetBVH::OverlapTask (const MeshFacetBVH *pclOther, CollisionTask &rclTask) const
+{
+  std::vector<std::pair<unsigned int, unsigned int> > aclStack;
+  aclStack.push_back(std::make_pair(rclTask.uiNode1, rclTask.uiNode2));
+
+  while (!aclStack.empty()) {
+    unsigned int uiNode1 = aclStack.back().first;
+    unsigned int uiNode2 = aclStack.back().second;
+    aclStack.pop_back();
+    const Node& rclNode1 = _aclNodes[uiNode1];
+    const Node& rclNode2 = pclOther->_aclNodes[uiNode2];
+
+    if (!Overlap(rclNode1, rclNode2))
+      continue;
+
+    if (rclNode1.uiCount > 0 && rclNode2.uiCount > 0) {
+      unsigned long ulEnd1 = rclNode1.uiIndex + rclNode1.uiCount;
+      unsigned long ulEnd2 = rclNode2.uiIndex + rclNode2.uiCount;
+      for (unsigned long i = rclNode1.uiIndex; i < ulEnd1; i++) {
+        for (unsigned long j = rclNode2.uiIndex; j < ulEnd2; j++) {
+          if (FacetBoxesOverlap(&_aclVertices[3 * i], &pclOther->_aclVertices[3 * j]))
+            rclTask.aclPairs.push_back(std::make_pair(_aulFacets[i], pclOther->_aulFacets[j]));
+        }
+      }
+    }
+    else if (rclNode2.uiCount > 0 || (rclNode1.uiCount == 0 &&
+             NodeExtent(rclNode1.afMin, rclNode1.afMax) >= NodeExtent(rclNode2.afMin, rclNode2.afMax))) {
+      aclStack.push_back(std::make_pair(rclNode1.uiIndex, uiNode2));
+      aclStack.push_back(std::make_pair(rclNode1.uiIndex + 1, uiNode2));
+    }
+    else {
+      aclStack.push_back(std::make_pair(uiNode1, rclNode2.uiIndex));
+      aclStack.push_back(std::make_pair(uiNode1, rclNode2.uiIndex + 1));
+    }
+  }
+}
+
+void MeshFacetBVH::OverlappingFacets (const MeshFacetBVH &rclOther,
+                                      std::vector<std::pair<unsigned long, unsigned long> > &raclPairs) const
+{
+  raclPairs.clear();
+  if (_aclNodes.empty() || rclOther._aclNodes.empty())
+    return;
+
+  int iThreads = QThread::idealThreadCount();
+  if (_aulFacets.size() + rclOther._aulFacets.size() < MESH_CT_PARALLEL_COLLISION || iThreads <= 1) {
+    CollisionTask clTask;
+    clTask.uiNode1 = clTask.uiNode2 = 0;
+    OverlapTask(&rclOther, clTask);
+    raclPairs.swap(clTask.aclPairs);
+  }
+  else {
+    std::vector<CollisionTask> aclTasks(1);
+    aclTasks[0].uiNode1 = aclTasks[0].uiNode2 = 0;
+    unsigned long ulCtTasks = 16 * (unsigned long)iThreads;
+    bool bSplit = true;
+    while (bSplit && aclTasks.size() < ulCtTasks) {
+      std::vector<CollisionTask> aclNext;
+      bSplit = false;
+      for (std::vector<CollisionTask>::iterator it = aclTasks.begin(); it != aclTasks.end(); ++it) {
+        if (SplitTask(rclOther, it->uiNode1, it->uiNode2, aclNext))
+          bSplit = true;
+      }
+      aclTasks.swap(aclNext);
+    }
+
+    QFuture<void> future = QtConcurrent::map(aclTasks, boost::bind(&MeshFacetBVH::OverlapTask, this, &rclOther, _1));
+    future.waitForFinished();
+
+    for (std::vector<CollisionTask>::iterator it = aclTasks.begin(); it != aclTasks.end(); ++it)
+      raclPairs.insert(raclPairs.end(), it->aclPairs.begin(), it->aclPairs.end());
+  }
+
+  std::sort(raclPairs.begin(), raclPairs.end());
+}
@@ -0,0 +1,239 @@
+/***************************************************************************
+ *   Copyright (c) 2012 Imetric 3D GmbH                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef MESH_BVH_H
+#define MESH_BVH_H
+
+#include <utility>
+#include <vector>
+
+#include "MeshKernel.h"
+#include <Base/Vector3D.h>
+#include <Base/BoundBox.h>
+
+#define  MESH_BVH_MAX_LEAF_SIZE   4    // Maximum number of facets per leaf node
+#define  MESH_BVH_CT_BINS        16    // Number of bins to evaluate the SAH
+#define  MESH_CT_PARALLEL_QUERY 1000   // Minimum number of queries to process a batch in parallel
+#define  MESH_CT_PARALLEL_COLLISION 10000 // Minimum number of facets to search for self-intersections in parallel
+
+namespace MeshCore {
+
+class MeshKernel;
+
+/**
+ * The MeshFacetBVH class is a bounding volume hierarchy over the facets of a
+ * mesh. In contrast to the MeshFacetGrid the splitting planes are chosen by
+ * the surface area heuristic (SAH), so the search performance doesn't depend
+ * on a grid resolution and doesn't degrade on meshes with a very non-uniform
+ * facet density.
+ *
+ * The nodes are stored in one flat array with the two children of a node
+ * placed next to each other. The vertices of the facets are copied in leaf
+ * order, hence a query touches contiguous memory only and doesn't need to
+ * access the mesh kernel.
+ *
+ * Like the grids the hierarchy doesn't get notified if the attached mesh
+ * changes. In this case Rebuild() must be called.
+ */
+class MeshExport MeshFacetBVH
+{
+public:
+  /** @name Construction */
+  //@{
+  /// Construction
+  MeshFacetBVH (const MeshKernel &rclM);
+  /// Construction
+  MeshFacetBVH (void);
+  /// Destruction
+  virtual ~MeshFacetBVH (void) { }
+  //@}
+
+public:
+  /** Attaches the mesh kernel to this hierarchy, an already attached mesh
+   * gets detached. The hierarchy gets rebuilt automatically. */
+  virtual void Attach (const MeshKernel &rclM);
+  /** Rebuilds the hierarchy. */
+  virtual void Rebuild (void);
+  /** Returns the bounding box of the whole hierarchy. */
+  Base::BoundBox3f GetBoundBox (void) const;
+  /** Returns the number of nodes. */
+  unsigned long CountNodes (void) const
+  { return _aclNodes.size(); }
+  /** Returns the number of facets the hierarchy was built with. */
+  unsigned long CountElements (void) const
+  { return _aulFacets.size(); }
+
+  /** @name Single queries */
+  //@{
+  /**
+   * Searches for the nearest facet hit by the ray defined by (\a rclPt,
+   * \a rclDir). Only intersections in direction of \a rclDir are taken into
+   * account. The point \a rclRes holds the intersection point and
+   * \a rulFacet the index of the facet.
+   */
+  bool NearestFacetOnRay (const Base::Vector3f &rclPt, const Base::Vector3f &rclDir,
+                          Base::Vector3f &rclRes, unsigned long &rulFacet) const;
+  /**
+   * Searches for the nearest facet to the point \a rclPt whose distance is
+   * less than \a fMaxDistance. The point \a rclRes holds the nearest point
+   * on the facet and \a rulFacet the index of the facet.
+   */
+  bool NearestPointFromPoint (const Base::Vector3f &rclPt, float fMaxDistance,
+                              unsigned long &rulFacet, Base::Vector3f &rclRes) const;
+  /**
+   * Searches for the nearest facet to the point \a rclPt.
+   */
+  bool NearestPointFromPoint (const Base::Vector3f &rclPt,
+                              unsigned long &rulFacet, Base::Vector3f &rclRes) const;
+  //@}
+
+  /** @name Batched queries
+   * The batched queries process \a N rays or points in one call. For large
+   * batches the work is distributed over all available cores. For queries
+   * without a result the facet index is set to ULONG_MAX.
+   */
+  //@{
+  /**
+   * Does a ray query for each pair (\a rclPts[i], \a rclDirs[i]).
+   */
+  void NearestFacetsOnRays (const std::vector<Base::Vector3f> &rclPts, const std::vector<Base::Vector3f> &rclDirs,
+                            std::vector<Base::Vector3f> &rclRes, std::vector<unsigned long> &raulFacets) const;
+  /**
+   * Does a nearest point query for each point of \a rclPts. Facets with a
+   * distance not less than \a fMaxDistance are ignored.
+   */
+  void NearestPointsFromPoints (const std::vector<Base::Vector3f> &rclPts, float fMaxDistance,
+                                std::vector<unsigned long> &raulFacets, std::vector<Base::Vector3f> &rclRes) const;
+  //@}
+
+  /** @name Self-intersections */
+  //@{
+  /**
+   * Collects all pairs of facets that intersect each other. Facets sharing
+   * a point are not tested. Each pair holds the lower facet index first and
+   * the pairs are sorted. For large meshes the work is distributed over all
+   * available cores.
+   */
+  void SelfIntersections (std::vector<std::pair<unsigned long, unsigned long> > &raclPairs) const;
+  /**
+   * Checks whether any two facets intersect each other. The search stops at
+   * the first intersecting pair, on all cores.
+   */
+  bool HasSelfIntersections () const;
+  //@}
+
+  /** @name Overlaps with another mesh */
+  //@{
+  /**
+   * Collects all pairs of facets of this mesh and the mesh of \a rclOther
+   * whose bounding boxes overlap. The first index of a pair refers to this
+   * mesh and the second one to the other mesh. The pairs are sorted. For
+   * large meshes the work is distributed over all available cores.
+   */
+  void OverlappingFacets (const MeshFacetBVH &rclOther,
+                          std::vector<std::pair<unsigned long, unsigned long> > &raclPairs) const;
+  //@}
+
+protected:
+  /** A node of the hierarchy, 32 bytes in size. For inner nodes \a uiCount
+   * is 0 and \a uiIndex refers to the first of the two adjacent children.
+   * For leaves \a uiIndex is the position of the first facet in the leaf
+   * ordered arrays.
+   */
+  struct Node
+  {
+    float afMin[3], afMax[3];
+    unsigned int uiIndex;
+    unsigned int uiCount;
+  };
+
+  /** A range of a batch of queries. */
+  struct QueryRange
+  {
+    unsigned long ulBegin, ulEnd;
+    float fMaxDistance;
+    const std::vector<Base::Vector3f> *pclPts;
+    const std::vector<Base::Vector3f> *pclDirs;
+    std::vector<Base::Vector3f> *pclRes;
+    std::vector<unsigned long> *paulFacets;
+  };
+
+  /** A pair of nodes to test for intersecting facets. If both indices are
+   * equal the node is tested against itself. For the tests against another
+   * hierarchy \a uiNode2 refers to a node of the other hierarchy.
+   * If \a pbFound is set the tasks stop as soon as one of them has found an
+   * intersection.
+   */
+  struct CollisionTask
+  {
+    CollisionTask() : uiNode1(0), uiNode2(0), pbFound(0) {}
+    unsigned int uiNode1, uiNode2;
+    volatile bool *pbFound;
+    std::vector<std::pair<unsigned long, unsigned long> > aclPairs;
+  };
+
+  /** @name Build */
+  //@{
+  /** Splits the facets in the range [\a ulBegin, \a ulEnd) by the surface
+   * area heuristic and returns the position of the split in \a rulMid.
+   * Returns false if the facets should rather be kept in a leaf. */
+  bool Split (unsigned long ulBegin, unsigned long ulEnd, const std::vector<Base::Vector3f> &raclCentroids,
+              const std::vector<Base::BoundBox3f> &raclBoxes, unsigned long &rulMid);
+  /** Sets the bounds of a node to the boxes of its facets. */
+  void SetBounds (Node &rclNode, const std::vector<Base::BoundBox3f> &raclBoxes) const;
+  //@}
+
+  /** @name Traversal */
+  //@{
+  bool TraceRay (const Base::Vector3f &rclPt, const Base::Vector3f &rclDir, Base::Vector3f &rclRes,
+                 unsigned long &rulFacet, std::vector<unsigned int> &rauiStack) const;
+  bool SearchNearest (const Base::Vector3f &rclPt, float fMaxDistance, Base::Vector3f &rclRes,
+                      unsigned long &rulFacet, std::vector<unsigned int> &rauiStack) const;
+  void TraceRange (QueryRange &rclRange) const;
+  void SearchRange (QueryRange &rclRange) const;
+  void ProcessBatch (unsigned long ulCtQueries, QueryRange &rclTemplate, bool bRays) const;
+  //@}
+
+  /** @name Collision */
+  //@{
+  bool Overlap (const Node &rclNode1, const Node &rclNode2) const;
+  bool SplitTask (unsigned int uiNode1, unsigned int uiNode2, std::vector<CollisionTask> &raclTasks) const;
+  void CollideTask (CollisionTask &rclTask) const;
+  void Collide (volatile bool *pbFound, std::vector<CollisionTask> &raclTasks) const;
+  void CollideFacets (unsigned long ulPos1, unsigned long ulPos2,
+                      std::vector<std::pair<unsigned long, unsigned long> > &raclPairs) const;
+  bool SplitTask (const MeshFacetBVH &rclOther, unsigned int uiNode1, unsigned int uiNode2,
+                  std::vector<CollisionTask> &raclTasks) const;
+  void OverlapTask (const MeshFacetBVH *pclOther, CollisionTask &rclTask) const;
+  //@}
+
+protected:
+  const MeshKernel* _pclMesh;  /**< The mesh kernel. */
+  std::vector<Node> _aclNodes; /**< Flattened nodes, the root is the first node. */
+  std::vector<unsigned long> _aulFacets; /**< Facet indices in leaf order. */
+  std::vector<Base::Vector3f> _aclVertices; /**< Facet vertices in leaf order, three per facet. */
+};
+
+} // namespace MeshCore
+
+#endif // MESH_BVH_H
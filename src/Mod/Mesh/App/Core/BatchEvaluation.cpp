@@ -0,0 +1,306 @@
+/***************************************************************************
+ *   Copyright (c) 2012 Imetric 3D GmbH                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <algorithm>
+#endif
+
+#include <QFuture>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+#include <boost/bind.hpp>
+#include <boost/math/special_functions/fpclassify.hpp>
+
+#include "BatchEvaluation.h"
+#include "Degeneration.h"
+#include "Elements.h"
+#include "MeshKernel.h"
+
+using namespace MeshCore;
+
+bool MeshDefectReport::IsEmpty (void) const
+{
+  return invalidPoints.empty() && invalidFacets.empty() && nanPoints.empty() &&
+         rangePoints.empty() && rangeFacets.empty() && corruptedFacets.empty() &&
+         degeneratedFacets.empty() && deformedFacets.empty() &&
+         duplicatedPoints.empty() && duplicatedFacets.empty() &&
+         neighbourhood.empty() && nonManifolds.empty() && selfIntersections.empty();
+}
+
+void MeshDefectReport::Clear (void)
+{
+  invalidPoints.clear();
+  invalidFacets.clear();
+  nanPoints.clear();
+  rangePoints.clear();
+  rangeFacets.clear();
+  corruptedFacets.clear();
+  degeneratedFacets.clear();
+  deformedFacets.clear();
+  duplicatedPoints.clear();
+  duplicatedFacets.clear();
+  neighbourhood.clear();
+  nonManifolds.clear();
+  selfIntersections.clear();
+}
+
+// ----------------------------------------------------------------------
+
+MeshEvalBatch::MeshEvalBatch (const MeshKernel &rclM, int iChecks)
+  : MeshEvaluation(rclM), _iChecks(iChecks)
+{
+}
+
+void MeshEvalBatch::CheckPoints (ElementRange &rclRange) const
+{
+  const MeshPointArray& rPoints = _rclMesh.GetPoints();
+  bool bInvalids = (_iChecks & Invalids) != 0;
+  bool bNaN = (_iChecks & NaNPoints) != 0;
+
+  for (unsigned long i = rclRange.ulBegin; i < rclRange.ulEnd; i++) {
+    const MeshPoint& rclP = rPoints[i];
+    if (bInvalids && !rclP.IsValid())
+      rclRange.invalid.push_back(i);
+    if (bNaN && (boost::math::isnan(rclP.x) || boost::math::isnan(rclP.y) || boost::math::isnan(rclP.z)))
+      rclRange.nan.push_back(i);
+  }
+}
+
+void MeshEvalBatch::CheckFacets (ElementRange &rclRange) const
+{
+  const MeshFacetArray& rFacets = _rclMesh.GetFacets();
+  const MeshPointArray& rPoints = _rclMesh.GetPoints();
+  unsigned long ulCtFacets = rFacets.size();
+  unsigned long ulCtPoints = rPoints.size();
+  bool bGeometry = (_iChecks & (DegeneratedFacets | DeformedFacets)) != 0;
+
+  for (unsigned long i = rclRange.ulBegin; i < rclRange.ulEnd; i++) {
+    const MeshFacet& rclF = rFacets[i];
+    const unsigned long* p = rclF._aulPoints;
+    const unsigned long* n = rclF._aulNeighbours;
+
+    if (_iChecks & RangeFacets) {
+      for (int j = 0; j < 3; j++) {
+        if (n[j] >= ulCtFacets && n[j] < ULONG_MAX) {
+          rclRange.rangeFacets.push_back(i);
+          break;
+        }
+      }
+    }
+
+    // the remaining checks access the points
+    if (p[0] >= ulCtPoints || p[1] >= ulCtPoints || p[2] >= ulCtPoints) {
+      if (_iChecks & RangePoints)
+        rclRange.rangePoints.push_back(i);
+      continue;
+    }
+
+    if (_iChecks & Invalids) {
+      if (!rclF.IsValid() || !rPoints[p[0]].IsValid() ||
+          !rPoints[p[1]].IsValid() || !rPoints[p[2]].IsValid())
+        rclRange.invalid.push_back(i);
+    }
+
+    if (_iChecks & CorruptedFacets) {
+      if (p[0] == p[1] || p[1] == p[2] || p[2] == p[0])
+        rclRange.corrupted.push_back(i);
+    }
+
+    if (bGeometry) {
+      MeshGeomFacet clFacet = _rclMesh.GetFacet(rclF);
+      if ((_iChecks & DegeneratedFacets) && clFacet.IsDegenerated())
+        rclRange.degenerated.push_back(i);
+      if ((_iChecks & DeformedFacets) && clFacet.IsDeformed())
+        rclRange.deformed.push_back(i);
+    }
+  }
+}
+
+void MeshEvalBatch::FindDuplicatedPoints (void)
+{
+  _clReport.duplicatedPoints = MeshEvalDuplicatePoints(_rclMesh).GetIndices();
+  std::sort(_clReport.duplicatedPoints.begin(), _clReport.duplicatedPoints.end());
+}
+
+void MeshEvalBatch::FindDuplicatedFacets (void)
+{
+  _clReport.duplicatedFacets = MeshEvalDuplicateFacets(_rclMesh).GetIndices();
+  std::sort(_clReport.duplicatedFacets.begin(), _clReport.duplicatedFacets.end());
+}
+
+void MeshEvalBatch::Merge (std::vector<ElementRange> &raclRanges, std::vector<unsigned long> ElementRange::*pList,
+                           std::vector<unsigned long> &raulResult)
+{
+  // the ranges are in ascending order, hence the merged list is sorted too
+  for (std::vector<ElementRange>::iterator it = raclRanges.begin(); it != raclRanges.end(); ++it)
+    raulResult.insert(raulResult.end(), ((*it).*pList).begin(), ((*it).*pList).end());
+}
+
+void MeshEvalBatch::Traverse (unsigned long ulCtElements, bool bFacets, std::vector<ElementRange> &raclRanges) const
+{
+  int iThreads = QThread::idealThreadCount();
+  if (ulCtElements < MESH_CT_PARALLEL_EVAL || iThreads <= 1) {
+    raclRanges.resize(1);
+    raclRanges[0].ulBegin = 0;
+    raclRanges[0].ulEnd = ulCtElements;
+    if (bFacets)
+      CheckFacets(raclRanges[0]);
+    else
+      CheckPoints(raclRanges[0]);
+    return;
+  }
+
+  // use more ranges than threads to balance the work load
+  unsigned long ulCtRanges = 4 * (unsigned long)iThreads;
+  unsigned long ulStep = (ulCtElements + ulCtRanges - 1) / ulCtRanges;
+  for (unsigned long i = 0; i < ulCtElements; i += ulStep) {
+    ElementRange clRange;
+    clRange.ulBegin = i;
+    clRange.ulEnd = std::min<unsigned long>(i + ulStep, ulCtElements);
+    raclRanges.push_back(clRange);
+  }
+
+  QFuture<void> future;
+  if (bFacets)
+    future = QtConcurrent::map(raclRanges, boost::bind(&MeshEvalBatch::CheckFacets, this, _1));
+  else
+    future = QtConcurrent::map(raclRanges, boost::bind(&MeshEvalBatch::CheckPoints, this, _1));
+  future.waitForFinished();
+}
+
+bool MeshEvalBatch::Evaluate ()
+{
+  _clReport.Clear();
+  unsigned long ulCtFacets = _rclMesh.CountFacets();
+  bool bParallel = ulCtFacets >= MESH_CT_PARALLEL_EVAL && QThread::idealThreadCount() > 1;
+
+  // the checks which sort the whole mesh run next to the traversals
+  QFuture<void> dupPoints, dupFacets;
+  if (_iChecks & DuplicatedPoints) {
+    if (bParallel)
+      dupPoints = QtConcurrent::run(this, &MeshEvalBatch::FindDuplicatedPoints);
+    else
+      FindDuplicatedPoints();
+  }
+  if (_iChecks & DuplicatedFacets) {
+    if (bParallel)
+      dupFacets = QtConcurrent::run(this, &MeshEvalBatch::FindDuplicatedFacets);
+    else
+      FindDuplicatedFacets();
+  }
+
+  if (_iChecks & (Invalids | NaNPoints)) {
+    std::vector<ElementRange> aclRanges;
+    Traverse(_rclMesh.CountPoints(), false, aclRanges);
+    Merge(aclRanges, &ElementRange::invalid, _clReport.invalidPoints);
+    Merge(aclRanges, &ElementRange::nan, _clReport.nanPoints);
+  }
+
+  if (_iChecks & (Invalids | RangePoints | RangeFacets | CorruptedFacets | DegeneratedFacets | DeformedFacets)) {
+    std::vector<ElementRange> aclRanges;
+    Traverse(ulCtFacets, true, aclRanges);
+    Merge(aclRanges, &ElementRange::invalid, _clReport.invalidFacets);
+    Merge(aclRanges, &ElementRange::rangePoints, _clReport.rangePoints);
+    Merge(aclRanges, &ElementRange::rangeFacets, _clReport.rangeFacets);
+    Merge(aclRanges, &ElementRange::corrupted, _clReport.corruptedFacets);
+    Merge(aclRanges, &ElementRange::degenerated, _clReport.degeneratedFacets);
+    Merge(aclRanges, &ElementRange::deformed, _clReport.deformedFacets);
+  }
+
+  // These checks use the sequencer which must only be used by the main
+  // thread, so they are done here while the search for duplicates may
+  // still be running.
+  if (_iChecks & Neighbourhood) {
+    std::vector<unsigned long>& inds = _clReport.neighbourhood;
+    inds = MeshEvalNeighbourhood(_rclMesh).GetIndices();
+    std::sort(inds.begin(), inds.end());
+    inds.erase(std::unique(inds.begin(), inds.end()), inds.end());
+  }
+  if (_iChecks & NonManifolds) {
+    MeshEvalTopology cEval(_rclMesh);
+    if (!cEval.Evaluate())
+      _clReport.nonManifolds = cEval.GetIndices();
+  }
+  // the intersection test needs valid point indices
+  if ((_iChecks & SelfIntersections) && _clReport.rangePoints.empty()) {
+    MeshEvalSelfIntersection(_rclMesh).GetIntersections(_clReport.selfIntersections);
+  }
+
+  dupPoints.waitForFinished();
+  dupFacets.waitForFinished();
+
+  return _clReport.IsEmpty();
+}
+
+// ----------------------------------------------------------------------
+
+bool MeshFixBatch::Fixup ()
+{
+  const MeshDefectReport& r = _rclReport;
+
+  if (!r.invalidPoints.empty() || !r.invalidFacets.empty())
+    MeshFixInvalids(_rclMesh).Fixup();
+  if (!r.nanPoints.empty())
+    MeshFixNaNPoints(_rclMesh).Fixup();
+
+  // indices
+  if (!r.neighbourhood.empty() || !r.rangeFacets.empty())
+    MeshFixNeighbourhood(_rclMesh).Fixup();
+  if (!r.rangePoints.empty()) {
+    // all further steps access the points of the facets
+    if (!MeshFixRangePoint(_rclMesh).Fixup())
+      return false;
+  }
+
+  // merging duplicated points may create corrupted, duplicated or
+  // degenerated facets, hence these steps are also done in this case
+  bool bMerged = !r.duplicatedPoints.empty();
+  if (bMerged)
+    MeshFixDuplicatePoints(_rclMesh).Fixup();
+  if (bMerged || !r.corruptedFacets.empty())
+    MeshFixCorruptedFacets(_rclMesh).Fixup();
+  if (bMerged || !r.duplicatedFacets.empty())
+    MeshFixDuplicateFacets(_rclMesh).Fixup();
+  if (bMerged || !r.degeneratedFacets.empty())
+    MeshFixDegeneratedFacets(_rclMesh).Fixup();
+  if (!r.deformedFacets.empty())
+    MeshFixDeformedFacets(_rclMesh, _fMaxAngle).Fixup();
+
+  // the indices of the report are outdated now
+  if (!r.nonManifolds.empty()) {
+    MeshEvalTopology cEval(_rclMesh);
+    if (!cEval.Evaluate())
+      MeshFixTopology(_rclMesh, cEval.GetFacets()).Fixup();
+  }
+  if (!r.selfIntersections.empty()) {
+    std::vector<std::pair<unsigned long, unsigned long> > intersections;
+    MeshEvalSelfIntersection(_rclMesh).GetIntersections(intersections);
+    if (!intersections.empty())
+      MeshFixSelfIntersection(_rclMesh, intersections).Fixup();
+  }
+
+  return true;
+}
@@ -0,0 +1,170 @@
+/***************************************************************************
+ *   Copyright (c) 2012 Imetric 3D GmbH                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef MESH_BATCHEVALUATION_H
+#define MESH_BATCHEVALUATION_H
+
+#include <utility>
+#include <vector>
+
+#include "Evaluation.h"
+
+#define  MESH_CT_PARALLEL_EVAL 50000  // Minimum number of elements to check a mesh in parallel
+
+namespace MeshCore {
+
+class MeshKernel;
+
+/**
+ * The MeshDefectReport structure collects the results of a MeshEvalBatch run.
+ * Unless stated otherwise the lists contain facet indices in ascending order.
+ */
+struct MeshExport MeshDefectReport
+{
+  std::vector<unsigned long> invalidPoints;     /**< Points marked as 'Invalid'. */
+  std::vector<unsigned long> invalidFacets;     /**< Facets marked as 'Invalid' or with invalid points. */
+  std::vector<unsigned long> nanPoints;         /**< Points with NaN coordinates. */
+  std::vector<unsigned long> rangePoints;       /**< Facets with out of range point indices. */
+  std::vector<unsigned long> rangeFacets;       /**< Facets with out of range neighbour indices. */
+  std::vector<unsigned long> corruptedFacets;   /**< Facets which reference a point more than once. */
+  std::vector<unsigned long> degeneratedFacets; /**< Facets with collinear points. */
+  std::vector<unsigned long> deformedFacets;    /**< Facets with an angle < 30 or > 120 degree. */
+  std::vector<unsigned long> duplicatedPoints;  /**< Points with the same coordinates as another point. */
+  std::vector<unsigned long> duplicatedFacets;  /**< Facets with the same points as another facet. */
+  std::vector<unsigned long> neighbourhood;     /**< Facets with wrong neighbour indices. */
+  std::vector<std::pair<unsigned long, unsigned long> > nonManifolds;      /**< Point indices of non-manifold edges. */
+  std::vector<std::pair<unsigned long, unsigned long> > selfIntersections; /**< Pairs of intersecting facets. */
+
+  /** Returns true if no defect was found. */
+  bool IsEmpty (void) const;
+  /** Removes all entries. */
+  void Clear (void);
+};
+
+/**
+ * The MeshEvalBatch class runs several checks in one go. Instead of doing a
+ * full pass over the mesh for each check the element-wise checks are done in
+ * one traversal, split into ranges that are processed on all cores. The
+ * checks that sort the whole mesh (duplicated points and facets) run
+ * concurrently to this traversal while the edge-based checks and the check
+ * for self-intersections are done by the calling thread.
+ * @see MeshFixBatch
+ */
+class MeshExport MeshEvalBatch : public MeshEvaluation
+{
+public:
+  /** The checks to run. */
+  enum Check {
+    Invalids          = 0x0001,
+    NaNPoints         = 0x0002,
+    RangePoints       = 0x0004,
+    RangeFacets       = 0x0008,
+    CorruptedFacets   = 0x0010,
+    DegeneratedFacets = 0x0020,
+    DeformedFacets    = 0x0040,
+    DuplicatedPoints  = 0x0080,
+    DuplicatedFacets  = 0x0100,
+    Neighbourhood     = 0x0200,
+    NonManifolds      = 0x0400,
+    SelfIntersections = 0x0800,
+    /** All checks except the expensive or rather cosmetic ones. */
+    Defaults          = 0x07bf,
+    All               = 0x0fff
+  };
+
+  /**
+   * Construction. \a iChecks is a combination of Check flags.
+   */
+  MeshEvalBatch (const MeshKernel &rclM, int iChecks = Defaults);
+  /**
+   * Destruction.
+   */
+  ~MeshEvalBatch () { }
+  /**
+   * Runs all selected checks and returns false if any defect was found.
+   */
+  bool Evaluate ();
+  /**
+   * Returns the defects found by the last call of Evaluate().
+   */
+  const MeshDefectReport& GetReport() const
+  { return _clReport; }
+
+protected:
+  /** The results of a range of points or facets. */
+  struct ElementRange
+  {
+    unsigned long ulBegin, ulEnd;
+    std::vector<unsigned long> invalid, nan, rangePoints, rangeFacets;
+    std::vector<unsigned long> corrupted, degenerated, deformed;
+  };
+
+  void CheckPoints (ElementRange &rclRange) const;
+  void CheckFacets (ElementRange &rclRange) const;
+  void FindDuplicatedPoints (void);
+  void FindDuplicatedFacets (void);
+  void Traverse (unsigned long ulCtElements, bool bFacets, std::vector<ElementRange> &raclRanges) const;
+  static void Merge (std::vector<ElementRange> &raclRanges, std::vector<unsigned long> ElementRange::*pList,
+                     std::vector<unsigned long> &raulResult);
+
+private:
+  int _iChecks;
+  MeshDefectReport _clReport;
+};
+
+/**
+ * The MeshFixBatch class repairs the defects reported by MeshEvalBatch. The
+ * repairs are applied in an order where a later step doesn't re-introduce
+ * defects removed by an earlier one: invalid elements and indices first, then
+ * duplicated points (which may produce degenerated and duplicated facets),
+ * duplicated and degenerated facets and finally the topological defects.
+ * Since each repair changes the indices the checks that need indices are
+ * redone on the modified mesh.
+ * @see MeshEvalBatch
+ */
+class MeshExport MeshFixBatch : public MeshValidation
+{
+public:
+  /**
+   * Construction. Only the defects listed in \a rclReport get repaired.
+   * \a fMaxAngle is used to fix deformed facets.
+   */
+  MeshFixBatch (MeshKernel &rclM, const MeshDefectReport &rclReport, float fMaxAngle = 0.1f)
+    : MeshValidation(rclM), _rclReport(rclReport), _fMaxAngle(fMaxAngle) { }
+  /**
+   * Destruction.
+   */
+  ~MeshFixBatch () { }
+  /**
+   * Repairs the defects.
+   */
+  bool Fixup ();
+
+private:
+  const MeshDefectReport& _rclReport;
+  float _fMaxAngle;
+};
+
+} // namespace MeshCore
+
+#endif // MESH_BATCHEVALUATION_H
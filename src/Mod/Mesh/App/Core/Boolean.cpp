@@ -0,0 +1,1344 @@
+/***************************************************************************
+ *   Copyright (c) 2012 Imetric 3D GmbH                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <algorithm>
+# include <climits>
+# include <cmath>
+#endif
+
+#include <QFuture>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+
+#include "Boolean.h"
+#include "BVH.h"
+#include "Elements.h"
+#include "MeshKernel.h"
+
+using namespace MeshCore;
+
+
+namespace MeshCore {
+
+// Exact orientation predicate for points with float coordinates. The fast
+// evaluation in double precision is used if it is safely away from zero,
+// otherwise the determinant is summed up exactly as floating-point expansion
+// (see J.R. Shewchuk, Adaptive Precision Floating-Point Arithmetic and Fast
+// Robust Geometric Predicates).
+
+static inline void TwoSum (double a, double b, double &x, double &y)
+{
+  x = a + b;
+  double bv = x - a;
+  double av = x - bv;
+  y = (a - av) + (b - bv);
+}
+
+static inline void TwoProduct (double a, double b, double &x, double &y)
+{
+  x = a * b;
+  double c = 134217729.0 * a; // 2^27 + 1
+  double ahi = c - (c - a);
+  double alo = a - ahi;
+  c = 134217729.0 * b;
+  double bhi = c - (c - b);
+  double blo = b - bhi;
+  y = alo * blo - (((x - ahi * bhi) - alo * bhi) - ahi * blo);
+}
+
+/** Adds \a b to the expansion \a e with \a n components and returns the new
+ * number of components. Zero components are dropped. */
+static inline int GrowExpansion (double *e, int n, double b)
+{
+  double q = b, s, h;
+  int m = 0;
+  for (int i = 0; i < n; i++) {
+    TwoSum(q, e[i], s, h);
+    q = s;
+    if (h != 0.0)
+      e[m++] = h;
+  }
+  if (q != 0.0)
+    e[m++] = q;
+  return m;
+}
+
+static int OrientExact (const Base::Vector3f &a, const Base::Vector3f &b,
+                        const Base::Vector3f &c, const Base::Vector3f &d)
+{
+  // The determinant |x y z 1| of the four points is expanded along the z
+  // column. The product of two floats is exact in double precision, only the
+  // multiplication with z needs an error term.
+  static const int aiOthers[4][3] = {{1,2,3},{0,2,3},{0,1,3},{0,1,2}};
+  const Base::Vector3f* p[4] = {&a, &b, &c, &d};
+  double e[48];
+  int n = 0;
+  for (int i = 0; i < 4; i++) {
+    const Base::Vector3f& u = *p[aiOthers[i][0]];
+    const Base::Vector3f& v = *p[aiOthers[i][1]];
+    const Base::Vector3f& w = *p[aiOthers[i][2]];
+    double afTerms[6];
+    afTerms[0] =  (double)u.x * (double)v.y;
+    afTerms[1] = -(double)v.x * (double)u.y;
+    afTerms[2] =  (double)v.x * (double)w.y;
+    afTerms[3] = -(double)w.x * (double)v.y;
+    afTerms[4] =  (double)w.x * (double)u.y;
+    afTerms[5] = -(double)u.x * (double)w.y;
+    // the orientation is the negative determinant
+    double z = (i % 2 == 0) ? -(double)p[i]->z : (double)p[i]->z;
+    for (int j = 0; j < 6; j++) {
+      double hi, lo;
+      TwoProduct(afTerms[j], z, hi, lo);
+      n = GrowExpansion(e, n, lo);
+      n = GrowExpansion(e, n, hi);
+    }
+  }
+
+  if (n == 0)
+    return 0;
+  return e[n - 1] > 0.0 ? 1 : -1;
+}
+
+/** Returns 1 if \a d lies above the plane through \a a, \a b and \a c,
+ * -1 if it lies below and 0 if it lies on the plane. */
+static int Orient (const Base::Vector3f &a, const Base::Vector3f &b,
+                   const Base::Vector3f &c, const Base::Vector3f &d)
+{
+  double ux = (double)b.x - a.x, uy = (double)b.y - a.y, uz = (double)b.z - a.z;
+  double vx = (double)c.x - a.x, vy = (double)c.y - a.y, vz = (double)c.z - a.z;
+  double wx = (double)d.x - a.x, wy = (double)d.y - a.y, wz = (double)d.z - a.z;
+  double fDet = wx * (uy * vz - uz * vy) + wy * (uz * vx - ux * vz) + wz * (ux * vy - uy * vx);
+  double fPerm = fabs(wx) * (fabs(uy * vz) + fabs(uz * vy))
+               + fabs(wy) * (fabs(uz * vx) + fabs(ux * vz))
+               + fabs(wz) * (fabs(ux * vy) + fabs(uy * vx));
+  double fBound = 7.7715611723761027e-16 * fPerm; // (7 + 56 eps) * eps
+  if (fDet > fBound)
+    return 1;
+  if (-fDet > fBound)
+    return -1;
+  return OrientExact(a, b, c, d);
+}
+
+/** Adds \a fFactor times the \a iAxis component of (q - p) x (s - r) to the
+ * expansion \a e with \a n components and returns the new number of
+ * components. \a fFactor must be a float value. */
+static int GrowCross (double *e, int n, double fFactor, int iAxis,
+                      const Base::Vector3f &p, const Base::Vector3f &q,
+                      const Base::Vector3f &r, const Base::Vector3f &s)
+{
+  // (q - p)_i * (s - r)_j - (q - p)_j * (s - r)_i with all products of two
+  // floats, these are exact in double precision
+  int i = (iAxis + 1) % 3, j = (iAxis + 2) % 3;
+  double afTerms[8];
+  afTerms[0] =  (double)q[i] * (double)s[j];
+  afTerms[1] = -(double)q[i] * (double)r[j];
+  afTerms[2] = -(double)p[i] * (double)s[j];
+  afTerms[3] =  (double)p[i] * (double)r[j];
+  afTerms[4] = -(double)q[j] * (double)s[i];
+  afTerms[5] =  (double)q[j] * (double)r[i];
+  afTerms[6] =  (double)p[j] * (double)s[i];
+  afTerms[7] = -(double)p[j] * (double)r[i];
+  for (int k = 0; k < 8; k++) {
+    double hi, lo;
+    TwoProduct(afTerms[k], fFactor, hi, lo);
+    if (lo != 0.0)
+      n = GrowExpansion(e, n, lo);
+    n = GrowExpansion(e, n, hi);
+  }
+  return n;
+}
+
+static inline bool SamePoint (const Base::Vector3f &p, const Base::Vector3f &q)
+{
+  return p.x == q.x && p.y == q.y && p.z == q.z;
+}
+
+/** Checks whether \a x lies exactly inside the segment between \a p and \a q. */
+static bool IsOnSegment (const Base::Vector3f &p, const Base::Vector3f &q, const Base::Vector3f &x)
+{
+  for (int iAxis = 0; iAxis < 3; iAxis++) {
+    double e[16];
+    if (GrowCross(e, 0, 1.0, iAxis, p, q, p, x) > 0)
+      return false;
+  }
+  for (int i = 0; i < 3; i++) {
+    if (p[i] != q[i])
+      return (p[i] < x[i] && x[i] < q[i]) || (q[i] < x[i] && x[i] < p[i]);
+  }
+  return false;
+}
+
+/** Orders points by their coordinates. */
+struct CutPointOrder
+{
+  const std::vector<Base::Vector3f>* pclPoints;
+  bool operator () (unsigned long i, unsigned long j) const
+  {
+    const Base::Vector3f& p = (*pclPoints)[i];
+    const Base::Vector3f& q = (*pclPoints)[j];
+    if (p.x != q.x)
+      return p.x < q.x;
+    if (p.y != q.y)
+      return p.y < q.y;
+    return p.z < q.z;
+  }
+};
+
+// ----------------------------------------------------------------------------
+// Planar helpers for the retriangulation of a facet
+
+/** The vertices of a facet projected onto the plane of its largest normal
+ * component. The projection keeps the orientation of the facet. */
+struct PlanarPoints
+{
+  std::vector<double> x, y;
+
+  double Orient (int a, int b, int c) const
+  {
+    return (x[b] - x[a]) * (y[c] - y[a]) - (y[b] - y[a]) * (x[c] - x[a]);
+  }
+
+  double Area (const std::vector<int> &raiPoly) const
+  {
+    double fArea = 0.0;
+    std::size_t n = raiPoly.size();
+    for (std::size_t i = 0; i < n; i++) {
+      int a = raiPoly[i], b = raiPoly[(i + 1) % n];
+      fArea += x[a] * y[b] - x[b] * y[a];
+    }
+    return 0.5 * fArea;
+  }
+
+  bool Contains (const std::vector<int> &raiPoly, int p) const
+  {
+    bool bInside = false;
+    std::size_t n = raiPoly.size();
+    for (std::size_t i = 0, j = n - 1; i < n; j = i++) {
+      int a = raiPoly[i], b = raiPoly[j];
+      if ((y[a] > y[p]) != (y[b] > y[p]) &&
+          x[p] < (x[b] - x[a]) * (y[p] - y[a]) / (y[b] - y[a]) + x[a])
+        bInside = !bInside;
+    }
+    return bInside;
+  }
+
+  /** Checks if the segment (a,b) properly crosses an edge of \a raiPoly. */
+  bool Crosses (int a, int b, const std::vector<int> &raiPoly) const
+  {
+    std::size_t n = raiPoly.size();
+    for (std::size_t i = 0; i < n; i++) {
+      int c = raiPoly[i], d = raiPoly[(i + 1) % n];
+      if (c == a || c == b || d == a || d == b)
+        continue;
+      double o1 = Orient(a, b, c), o2 = Orient(a, b, d);
+      double o3 = Orient(c, d, a), o4 = Orient(c, d, b);
+      if (((o1 > 0.0 && o2 < 0.0) || (o1 < 0.0 && o2 > 0.0)) &&
+          ((o3 > 0.0 && o4 < 0.0) || (o3 < 0.0 && o4 > 0.0)))
+        return true;
+    }
+    return false;
+  }
+};
+
+/** Returns the representative of the region of element \a x. */
+static inline unsigned long FindRegion (std::vector<unsigned long> &raulRegion, unsigned long x)
+{
+  while (raulRegion[x] != x) {
+    raulRegion[x] = raulRegion[raulRegion[x]];
+    x = raulRegion[x];
+  }
+  return x;
+}
+
+/** Joins the regions of the elements \a x and \a y. */
+static inline void JoinRegions (std::vector<unsigned long> &raulRegion, unsigned long x, unsigned long y)
+{
+  x = FindRegion(raulRegion, x);
+  y = FindRegion(raulRegion, y);
+  if (x != y)
+    raulRegion[x] = y;
+}
+
+/** Orders half-edges by their angle. */
+struct AngleOrder
+{
+  const std::vector<double>* pfAngles;
+  bool operator () (int i, int j) const
+  { return (*pfAngles)[i] < (*pfAngles)[j]; }
+};
+
+/** Connects the hole \a raiHole to the polygon \a raiPoly by the shortest
+ * bridge not crossing any edge of the polygon or of the holes. */
+static bool BridgeHole (const PlanarPoints &rclPts, std::vector<int> &raiPoly, const std::vector<int> &raiHole,
+                        const std::vector<std::vector<int> > &raclHoles)
+{
+  std::vector<std::pair<double, std::pair<std::size_t, std::size_t> > > aclCandidates;
+  for (std::size_t i = 0; i < raiHole.size(); i++) {
+    for (std::size_t j = 0; j < raiPoly.size(); j++) {
+      int h = raiHole[i], p = raiPoly[j];
+      double dx = rclPts.x[h] - rclPts.x[p], dy = rclPts.y[h] - rclPts.y[p];
+      aclCandidates.push_back(std::make_pair(dx * dx + dy * dy, std::make_pair(i, j)));
+    }
+  }
+  std::sort(aclCandidates.begin(), aclCandidates.end());
+
+  for (std::size_t k = 0; k < aclCandidates.size(); k++) {
+    std::size_t i = aclCandidates[k].second.first, j = aclCandidates[k].second.second;
+    int h = raiHole[i], p = raiPoly[j];
+    bool bVisible = !rclPts.Crosses(h, p, raiPoly);
+    for (std::size_t l = 0; l < raclHoles.size() && bVisible; l++)
+      bVisible = !rclPts.Crosses(h, p, raclHoles[l]);
+    if (!bVisible)
+      continue;
+
+    // walk around the hole and return over the bridge
+    std::vector<int> aiMerged(raiPoly.begin(), raiPoly.begin() + j + 1);
+    for (std::size_t l = 0; l <= raiHole.size(); l++)
+      aiMerged.push_back(raiHole[(i + l) % raiHole.size()]);
+    aiMerged.insert(aiMerged.end(), raiPoly.begin() + j, raiPoly.end());
+    raiPoly.swap(aiMerged);
+    return true;
+  }
+
+  return false;
+}
+
+/** Triangulates the simple polygon \a raiPoly by ear clipping. Returns
+ * false if the polygon had to be cut at a vertex that isn't an ear. */
+static bool ClipEars (const PlanarPoints &rclPts, std::vector<int> raiPoly, std::vector<int> &raiTriangles)
+{
+  bool bSuccess = true;
+  while (raiPoly.size() > 3) {
+    std::size_t n = raiPoly.size();
+    std::size_t ulEar = n, ulBest = 0;
+    double fBest = -1.0;
+    for (std::size_t i = 0; i < n && ulEar == n; i++) {
+      int a = raiPoly[(i + n - 1) % n], b = raiPoly[i], c = raiPoly[(i + 1) % n];
+      double fOrient = rclPts.Orient(a, b, c);
+      if (fOrient > fBest) {
+        fBest = fOrient;
+        ulBest = i;
+      }
+      if (fOrient <= 0.0)
+        continue;
+      bool bEar = true;
+      for (std::size_t j = 0; j < n && bEar; j++) {
+        int p = raiPoly[j];
+        if (p == a || p == b || p == c)
+          continue;
+        if (rclPts.Orient(a, b, p) >= 0.0 && rclPts.Orient(b, c, p) >= 0.0 && rclPts.Orient(c, a, p) >= 0.0)
+          bEar = false;
+      }
+      if (bEar)
+        ulEar = i;
+    }
+
+    if (ulEar == n) {
+      bSuccess = false;
+      ulEar = ulBest;
+    }
+    raiTriangles.push_back(raiPoly[(ulEar + n - 1) % n]);
+    raiTriangles.push_back(raiPoly[ulEar]);
+    raiTriangles.push_back(raiPoly[(ulEar + 1) % n]);
+    raiPoly.erase(raiPoly.begin() + ulEar);
+  }
+
+  if (raiPoly.size() == 3)
+    raiTriangles.insert(raiTriangles.end(), raiPoly.begin(), raiPoly.end());
+  return bSuccess;
+}
+
+} // namespace MeshCore
+
+// ----------------------------------------------------------------------------
+
+bool MeshBoolean::CutKey::operator < (const CutKey &rclKey) const
+{
+  if (ulP != rclKey.ulP)
+    return ulP < rclKey.ulP;
+  if (ulQ != rclKey.ulQ)
+    return ulQ < rclKey.ulQ;
+  return ulFacet < rclKey.ulFacet;
+}
+
+bool MeshBoolean::CutKey::operator == (const CutKey &rclKey) const
+{
+  return ulP == rclKey.ulP && ulQ == rclKey.ulQ && ulFacet == rclKey.ulFacet;
+}
+
+MeshBoolean::MeshBoolean (const MeshKernel &rclMesh1, const MeshKernel &rclMesh2, MeshKernel &rclResult,
+                          SetOperations::OperationType eType)
+  : _rclResult(rclResult), _eType(eType), _clStats(Statistics()),
+    _ulCtPoints1(0), _ulCtFacets1(0), _ulCtPoints(0)
+{
+  _apclMesh[0] = &rclMesh1;
+  _apclMesh[1] = &rclMesh2;
+}
+
+MeshBoolean::~MeshBoolean (void)
+{
+}
+
+unsigned long MeshBoolean::GetCanonical (unsigned long ulIndex) const
+{
+  std::vector<std::pair<unsigned long, unsigned long> >::const_iterator it;
+  it = std::lower_bound(_aclCanonical.begin(), _aclCanonical.end(), std::make_pair(ulIndex, 0UL));
+  if (it != _aclCanonical.end() && it->first == ulIndex)
+    return it->second;
+  return ulIndex;
+}
+
+const Base::Vector3f& MeshBoolean::GetPoint (unsigned long ulIndex) const
+{
+  if (ulIndex < _ulCtPoints1)
+    return _apclMesh[0]->GetPoints()[ulIndex];
+  else if (ulIndex < _ulCtPoints)
+    return _apclMesh[1]->GetPoints()[ulIndex - _ulCtPoints1];
+  else
+    return _aclCutPoints[ulIndex - _ulCtPoints];
+}
+
+void MeshBoolean::GetFacetPoints (unsigned long ulFacet, unsigned long aulPoints[3]) const
+{
+  if (ulFacet < _ulCtFacets1) {
+    const MeshFacet& rclFacet = _apclMesh[0]->GetFacets()[ulFacet];
+    for (int i = 0; i < 3; i++)
+      aulPoints[i] = rclFacet._aulPoints[i];
+  }
+  else {
+    const MeshFacet& rclFacet = _apclMesh[1]->GetFacets()[ulFacet - _ulCtFacets1];
+    for (int i = 0; i < 3; i++)
+      aulPoints[i] = rclFacet._aulPoints[i] + _ulCtPoints1;
+  }
+}
+
+int MeshBoolean::EdgeSign (unsigned long ulP, unsigned long ulQ, unsigned long ulA, unsigned long ulB) const
+{
+  // Evaluate the predicate in a canonical order so that both facets sharing
+  // the edge (ulA, ulB) get opposite signs, also for the degenerated case.
+  bool bFlip = false;
+  if (ulP > ulQ) {
+    std::swap(ulP, ulQ);
+    bFlip = !bFlip;
+  }
+  if (ulA > ulB) {
+    std::swap(ulA, ulB);
+    bFlip = !bFlip;
+  }
+  int iSign = Orient(GetPoint(ulP), GetPoint(ulQ), GetPoint(ulA), GetPoint(ulB));
+  if (iSign == 0)
+    iSign = SymbolicOrient(ulP, ulQ, ulA, ulB);
+  if (iSign == 0)
+    iSign = 1;
+  return bFlip ? -iSign : iSign;
+}
+
+int MeshBoolean::SymbolicOrient (unsigned long ulA, unsigned long ulB, unsigned long ulC, unsigned long ulD) const
+{
+  // The points of the second mesh are moved by e * m + (e^2, e^3, e^4) with
+  // an infinitesimal e and the offset m of the point. The sign is taken from
+  // the first order term which is the sum of the scalar products of m with
+  // the gradient of the determinant with respect to the moved points. If it
+  // vanishes the translation decides.
+  static const int aiGradient[4][5] = {{-1,1,2,1,3}, {1,0,2,0,3}, {1,0,3,0,1}, {1,0,1,0,2}};
+  unsigned long aulIds[4] = { ulA, ulB, ulC, ulD };
+  const Base::Vector3f* p[4];
+  for (int i = 0; i < 4; i++)
+    p[i] = &GetPoint(aulIds[i]);
+
+  double e[288];
+  int n = 0;
+  for (int i = 0; i < 4; i++) {
+    if (aulIds[i] < _ulCtPoints1)
+      continue;
+    const int* g = aiGradient[i];
+    const Base::Vector3f& m = _aclOffsets[aulIds[i] - _ulCtPoints1];
+    for (int iAxis = 0; iAxis < 3; iAxis++) {
+      if (m[iAxis] != 0.0f)
+        n = GrowCross(e, n, g[0] * m[iAxis], iAxis, *p[g[1]], *p[g[2]], *p[g[3]], *p[g[4]]);
+    }
+  }
+  if (n > 0)
+    return e[n - 1] > 0.0 ? 1 : -1;
+
+  for (int iAxis = 0; iAxis < 3; iAxis++) {
+    n = 0;
+    for (int i = 0; i < 4; i++) {
+      if (aulIds[i] < _ulCtPoints1)
+        continue;
+      const int* g = aiGradient[i];
+      n = GrowCross(e, n, g[0], iAxis, *p[g[1]], *p[g[2]], *p[g[3]], *p[g[4]]);
+    }
+    if (n > 0)
+      return e[n - 1] > 0.0 ? 1 : -1;
+  }
+
+  return 0;
+}
+
+int MeshBoolean::FacetSide (unsigned long ulFacet, unsigned long ulPoint) const
+{
+  unsigned long aulPoints[3];
+  GetFacetPoints(ulFacet, aulPoints);
+  int iSign = Orient(GetPoint(aulPoints[0]), GetPoint(aulPoints[1]), GetPoint(aulPoints[2]), GetPoint(ulPoint));
+  if (iSign == 0 && ulPoint < _ulCtPoints)
+    iSign = SymbolicOrient(aulPoints[0], aulPoints[1], aulPoints[2], ulPoint);
+  return iSign;
+}
+
+bool MeshBoolean::IsCurveEdge (unsigned long ulP, unsigned long ulQ) const
+{
+  std::pair<unsigned long, unsigned long> clEdge(std::min<unsigned long>(ulP, ulQ), std::max<unsigned long>(ulP, ulQ));
+  std::vector<std::pair<std::pair<unsigned long, unsigned long>, unsigned long> >::const_iterator it;
+  it = std::lower_bound(_aclCurveEdges.begin(), _aclCurveEdges.end(), std::make_pair(clEdge, 0UL));
+  return it != _aclCurveEdges.end() && it->first == clEdge;
+}
+
+bool MeshBoolean::Pierces (unsigned long ulP, unsigned long ulQ, const unsigned long aulFacet[3]) const
+{
+  // The caller has already checked that P and Q lie on different sides of the
+  // plane. The edge pierces the facet if it passes all three facet edges on
+  // the same side.
+  int iSign0 = EdgeSign(ulP, ulQ, aulFacet[0], aulFacet[1]);
+  int iSign1 = EdgeSign(ulP, ulQ, aulFacet[1], aulFacet[2]);
+  if (iSign0 != iSign1)
+    return false;
+  int iSign2 = EdgeSign(ulP, ulQ, aulFacet[2], aulFacet[0]);
+  return iSign1 == iSign2;
+}
+
+void MeshBoolean::IntersectRange (PairRange &rclRange) const
+{
+  const std::vector<std::pair<unsigned long, unsigned long> >& rclPairs = *rclRange.pclPairs;
+  rclRange.ulCoplanar = 0;
+  rclRange.ulDegenerated = 0;
+
+  for (unsigned long k = rclRange.ulBegin; k < rclRange.ulEnd; k++) {
+    unsigned long aulFacets[2] = { rclPairs[k].first, rclPairs[k].second + _ulCtFacets1 };
+    unsigned long aulPoints[2][3];
+    GetFacetPoints(aulFacets[0], aulPoints[0]);
+    GetFacetPoints(aulFacets[1], aulPoints[1]);
+
+    // side of the points of each facet with respect to the plane of the other one
+    int aiSigns[2][3];
+    bool bCoplanar = true, bCut = true;
+    for (int s = 0; s < 2 && bCut; s++) {
+      const unsigned long* o = aulPoints[1 - s];
+      for (int i = 0; i < 3; i++) {
+        aiSigns[s][i] = Orient(GetPoint(o[0]), GetPoint(o[1]), GetPoint(o[2]), GetPoint(aulPoints[s][i]));
+        if (aiSigns[s][i] != 0)
+          bCoplanar = false;
+        else
+          aiSigns[s][i] = SymbolicOrient(o[0], o[1], o[2], aulPoints[s][i]);
+        if (aiSigns[s][i] == 0)
+          aiSigns[s][i] = 1; // degenerated facet
+      }
+      if (aiSigns[s][0] == aiSigns[s][1] && aiSigns[s][1] == aiSigns[s][2])
+        bCut = false;
+    }
+
+    if (bCoplanar)
+      rclRange.ulCoplanar++;
+    if (!bCut)
+      continue;
+
+    // the end points of the segment are where the edges of one facet pierce the other facet
+    Segment clSegment;
+    int iCtPoints = 0;
+    for (int s = 0; s < 2; s++) {
+      for (int i = 0; i < 3; i++) {
+        int j = (i + 1) % 3;
+        unsigned long ulP = aulPoints[s][i], ulQ = aulPoints[s][j];
+        if (aiSigns[s][i] == aiSigns[s][j] || !Pierces(ulP, ulQ, aulPoints[1 - s]))
+          continue;
+        if (iCtPoints < 2) {
+          CutKey& rclKey = clSegment.aclKeys[iCtPoints];
+          rclKey.ulP = std::min<unsigned long>(ulP, ulQ);
+          rclKey.ulQ = std::max<unsigned long>(ulP, ulQ);
+          rclKey.ulFacet = aulFacets[1 - s];
+        }
+        iCtPoints++;
+      }
+    }
+
+    if (iCtPoints == 2) {
+      clSegment.aulFacets[0] = aulFacets[0];
+      clSegment.aulFacets[1] = aulFacets[1];
+      rclRange.aclSegments.push_back(clSegment);
+    }
+    else if (iCtPoints > 0) {
+      rclRange.ulDegenerated++;
+    }
+  }
+}
+
+void MeshBoolean::Intersect (const std::vector<std::pair<unsigned long, unsigned long> > &raclPairs)
+{
+  unsigned long ulCtPairs = raclPairs.size();
+  std::vector<PairRange> aclRanges;
+  PairRange clRange;
+  clRange.pclPairs = &raclPairs;
+
+  int iThreads = QThread::idealThreadCount();
+  if (ulCtPairs < MESH_CT_PARALLEL_BOOLEAN || iThreads <= 1) {
+    clRange.ulBegin = 0;
+    clRange.ulEnd = ulCtPairs;
+    aclRanges.push_back(clRange);
+    IntersectRange(aclRanges.front());
+  }
+  else {
+    unsigned long ulCtRanges = 4 * (unsigned long)iThreads;
+    unsigned long ulStep = (ulCtPairs + ulCtRanges - 1) / ulCtRanges;
+    for (unsigned long i = 0; i < ulCtPairs; i += ulStep) {
+      clRange.ulBegin = i;
+      clRange.ulEnd = std::min<unsigned long>(i + ulStep, ulCtPairs);
+      aclRanges.push_back(clRange);
+    }
+
+    QFuture<void> future = QtConcurrent::map(aclRanges, boost::bind(&MeshBoolean::IntersectRange, this, _1));
+    future.waitForFinished();
+  }
+
+  for (std::vector<PairRange>::iterator it = aclRanges.begin(); it != aclRanges.end(); ++it) {
+    _aclSegments.insert(_aclSegments.end(), it->aclSegments.begin(), it->aclSegments.end());
+    _clStats.ulCoplanar += it->ulCoplanar;
+    _clStats.ulDegenerated += it->ulDegenerated;
+  }
+  _clStats.ulIntersections = _aclSegments.size();
+}
+
+void MeshBoolean::ComputeCutPoints (void)
+{
+  std::vector<CutKey> aclKeys;
+  aclKeys.reserve(2 * _aclSegments.size());
+  for (std::vector<Segment>::iterator it = _aclSegments.begin(); it != _aclSegments.end(); ++it) {
+    aclKeys.push_back(it->aclKeys[0]);
+    aclKeys.push_back(it->aclKeys[1]);
+  }
+  std::sort(aclKeys.begin(), aclKeys.end());
+  aclKeys.erase(std::unique(aclKeys.begin(), aclKeys.end()), aclKeys.end());
+
+  // The point is computed in double precision from the end points of the
+  // edge and the plane of the facet. If the rounded point coincides with
+  // one of these points the existing point is taken instead.
+  std::vector<unsigned long> aulIds(aclKeys.size());
+  std::vector<Base::Vector3f> aclPoints(aclKeys.size());
+  std::vector<unsigned long> aulNew;
+  for (unsigned long k = 0; k < aclKeys.size(); k++) {
+    const CutKey& rclKey = aclKeys[k];
+    unsigned long aulFacet[3];
+    GetFacetPoints(rclKey.ulFacet, aulFacet);
+    const Base::Vector3f& a = GetPoint(aulFacet[0]);
+    const Base::Vector3f& b = GetPoint(aulFacet[1]);
+    const Base::Vector3f& c = GetPoint(aulFacet[2]);
+    const Base::Vector3f& p = GetPoint(rclKey.ulP);
+    const Base::Vector3f& q = GetPoint(rclKey.ulQ);
+
+    double ux = (double)b.x - a.x, uy = (double)b.y - a.y, uz = (double)b.z - a.z;
+    double vx = (double)c.x - a.x, vy = (double)c.y - a.y, vz = (double)c.z - a.z;
+    double nx = uy * vz - uz * vy, ny = uz * vx - ux * vz, nz = ux * vy - uy * vx;
+    double fDistP = ((double)p.x - a.x) * nx + ((double)p.y - a.y) * ny + ((double)p.z - a.z) * nz;
+    double fDistQ = ((double)q.x - a.x) * nx + ((double)q.y - a.y) * ny + ((double)q.z - a.z) * nz;
+    double t = fDistP != fDistQ ? fDistP / (fDistP - fDistQ) : 0.5;
+    t = std::max<double>(0.0, std::min<double>(1.0, t));
+    Base::Vector3f clPt((float)(p.x + t * ((double)q.x - p.x)),
+                        (float)(p.y + t * ((double)q.y - p.y)),
+                        (float)(p.z + t * ((double)q.z - p.z)));
+
+    unsigned long aulCandidates[5] = { rclKey.ulP, rclKey.ulQ, aulFacet[0], aulFacet[1], aulFacet[2] };
+    aulIds[k] = ULONG_MAX;
+    for (int i = 0; i < 5; i++) {
+      if (SamePoint(clPt, GetPoint(aulCandidates[i]))) {
+        aulIds[k] = aulCandidates[i];
+        break;
+      }
+    }
+    if (aulIds[k] == ULONG_MAX) {
+      aclPoints[k] = clPt;
+      aulNew.push_back(k);
+    }
+  }
+
+  // points of different keys may coincide after rounding
+  CutPointOrder clOrder;
+  clOrder.pclPoints = &aclPoints;
+  std::sort(aulNew.begin(), aulNew.end(), clOrder);
+  for (std::vector<unsigned long>::iterator it = aulNew.begin(); it != aulNew.end(); ++it) {
+    if (it == aulNew.begin() || !SamePoint(aclPoints[*it], aclPoints[*(it - 1)]))
+      _aclCutPoints.push_back(aclPoints[*it]);
+    aulIds[*it] = _ulCtPoints + _aclCutPoints.size() - 1;
+  }
+  _clStats.ulCutPoints = aclKeys.size();
+
+  for (std::vector<Segment>::iterator it = _aclSegments.begin(); it != _aclSegments.end(); ++it) {
+    for (int i = 0; i < 2; i++) {
+      unsigned long k = std::lower_bound(aclKeys.begin(), aclKeys.end(), it->aclKeys[i]) - aclKeys.begin();
+      it->aulPoints[i] = aulIds[k];
+    }
+  }
+
+  // Points of both meshes and of the curve may coincide, e.g. if the meshes
+  // touch at a vertex. Such points are represented by the lowest index.
+  std::vector<unsigned long> aulUsed;
+  for (std::vector<Segment>::iterator it = _aclSegments.begin(); it != _aclSegments.end(); ++it) {
+    for (int i = 0; i < 2; i++) {
+      unsigned long aulFacet[3];
+      GetFacetPoints(it->aulFacets[i], aulFacet);
+      aulUsed.insert(aulUsed.end(), aulFacet, aulFacet + 3);
+      aulUsed.push_back(it->aulPoints[i]);
+    }
+  }
+  std::sort(aulUsed.begin(), aulUsed.end());
+  aulUsed.erase(std::unique(aulUsed.begin(), aulUsed.end()), aulUsed.end());
+  std::vector<Base::Vector3f> aclUsed(aulUsed.size());
+  std::vector<unsigned long> aulOrder(aulUsed.size());
+  for (unsigned long i = 0; i < aulUsed.size(); i++) {
+    aclUsed[i] = GetPoint(aulUsed[i]);
+    aulOrder[i] = i;
+  }
+  clOrder.pclPoints = &aclUsed;
+  std::stable_sort(aulOrder.begin(), aulOrder.end(), clOrder);
+  for (unsigned long i = 0, j; i < aulOrder.size(); i = j) {
+    for (j = i + 1; j < aulOrder.size() && SamePoint(aclUsed[aulOrder[i]], aclUsed[aulOrder[j]]); j++)
+      _aclCanonical.push_back(std::make_pair(aulUsed[aulOrder[j]], aulUsed[aulOrder[i]]));
+  }
+  std::sort(_aclCanonical.begin(), _aclCanonical.end());
+
+  for (std::vector<Segment>::iterator it = _aclSegments.begin(); it != _aclSegments.end(); ++it) {
+    it->aulPoints[0] = GetCanonical(it->aulPoints[0]);
+    it->aulPoints[1] = GetCanonical(it->aulPoints[1]);
+    if (it->aulPoints[0] != it->aulPoints[1]) {
+      _aclCurveEdges.push_back(std::make_pair(std::make_pair(std::min<unsigned long>(it->aulPoints[0], it->aulPoints[1]),
+                                                             std::max<unsigned long>(it->aulPoints[0], it->aulPoints[1])),
+                                              (unsigned long)(it - _aclSegments.begin())));
+    }
+  }
+  std::sort(_aclCurveEdges.begin(), _aclCurveEdges.end());
+
+  // In degenerated cases a point of the curve lies exactly on an edge of a
+  // cut facet. Then the neighbour facet must be split at this point, too.
+  for (std::vector<Segment>::iterator it = _aclSegments.begin(); it != _aclSegments.end(); ++it) {
+    if (it->aulPoints[0] == it->aulPoints[1])
+      continue;
+    for (int s = 0; s < 2; s++) {
+      const MeshFacetArray& rclFacets = _apclMesh[s]->GetFacets();
+      unsigned long ulFacetOffset = s == 0 ? 0 : _ulCtFacets1;
+      const MeshFacet& rclFacet = rclFacets[it->aulFacets[s] - ulFacetOffset];
+      unsigned long aulCorners[3];
+      GetFacetPoints(it->aulFacets[s], aulCorners);
+      for (int i = 0; i < 3; i++)
+        aulCorners[i] = GetCanonical(aulCorners[i]);
+      for (int i = 0; i < 2; i++) {
+        unsigned long ulPt = it->aulPoints[i];
+        if (ulPt == aulCorners[0] || ulPt == aulCorners[1] || ulPt == aulCorners[2])
+          continue;
+        for (int e = 0; e < 3; e++) {
+          unsigned long ulNeighbour = rclFacet._aulNeighbours[e];
+          if (ulNeighbour != ULONG_MAX &&
+              IsOnSegment(GetPoint(aulCorners[e]), GetPoint(aulCorners[(e + 1) % 3]), GetPoint(ulPt))) {
+            _aclFacetPoints.push_back(std::make_pair(ulNeighbour + ulFacetOffset, ulPt));
+            break;
+          }
+        }
+      }
+    }
+  }
+  std::sort(_aclFacetPoints.begin(), _aclFacetPoints.end());
+  _aclFacetPoints.erase(std::unique(_aclFacetPoints.begin(), _aclFacetPoints.end()), _aclFacetPoints.end());
+}
+
+void MeshBoolean::SplitFacet (unsigned long ulFacet, SplitRange &rclRange) const
+{
+  std::pair<unsigned long, unsigned long> clFirst(ulFacet, 0), clLast(ulFacet, ULONG_MAX);
+  unsigned long ulStart = std::lower_bound(_aclFacetSegments.begin(), _aclFacetSegments.end(), clFirst) - _aclFacetSegments.begin();
+  unsigned long ulEnd = std::upper_bound(_aclFacetSegments.begin(), _aclFacetSegments.end(), clLast) - _aclFacetSegments.begin();
+  unsigned long aulCorners[3];
+  GetFacetPoints(ulFacet, aulCorners);
+  for (int i = 0; i < 3; i++)
+    aulCorners[i] = GetCanonical(aulCorners[i]);
+
+  // Collect the points of the curve with the facet edge they lie on (or -1
+  // for inner points) and the segments with the facet they are cut with.
+  std::vector<std::pair<unsigned long, int> > aclPoints;
+  std::vector<std::pair<std::pair<unsigned long, unsigned long>, unsigned long> > aclCurve;
+  for (unsigned long k = ulStart; k < ulEnd; k++) {
+    // a segment may shrink to a point by rounding, nevertheless its keys
+    // tell on which edge the point lies
+    const Segment& rclSegment = _aclSegments[_aclFacetSegments[k].second];
+    for (int i = 0; i < 2; i++) {
+      unsigned long ulPt = rclSegment.aulPoints[i];
+      if (ulPt == aulCorners[0] || ulPt == aulCorners[1] || ulPt == aulCorners[2])
+        continue;
+      const CutKey& rclKey = rclSegment.aclKeys[i];
+      int iEdge = -1;
+      if (rclKey.ulFacet != ulFacet) {
+        for (int e = 0; e < 3; e++) {
+          unsigned long ulP = aulCorners[e], ulQ = aulCorners[(e + 1) % 3];
+          if ((ulP == rclKey.ulP && ulQ == rclKey.ulQ) || (ulP == rclKey.ulQ && ulQ == rclKey.ulP))
+            iEdge = e;
+        }
+      }
+      aclPoints.push_back(std::make_pair(ulPt, iEdge));
+    }
+    if (rclSegment.aulPoints[0] == rclSegment.aulPoints[1])
+      continue;
+    unsigned long ulOther = rclSegment.aulFacets[0] == ulFacet ? rclSegment.aulFacets[1] : rclSegment.aulFacets[0];
+    aclCurve.push_back(std::make_pair(std::make_pair(rclSegment.aulPoints[0], rclSegment.aulPoints[1]), ulOther));
+  }
+
+  // points of the curve lying on the edges but not ending a segment on this facet
+  std::vector<std::pair<unsigned long, unsigned long> >::const_iterator it;
+  it = std::lower_bound(_aclFacetPoints.begin(), _aclFacetPoints.end(), clFirst);
+  for (; it != _aclFacetPoints.end() && it->first == ulFacet; ++it)
+    aclPoints.push_back(std::make_pair(it->second, -1));
+
+  // points on an edge take precedence over inner points with the same index
+  std::sort(aclPoints.begin(), aclPoints.end());
+  std::vector<unsigned long> aulIndices(aulCorners, aulCorners + 3);
+  std::vector<int> aiEdges(3, -2);
+  for (std::size_t i = 0; i < aclPoints.size(); i++) {
+    if (i + 1 < aclPoints.size() && aclPoints[i + 1].first == aclPoints[i].first)
+      continue;
+    aulIndices.push_back(aclPoints[i].first);
+    aiEdges.push_back(aclPoints[i].second);
+  }
+  int iCtPoints = (int)aulIndices.size();
+
+  // In degenerated cases an edge of the other mesh pierces the facet exactly
+  // at its boundary. The point is then shared with the neighbour facet.
+  for (int i = 3; i < iCtPoints; i++) {
+    for (int e = 0; e < 3 && aiEdges[i] < 0; e++) {
+      if (IsOnSegment(GetPoint(aulCorners[e]), GetPoint(aulCorners[(e + 1) % 3]), GetPoint(aulIndices[i])))
+        aiEdges[i] = e;
+    }
+  }
+
+  // project onto the plane of the largest normal component
+  const Base::Vector3f& a = GetPoint(aulCorners[0]);
+  const Base::Vector3f& b = GetPoint(aulCorners[1]);
+  const Base::Vector3f& c = GetPoint(aulCorners[2]);
+  double afNormal[3];
+  afNormal[0] = ((double)b.y - a.y) * ((double)c.z - a.z) - ((double)b.z - a.z) * ((double)c.y - a.y);
+  afNormal[1] = ((double)b.z - a.z) * ((double)c.x - a.x) - ((double)b.x - a.x) * ((double)c.z - a.z);
+  afNormal[2] = ((double)b.x - a.x) * ((double)c.y - a.y) - ((double)b.y - a.y) * ((double)c.x - a.x);
+  int iAxis = 0;
+  for (int i = 1; i < 3; i++) {
+    if (fabs(afNormal[i]) > fabs(afNormal[iAxis]))
+      iAxis = i;
+  }
+  int iU = (iAxis + 1) % 3, iV = (iAxis + 2) % 3;
+  if (afNormal[iAxis] < 0.0)
+    std::swap(iU, iV);
+
+  PlanarPoints clPts;
+  clPts.x.resize(iCtPoints);
+  clPts.y.resize(iCtPoints);
+  for (int i = 0; i < iCtPoints; i++) {
+    const Base::Vector3f& p = GetPoint(aulIndices[i]);
+    clPts.x[i] = p[iU];
+    clPts.y[i] = p[iV];
+  }
+
+  // the edges of the graph: the facet edges split at the curve points and the curve segments
+  std::vector<std::pair<int, int> > aclEdges;
+  for (int e = 0; e < 3; e++) {
+    int s = e, t = (e + 1) % 3;
+    std::vector<std::pair<double, int> > aclOnEdge;
+    double dx = clPts.x[t] - clPts.x[s], dy = clPts.y[t] - clPts.y[s];
+    for (int i = 3; i < iCtPoints; i++) {
+      if (aiEdges[i] == e)
+        aclOnEdge.push_back(std::make_pair((clPts.x[i] - clPts.x[s]) * dx + (clPts.y[i] - clPts.y[s]) * dy, i));
+    }
+    std::sort(aclOnEdge.begin(), aclOnEdge.end());
+    int iPrev = s;
+    for (std::vector<std::pair<double, int> >::iterator it = aclOnEdge.begin(); it != aclOnEdge.end(); ++it) {
+      aclEdges.push_back(std::make_pair(iPrev, it->second));
+      iPrev = it->second;
+    }
+    aclEdges.push_back(std::make_pair(iPrev, t));
+  }
+
+  std::vector<std::pair<std::pair<int, int>, unsigned long> > aclConstraints;
+  for (std::size_t i = 0; i < aclCurve.size(); i++) {
+    int iP = -1, iQ = -1;
+    for (int j = 0; j < 3; j++) {
+      if (aulIndices[j] == aclCurve[i].first.first)
+        iP = j;
+      if (aulIndices[j] == aclCurve[i].first.second)
+        iQ = j;
+    }
+    if (iP < 0)
+      iP = std::lower_bound(aulIndices.begin() + 3, aulIndices.end(), aclCurve[i].first.first) - aulIndices.begin();
+    if (iQ < 0)
+      iQ = std::lower_bound(aulIndices.begin() + 3, aulIndices.end(), aclCurve[i].first.second) - aulIndices.begin();
+    aclEdges.push_back(std::make_pair(iP, iQ));
+    aclConstraints.push_back(std::make_pair(std::make_pair(std::min<int>(iP, iQ), std::max<int>(iP, iQ)), aclCurve[i].second));
+  }
+  std::sort(aclConstraints.begin(), aclConstraints.end());
+
+  for (std::vector<std::pair<int, int> >::iterator it = aclEdges.begin(); it != aclEdges.end(); ++it) {
+    if (it->first > it->second)
+      std::swap(it->first, it->second);
+  }
+  std::sort(aclEdges.begin(), aclEdges.end());
+  aclEdges.erase(std::unique(aclEdges.begin(), aclEdges.end()), aclEdges.end());
+
+  // remove the curve segments ending inside the facet
+  int iCtEdges = (int)aclEdges.size();
+  std::vector<std::vector<int> > aclAdjacent(iCtPoints);
+  std::vector<char> abAlive(iCtEdges, 1);
+  for (int e = 0; e < iCtEdges; e++) {
+    aclAdjacent[aclEdges[e].first].push_back(e);
+    aclAdjacent[aclEdges[e].second].push_back(e);
+  }
+  std::vector<int> aiDegree(iCtPoints), aiDangling;
+  for (int i = 0; i < iCtPoints; i++) {
+    aiDegree[i] = (int)aclAdjacent[i].size();
+    if (i >= 3 && aiDegree[i] == 1)
+      aiDangling.push_back(i);
+  }
+  while (!aiDangling.empty()) {
+    int i = aiDangling.back();
+    aiDangling.pop_back();
+    for (std::vector<int>::iterator it = aclAdjacent[i].begin(); it != aclAdjacent[i].end(); ++it) {
+      if (!abAlive[*it])
+        continue;
+      abAlive[*it] = 0;
+      rclRange.ulOpenEdges++;
+      aiDegree[i]--;
+      int j = aclEdges[*it].first == i ? aclEdges[*it].second : aclEdges[*it].first;
+      if (--aiDegree[j] == 1 && j >= 3)
+        aiDangling.push_back(j);
+    }
+  }
+
+  // Sort the outgoing half-edges of each point by angle. The half-edges
+  // 2*e and 2*e+1 run along the edge e in both directions.
+  std::vector<double> afAngles(2 * iCtEdges);
+  std::vector<std::vector<int> > aclOutgoing(iCtPoints);
+  for (int e = 0; e < iCtEdges; e++) {
+    if (!abAlive[e])
+      continue;
+    int p = aclEdges[e].first, q = aclEdges[e].second;
+    afAngles[2 * e] = atan2(clPts.y[q] - clPts.y[p], clPts.x[q] - clPts.x[p]);
+    afAngles[2 * e + 1] = atan2(clPts.y[p] - clPts.y[q], clPts.x[p] - clPts.x[q]);
+    aclOutgoing[p].push_back(2 * e);
+    aclOutgoing[q].push_back(2 * e + 1);
+  }
+  AngleOrder clOrder;
+  clOrder.pfAngles = &afAngles;
+  std::vector<int> aiPosition(2 * iCtEdges, -1);
+  for (int i = 0; i < iCtPoints; i++) {
+    std::sort(aclOutgoing[i].begin(), aclOutgoing[i].end(), clOrder);
+    for (std::size_t j = 0; j < aclOutgoing[i].size(); j++)
+      aiPosition[aclOutgoing[i][j]] = (int)j;
+  }
+
+  // Trace the faces. Arriving at a point the next half-edge is the one
+  // clockwise after the reverse half-edge, so the face is on the left.
+  std::vector<std::vector<int> > aclFaces, aclHoles;
+  std::vector<double> afFaceAreas;
+  std::vector<char> abVisited(2 * iCtEdges, 0);
+  for (int h = 0; h < 2 * iCtEdges; h++) {
+    if (!abAlive[h / 2] || abVisited[h])
+      continue;
+    std::vector<int> aiCycle;
+    bool bCorner = false;
+    int g = h;
+    do {
+      abVisited[g] = 1;
+      int iFrom = (g % 2 == 0) ? aclEdges[g / 2].first : aclEdges[g / 2].second;
+      aiCycle.push_back(iFrom);
+      if (iFrom < 3)
+        bCorner = true;
+      int iTwin = g ^ 1;
+      int iTo = (iTwin % 2 == 0) ? aclEdges[iTwin / 2].first : aclEdges[iTwin / 2].second;
+      const std::vector<int>& raiOut = aclOutgoing[iTo];
+      int iPos = aiPosition[iTwin];
+      g = raiOut[iPos == 0 ? raiOut.size() - 1 : iPos - 1];
+    }
+    while (g != h && !abVisited[g]);
+
+    double fArea = clPts.Area(aiCycle);
+    if (fArea > 0.0) {
+      aclFaces.push_back(aiCycle);
+      afFaceAreas.push_back(fArea);
+    }
+    else if (!bCorner && !aiCycle.empty()) {
+      aclHoles.push_back(aiCycle);
+    }
+  }
+
+  // assign each hole to the smallest face containing it
+  std::vector<std::vector<std::vector<int> > > aclFaceHoles(aclFaces.size());
+  for (std::vector<std::vector<int> >::iterator it = aclHoles.begin(); it != aclHoles.end(); ++it) {
+    std::size_t ulBest = aclFaces.size();
+    for (std::size_t f = 0; f < aclFaces.size(); f++) {
+      if (std::find_first_of(aclFaces[f].begin(), aclFaces[f].end(), it->begin(), it->end()) != aclFaces[f].end())
+        continue;
+      if (!clPts.Contains(aclFaces[f], it->front()))
+        continue;
+      if (ulBest == aclFaces.size() || afFaceAreas[f] < afFaceAreas[ulBest])
+        ulBest = f;
+    }
+    if (ulBest < aclFaces.size())
+      aclFaceHoles[ulBest].push_back(*it);
+    else
+      rclRange.ulFailures++;
+  }
+
+  // triangulate the faces
+  std::vector<int> aiTriangles;
+  for (std::size_t f = 0; f < aclFaces.size(); f++) {
+    std::vector<int>& raiFace = aclFaces[f];
+    std::vector<std::vector<int> >& raclFaceHoles = aclFaceHoles[f];
+    while (!raclFaceHoles.empty()) {
+      std::vector<int> aiHole = raclFaceHoles.back();
+      raclFaceHoles.pop_back();
+      if (!BridgeHole(clPts, raiFace, aiHole, raclFaceHoles))
+        rclRange.ulFailures++;
+    }
+    if (!ClipEars(clPts, raiFace, aiTriangles))
+      rclRange.ulFailures++;
+  }
+
+  // An edge on the curve votes for inside if the opposite point lies below
+  // the facet of the other mesh it is cut with.
+  for (std::size_t i = 0; i < aiTriangles.size(); i += 3) {
+    SubFacet clFacet;
+    clFacet.ulFacet = ulFacet;
+    clFacet.iVotes = 0;
+    for (int j = 0; j < 3; j++) {
+      int p = aiTriangles[i + j], q = aiTriangles[i + (j + 1) % 3], r = aiTriangles[i + (j + 2) % 3];
+      clFacet.aulPoints[j] = aulIndices[p];
+      std::pair<int, int> clEdge(std::min<int>(p, q), std::max<int>(p, q));
+      std::vector<std::pair<std::pair<int, int>, unsigned long> >::iterator it;
+      it = std::lower_bound(aclConstraints.begin(), aclConstraints.end(), std::make_pair(clEdge, 0UL));
+      if (it != aclConstraints.end() && it->first == clEdge) {
+        clFacet.iVotes -= FacetSide(it->second, aulIndices[r]);
+      }
+    }
+    rclRange.aclFacets.push_back(clFacet);
+  }
+}
+
+void MeshBoolean::RetriangulateRange (SplitRange &rclRange) const
+{
+  rclRange.ulOpenEdges = 0;
+  rclRange.ulFailures = 0;
+  for (unsigned long i = rclRange.ulBegin; i < rclRange.ulEnd; i++)
+    SplitFacet(_aulSplitFacets[i], rclRange);
+}
+
+void MeshBoolean::Retriangulate (std::vector<SubFacet> &raclFacets)
+{
+  for (unsigned long i = 0; i < _aclSegments.size(); i++) {
+    _aclFacetSegments.push_back(std::make_pair(_aclSegments[i].aulFacets[0], i));
+    _aclFacetSegments.push_back(std::make_pair(_aclSegments[i].aulFacets[1], i));
+  }
+  std::sort(_aclFacetSegments.begin(), _aclFacetSegments.end());
+  for (unsigned long i = 0; i < _aclFacetSegments.size(); i++)
+    _aulSplitFacets.push_back(_aclFacetSegments[i].first);
+  for (unsigned long i = 0; i < _aclFacetPoints.size(); i++)
+    _aulSplitFacets.push_back(_aclFacetPoints[i].first);
+  std::sort(_aulSplitFacets.begin(), _aulSplitFacets.end());
+  _aulSplitFacets.erase(std::unique(_aulSplitFacets.begin(), _aulSplitFacets.end()), _aulSplitFacets.end());
+  unsigned long ulCtFacets = _aulSplitFacets.size();
+  _clStats.ulSplitFacets = ulCtFacets;
+
+  std::vector<SplitRange> aclRanges;
+  SplitRange clRange;
+  int iThreads = QThread::idealThreadCount();
+  if (ulCtFacets < MESH_CT_PARALLEL_BOOLEAN || iThreads <= 1) {
+    clRange.ulBegin = 0;
+    clRange.ulEnd = ulCtFacets;
+    aclRanges.push_back(clRange);
+    RetriangulateRange(aclRanges.front());
+  }
+  else {
+    unsigned long ulCtRanges = 4 * (unsigned long)iThreads;
+    unsigned long ulStep = (ulCtFacets + ulCtRanges - 1) / ulCtRanges;
+    for (unsigned long i = 0; i < ulCtFacets; i += ulStep) {
+      clRange.ulBegin = i;
+      clRange.ulEnd = std::min<unsigned long>(i + ulStep, ulCtFacets);
+      aclRanges.push_back(clRange);
+    }
+
+    QFuture<void> future = QtConcurrent::map(aclRanges, boost::bind(&MeshBoolean::RetriangulateRange, this, _1));
+    future.waitForFinished();
+  }
+
+  for (std::vector<SplitRange>::iterator it = aclRanges.begin(); it != aclRanges.end(); ++it) {
+    raclFacets.insert(raclFacets.end(), it->aclFacets.begin(), it->aclFacets.end());
+    _clStats.ulOpenEdges += it->ulOpenEdges;
+    _clStats.ulFailures += it->ulFailures;
+  }
+}
+
+bool MeshBoolean::IsInside (const Base::Vector3f &rclPt, int iSide, const MeshFacetBVH &rclBVH) const
+{
+  // A point is inside if the nearest facet hit by a ray is seen from its
+  // back side. Take the majority of three rays in skew directions.
+  static const float afDirs[3][3] = {{ 0.2672612f,  0.5345225f,  0.8017837f},
+                                     {-0.8017837f,  0.2672612f,  0.5345225f},
+                                     { 0.5345225f, -0.8017837f, -0.2672612f}};
+  int iInside = 0;
+  for (int i = 0; i < 3; i++) {
+    Base::Vector3f clDir(afDirs[i][0], afDirs[i][1], afDirs[i][2]), clRes;
+    unsigned long ulFacet;
+    if (rclBVH.NearestFacetOnRay(rclPt, clDir, clRes, ulFacet)) {
+      if (_apclMesh[iSide]->GetFacet(ulFacet).GetNormal() * clDir > 0.0f)
+        iInside++;
+    }
+  }
+  return iInside >= 2;
+}
+
+void MeshBoolean::Classify (int iSide, const std::vector<SubFacet> &raclFacets, unsigned long ulBegin, unsigned long ulEnd,
+                            const MeshFacetBVH &rclOther, std::vector<char> &racInside) const
+{
+  // The elements are the facets of the mesh followed by the facets of the
+  // triangulations of the cut facets. They are grouped into regions which
+  // are connected without crossing the curve.
+  const MeshFacetArray& rclFacets = _apclMesh[iSide]->GetFacets();
+  unsigned long ulCtFacets = rclFacets.size();
+  unsigned long ulFacetOffset = iSide == 0 ? 0 : _ulCtFacets1;
+  unsigned long ulPointOffset = iSide == 0 ? 0 : _ulCtPoints1;
+  unsigned long ulCtElements = ulCtFacets + (ulEnd - ulBegin);
+
+  std::vector<char> abSplit(ulCtFacets, 0);
+  for (unsigned long k = ulBegin; k < ulEnd; k++)
+    abSplit[raclFacets[k].ulFacet - ulFacetOffset] = 1;
+
+  std::vector<unsigned long> aulRegion(ulCtElements);
+  for (unsigned long i = 0; i < ulCtElements; i++)
+    aulRegion[i] = i;
+
+  std::vector<std::pair<std::pair<unsigned long, unsigned long>, unsigned long> > aclEdges;
+  for (unsigned long f = 0; f < ulCtFacets; f++) {
+    const MeshFacet& rclFacet = rclFacets[f];
+    for (int i = 0; i < 3; i++) {
+      unsigned long n = rclFacet._aulNeighbours[i];
+      if (n == ULONG_MAX || abSplit[n] == abSplit[f])
+        continue;
+      // edge between a cut and an uncut facet
+      if (abSplit[n]) {
+        unsigned long p = GetCanonical(rclFacet._aulPoints[i] + ulPointOffset);
+        unsigned long q = GetCanonical(rclFacet._aulPoints[(i + 1) % 3] + ulPointOffset);
+        aclEdges.push_back(std::make_pair(std::make_pair(std::min<unsigned long>(p, q), std::max<unsigned long>(p, q)), f));
+      }
+    }
+    if (abSplit[f])
+      continue;
+    for (int i = 0; i < 3; i++) {
+      unsigned long n = rclFacet._aulNeighbours[i];
+      if (n != ULONG_MAX && n > f && !abSplit[n] &&
+          !IsCurveEdge(GetCanonical(rclFacet._aulPoints[i] + ulPointOffset),
+                       GetCanonical(rclFacet._aulPoints[(i + 1) % 3] + ulPointOffset))) {
+        JoinRegions(aulRegion, f, n);
+      }
+    }
+  }
+
+  for (unsigned long k = ulBegin; k < ulEnd; k++) {
+    const SubFacet& rclFacet = raclFacets[k];
+    for (int i = 0; i < 3; i++) {
+      unsigned long p = rclFacet.aulPoints[i], q = rclFacet.aulPoints[(i + 1) % 3];
+      aclEdges.push_back(std::make_pair(std::make_pair(std::min<unsigned long>(p, q), std::max<unsigned long>(p, q)),
+                                        ulCtFacets + k - ulBegin));
+    }
+  }
+  std::sort(aclEdges.begin(), aclEdges.end());
+  for (std::size_t i = 0; i < aclEdges.size(); ) {
+    std::size_t j = i + 1;
+    while (j < aclEdges.size() && aclEdges[j].first == aclEdges[i].first)
+      j++;
+    if (!IsCurveEdge(aclEdges[i].first.first, aclEdges[i].first.second)) {
+      for (std::size_t l = i + 1; l < j; l++) {
+        JoinRegions(aulRegion, aclEdges[i].second, aclEdges[l].second);
+      }
+    }
+    i = j;
+  }
+
+  // Sum up the votes of each region. Regions without votes are not touched
+  // by the curve and are checked by a ray test.
+  std::vector<int> aiVotes(ulCtElements, 0);
+  for (unsigned long k = ulBegin; k < ulEnd; k++) {
+    aiVotes[FindRegion(aulRegion, ulCtFacets + k - ulBegin)] += raclFacets[k].iVotes;
+  }
+  // In degenerated cases an edge of an uncut facet lies on the curve.
+  for (unsigned long f = 0; f < ulCtFacets; f++) {
+    if (abSplit[f])
+      continue;
+    const MeshFacet& rclFacet = rclFacets[f];
+    for (int i = 0; i < 3; i++) {
+      unsigned long p = GetCanonical(rclFacet._aulPoints[i] + ulPointOffset);
+      unsigned long q = GetCanonical(rclFacet._aulPoints[(i + 1) % 3] + ulPointOffset);
+      std::pair<unsigned long, unsigned long> clEdge(std::min<unsigned long>(p, q), std::max<unsigned long>(p, q));
+      std::vector<std::pair<std::pair<unsigned long, unsigned long>, unsigned long> >::const_iterator it;
+      it = std::lower_bound(_aclCurveEdges.begin(), _aclCurveEdges.end(), std::make_pair(clEdge, 0UL));
+      for (; it != _aclCurveEdges.end() && it->first == clEdge; ++it) {
+        const Segment& rclSegment = _aclSegments[it->second];
+        aiVotes[FindRegion(aulRegion, f)] -= FacetSide(rclSegment.aulFacets[1 - iSide],
+                                                       rclFacet._aulPoints[(i + 2) % 3] + ulPointOffset);
+      }
+    }
+  }
+
+  std::vector<signed char> aiState(ulCtElements, -1);
+  racInside.assign(ulCtElements, 0);
+  for (unsigned long e = 0; e < ulCtElements; e++) {
+    if (e < ulCtFacets && abSplit[e]) {
+      racInside[e] = 2; // replaced by its triangulation
+      continue;
+    }
+    unsigned long x = FindRegion(aulRegion, e);
+    if (aiState[x] < 0) {
+      if (aiVotes[x] != 0) {
+        aiState[x] = aiVotes[x] > 0 ? 1 : 0;
+      }
+      else {
+        Base::Vector3f clCenter;
+        if (e < ulCtFacets)
+          clCenter = _apclMesh[iSide]->GetFacet(e).GetGravityPoint();
+        else
+          clCenter = (GetPoint(raclFacets[e - ulCtFacets + ulBegin].aulPoints[0]) +
+                      GetPoint(raclFacets[e - ulCtFacets + ulBegin].aulPoints[1]) +
+                      GetPoint(raclFacets[e - ulCtFacets + ulBegin].aulPoints[2])) / 3.0f;
+        aiState[x] = IsInside(clCenter, 1 - iSide, rclOther) ? 1 : 0;
+      }
+    }
+    racInside[e] = aiState[x];
+  }
+}
+
+void MeshBoolean::Do (void)
+{
+  _clStats = Statistics();
+  _aclSegments.clear();
+  _aclCutPoints.clear();
+  _aclCurveEdges.clear();
+  _aclFacetSegments.clear();
+  _aclFacetPoints.clear();
+  _aclCanonical.clear();
+  _aulSplitFacets.clear();
+  _ulCtPoints1 = _apclMesh[0]->CountPoints();
+  _ulCtFacets1 = _apclMesh[0]->CountFacets();
+  _ulCtPoints = _ulCtPoints1 + _apclMesh[1]->CountPoints();
+
+  // In degenerated cases the second mesh is considered as slightly grown or,
+  // for the intersection, shrunk. So coplanar facets don't leave thin slivers.
+  float fGrow = (_eType == SetOperations::Intersect || _eType == SetOperations::Inner) ? -1.0f : 1.0f;
+  const MeshPointArray& rclPoints2 = _apclMesh[1]->GetPoints();
+  const MeshFacetArray& rclFacets2 = _apclMesh[1]->GetFacets();
+  _aclOffsets.assign(rclPoints2.size(), Base::Vector3f(0.0f, 0.0f, 0.0f));
+  for (MeshFacetArray::_TConstIterator it = rclFacets2.begin(); it != rclFacets2.end(); ++it) {
+    const Base::Vector3f& a = rclPoints2[it->_aulPoints[0]];
+    const Base::Vector3f& b = rclPoints2[it->_aulPoints[1]];
+    const Base::Vector3f& c = rclPoints2[it->_aulPoints[2]];
+    Base::Vector3f clNormal = (b - a) % (c - a);
+    clNormal.Normalize();
+    for (int i = 0; i < 3; i++)
+      _aclOffsets[it->_aulPoints[i]] += fGrow * clNormal;
+  }
+
+  // candidate pairs of facets
+  MeshFacetBVH clBVH1(*_apclMesh[0]);
+  MeshFacetBVH clBVH2(*_apclMesh[1]);
+  std::vector<std::pair<unsigned long, unsigned long> > aclPairs;
+  clBVH1.OverlappingFacets(clBVH2, aclPairs);
+  _clStats.ulCandidates = aclPairs.size();
+
+  // intersection curve and the triangulation of the cut facets
+  Intersect(aclPairs);
+  aclPairs.clear();
+  ComputeCutPoints();
+  std::vector<SubFacet> aclSubFacets;
+  Retriangulate(aclSubFacets);
+
+  // the sub facets are sorted by the cut facets, i.e. those of the first mesh come first
+  unsigned long ulMid = 0;
+  while (ulMid < aclSubFacets.size() && aclSubFacets[ulMid].ulFacet < _ulCtFacets1)
+    ulMid++;
+
+  bool abUse[2] = { true, true };
+  char acKeep[2] = { 0, 0 };
+  bool bFlip = false;
+  switch (_eType)
+  {
+    case SetOperations::Union:      acKeep[0] = 0; acKeep[1] = 0; break;
+    case SetOperations::Intersect:  acKeep[0] = 1; acKeep[1] = 1; break;
+    case SetOperations::Difference: acKeep[0] = 0; acKeep[1] = 1; bFlip = true; break;
+    case SetOperations::Inner:      acKeep[0] = 1; abUse[1] = false; break;
+    case SetOperations::Outer:      acKeep[0] = 0; abUse[1] = false; break;
+    default:                        abUse[0] = abUse[1] = false; break;
+  }
+
+  std::vector<unsigned long> aulIndex(_ulCtPoints + _aclCutPoints.size(), ULONG_MAX);
+  MeshPointArray clPoints;
+  MeshFacetArray clFacets;
+  for (int s = 0; s < 2; s++) {
+    if (!abUse[s])
+      continue;
+    std::vector<char> acInside; // 0: outside, 1: inside, 2: cut facet
+    unsigned long ulBegin = s == 0 ? 0 : ulMid;
+    unsigned long ulEnd = s == 0 ? ulMid : aclSubFacets.size();
+    Classify(s, aclSubFacets, ulBegin, ulEnd, s == 0 ? clBVH2 : clBVH1, acInside);
+
+    const MeshFacetArray& rclFacets = _apclMesh[s]->GetFacets();
+    unsigned long ulPointOffset = s == 0 ? 0 : _ulCtPoints1;
+    for (unsigned long e = 0; e < acInside.size(); e++) {
+      if (acInside[e] != acKeep[s])
+        continue;
+      unsigned long aulPoints[3];
+      if (e < rclFacets.size()) {
+        for (int i = 0; i < 3; i++)
+          aulPoints[i] = GetCanonical(rclFacets[e]._aulPoints[i] + ulPointOffset);
+      }
+      else {
+        for (int i = 0; i < 3; i++)
+          aulPoints[i] = aclSubFacets[e - rclFacets.size() + ulBegin].aulPoints[i];
+      }
+      if (aulPoints[0] == aulPoints[1] || aulPoints[1] == aulPoints[2] || aulPoints[2] == aulPoints[0])
+        continue;
+      if (bFlip && s == 1)
+        std::swap(aulPoints[1], aulPoints[2]);
+      for (int i = 0; i < 3; i++) {
+        unsigned long& rulIndex = aulIndex[aulPoints[i]];
+        if (rulIndex == ULONG_MAX) {
+          rulIndex = clPoints.size();
+          clPoints.push_back(MeshPoint(GetPoint(aulPoints[i])));
+        }
+        aulPoints[i] = rulIndex;
+      }
+      clFacets.push_back(MeshFacet(aulPoints[0], aulPoints[1], aulPoints[2]));
+    }
+  }
+
+  _rclResult.Adopt(clPoints, clFacets, true);
+}
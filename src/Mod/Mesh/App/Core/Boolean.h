@@ -0,0 +1,186 @@
+/***************************************************************************
+ *   Copyright (c) 2012 Imetric 3D GmbH                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef MESH_BOOLEAN_H
+#define MESH_BOOLEAN_H
+
+#include <utility>
+#include <vector>
+
+#include "SetOperations.h"
+#include <Base/Vector3D.h>
+
+#define  MESH_CT_PARALLEL_BOOLEAN 1000  // Minimum number of facet pairs or split facets to process in parallel
+
+namespace MeshCore {
+
+class MeshKernel;
+class MeshFacetBVH;
+
+/**
+ * The MeshBoolean class computes the union, intersection or difference of
+ * two closed and consistently oriented meshes. In contrast to SetOperations
+ * it is designed for large meshes and for a consistent intersection curve:
+ * \li The pairs of facets to cut are searched with a bounding volume
+ *     hierarchy of each mesh.
+ * \li Whether an edge of one mesh pierces a facet of the other mesh is
+ *     decided with exact orientation predicates. Degenerated cases like a
+ *     point lying exactly on a facet of the other mesh are resolved as if the
+ *     second mesh was moved by an infinitesimal amount, so all facets sharing
+ *     an edge or point get consistent answers.
+ * \li Each point of the intersection curve is identified by the edge and the
+ *     facet it comes from. Hence the curve is closed and the facets of both
+ *     meshes along the curve share the same points.
+ * \li Each cut facet is retriangulated by tracing the faces of the planar
+ *     graph of its edges and the curve segments lying on it.
+ * \li The parts of the meshes are classified as inside or outside of the
+ *     other mesh by the orientation of the facets along the curve.
+ * The intersection tests and the retriangulation run on all cores.
+ *
+ * Since the input meshes are considered as slightly moved against each other
+ * coplanar facets never cut each other, nevertheless the overlapping parts
+ * are classified properly.
+ */
+class MeshExport MeshBoolean
+{
+public:
+  /** Statistics of the last run. */
+  struct Statistics
+  {
+    unsigned long ulCandidates;    /**< Pairs of facets with overlapping bounding boxes. */
+    unsigned long ulIntersections; /**< Pairs of facets cutting each other. */
+    unsigned long ulCoplanar;      /**< Pairs of coplanar facets. */
+    unsigned long ulDegenerated;   /**< Pairs without a well-defined intersection segment. */
+    unsigned long ulCutPoints;     /**< Points of the intersection curve. */
+    unsigned long ulSplitFacets;   /**< Facets that were retriangulated. */
+    unsigned long ulOpenEdges;     /**< Curve segments ending inside a facet, these are ignored. */
+    unsigned long ulFailures;      /**< Faces that couldn't be triangulated properly. */
+  };
+
+  /// Construction
+  MeshBoolean (const MeshKernel &rclMesh1, const MeshKernel &rclMesh2, MeshKernel &rclResult,
+               SetOperations::OperationType eType);
+  /// Destruction
+  ~MeshBoolean (void);
+
+  /** Computes the result mesh. */
+  void Do (void);
+  /** Returns the statistics of the last call of Do(). */
+  const Statistics& GetStatistics (void) const
+  { return _clStats; }
+
+protected:
+  /** A point of the intersection curve is where the edge (\a ulP, \a ulQ)
+   * with \a ulP < \a ulQ of one mesh pierces the facet \a ulFacet of the
+   * other mesh. The points of the second mesh are numbered after those of
+   * the first one, the same holds for the facets.
+   */
+  struct CutKey
+  {
+    unsigned long ulP, ulQ, ulFacet;
+    bool operator < (const CutKey &rclKey) const;
+    bool operator == (const CutKey &rclKey) const;
+  };
+
+  /** The part of the intersection curve lying on two facets. */
+  struct Segment
+  {
+    unsigned long aulFacets[2]; /**< The facets of the first and the second mesh. */
+    CutKey aclKeys[2];          /**< The end points. */
+    unsigned long aulPoints[2]; /**< The point indices of the end points. */
+  };
+
+  /** A facet of the triangulation of a cut facet. */
+  struct SubFacet
+  {
+    unsigned long aulPoints[3];
+    unsigned long ulFacet; /**< The cut facet. */
+    int iVotes;            /**< Number of edges on the curve voting for inside minus those voting for outside. */
+  };
+
+  /** A range of pairs of facets to cut. */
+  struct PairRange
+  {
+    unsigned long ulBegin, ulEnd;
+    const std::vector<std::pair<unsigned long, unsigned long> > *pclPairs;
+    std::vector<Segment> aclSegments;
+    unsigned long ulCoplanar, ulDegenerated;
+  };
+
+  /** A range of cut facets to retriangulate. */
+  struct SplitRange
+  {
+    unsigned long ulBegin, ulEnd;
+    std::vector<SubFacet> aclFacets;
+    unsigned long ulOpenEdges, ulFailures;
+  };
+
+  /** @name Predicates */
+  //@{
+  const Base::Vector3f& GetPoint (unsigned long ulIndex) const;
+  unsigned long GetCanonical (unsigned long ulIndex) const;
+  void GetFacetPoints (unsigned long ulFacet, unsigned long aulPoints[3]) const;
+  int EdgeSign (unsigned long ulP, unsigned long ulQ, unsigned long ulA, unsigned long ulB) const;
+  /** Returns the orientation of four coplanar points of the input meshes as
+   * if the points of the second mesh were moved by an infinitesimal amount.
+   * Returns 0 only for degenerated configurations. */
+  int SymbolicOrient (unsigned long ulA, unsigned long ulB, unsigned long ulC, unsigned long ulD) const;
+  /** Returns the orientation of the point \a ulPoint relative to the facet \a ulFacet. */
+  int FacetSide (unsigned long ulFacet, unsigned long ulPoint) const;
+  bool IsCurveEdge (unsigned long ulP, unsigned long ulQ) const;
+  bool Pierces (unsigned long ulP, unsigned long ulQ, const unsigned long aulFacet[3]) const;
+  //@}
+
+  /** @name Steps */
+  //@{
+  void Intersect (const std::vector<std::pair<unsigned long, unsigned long> > &raclPairs);
+  void IntersectRange (PairRange &rclRange) const;
+  void ComputeCutPoints (void);
+  void Retriangulate (std::vector<SubFacet> &raclFacets);
+  void RetriangulateRange (SplitRange &rclRange) const;
+  void SplitFacet (unsigned long ulFacet, SplitRange &rclRange) const;
+  void Classify (int iSide, const std::vector<SubFacet> &raclFacets, unsigned long ulBegin, unsigned long ulEnd,
+                 const MeshFacetBVH &rclOther, std::vector<char> &racInside) const;
+  bool IsInside (const Base::Vector3f &rclPt, int iSide, const MeshFacetBVH &rclBVH) const;
+  //@}
+
+private:
+  const MeshKernel* _apclMesh[2];          /**< The input meshes. */
+  MeshKernel& _rclResult;                  /**< The result mesh. */
+  SetOperations::OperationType _eType;     /**< The operation. */
+  Statistics _clStats;
+  unsigned long _ulCtPoints1, _ulCtFacets1; /**< Number of points and facets of the first mesh. */
+  unsigned long _ulCtPoints;               /**< Number of points of both meshes. */
+  std::vector<Segment> _aclSegments;       /**< Segments of the intersection curve. */
+  std::vector<Base::Vector3f> _aclOffsets;  /**< Directions to move the points of the second mesh in degenerated cases. */
+  std::vector<Base::Vector3f> _aclCutPoints; /**< New points of the intersection curve. */
+  std::vector<std::pair<std::pair<unsigned long, unsigned long>, unsigned long> > _aclCurveEdges; /**< Curve segments as point pairs and their index, sorted. */
+  std::vector<std::pair<unsigned long, unsigned long> > _aclFacetSegments; /**< Cut facets and their segments, sorted. */
+  std::vector<std::pair<unsigned long, unsigned long> > _aclFacetPoints; /**< Facets and curve points lying on their edges, sorted. */
+  std::vector<std::pair<unsigned long, unsigned long> > _aclCanonical; /**< Coinciding points and the point representing them, sorted. */
+  std::vector<unsigned long> _aulSplitFacets; /**< Facets to retriangulate, sorted. */
+};
+
+} // namespace MeshCore
+
+#endif // MESH_BOOLEAN_H
@@ -25,6 +25,7 @@
 
 #ifndef _PreComp_
 # include <algorithm>
+# include <cmath>
 #endif
 
 #include <Base/Sequencer.h>
@@ -248,4 +249,247 @@ void MeshBuilder::Finish (bool freeMemory)
     }
 
     _meshKernel.RecalcBoundBox();
+    _meshKernel.Touch();
+}
+
+// ----------------------------------------------------------------------------
+
+/** Cell size of the spatial hash as multiple of the point tolerance */
+#define MESH_BUILDER_CELL_FACTOR 4.0f
+
+namespace MeshCore {
+/** Hash function of a cell, see Teschner et al.: Optimized Spatial Hashing
+ * for Collision Detection of Deformable Objects */
+static inline unsigned long HashCell (int64_t x, int64_t y, int64_t z)
+{
+    uint64_t h = ((uint64_t)x * 73856093UL) ^ ((uint64_t)y * 19349663UL) ^ ((uint64_t)z * 83492791UL);
+    return (unsigned long)h;
+}
+}
+
+MeshFastBuilder::MeshFastBuilder (MeshKernel& kernel)
+  : _meshKernel(kernel), _fCellSize(0.0f), _fTolerance2(0.0f), _ctDegenerated(0)
+{
+}
+
+MeshFastBuilder::~MeshFastBuilder (void)
+{
+}
+
+void MeshFastBuilder::Initialize (unsigned long ctFacets)
+{
+    _meshKernel.Clear();
+    _meshKernel._aclFacetArray.reserve(ctFacets);
+    // usually the number of vertices is the half of the number of facets
+    unsigned long ctPoints = ctFacets / 2;
+    _meshKernel._aclPointArray.reserve((unsigned long)(float(ctPoints)*1.10f));
+
+    // the cell size must be positive even if only identical points get welded
+    _fCellSize = std::max<float>(MESH_BUILDER_CELL_FACTOR * MeshDefinitions::_fMinPointDistance, FLOAT_EPS);
+    _fTolerance2 = MeshDefinitions::_fMinPointDistanceP2;
+    _ctDegenerated = 0;
+
+    // the number of buckets must be a power of two
+    unsigned long ctBuckets = 1024;
+    while (ctBuckets < ctPoints)
+        ctBuckets *= 2;
+    _nextPoint.clear();
+    _nextPoint.reserve((unsigned long)(float(ctPoints)*1.10f));
+    _buckets.assign(ctBuckets, ULONG_MAX);
+}
+
+unsigned long MeshFastBuilder::HashPoint (const Base::Vector3f& rclPt) const
+{
+    int64_t x = (int64_t)floor(double(rclPt.x) / _fCellSize);
+    int64_t y = (int64_t)floor(double(rclPt.y) / _fCellSize);
+    int64_t z = (int64_t)floor(double(rclPt.z) / _fCellSize);
+    return HashCell(x, y, z) & (_buckets.size() - 1);
+}
+
+void MeshFastBuilder::Rehash (unsigned long ctBuckets)
+{
+    const MeshPointArray& rPoints = _meshKernel._aclPointArray;
+    _buckets.assign(ctBuckets, ULONG_MAX);
+    for (unsigned long i = 0; i < rPoints.size(); i++)
+    {
+        unsigned long ulBucket = HashPoint(rPoints[i]);
+        _nextPoint[i] = _buckets[ulBucket];
+        _buckets[ulBucket] = i;
+    }
+}
+
+unsigned long MeshFastBuilder::FindPoint (unsigned long ulBucket, const Base::Vector3f& rclPt) const
+{
+    // the chain of a bucket may contain points of other cells, too
+    const MeshPointArray& rPoints = _meshKernel._aclPointArray;
+    for (unsigned long i = _buckets[ulBucket]; i != ULONG_MAX; i = _nextPoint[i])
+    {
+        float fDist = Base::DistanceP2(rPoints[i], rclPt);
+        if (fDist < _fTolerance2 || fDist == 0.0f)
+            return i;
+    }
+
+    return ULONG_MAX;
+}
+
+unsigned long MeshFastBuilder::InsertPoint (const Base::Vector3f& rclPt)
+{
+    double fX = double(rclPt.x) / _fCellSize;
+    double fY = double(rclPt.y) / _fCellSize;
+    double fZ = double(rclPt.z) / _fCellSize;
+    double fCellX = floor(fX), fCellY = floor(fY), fCellZ = floor(fZ);
+    int64_t x = (int64_t)fCellX, y = (int64_t)fCellY, z = (int64_t)fCellZ;
+    unsigned long ulMask = _buckets.size() - 1;
+
+    // most points are shared by several facets, so search the own cell first
+    unsigned long ulBucket = HashCell(x, y, z) & ulMask;
+    unsigned long ulIndex = FindPoint(ulBucket, rclPt);
+    if (ulIndex != ULONG_MAX)
+        return ulIndex;
+
+    // if the point is close to the border of its cell the neighbour cells must be checked, too
+    const double fBorder = 1.0 / MESH_BUILDER_CELL_FACTOR;
+    int dx = (fX - fCellX < fBorder) ? -1 : (fX - fCellX > 1.0 - fBorder ? 1 : 0);
+    int dy = (fY - fCellY < fBorder) ? -1 : (fY - fCellY > 1.0 - fBorder ? 1 : 0);
+    int dz = (fZ - fCellZ < fBorder) ? -1 : (fZ - fCellZ > 1.0 - fBorder ? 1 : 0);
+    for (int i = 1; i < 8; i++)
+    {
+        int ox = (i & 1) ? dx : 0;
+        int oy = (i & 2) ? dy : 0;
+        int oz = (i & 4) ? dz : 0;
+        if (((i & 1) && !dx) || ((i & 2) && !dy) || ((i & 4) && !dz))
+            continue;
+        ulIndex = FindPoint(HashCell(x + ox, y + oy, z + oz) & ulMask, rclPt);
+        if (ulIndex != ULONG_MAX)
+            return ulIndex;
+    }
+
+    // new point
+    MeshPointArray& rPoints = _meshKernel._aclPointArray;
+    ulIndex = rPoints.size();
+    rPoints.push_back(MeshPoint(rclPt));
+    _nextPoint.push_back(_buckets[ulBucket]);
+    _buckets[ulBucket] = ulIndex;
+
+    // keep the chains short
+    if (rPoints.size() > _buckets.size())
+        Rehash(2 * _buckets.size());
+
+    return ulIndex;
+}
+
+void MeshFastBuilder::AddFacet (const MeshGeomFacet& facet)
+{
+    Base::Vector3f facetPoints[4] = { facet._aclPoints[0], facet._aclPoints[1],
+                                      facet._aclPoints[2], facet.GetNormal() };
+    AddFacet(facetPoints);
+}
+
+void MeshFastBuilder::AddFacet (Base::Vector3f* facetPoints)
+{
+    // adjust circulation direction
+    if ((((facetPoints[1] - facetPoints[0]) % (facetPoints[2] - facetPoints[0])) * facetPoints[3]) < 0.0f)
+    {
+        std::swap(facetPoints[1], facetPoints[2]);
+    }
+
+    MeshFacet mf;
+    for (int i = 0; i < 3; i++)
+        mf._aulPoints[i] = InsertPoint(facetPoints[i]);
+
+    // check for degenerated facet (one edge has length 0)
+    if ((mf._aulPoints[0] == mf._aulPoints[1]) || (mf._aulPoints[0] == mf._aulPoints[2]) || (mf._aulPoints[1] == mf._aulPoints[2]))
+    {
+        _ctDegenerated++;
+        return;
+    }
+
+    _meshKernel._aclFacetArray.push_back(mf);
+}
+
+void MeshFastBuilder::SetNeighbourhood ()
+{
+    MeshFacetArray& rFacets = _meshKernel._aclFacetArray;
+    unsigned long ctFacets = rFacets.size();
+    unsigned long ctPoints = _meshKernel._aclPointArray.size();
+
+    // counting sort of the facet corners by their point index
+    std::vector<unsigned long> offsets(ctPoints + 1, 0);
+    for (MeshFacetArray::_TConstIterator it = rFacets.begin(); it != rFacets.end(); ++it)
+    {
+        for (int i = 0; i < 3; i++)
+            offsets[it->_aulPoints[i] + 1]++;
+    }
+    for (unsigned long p = 0; p < ctPoints; p++)
+        offsets[p + 1] += offsets[p];
+
+    std::vector<unsigned long> corners(offsets.back());
+    {
+        std::vector<unsigned long> fill(offsets.begin(), offsets.end() - 1);
+        for (unsigned long f = 0; f < ctFacets; f++)
+        {
+            for (int i = 0; i < 3; i++)
+                corners[fill[rFacets[f]._aulPoints[i]]++] = f;
+        }
+    }
+
+    // Like MeshBuilder, at an edge shared by more than two facets the first
+    // of them gets the last one as neighbour and all others get the first.
+    for (unsigned long f = 0; f < ctFacets; f++)
+    {
+        MeshFacet& mf = rFacets[f];
+        for (int i = 0; i < 3; i++)
+        {
+            unsigned long p0 = mf._aulPoints[i];
+            unsigned long p1 = mf._aulPoints[(i+1)%3];
+            unsigned long first = ULONG_MAX, last = ULONG_MAX;
+            for (unsigned long k = offsets[p0]; k < offsets[p0 + 1]; k++)
+            {
+                // the facets of a point are sorted by their index
+                unsigned long g = corners[k];
+                if (g != f && rFacets[g].HasPoint(p1))
+                {
+                    if (first == ULONG_MAX)
+                        first = g;
+                    last = g;
+                }
+            }
+
+            if (first == ULONG_MAX)
+                mf._aulNeighbours[i] = ULONG_MAX;
+            else if (f < first)
+                mf._aulNeighbours[i] = last;
+            else
+                mf._aulNeighbours[i] = first;
+        }
+    }
+}
+
+void MeshFastBuilder::RemoveUnreferencedPoints()
+{
+    _meshKernel._aclPointArray.SetFlag(MeshPoint::INVALID);
+    for ( MeshFacetArray::_TConstIterator it = _meshKernel._aclFacetArray.begin(); it != _meshKernel._aclFacetArray.end(); ++it )
+    {
+        for ( int i=0; i<3; i++ )
+            _meshKernel._aclPointArray[it->_aulPoints[i]].ResetInvalid();
+    }
+
+    unsigned long uValidPts = std::count_if(_meshKernel._aclPointArray.begin(), _meshKernel._aclPointArray.end(), std::mem_fun_ref(&MeshPoint::IsValid));
+    if ( uValidPts < _meshKernel.CountPoints() )
+        _meshKernel.RemoveInvalids();
+}
+
+void MeshFastBuilder::Finish ()
+{
+    // free the memory of the hash before the neighbourhood gets built
+    { std::vector<unsigned long>().swap(_buckets); }
+    { std::vector<unsigned long>().swap(_nextPoint); }
+
+    SetNeighbourhood();
+    // the points of degenerated facets have been inserted anyway
+    if (_ctDegenerated > 0)
+        RemoveUnreferencedPoints();
+
+    _meshKernel.RecalcBoundBox();
+    _meshKernel.Touch();
 }
@@ -164,6 +164,56 @@ private:
     float _fSaveTolerance;
 };
 
+/**
+ * Class for creating the mesh structure of large meshes, e.g. from an STL
+ * file with millions of facets. It's used in the same way as MeshBuilder
+ * but is much faster and needs much less memory:
+ * \li Points are welded with a spatial hash instead of a std::set. Two
+ *     points are merged if their distance is less than
+ *     MeshDefinitions::_fMinPointDistance.
+ * \li The neighbourhood is set up by a counting sort of the facet corners
+ *     by their point index instead of a std::set of edges. Edges shared by
+ *     more than two facets get the same neighbours as with MeshBuilder.
+ *
+ * In contrast to MeshBuilder the facets are always added to an empty mesh
+ * and no progress is shown, this is left to the caller.
+ */
+class MeshExport MeshFastBuilder
+{
+public:
+    MeshFastBuilder(MeshKernel &rclM);
+    ~MeshFastBuilder(void);
+
+    /** Initializes the class. Must be done before adding facets.
+     * @param ctFacets expected count of facets.
+     */
+    void Initialize (unsigned long ctFacets);
+    /** Add new facet
+     * @param facetPoints Array of vectors (size 4) in order of vec1, vec2,
+     *                    vec3, normal
+     */
+    void AddFacet (Base::Vector3f* facetPoints);
+    /** Add new facet */
+    void AddFacet (const MeshGeomFacet& facet);
+    /** Finishes building up the mesh structure. Must be done after adding facets. */
+    void Finish ();
+
+private:
+    unsigned long InsertPoint (const Base::Vector3f& rclPt);
+    unsigned long FindPoint (unsigned long ulBucket, const Base::Vector3f& rclPt) const;
+    unsigned long HashPoint (const Base::Vector3f& rclPt) const;
+    void Rehash (unsigned long ctBuckets);
+    void SetNeighbourhood ();
+    void RemoveUnreferencedPoints ();
+
+private:
+    MeshKernel& _meshKernel;
+    float _fCellSize, _fTolerance2;
+    /** Head of the chain of points per bucket, and the next point of a chain per point. */
+    std::vector<unsigned long> _buckets, _nextPoint;
+    unsigned long _ctDegenerated;
+};
+
 } // namespace MeshCore
 
 #endif 
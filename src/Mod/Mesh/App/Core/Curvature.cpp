@@ -27,6 +27,7 @@
 
 #include <QFuture>
 #include <QFutureWatcher>
+#include <QThread>
 #include <QtConcurrentMap>
 #include <boost/bind.hpp>
 
@@ -129,6 +130,223 @@ void MeshCurvature::ComputePerVertex()
 
 // --------------------------------------------------------
 
+MeshPointCurvature::MeshPointCurvature(const MeshKernel& kernel, unsigned short rings)
+  : myKernel(kernel), myRings(std::max<unsigned short>(1, rings))
+{
+}
+
+void MeshPointCurvature::Compute(std::vector<CurvatureInfo>& info) const
+{
+    unsigned long countPoints = myKernel.CountPoints();
+    info.resize(countPoints);
+    if (countPoints == 0)
+        return;
+
+    MeshCompactPointToFacets search(myKernel);
+    std::vector<PointRange> ranges;
+    int threads = QThread::idealThreadCount();
+    if (countPoints < MESH_CT_PARALLEL_CURVATURE || threads <= 1) {
+        PointRange range = {0, countPoints, &(info[0]), &search};
+        ComputeRange(range);
+        return;
+    }
+
+    // use more ranges than threads to balance the work load
+    unsigned long countRanges = 4 * (unsigned long)threads;
+    unsigned long step = (countPoints + countRanges - 1) / countRanges;
+    for (unsigned long i = 0; i < countPoints; i += step) {
+        PointRange range = {i, std::min<unsigned long>(i + step, countPoints), &(info[i]), &search};
+        ranges.push_back(range);
+    }
+
+    QFuture<void> future = QtConcurrent::map
+        (ranges, boost::bind(&MeshPointCurvature::ComputeRange, this, _1));
+    future.waitForFinished();
+}
+
+void MeshPointCurvature::ComputeRange(PointRange& range) const
+{
+    Workspace ws;
+    for (unsigned long i = range.begin; i < range.end; i++)
+        ComputePoint(i, *range.search, ws, range.info[i - range.begin]);
+}
+
+namespace MeshCore {
+/** Solves the n x n system A*x = b in place by Gaussian elimination, the result is stored in \a b. */
+static bool SolveLinear(double A[5][5], double b[5], int n)
+{
+    for (int col = 0; col < n; col++) {
+        int pivot = col;
+        for (int row = col + 1; row < n; row++) {
+            if (fabs(A[row][col]) > fabs(A[pivot][col]))
+                pivot = row;
+        }
+        // the coordinates are normalized, so a fixed threshold is fine
+        if (fabs(A[pivot][col]) < 1.0e-10)
+            return false;
+        if (pivot != col) {
+            for (int k = 0; k < n; k++)
+                std::swap(A[col][k], A[pivot][k]);
+            std::swap(b[col], b[pivot]);
+        }
+        for (int row = col + 1; row < n; row++) {
+            double f = A[row][col] / A[col][col];
+            for (int k = col; k < n; k++)
+                A[row][k] -= f * A[col][k];
+            b[row] -= f * b[col];
+        }
+    }
+    for (int row = n - 1; row >= 0; row--) {
+        for (int k = row + 1; k < n; k++)
+            b[row] -= A[row][k] * b[k];
+        b[row] /= A[row][row];
+    }
+    return true;
+}
+}
+
+void MeshPointCurvature::ComputePoint(unsigned long index, const MeshCompactPointToFacets& search,
+                                      Workspace& ws, CurvatureInfo& info) const
+{
+    const MeshPointArray& rPoints = myKernel.GetPoints();
+    const MeshFacetArray& rFacets = myKernel.GetFacets();
+    info.fMaxCurvature = 0.0f;
+    info.fMinCurvature = 0.0f;
+    info.cMaxCurvDir.Set(0.0f, 0.0f, 0.0f);
+    info.cMinCurvDir.Set(0.0f, 0.0f, 0.0f);
+
+    // collect the neighbourhood ring by ring, the rings are small enough for a linear search
+    std::vector<unsigned long>& points = ws.points;
+    points.clear();
+    points.push_back(index);
+    std::size_t ringBegin = 0;
+    for (unsigned short ring = 0; ring < myRings; ring++) {
+        std::size_t ringEnd = points.size();
+        for (std::size_t i = ringBegin; i < ringEnd; i++) {
+            MeshNeighbourRange faces = search[points[i]];
+            for (MeshNeighbourRange::const_iterator it = faces.begin(); it != faces.end(); ++it) {
+                const MeshFacet& face = rFacets[*it];
+                for (int j = 0; j < 3; j++) {
+                    if (std::find(points.begin(), points.end(), face._aulPoints[j]) == points.end())
+                        points.push_back(face._aulPoints[j]);
+                }
+            }
+        }
+        ringBegin = ringEnd;
+    }
+
+    // the normal of the point is the area weighted sum of the normals of its facets
+    const Base::Vector3f& pf = rPoints[index];
+    Base::Vector3d p(pf.x, pf.y, pf.z);
+    Base::Vector3d normal;
+    MeshNeighbourRange faces = search[index];
+    for (MeshNeighbourRange::const_iterator it = faces.begin(); it != faces.end(); ++it) {
+        const MeshFacet& face = rFacets[*it];
+        const Base::Vector3f& p0 = rPoints[face._aulPoints[0]];
+        const Base::Vector3f& p1 = rPoints[face._aulPoints[1]];
+        const Base::Vector3f& p2 = rPoints[face._aulPoints[2]];
+        Base::Vector3d e1(p1.x - p0.x, p1.y - p0.y, p1.z - p0.z);
+        Base::Vector3d e2(p2.x - p0.x, p2.y - p0.y, p2.z - p0.z);
+        normal += e1 % e2;
+    }
+    if (normal.Length() <= 0.0 || points.size() < 4)
+        return;
+    normal.Normalize();
+
+    // the tangent frame, z is counted against the normal to get the sign of ComputePerVertex()
+    Base::Vector3d axis(1.0, 0.0, 0.0);
+    if (fabs(normal.y) < fabs(normal.x) && fabs(normal.y) <= fabs(normal.z))
+        axis.Set(0.0, 1.0, 0.0);
+    else if (fabs(normal.z) < fabs(normal.x) && fabs(normal.z) < fabs(normal.y))
+        axis.Set(0.0, 0.0, 1.0);
+    Base::Vector3d u = normal % axis;
+    u.Normalize();
+    Base::Vector3d v = normal % u;
+
+    // the coordinates are scaled by the mean distance of the neighbours
+    double scale = 0.0;
+    for (std::size_t i = 1; i < points.size(); i++) {
+        const Base::Vector3f& q = rPoints[points[i]];
+        scale += Base::Vector3d(q.x - p.x, q.y - p.y, q.z - p.z).Length();
+    }
+    scale /= (double)(points.size() - 1);
+    if (scale <= 0.0)
+        return;
+
+    // normal equations of the least squares fit
+    double A[5][5] = {{0.0}};
+    double b[5] = {0.0};
+    for (std::size_t i = 1; i < points.size(); i++) {
+        const Base::Vector3f& q = rPoints[points[i]];
+        Base::Vector3d d((q.x - p.x) / scale, (q.y - p.y) / scale, (q.z - p.z) / scale);
+        double x = d * u, y = d * v, z = -(d * normal);
+        double r[5] = {x * x, x * y, y * y, x, y};
+        for (int j = 0; j < 5; j++) {
+            for (int k = 0; k < 5; k++)
+                A[j][k] += r[j] * r[k];
+            b[j] += r[j] * z;
+        }
+    }
+
+    // fall back to a quadric without linear terms for too few points
+    double c[5] = {0.0};
+    double A5[5][5], b5[5];
+    memcpy(A5, A, sizeof(A));
+    memcpy(b5, b, sizeof(b));
+    if (points.size() > 5 && SolveLinear(A5, b5, 5)) {
+        memcpy(c, b5, sizeof(c));
+    }
+    else if (SolveLinear(A, b, 3)) {
+        memcpy(c, b, 3 * sizeof(double));
+    }
+    else {
+        return;
+    }
+
+    // shape operator of the quadric at the origin
+    double fx = c[3], fy = c[4], fxx = 2.0 * c[0], fxy = c[1], fyy = 2.0 * c[2];
+    double E = 1.0 + fx * fx, F = fx * fy, G = 1.0 + fy * fy;
+    double det = E * G - F * F;
+    double w = sqrt(det);
+    double L = fxx / w, M = fxy / w, N = fyy / w;
+    double S00 = (G * L - F * M) / det, S01 = (G * M - F * N) / det;
+    double S10 = (E * M - F * L) / det, S11 = (E * N - F * M) / det;
+    double trace = S00 + S11;
+    double discr = (S00 - S11) * (S00 - S11) + 4.0 * S01 * S10;
+    double root = discr > 0.0 ? sqrt(discr) : 0.0;
+    double kmax = 0.5 * (trace + root);
+    double kmin = 0.5 * (trace - root);
+
+    // eigenvector of the maximum curvature in the parameter plane
+    double w0x = S01, w0y = kmax - S00;
+    double w1x = kmax - S11, w1y = S10;
+    double ex, ey;
+    if (w0x * w0x + w0y * w0y >= w1x * w1x + w1y * w1y) {
+        ex = w0x; ey = w0y;
+    }
+    else {
+        ex = w1x; ey = w1y;
+    }
+    if (ex * ex + ey * ey < 1.0e-20) {
+        ex = 1.0; ey = 0.0; // umbilic point
+    }
+
+    Base::Vector3d tu = u - normal * fx;
+    Base::Vector3d tv = v - normal * fy;
+    Base::Vector3d dmax = tu * ex + tv * ey;
+    dmax.Normalize();
+    Base::Vector3d ns = tu % tv;
+    Base::Vector3d dmin = ns % dmax;
+    dmin.Normalize();
+
+    info.fMaxCurvature = (float)(kmax / scale);
+    info.fMinCurvature = (float)(kmin / scale);
+    info.cMaxCurvDir.Set((float)dmax.x, (float)dmax.y, (float)dmax.z);
+    info.cMinCurvDir.Set((float)dmin.x, (float)dmin.y, (float)dmin.z);
+}
+
+// --------------------------------------------------------
+
 namespace MeshCore {
 class FitPointCollector : public MeshCollector
 {
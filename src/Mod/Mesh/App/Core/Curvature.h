@@ -26,10 +26,13 @@
 #include <vector>
 #include <Base/Vector3D.h>
 
+#define  MESH_CT_PARALLEL_CURVATURE 10000  // Minimum number of points to compute the curvature in parallel
+
 namespace MeshCore {
 
 class MeshKernel;
 class MeshRefPointToFacets;
+class MeshCompactPointToFacets;
 
 /** Curvature information. */
 struct MeshExport CurvatureInfo
@@ -70,6 +73,49 @@ private:
     std::vector<CurvatureInfo> myCurvature;
 };
 
+/**
+ * The MeshPointCurvature class estimates the principal curvatures and
+ * directions at the points of a mesh. For each point the points of its
+ * n-ring neighbourhood are collected on the compact point-to-facets table and
+ * the quadric z = ax^2 + bxy + cy^2 + dx + ey is fitted in the tangent frame of
+ * the point. The fit sums up the normal equations while visiting the
+ * neighbours, so no neighbourhood set or point list is built per point.
+ * The points are processed in ranges on all cores and each range reuses one
+ * workspace for all its points. The signs follow MeshCurvature::ComputePerVertex(),
+ * i.e. a sphere with outward normals has a positive curvature.
+ */
+class MeshExport MeshPointCurvature
+{
+public:
+    /** Construction. \a usRings is the size of the neighbourhood used for the fit. */
+    MeshPointCurvature(const MeshKernel& kernel, unsigned short usRings = 2);
+    /** Computes the curvature of all points and writes it to \a info,
+     * which gets resized to the number of points. */
+    void Compute(std::vector<CurvatureInfo>& info) const;
+
+protected:
+    /** Buffers reused for all points of a range. */
+    struct Workspace
+    {
+        std::vector<unsigned long> points; /**< The neighbourhood, sorted ring by ring. */
+    };
+    /** A range of points and the output for its first point. */
+    struct PointRange
+    {
+        unsigned long begin, end;
+        CurvatureInfo* info;
+        const MeshCompactPointToFacets* search;
+    };
+
+    void ComputeRange(PointRange& range) const;
+    void ComputePoint(unsigned long index, const MeshCompactPointToFacets& search,
+                      Workspace& ws, CurvatureInfo& info) const;
+
+private:
+    const MeshKernel& myKernel;
+    unsigned short myRings;
+};
+
 } // MeshCore
 
 #endif // MESHCORE_CURVATURE_H
@@ -0,0 +1,545 @@
+/***************************************************************************
+ *   Copyright (c) 2012 Imetric 3D GmbH                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <algorithm>
+# include <climits>
+# include <cmath>
+#endif
+
+#include "Decimation.h"
+#include "MeshKernel.h"
+
+using namespace MeshCore;
+
+void MeshDecimation::Quadric::Clear (void)
+{
+  for (int i = 0; i < 10; i++)
+    a[i] = 0.0;
+}
+
+void MeshDecimation::Quadric::AddPlane (const Base::Vector3f &rclNormal, const Base::Vector3f &rclBase,
+                                        double fWeight)
+{
+  double x = rclNormal.x, y = rclNormal.y, z = rclNormal.z;
+  double d = -(x * rclBase.x + y * rclBase.y + z * rclBase.z);
+  a[0] += fWeight * x * x; a[1] += fWeight * x * y; a[2] += fWeight * x * z; a[3] += fWeight * x * d;
+  a[4] += fWeight * y * y; a[5] += fWeight * y * z; a[6] += fWeight * y * d;
+  a[7] += fWeight * z * z; a[8] += fWeight * z * d;
+  a[9] += fWeight * d * d;
+}
+
+MeshDecimation::Quadric& MeshDecimation::Quadric::operator += (const Quadric &rclQ)
+{
+  for (int i = 0; i < 10; i++)
+    a[i] += rclQ.a[i];
+  return *this;
+}
+
+double MeshDecimation::Quadric::Evaluate (const Base::Vector3f &rclPt) const
+{
+  double x = rclPt.x, y = rclPt.y, z = rclPt.z;
+  return a[0] * x * x + 2.0 * a[1] * x * y + 2.0 * a[2] * x * z + 2.0 * a[3] * x
+       + a[4] * y * y + 2.0 * a[5] * y * z + 2.0 * a[6] * y
+       + a[7] * z * z + 2.0 * a[8] * z
+       + a[9];
+}
+
+bool MeshDecimation::Quadric::Optimize (Base::Vector3f &rclPt) const
+{
+  // solve the 3x3 system with Cramer's rule, give up if it is (nearly) singular
+  // as it happens for flat regions or along straight creases
+  double c00 = a[4] * a[7] - a[5] * a[5];
+  double c01 = a[2] * a[5] - a[1] * a[7];
+  double c02 = a[1] * a[5] - a[2] * a[4];
+  double det = a[0] * c00 + a[1] * c01 + a[2] * c02;
+  double tr = a[0] + a[4] + a[7];
+  if (fabs(det) <= 1.0e-6 * tr * tr * tr)
+    return false;
+
+  double c11 = a[0] * a[7] - a[2] * a[2];
+  double c12 = a[1] * a[2] - a[0] * a[5];
+  double c22 = a[0] * a[4] - a[1] * a[1];
+  double b0 = -a[3], b1 = -a[6], b2 = -a[8];
+  rclPt.x = (float)((c00 * b0 + c01 * b1 + c02 * b2) / det);
+  rclPt.y = (float)((c01 * b0 + c11 * b1 + c12 * b2) / det);
+  rclPt.z = (float)((c02 * b0 + c12 * b1 + c22 * b2) / det);
+  return true;
+}
+
+// ---------------------------------------------------------------------------
+
+MeshDecimation::MeshDecimation (MeshKernel &rclMesh)
+  : _rclMesh(rclMesh), _ulTargetSize(0), _fTolerance(FLOAT_MAX), _bPreserveBoundary(true),
+    _fFeatureAngle(0.785398f), _fWeight(100.0f), _fMaxCost(FLOAT_MAX), _ulCtFacets(0)
+{
+  _clStats.ulCollapses = 0;
+  _clStats.ulRemoved = 0;
+  _clStats.ulStale = 0;
+  _clStats.ulRejected = 0;
+  _clStats.fMaxError = 0.0f;
+}
+
+MeshDecimation::~MeshDecimation (void)
+{
+}
+
+bool MeshDecimation::Decimate (void)
+{
+  _clStats.ulCollapses = 0;
+  _clStats.ulRemoved = 0;
+  _clStats.ulStale = 0;
+  _clStats.ulRejected = 0;
+  _clStats.fMaxError = 0.0f;
+
+  _fMaxCost = FLOAT_MAX;
+  if (_fTolerance < sqrt(FLOAT_MAX))
+    _fMaxCost = _fTolerance * _fTolerance;
+  Initialize();
+  std::make_heap(_aclQueue.begin(), _aclQueue.end());
+  std::vector<Collapse>::size_type ulMaxQueue = std::max<std::vector<Collapse>::size_type>
+    (2 * _aclQueue.size(), 1024);
+  std::vector<unsigned long>::size_type ulMaxRefs = 2 * _aulRefs.size();
+
+  while (_ulCtFacets > _ulTargetSize && !_aclQueue.empty()) {
+    std::pop_heap(_aclQueue.begin(), _aclQueue.end());
+    Collapse clC = _aclQueue.back();
+    _aclQueue.pop_back();
+
+    if (!IsValid(clC)) {
+      _clStats.ulStale++;
+      continue;
+    }
+    // all valid entries left in the queue are more expensive
+    if (clC.fCost > _fMaxCost)
+      break;
+    if (!CanCollapse(clC)) {
+      _clStats.ulRejected++;
+      continue;
+    }
+
+    DoCollapse(clC);
+    _clStats.ulCollapses++;
+    _clStats.fMaxError = std::max<float>(_clStats.fMaxError, clC.fCost);
+
+    // drop the outdated references and queue entries from time to time
+    if (_aulRefs.size() > ulMaxRefs)
+      BuildReferences();
+    if (_aclQueue.size() > ulMaxQueue) {
+      std::vector<Collapse>::iterator it = _aclQueue.begin();
+      for (std::vector<Collapse>::iterator jt = _aclQueue.begin(); jt != _aclQueue.end(); ++jt) {
+        if (IsValid(*jt))
+          *it++ = *jt;
+      }
+      _aclQueue.erase(it, _aclQueue.end());
+      std::make_heap(_aclQueue.begin(), _aclQueue.end());
+      ulMaxQueue = std::max<std::vector<Collapse>::size_type>(2 * _aclQueue.size(), 1024);
+    }
+  }
+
+  _clStats.fMaxError = (float)sqrt(_clStats.fMaxError);
+
+  bool bChanged = _clStats.ulRemoved > 0;
+  if (bChanged)
+    Finish();
+
+  // free the memory
+  std::vector<Base::Vector3f>().swap(_aclPoints);
+  std::vector<unsigned long>().swap(_aulFacets);
+  std::vector<char>().swap(_acRemovedFacets);
+  std::vector<Quadric>().swap(_aclQuadrics);
+  std::vector<unsigned long>().swap(_aulStamps);
+  std::vector<char>().swap(_acBoundary);
+  std::vector<unsigned long>().swap(_aulFirst);
+  std::vector<unsigned long>().swap(_aulCount);
+  std::vector<unsigned long>().swap(_aulRefs);
+  std::vector<Collapse>().swap(_aclQueue);
+  return bChanged;
+}
+
+void MeshDecimation::Initialize (void)
+{
+  const MeshPointArray& rclPoints = _rclMesh.GetPoints();
+  const MeshFacetArray& rclFacets = _rclMesh.GetFacets();
+  unsigned long ulCtPoints = rclPoints.size();
+  unsigned long ulCtFacets = rclFacets.size();
+
+  _aclPoints.assign(rclPoints.begin(), rclPoints.end());
+  _aulFacets.resize(3 * ulCtFacets);
+  _acRemovedFacets.assign(ulCtFacets, 0);
+  _aulStamps.assign(ulCtPoints, 0);
+  _acBoundary.assign(ulCtPoints, 0);
+  _ulCtFacets = 0;
+
+  Quadric clZero;
+  clZero.Clear();
+  _aclQuadrics.assign(ulCtPoints, clZero);
+
+  // the planes of the facets
+  std::vector<Base::Vector3f> aclNormals(ulCtFacets);
+  for (unsigned long i = 0; i < ulCtFacets; i++) {
+    const MeshFacet& rclF = rclFacets[i];
+    for (int j = 0; j < 3; j++)
+      _aulFacets[3 * i + j] = rclF._aulPoints[j];
+    if (rclF._aulPoints[0] == rclF._aulPoints[1] || rclF._aulPoints[1] == rclF._aulPoints[2] ||
+        rclF._aulPoints[2] == rclF._aulPoints[0]) {
+      _acRemovedFacets[i] = 1;
+      continue;
+    }
+
+    _ulCtFacets++;
+    const Base::Vector3f& rclP0 = _aclPoints[rclF._aulPoints[0]];
+    Base::Vector3f clNormal = (_aclPoints[rclF._aulPoints[1]] - rclP0) % (_aclPoints[rclF._aulPoints[2]] - rclP0);
+    if (clNormal.Length() > 0.0f) {
+      clNormal.Normalize();
+      for (int j = 0; j < 3; j++)
+        _aclQuadrics[rclF._aulPoints[j]].AddPlane(clNormal, rclP0, 1.0);
+    }
+    aclNormals[i] = clNormal;
+  }
+
+  // constraint planes along the boundary and the sharp edges
+  float fCosFeature = (float)cos(_fFeatureAngle);
+  for (unsigned long i = 0; i < ulCtFacets; i++) {
+    if (_acRemovedFacets[i])
+      continue;
+    const MeshFacet& rclF = rclFacets[i];
+    for (int j = 0; j < 3; j++) {
+      unsigned long ulP0 = rclF._aulPoints[j];
+      unsigned long ulP1 = rclF._aulPoints[(j + 1) % 3];
+      unsigned long ulN = rclF._aulNeighbours[j];
+      Base::Vector3f clEdge = _aclPoints[ulP1] - _aclPoints[ulP0];
+      if (ulN == ULONG_MAX) {
+        _acBoundary[ulP0] = 1;
+        _acBoundary[ulP1] = 1;
+        Base::Vector3f clNormal = clEdge % aclNormals[i];
+        if (clNormal.Length() > 0.0f) {
+          clNormal.Normalize();
+          _aclQuadrics[ulP0].AddPlane(clNormal, _aclPoints[ulP0], _fWeight);
+          _aclQuadrics[ulP1].AddPlane(clNormal, _aclPoints[ulP0], _fWeight);
+        }
+      }
+      else if (ulN > i && ulN < ulCtFacets && !_acRemovedFacets[ulN] &&
+               aclNormals[i] * aclNormals[ulN] < fCosFeature) {
+        Base::Vector3f clNormal1 = clEdge % aclNormals[i];
+        Base::Vector3f clNormal2 = clEdge % aclNormals[ulN];
+        if (clNormal1.Length() > 0.0f && clNormal2.Length() > 0.0f) {
+          clNormal1.Normalize();
+          clNormal2.Normalize();
+          _aclQuadrics[ulP0].AddPlane(clNormal1, _aclPoints[ulP0], _fWeight);
+          _aclQuadrics[ulP1].AddPlane(clNormal1, _aclPoints[ulP0], _fWeight);
+          _aclQuadrics[ulP0].AddPlane(clNormal2, _aclPoints[ulP0], _fWeight);
+          _aclQuadrics[ulP1].AddPlane(clNormal2, _aclPoints[ulP0], _fWeight);
+        }
+      }
+    }
+  }
+
+  BuildReferences();
+
+  // each edge once
+  _aclQueue.clear();
+  _aclQueue.reserve(ulCtFacets + ulCtFacets / 2);
+  for (unsigned long i = 0; i < ulCtFacets; i++) {
+    if (_acRemovedFacets[i])
+      continue;
+    const MeshFacet& rclF = rclFacets[i];
+    for (int j = 0; j < 3; j++) {
+      unsigned long ulN = rclF._aulNeighbours[j];
+      if (ulN == ULONG_MAX || ulN > i)
+        PushEdge(rclF._aulPoints[j], rclF._aulPoints[(j + 1) % 3]);
+    }
+  }
+}
+
+void MeshDecimation::BuildReferences (void)
+{
+  unsigned long ulCtPoints = _aclPoints.size();
+  unsigned long ulCtFacets = _acRemovedFacets.size();
+  _aulCount.assign(ulCtPoints, 0);
+  for (unsigned long i = 0; i < ulCtFacets; i++) {
+    if (!_acRemovedFacets[i]) {
+      for (int j = 0; j < 3; j++)
+        _aulCount[_aulFacets[3 * i + j]]++;
+    }
+  }
+
+  _aulFirst.resize(ulCtPoints);
+  unsigned long ulSum = 0;
+  for (unsigned long i = 0; i < ulCtPoints; i++) {
+    _aulFirst[i] = ulSum;
+    ulSum += _aulCount[i];
+  }
+
+  std::vector<unsigned long> aulPos(_aulFirst);
+  _aulRefs.resize(ulSum);
+  for (unsigned long i = 0; i < ulCtFacets; i++) {
+    if (!_acRemovedFacets[i]) {
+      for (int j = 0; j < 3; j++)
+        _aulRefs[aulPos[_aulFacets[3 * i + j]]++] = 3 * i + j;
+    }
+  }
+}
+
+void MeshDecimation::PushEdge (unsigned long ulP0, unsigned long ulP1)
+{
+  bool bBoundary0 = _acBoundary[ulP0] != 0;
+  bool bBoundary1 = _acBoundary[ulP1] != 0;
+  if (bBoundary0 && bBoundary1 && _bPreserveBoundary)
+    return;
+
+  Quadric clQ = _aclQuadrics[ulP0];
+  clQ += _aclQuadrics[ulP1];
+
+  Collapse clC;
+  if (bBoundary0 != bBoundary1) {
+    // never move a point away from the boundary
+    if (bBoundary1)
+      std::swap(ulP0, ulP1);
+    clC.clTarget = _aclPoints[ulP0];
+    clC.fCost = (float)clQ.Evaluate(clC.clTarget);
+  }
+  else {
+    const Base::Vector3f& rclP0 = _aclPoints[ulP0];
+    const Base::Vector3f& rclP1 = _aclPoints[ulP1];
+    Base::Vector3f clMid = 0.5f * (rclP0 + rclP1);
+    bool bOptimum = clQ.Optimize(clC.clTarget);
+    if (bOptimum && Base::DistanceP2(clC.clTarget, clMid) <= Base::DistanceP2(rclP0, rclP1)) {
+      clC.fCost = (float)clQ.Evaluate(clC.clTarget);
+    }
+    else {
+      // take the best of the end points and the mid point
+      double fCost0 = clQ.Evaluate(rclP0);
+      double fCost1 = clQ.Evaluate(rclP1);
+      double fCostMid = clQ.Evaluate(clMid);
+      if (fCostMid <= fCost0 && fCostMid <= fCost1) {
+        clC.clTarget = clMid;
+        clC.fCost = (float)fCostMid;
+      }
+      else if (fCost0 <= fCost1) {
+        clC.clTarget = rclP0;
+        clC.fCost = (float)fCost0;
+      }
+      else {
+        clC.clTarget = rclP1;
+        clC.fCost = (float)fCost1;
+      }
+    }
+  }
+
+  if (clC.fCost < 0.0f)
+    clC.fCost = 0.0f;
+  if (clC.fCost > _fMaxCost)
+    return; // will never be collapsed
+
+  clC.ulKeep = ulP0;
+  clC.ulRemove = ulP1;
+  clC.ulStampKeep = _aulStamps[ulP0];
+  clC.ulStampRemove = _aulStamps[ulP1];
+  _aclQueue.push_back(clC);
+  std::push_heap(_aclQueue.begin(), _aclQueue.end());
+}
+
+bool MeshDecimation::IsValid (const Collapse &rclC) const
+{
+  return _aulStamps[rclC.ulKeep] == rclC.ulStampKeep &&
+         _aulStamps[rclC.ulRemove] == rclC.ulStampRemove;
+}
+
+bool MeshDecimation::HasPoint (unsigned long ulFacet, unsigned long ulPoint) const
+{
+  const unsigned long* pulPoints = &_aulFacets[3 * ulFacet];
+  return pulPoints[0] == ulPoint || pulPoints[1] == ulPoint || pulPoints[2] == ulPoint;
+}
+
+void MeshDecimation::CollectNeighbours (unsigned long ulPoint, std::vector<unsigned long> &raulPoints) const
+{
+  raulPoints.clear();
+  unsigned long ulEnd = _aulFirst[ulPoint] + _aulCount[ulPoint];
+  for (unsigned long i = _aulFirst[ulPoint]; i < ulEnd; i++) {
+    unsigned long ulFacet = _aulRefs[i] / 3;
+    if (_acRemovedFacets[ulFacet])
+      continue;
+    for (int j = 0; j < 3; j++) {
+      unsigned long ulP = _aulFacets[3 * ulFacet + j];
+      if (ulP != ulPoint)
+        raulPoints.push_back(ulP);
+    }
+  }
+  std::sort(raulPoints.begin(), raulPoints.end());
+  raulPoints.erase(std::unique(raulPoints.begin(), raulPoints.end()), raulPoints.end());
+}
+
+bool MeshDecimation::CanCollapse (const Collapse &rclC)
+{
+  unsigned long ulKeep = rclC.ulKeep, ulRemove = rclC.ulRemove;
+
+  // the edge must be shared by one or two facets
+  unsigned long ulShared = 0;
+  unsigned long ulEnd = _aulFirst[ulRemove] + _aulCount[ulRemove];
+  for (unsigned long i = _aulFirst[ulRemove]; i < ulEnd; i++) {
+    unsigned long ulFacet = _aulRefs[i] / 3;
+    if (!_acRemovedFacets[ulFacet] && HasPoint(ulFacet, ulKeep))
+      ulShared++;
+  }
+  if (ulShared == 0 || ulShared > 2)
+    return false;
+  // an inner edge connecting two boundary points would pinch the mesh
+  if (ulShared == 2 && _acBoundary[ulKeep] && _acBoundary[ulRemove])
+    return false;
+
+  // link condition: the only common neighbours are the opposite points of the shared facets
+  CollectNeighbours(ulKeep, _aulNeighbours0);
+  CollectNeighbours(ulRemove, _aulNeighbours1);
+  if (_aulNeighbours0.size() <= 3 && _aulNeighbours1.size() <= 3)
+    return false; // tetrahedron or single facet
+  unsigned long ulCommon = 0;
+  std::vector<unsigned long>::iterator it = _aulNeighbours0.begin();
+  std::vector<unsigned long>::iterator jt = _aulNeighbours1.begin();
+  while (it != _aulNeighbours0.end() && jt != _aulNeighbours1.end()) {
+    if (*it < *jt)
+      ++it;
+    else if (*jt < *it)
+      ++jt;
+    else {
+      ulCommon++;
+      ++it;
+      ++jt;
+    }
+  }
+  if (ulCommon != ulShared)
+    return false;
+
+  // no remaining facet may flip over or become degenerated
+  unsigned long aulPoints[2] = { ulKeep, ulRemove };
+  for (int k = 0; k < 2; k++) {
+    unsigned long ulPoint = aulPoints[k];
+    unsigned long ulOther = aulPoints[1 - k];
+    const Base::Vector3f& rclOld = _aclPoints[ulPoint];
+    ulEnd = _aulFirst[ulPoint] + _aulCount[ulPoint];
+    for (unsigned long i = _aulFirst[ulPoint]; i < ulEnd; i++) {
+      unsigned long ulRef = _aulRefs[i];
+      unsigned long ulFacet = ulRef / 3;
+      if (_acRemovedFacets[ulFacet] || HasPoint(ulFacet, ulOther))
+        continue;
+      unsigned long ulCorner = ulRef % 3;
+      const Base::Vector3f& rclA = _aclPoints[_aulFacets[3 * ulFacet + (ulCorner + 1) % 3]];
+      const Base::Vector3f& rclB = _aclPoints[_aulFacets[3 * ulFacet + (ulCorner + 2) % 3]];
+      Base::Vector3f clOld = (rclA - rclOld) % (rclB - rclOld);
+      Base::Vector3f clNew = (rclA - rclC.clTarget) % (rclB - rclC.clTarget);
+      float fLen = clOld.Length() * clNew.Length();
+      if (fLen <= 0.0f || clOld * clNew < 0.25f * fLen)
+        return false;
+    }
+  }
+
+  return true;
+}
+
+void MeshDecimation::DoCollapse (const Collapse &rclC)
+{
+  unsigned long ulKeep = rclC.ulKeep, ulRemove = rclC.ulRemove;
+
+  // remove the facets of the edge and let the others point to the kept point
+  unsigned long ulEnd = _aulFirst[ulRemove] + _aulCount[ulRemove];
+  for (unsigned long i = _aulFirst[ulRemove]; i < ulEnd; i++) {
+    unsigned long ulRef = _aulRefs[i];
+    unsigned long ulFacet = ulRef / 3;
+    if (_acRemovedFacets[ulFacet])
+      continue;
+    if (HasPoint(ulFacet, ulKeep)) {
+      _acRemovedFacets[ulFacet] = 1;
+      _ulCtFacets--;
+      _clStats.ulRemoved++;
+    }
+    else {
+      _aulFacets[ulRef] = ulKeep;
+    }
+  }
+
+  _aclPoints[ulKeep] = rclC.clTarget;
+  _aclQuadrics[ulKeep] += _aclQuadrics[ulRemove];
+  _aulStamps[ulKeep]++;
+  _aulStamps[ulRemove] = ULONG_MAX;
+  if (_acBoundary[ulRemove])
+    _acBoundary[ulKeep] = 1;
+
+  // the references of the kept point are appended, the old ones become garbage
+  unsigned long ulFirst = _aulRefs.size();
+  unsigned long aulPoints[2] = { ulKeep, ulRemove };
+  for (int k = 0; k < 2; k++) {
+    unsigned long ulBegin = _aulFirst[aulPoints[k]];
+    ulEnd = ulBegin + _aulCount[aulPoints[k]];
+    for (unsigned long i = ulBegin; i < ulEnd; i++) {
+      unsigned long ulRef = _aulRefs[i];
+      if (!_acRemovedFacets[ulRef / 3])
+        _aulRefs.push_back(ulRef);
+    }
+  }
+  _aulFirst[ulKeep] = ulFirst;
+  _aulCount[ulKeep] = _aulRefs.size() - ulFirst;
+  _aulCount[ulRemove] = 0;
+
+  // the costs of all edges at the kept point have changed
+  CollectNeighbours(ulKeep, _aulNeighbours0);
+  for (std::vector<unsigned long>::iterator it = _aulNeighbours0.begin(); it != _aulNeighbours0.end(); ++it)
+    PushEdge(ulKeep, *it);
+}
+
+void MeshDecimation::Finish (void)
+{
+  unsigned long ulCtPoints = _aclPoints.size();
+  unsigned long ulCtFacets = _acRemovedFacets.size();
+
+  // keep the order of the remaining points and facets
+  std::vector<unsigned long> aulIndex(ulCtPoints, ULONG_MAX);
+  for (unsigned long i = 0; i < ulCtFacets; i++) {
+    if (!_acRemovedFacets[i]) {
+      for (int j = 0; j < 3; j++)
+        aulIndex[_aulFacets[3 * i + j]] = 0;
+    }
+  }
+
+  MeshPointArray aclPoints;
+  aclPoints.reserve(ulCtPoints);
+  for (unsigned long i = 0; i < ulCtPoints; i++) {
+    if (aulIndex[i] == 0) {
+      aulIndex[i] = aclPoints.size();
+      aclPoints.push_back(MeshPoint(_aclPoints[i]));
+    }
+  }
+
+  MeshFacetArray aclFacets;
+  aclFacets.reserve(_ulCtFacets);
+  for (unsigned long i = 0; i < ulCtFacets; i++) {
+    if (!_acRemovedFacets[i]) {
+      aclFacets.push_back(MeshFacet(aulIndex[_aulFacets[3 * i]], aulIndex[_aulFacets[3 * i + 1]],
+                                    aulIndex[_aulFacets[3 * i + 2]]));
+    }
+  }
+
+  _rclMesh.Adopt(aclPoints, aclFacets, true);
+}
@@ -0,0 +1,175 @@
+/***************************************************************************
+ *   Copyright (c) 2012 Imetric 3D GmbH                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef MESH_DECIMATION_H
+#define MESH_DECIMATION_H
+
+#include <vector>
+
+#include <Base/Vector3D.h>
+
+namespace MeshCore {
+
+class MeshKernel;
+
+/**
+ * The MeshDecimation class reduces the number of facets of a mesh by a series
+ * of edge collapses. The edges are collapsed in the order of the quadric error
+ * metric of Garland and Heckbert, i.e. each point carries the sum of squared
+ * distances to the planes of the original facets it has been merged with and
+ * an edge is replaced by the point where this sum is minimal.
+ *
+ * The candidates are kept in a priority queue with lazy deletion: instead of
+ * updating the entries of the edges around a collapse they are tagged with the
+ * version of their end points and silently dropped when popped after one of
+ * the points has changed. Before an edge is collapsed it is checked that the
+ * topology stays a manifold (link condition) and that no facet flips over.
+ *
+ * Boundary edges and sharp edges with a dihedral angle above the feature angle
+ * get additional constraint planes perpendicular to the adjacent facets so that
+ * the outline and the features are kept as good as possible. Optionally the
+ * boundary points can be locked completely.
+ *
+ * The decimation stops when the target number of facets is reached or the next
+ * collapse would exceed the tolerance. Since the quadric error of a point sums
+ * up the squared distances to all of its planes its square root is an upper
+ * bound for the distance to each of these planes.
+ */
+class MeshExport MeshDecimation
+{
+public:
+  /** Statistics of the last run. */
+  struct Statistics
+  {
+    unsigned long ulCollapses;  /**< Number of collapsed edges. */
+    unsigned long ulRemoved;    /**< Number of removed facets. */
+    unsigned long ulStale;      /**< Queue entries dropped because they were out of date. */
+    unsigned long ulRejected;   /**< Collapses rejected for topological or geometric reasons. */
+    float fMaxError;            /**< Square root of the largest quadric error of a collapse. */
+  };
+
+  /// Construction
+  MeshDecimation (MeshKernel &rclMesh);
+  /// Destruction
+  ~MeshDecimation (void);
+
+  /** @name Settings */
+  //@{
+  /** Sets the number of facets to reduce the mesh to. */
+  void SetTargetSize (unsigned long ulCtFacets)
+  { _ulTargetSize = ulCtFacets; }
+  /** Sets the maximum deviation a collapse may introduce, see the class
+   * description. By default there is no limit. */
+  void SetTolerance (float fTolerance)
+  { _fTolerance = fTolerance; }
+  /** If \a bPreserve is true boundary points are neither moved nor removed.
+   * Otherwise boundary edges may be collapsed along the boundary. The default
+   * is true. */
+  void SetPreserveBoundary (bool bPreserve)
+  { _bPreserveBoundary = bPreserve; }
+  /** Edges whose adjacent facets enclose an angle (in radians) greater than
+   * \a fAngle are treated as features. The default is 45 degree. */
+  void SetFeatureAngle (float fAngle)
+  { _fFeatureAngle = fAngle; }
+  /** Sets the weight of the constraint planes of boundary and feature edges. */
+  void SetConstraintWeight (float fWeight)
+  { _fWeight = fWeight; }
+  //@}
+
+  /** Decimates the mesh and returns true if any facet was removed. */
+  bool Decimate (void);
+  /** Returns the statistics of the last call of Decimate(). */
+  const Statistics& GetStatistics (void) const
+  { return _clStats; }
+
+protected:
+  /** The symmetric 4x4 matrix of a quadric. */
+  struct Quadric
+  {
+    double a[10];
+
+    void Clear (void);
+    void AddPlane (const Base::Vector3f &rclNormal, const Base::Vector3f &rclBase, double fWeight);
+    Quadric& operator += (const Quadric &rclQ);
+    double Evaluate (const Base::Vector3f &rclPt) const;
+    bool Optimize (Base::Vector3f &rclPt) const;
+  };
+
+  /** An entry of the priority queue. */
+  struct Collapse
+  {
+    float fCost;
+    unsigned long ulKeep, ulRemove;         /**< The point to keep and the one to remove. */
+    unsigned long ulStampKeep, ulStampRemove; /**< The versions of the points when the entry was made. */
+    Base::Vector3f clTarget;
+
+    /** The queue is a max-heap, so lower costs have higher priority. */
+    bool operator < (const Collapse &rclC) const
+    { return fCost > rclC.fCost; }
+  };
+
+  /** @name Steps */
+  //@{
+  void Initialize (void);
+  void BuildReferences (void);
+  void PushEdge (unsigned long ulP0, unsigned long ulP1);
+  bool IsValid (const Collapse &rclC) const;
+  bool CanCollapse (const Collapse &rclC);
+  void DoCollapse (const Collapse &rclC);
+  void Finish (void);
+  //@}
+
+  /** @name Helpers */
+  //@{
+  void CollectNeighbours (unsigned long ulPoint, std::vector<unsigned long> &raulPoints) const;
+  bool HasPoint (unsigned long ulFacet, unsigned long ulPoint) const;
+  //@}
+
+private:
+  MeshKernel& _rclMesh;
+  unsigned long _ulTargetSize;
+  float _fTolerance;
+  bool _bPreserveBoundary;
+  float _fFeatureAngle;
+  float _fWeight;
+  float _fMaxCost;                       /**< Square of the tolerance. */
+  Statistics _clStats;
+
+  unsigned long _ulCtFacets;             /**< Number of remaining facets. */
+  std::vector<Base::Vector3f> _aclPoints;
+  std::vector<unsigned long> _aulFacets; /**< Three point indices per facet. */
+  std::vector<char> _acRemovedFacets;
+  std::vector<Quadric> _aclQuadrics;
+  std::vector<unsigned long> _aulStamps; /**< Version of each point, ULONG_MAX for removed points. */
+  std::vector<char> _acBoundary;         /**< Flags points on the boundary. */
+  std::vector<unsigned long> _aulFirst;  /**< Start of the references of each point. */
+  std::vector<unsigned long> _aulCount;  /**< Number of references of each point. */
+  std::vector<unsigned long> _aulRefs;   /**< References of the points as 3 * facet + corner. */
+  std::vector<Collapse> _aclQueue;       /**< The heap of candidates. */
+  std::vector<unsigned long> _aulNeighbours0, _aulNeighbours1; /**< Buffers for CanCollapse(). */
+};
+
+} // namespace MeshCore
+
+#endif // MESH_DECIMATION_H
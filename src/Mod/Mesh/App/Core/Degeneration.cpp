@@ -1031,18 +1031,28 @@ bool MeshFixCorruptedFacets::Fixup()
 {
   MeshTopoAlgorithm cTopAlg(_rclMesh);
 
+  // RemoveCorruptedFacet() keeps the point indices of the other facets, so
+  // the half-edge index can be used. Then a removal only visits the facets
+  // around the removed one and the last facet is moved into the gap.
+  _rclMesh.BeginEdit();
+
   MeshFacetIterator it(_rclMesh);
   for ( it.Init(); it.More(); it.Next() )
   {
     if ( it->Area() <= FLOAT_EPS )
     {
+      unsigned long uCt = _rclMesh.CountFacets();
       unsigned long uId = it.Position();
       cTopAlg.RemoveCorruptedFacet(uId);
-      // due to a modification of the array the iterator became invalid
-      it.Set(uId-1);
+      if ( uCt != _rclMesh.CountFacets() )
+      {
+        // due to a modification of the array the iterator became invalid
+        it.Set(uId-1);
+      }
     }
   }
 
+  _rclMesh.EndEdit();
   return true;
 }
 
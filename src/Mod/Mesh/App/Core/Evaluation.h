@@ -70,7 +70,8 @@ protected:
 class MeshExport MeshValidation
 {
 public:
-  MeshValidation (MeshKernel &rclB) : _rclMesh(rclB) {}
+  /// The fixes modify the arrays directly, so an edit of the kernel is ended.
+  MeshValidation (MeshKernel &rclB) : _rclMesh(rclB) { _rclMesh.EndEdit(); }
   virtual ~MeshValidation () {}
 
   /**
@@ -292,6 +293,10 @@ public:
     virtual ~MeshEvalSelfIntersection () {}
     /// Evaluate the mesh and return if true if there are self intersections
     bool Evaluate ();
+    /** Does the same as Evaluate() but serially tests the facets sharing a cell
+     * of a facet grid. It is much slower and only kept for comparisons.
+     */
+    bool EvaluateByGrid ();
     /// collect all intersection lines
     void GetIntersections(const std::vector<std::pair<unsigned long, unsigned long> >&,
         std::vector<std::pair<Base::Vector3f, Base::Vector3f> >&) const;
@@ -27,6 +27,11 @@
 # include <algorithm>
 #endif
 
+#include <QFuture>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+
 #include "Grid.h"
 #include "Iterator.h"
 
@@ -37,7 +42,8 @@
 using namespace MeshCore;
 
 MeshGrid::MeshGrid (const MeshKernel &rclM)
-: _pclMesh(&rclM),
+: _bFillGrid(false),
+  _pclMesh(&rclM),
   _ulCtElements(0),
   _ulCtGridsX(0), _ulCtGridsY(0), _ulCtGridsZ(0),
   _fGridLenX(0.0f), _fGridLenY(0.0f), _fGridLenZ(0.0f),
@@ -46,7 +52,8 @@ MeshGrid::MeshGrid (const MeshKernel &rclM)
 }
 
 MeshGrid::MeshGrid (void)
-: _pclMesh(NULL),
+: _bFillGrid(false),
+  _pclMesh(NULL),
   _ulCtElements(0),
   _ulCtGridsX(MESH_CT_GRID), _ulCtGridsY(MESH_CT_GRID), _ulCtGridsZ(MESH_CT_GRID),
   _fGridLenX(0.0f), _fGridLenY(0.0f), _fGridLenZ(0.0f),
@@ -62,7 +69,9 @@ void MeshGrid::Attach (const MeshKernel &rclM)
 
 void MeshGrid::Clear (void)
 {
-  _aulGrid.clear();
+  _aulGridOffsets.clear();
+  _aulGridIndices.clear();
+  _bFillGrid = false;
   _pclMesh = NULL;  
 }
 
@@ -93,8 +102,6 @@ void MeshGrid::InitGrid (void)
 {
   assert(_pclMesh != NULL);
 
-  unsigned long i, j;
-
   // Grid Laengen berechnen wenn nicht initialisiert
   //
   if ((_ulCtGridsX == 0) || (_ulCtGridsX == 0) || (_ulCtGridsX == 0))
@@ -128,14 +135,33 @@ void MeshGrid::InitGrid (void)
   }
 
   // Daten-Struktur anlegen
-  _aulGrid.clear();
-  _aulGrid.resize(_ulCtGridsX);
-  for (i = 0; i < _ulCtGridsX; i++)
+  _aulGridIndices.clear();
+  _aulGridOffsets.clear();
+  _aulGridOffsets.resize(_ulCtGridsX * _ulCtGridsY * _ulCtGridsZ + 1, 0);
+  _bFillGrid = false;
+}
+
+void MeshGrid::BeginFill (void)
+{
+  // Turn the counts into the start offsets of the grid elements, shifted by one position
+  // so that AddElement() can use the entry behind each grid element as insert position.
+  unsigned long ulSize = _aulGridOffsets.size();
+  unsigned long ulStart = 0;
+  for (unsigned long i = 1; i < ulSize; i++)
   {
-    _aulGrid[i].resize(_ulCtGridsY);
-    for (j = 0; j < _ulCtGridsY; j++)
-      _aulGrid[i][j].resize(_ulCtGridsZ);
+    unsigned long ulCount = _aulGridOffsets[i];
+    _aulGridOffsets[i] = ulStart;
+    ulStart += ulCount;
   }
+
+  _aulGridIndices.resize(ulStart);
+  _bFillGrid = true;
+}
+
+void MeshGrid::EndFill (void)
+{
+  assert(_aulGridOffsets.back() == _aulGridIndices.size());
+  _bFillGrid = false;
 }
 
 unsigned long MeshGrid::Inside (const Base::BoundBox3f &rclBB, std::vector<unsigned long> &raulElements,
@@ -155,7 +181,7 @@ unsigned long MeshGrid::Inside (const Base::BoundBox3f &rclBB, std::vector<unsig
     {
       for (k = ulMinZ; k <= ulMaxZ; k++)
       {
-        raulElements.insert(raulElements.end(), _aulGrid[i][j][k].begin(), _aulGrid[i][j][k].end());
+        raulElements.insert(raulElements.end(), GridBegin(i, j, k), GridEnd(i, j, k));
       }
     }
   }  
@@ -190,7 +216,7 @@ unsigned long MeshGrid::Inside (const Base::BoundBox3f &rclBB, std::vector<unsig
       for (k = ulMinZ; k <= ulMaxZ; k++)
       {
         if (Base::DistanceP2(GetBoundBox(i, j, k).CalcCenter(), rclOrg) < fMinDistP2)
-          raulElements.insert(raulElements.end(), _aulGrid[i][j][k].begin(), _aulGrid[i][j][k].end());
+          raulElements.insert(raulElements.end(), GridBegin(i, j, k), GridEnd(i, j, k));
       }
     }
   }  
@@ -221,7 +247,7 @@ unsigned long MeshGrid::Inside (const Base::BoundBox3f &rclBB, std::set<unsigned
     {
       for (k = ulMinZ; k <= ulMaxZ; k++)
       {
-        raulElements.insert(_aulGrid[i][j][k].begin(), _aulGrid[i][j][k].end());
+        raulElements.insert(GridBegin(i, j, k), GridEnd(i, j, k));
       }
     }
   }  
@@ -450,7 +476,7 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsY; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[nX][i][j].begin(), _aulGrid[nX][i][j].end());
+              raclInd.insert(GridBegin(nX, i, j), GridEnd(nX, i, j));
           }
           nX++;
         }
@@ -464,7 +490,7 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsY; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[nX][i][j].begin(), _aulGrid[nX][i][j].end());
+              raclInd.insert(GridBegin(nX, i, j), GridEnd(nX, i, j));
           }
           nX++;
         }
@@ -478,7 +504,7 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[i][nY][j].begin(), _aulGrid[i][nY][j].end());
+              raclInd.insert(GridBegin(i, nY, j), GridEnd(i, nY, j));
           }
           nY++;
         }
@@ -492,7 +518,7 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsZ; j++)
-              raclInd.insert(_aulGrid[i][nY][j].begin(), _aulGrid[i][nY][j].end());
+              raclInd.insert(GridBegin(i, nY, j), GridEnd(i, nY, j));
           }
           nY--;
         }
@@ -506,7 +532,7 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsY; j++)
-              raclInd.insert(_aulGrid[i][j][nZ].begin(), _aulGrid[i][j][nZ].end());
+              raclInd.insert(GridBegin(i, j, nZ), GridEnd(i, j, nZ));
           }
           nZ++;
         }
@@ -520,7 +546,7 @@ void MeshGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt, std::set<uns
           for (unsigned long i = 0; i < _ulCtGridsX; i++)
           {
             for (unsigned long j = 0; j < _ulCtGridsY; j++)
-              raclInd.insert(_aulGrid[i][j][nZ].begin(), _aulGrid[i][j][nZ].end());
+              raclInd.insert(GridBegin(i, j, nZ), GridEnd(i, j, nZ));
           }
           nZ--;
         }
@@ -586,11 +612,12 @@ void MeshGrid::GetHull (unsigned long ulX, unsigned long ulY, unsigned long ulZ,
 unsigned long MeshGrid::GetElements (unsigned long ulX, unsigned long ulY, unsigned long ulZ,  
                                      std::set<unsigned long> &raclInd) const
 {
-  const std::set<unsigned long> &rclSet = _aulGrid[ulX][ulY][ulZ];
-  if (rclSet.size() > 0)
+  std::vector<unsigned long>::const_iterator pBegin = GridBegin(ulX, ulY, ulZ);
+  std::vector<unsigned long>::const_iterator pEnd = GridEnd(ulX, ulY, ulZ);
+  if (pBegin != pEnd)
   {
-    raclInd.insert(rclSet.begin(), rclSet.end());
-    return rclSet.size();
+    raclInd.insert(pBegin, pEnd);
+    return pEnd - pBegin;
   }
 
   return 0;
@@ -602,9 +629,7 @@ unsigned long MeshGrid::GetElements(const Base::Vector3f &rclPoint, std::vector<
   if (!CheckPosition(rclPoint, ulX, ulY, ulZ))
     return 0;
 
-  aulFacets.resize(_aulGrid[ulX][ulY][ulZ].size());
-
-  std::copy(_aulGrid[ulX][ulY][ulZ].begin(), _aulGrid[ulX][ulY][ulZ].end(), aulFacets.begin());
+  aulFacets.assign(GridBegin(ulX, ulY, ulZ), GridEnd(ulX, ulY, ulZ));
   return aulFacets.size();
 }
 
@@ -706,18 +731,105 @@ void MeshFacetGrid::RebuildGrid (void)
 {
   _ulCtElements = _pclMesh->CountFacets();
 
+  if (_ulCtElements >= MESH_CT_PARALLEL_GRID && QThread::idealThreadCount() > 1)
+  {
+    RebuildGridParallel();
+    return;
+  }
+
   InitGrid();
  
-  // Daten-Struktur fuellen
+  // Daten-Struktur fuellen: first pass counts, second pass stores the indices
   MeshFacetIterator clFIter(*_pclMesh);
 
-  unsigned long i = 0;
-  for (clFIter.Init(); clFIter.More(); clFIter.Next())
+  for (int iPass = 0; iPass < 2; iPass++)
   {
-//    AddFacet(*clFIter, i++, 2.0f);
-    AddFacet(*clFIter, i++);
+    if (iPass == 1)
+      BeginFill();
+    unsigned long i = 0;
+    for (clFIter.Init(); clFIter.More(); clFIter.Next())
+    {
+//      AddFacet(*clFIter, i++, 2.0f);
+      AddFacet(*clFIter, i++);
+    }
   }
 
+  EndFill();
+}
+
+void MeshFacetGrid::FillBucket (GridBucket &rclBucket) const
+{
+  unsigned long ulX, ulY, ulZ;
+  unsigned long ulX1, ulY1, ulZ1, ulX2, ulY2, ulZ2;
+
+  rclBucket.aclEntries.reserve(rclBucket.ulEnd - rclBucket.ulBegin);
+  for (unsigned long i = rclBucket.ulBegin; i < rclBucket.ulEnd; i++)
+  {
+    MeshGeomFacet clFacet = _pclMesh->GetFacet(i);
+
+    Base::BoundBox3f clBB;
+    clBB &= clFacet._aclPoints[0];
+    clBB &= clFacet._aclPoints[1];
+    clBB &= clFacet._aclPoints[2];
+
+    Pos(Base::Vector3f(clBB.MinX,clBB.MinY,clBB.MinZ), ulX1, ulY1, ulZ1);
+    Pos(Base::Vector3f(clBB.MaxX,clBB.MaxY,clBB.MaxZ), ulX2, ulY2, ulZ2);
+
+    // same as AddFacet()
+    if ((ulX1 < ulX2) || (ulY1 < ulY2) || (ulZ1 < ulZ2))
+    {
+      for (ulX = ulX1; ulX <= ulX2; ulX++)
+      {
+        for (ulY = ulY1; ulY <= ulY2; ulY++)
+        {
+          for (ulZ = ulZ1; ulZ <= ulZ2; ulZ++)
+          {
+            if (clFacet.IntersectBoundingBox(GetBoundBox(ulX, ulY, ulZ)))
+              rclBucket.aclEntries.push_back(std::make_pair(GridIndex(ulX, ulY, ulZ), i));
+          }
+        }
+      }
+    }
+    else
+      rclBucket.aclEntries.push_back(std::make_pair(GridIndex(ulX1, ulY1, ulZ1), i));
+  }
+}
+
+void MeshFacetGrid::RebuildGridParallel (void)
+{
+  InitGrid();
+
+  // split the facets into more ranges than threads to balance the load
+  unsigned long ulCtBuckets = 4 * (unsigned long)QThread::idealThreadCount();
+  unsigned long ulStep = (_ulCtElements + ulCtBuckets - 1) / ulCtBuckets;
+  std::vector<GridBucket> aclBuckets(ulCtBuckets);
+  for (unsigned long i = 0; i < ulCtBuckets; i++)
+  {
+    aclBuckets[i].ulBegin = std::min<unsigned long>(i * ulStep, _ulCtElements);
+    aclBuckets[i].ulEnd = std::min<unsigned long>((i + 1) * ulStep, _ulCtElements);
+  }
+
+  QFuture<void> future = QtConcurrent::map
+    (aclBuckets, boost::bind(&MeshFacetGrid::FillBucket, this, _1));
+  future.waitForFinished();
+
+  // merge the buckets in the order of their ranges to keep the indices of each grid element sorted
+  std::vector<GridBucket>::iterator it;
+  std::vector<std::pair<unsigned long, unsigned long> >::const_iterator jt;
+  for (it = aclBuckets.begin(); it != aclBuckets.end(); ++it)
+  {
+    for (jt = it->aclEntries.begin(); jt != it->aclEntries.end(); ++jt)
+      _aulGridOffsets[jt->first + 1]++;
+  }
+
+  BeginFill();
+  for (it = aclBuckets.begin(); it != aclBuckets.end(); ++it)
+  {
+    for (jt = it->aclEntries.begin(); jt != it->aclEntries.end(); ++jt)
+      _aulGridIndices[_aulGridOffsets[jt->first + 1]++] = jt->second;
+    std::vector<std::pair<unsigned long, unsigned long> >().swap(it->aclEntries);
+  }
+  EndFill();
 }
 
 unsigned long MeshFacetGrid::SearchNearestFromPoint (const Base::Vector3f &rclPt) const
@@ -918,8 +1030,8 @@ void MeshFacetGrid::SearchNearestFacetInGrid(unsigned long ulX, unsigned long ul
                                              const Base::Vector3f &rclPt, float &rfMinDist,
                                              unsigned long &rulFacetInd) const
 {
-  const std::set<unsigned long> &rclSet = _aulGrid[ulX][ulY][ulZ];
-  for (std::set<unsigned long>::const_iterator pI = rclSet.begin(); pI != rclSet.end(); pI++)
+  std::vector<unsigned long>::const_iterator pEnd = GridEnd(ulX, ulY, ulZ);
+  for (std::vector<unsigned long>::const_iterator pI = GridBegin(ulX, ulY, ulZ); pI != pEnd; pI++)
   {
     float fDist = _pclMesh->GetFacet(*pI).DistanceToPoint(rclPt);
     if (fDist < rfMinDist)
@@ -969,7 +1081,7 @@ void MeshPointGrid::AddPoint (const MeshPoint &rclPt, unsigned long ulPtIndex, f
   unsigned long ulX, ulY, ulZ;
   Pos(Base::Vector3f(rclPt.x, rclPt.y, rclPt.z), ulX, ulY, ulZ);
   if ( (ulX < _ulCtGridsX) && (ulY < _ulCtGridsY) && (ulZ < _ulCtGridsZ) )
-    _aulGrid[ulX][ulY][ulZ].insert(ulPtIndex);
+    AddElement(ulX, ulY, ulZ, ulPtIndex);
 }
 
 void MeshPointGrid::Validate (const MeshKernel &rclMesh)
@@ -1019,15 +1131,22 @@ void MeshPointGrid::RebuildGrid (void)
 
   InitGrid();
  
-  // Daten-Struktur fuellen
+  // Daten-Struktur fuellen: first pass counts, second pass stores the indices
 
   MeshPointIterator cPIter(*_pclMesh);
 
-  unsigned long i = 0;
-  for (cPIter.Init(); cPIter.More(); cPIter.Next())
+  for (int iPass = 0; iPass < 2; iPass++)
   {
-    AddPoint(*cPIter, i++);
+    if (iPass == 1)
+      BeginFill();
+    unsigned long i = 0;
+    for (cPIter.Init(); cPIter.More(); cPIter.Next())
+    {
+      AddPoint(*cPIter, i++);
+    }
   }
+
+  EndFill();
 }
 
 void MeshPointGrid::Pos (const Base::Vector3f &rclPoint, unsigned long &rulX, unsigned long &rulY, unsigned long &rulZ) const
@@ -1089,7 +1208,7 @@ bool MeshGridIterator::InitOnRay (const Base::Vector3f &rclPt, const Base::Vecto
   if ((_rclGrid.GetBoundBox().IsInBox(rclPt)) == true)
   {  // Voxel bestimmen, indem der Startpunkt liegt
     _rclGrid.Position(rclPt, _ulX, _ulY, _ulZ);
-    raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end());
+    raulElements.insert(raulElements.end(), _rclGrid.GridBegin(_ulX, _ulY, _ulZ), _rclGrid.GridEnd(_ulX, _ulY, _ulZ));
     _bValidRay = true;
   }
   else
@@ -1102,7 +1221,7 @@ bool MeshGridIterator::InitOnRay (const Base::Vector3f &rclPt, const Base::Vecto
       else
         _rclGrid.Position(cP1, _ulX, _ulY, _ulZ);
 
-      raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end());
+      raulElements.insert(raulElements.end(), _rclGrid.GridBegin(_ulX, _ulY, _ulZ), _rclGrid.GridEnd(_ulX, _ulY, _ulZ));
       _bValidRay = true;
     }
   }
@@ -1153,7 +1272,7 @@ bool MeshGridIterator::NextOnRay (std::vector<unsigned long> &raulElements)
   if ((_bValidRay == true) && (_rclGrid.CheckPos(_ulX, _ulY, _ulZ) == true))
   {
     GridElement pos(_ulX, _ulY, _ulZ); _cSearchPositions.insert(pos);
-    raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end()); 
+    raulElements.insert(raulElements.end(), _rclGrid.GridBegin(_ulX, _ulY, _ulZ), _rclGrid.GridEnd(_ulX, _ulY, _ulZ)); 
   }
   else
     _bValidRay = false;  // Strahl ausgetreten
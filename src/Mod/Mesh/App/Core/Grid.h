@@ -25,6 +25,7 @@
 #define MESH_GRID_H
 
 #include <set>
+#include <utility>
 
 #include "MeshKernel.h"
 #include <Base/Vector3D.h>
@@ -33,6 +34,7 @@
 #define  MESH_CT_GRID          256     // Default value for number of elements per grid
 #define  MESH_MAX_GRIDS        100000  // Default value for maximum number of grids
 #define  MESH_CT_GRID_PER_AXIS 20
+#define  MESH_CT_PARALLEL_GRID 100000  // Minimum number of facets to build a facet grid in parallel
 
 
 namespace MeshCore {
@@ -125,7 +127,10 @@ public:
   bool GetPositionToIndex(unsigned long id, unsigned long& ulX, unsigned long& ulY, unsigned long& ulZ) const;
   /** Returns the number of elements in a given grid. */
   unsigned long GetCtElements(unsigned long ulX, unsigned long ulY, unsigned long ulZ) const
-  { return _aulGrid[ulX][ulY][ulZ].size(); }
+  {
+    unsigned long ulGrid = GridIndex(ulX, ulY, ulZ);
+    return _aulGridOffsets[ulGrid+1] - _aulGridOffsets[ulGrid];
+  }
   /** Validates the grid structure and rebuilds it if needed. Must be implemented in sub-classes. */
   virtual void Validate (const MeshKernel &rclM) = 0;
   /** Verifies the grid structure and returns false if inconsistencies are found. */
@@ -156,8 +161,33 @@ protected:
   /** Returns the number of stored elements. Must be implemented in sub-classes. */
   virtual unsigned long HasElements (void) const = 0;
 
+  /** @name Filling
+   * The grid stores the element indices of all grid elements in one contiguous array (compressed
+   * sparse row layout) where the indices of a single grid element are addressed by an offset table.
+   * The structure is filled in two passes: after InitGrid() all elements are passed to AddElement()
+   * to count the entries per grid element. BeginFill() then computes the offsets and switches to
+   * the second pass where the same elements must be passed to AddElement() in the same order again.
+   * EndFill() finishes the structure.
+   */
+  //@{
+  /** Returns the linear index of a grid element. The position is not checked. */
+  inline unsigned long GridIndex (unsigned long ulX, unsigned long ulY, unsigned long ulZ) const;
+  /** Counts or stores the element \a ulIndex in the given grid element, depending on the current pass. */
+  inline void AddElement (unsigned long ulX, unsigned long ulY, unsigned long ulZ, unsigned long ulIndex);
+  /** Finishes the counting pass and prepares the structure for the storing pass. */
+  void BeginFill (void);
+  /** Finishes the storing pass. */
+  void EndFill (void);
+  /** Returns an iterator to the first element index in the given grid element. */
+  inline std::vector<unsigned long>::const_iterator GridBegin (unsigned long ulX, unsigned long ulY, unsigned long ulZ) const;
+  /** Returns an iterator past the last element index in the given grid element. */
+  inline std::vector<unsigned long>::const_iterator GridEnd (unsigned long ulX, unsigned long ulY, unsigned long ulZ) const;
+  //@}
+
 protected:
-  std::vector<std::vector<std::vector<std::set<unsigned long> > > >  _aulGrid;   /**< Grid data structure. */
+  std::vector<unsigned long> _aulGridOffsets; /**< Offsets of the grid elements into _aulGridIndices. */
+  std::vector<unsigned long> _aulGridIndices; /**< Element indices of all grid elements. */
+  bool              _bFillGrid;   /**< Whether AddElement() stores or only counts. */
   const MeshKernel* _pclMesh;     /**< The mesh kernel. */
   unsigned long     _ulCtElements;/**< Number of grid elements for validation issues. */
   unsigned long     _ulCtGridsX;  /**< Number of grid elements in z. */
@@ -233,6 +263,23 @@ protected:
   { return _pclMesh->CountFacets(); }
   /** Rebuilds the grid structure. */
   virtual void RebuildGrid (void);
+
+  /** @name Parallel build */
+  //@{
+  /** The facets of a contiguous index range with the grid elements they intersect, stored as
+   * pairs of linear grid index and facet index. */
+  struct GridBucket
+  {
+    unsigned long ulBegin, ulEnd;
+    std::vector<std::pair<unsigned long, unsigned long> > aclEntries;
+  };
+  /** Collects the grid elements of all facets in the range of \a rclBucket. This method doesn't
+   * modify the grid and can be called from several threads at the same time. */
+  void FillBucket (GridBucket &rclBucket) const;
+  /** Rebuilds the grid structure by filling the buckets of several facet ranges in parallel and
+   * merging them in index order afterwards. */
+  void RebuildGridParallel (void);
+  //@}
 };
 
 /**
@@ -295,7 +342,7 @@ public:
   /** Returns indices of the elements in the current grid. */
   void GetElements (std::vector<unsigned long> &raulElements) const
   {
-    raulElements.insert(raulElements.end(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].begin(), _rclGrid._aulGrid[_ulX][_ulY][_ulZ].end());
+    raulElements.insert(raulElements.end(), _rclGrid.GridBegin(_ulX, _ulY, _ulZ), _rclGrid.GridEnd(_ulX, _ulY, _ulZ));
   }
   /** Returns the number of elements in the current grid. */
   unsigned long GetCtElements() const
@@ -391,6 +438,32 @@ inline bool MeshGrid::CheckPos (unsigned long ulX, unsigned long ulY, unsigned l
   return ((ulX < _ulCtGridsX) && (ulY < _ulCtGridsY) && (ulZ < _ulCtGridsZ));
 }
 
+inline unsigned long MeshGrid::GridIndex (unsigned long ulX, unsigned long ulY, unsigned long ulZ) const
+{
+  return (ulZ * _ulCtGridsY + ulY) * _ulCtGridsX + ulX;
+}
+
+inline void MeshGrid::AddElement (unsigned long ulX, unsigned long ulY, unsigned long ulZ, unsigned long ulIndex)
+{
+  // While filling, the entry behind the grid element serves as insert position. After the
+  // last element has been stored it points to the end of the grid element's range.
+  unsigned long ulGrid = GridIndex(ulX, ulY, ulZ) + 1;
+  if (_bFillGrid)
+    _aulGridIndices[_aulGridOffsets[ulGrid]++] = ulIndex;
+  else
+    _aulGridOffsets[ulGrid]++;
+}
+
+inline std::vector<unsigned long>::const_iterator MeshGrid::GridBegin (unsigned long ulX, unsigned long ulY, unsigned long ulZ) const
+{
+  return _aulGridIndices.begin() + _aulGridOffsets[GridIndex(ulX, ulY, ulZ)];
+}
+
+inline std::vector<unsigned long>::const_iterator MeshGrid::GridEnd (unsigned long ulX, unsigned long ulY, unsigned long ulZ) const
+{
+  return _aulGridIndices.begin() + _aulGridOffsets[GridIndex(ulX, ulY, ulZ) + 1];
+}
+
 // --------------------------------------------------------------
 
 inline void MeshFacetGrid::Pos (const Base::Vector3f &rclPoint, unsigned long &rulX, unsigned long &rulY, unsigned long &rulZ) const
@@ -445,7 +518,7 @@ inline void MeshFacetGrid::AddFacet (const MeshGeomFacet &rclFacet, unsigned lon
   for (i = 0; i < 3; i++)
   {
     Pos(rclFacet._aclPoints[i], ulX, ulY, ulZ);
-    _aulGrid[ulX][ulY][ulZ].insert(ulFacetIndex);
+    AddElement(ulX, ulY, ulZ, ulFacetIndex);
     ulX1 = RSmin<unsigned long>(ulX1, ulX); ulY1 = RSmin<unsigned long>(ulY1, ulY); ulZ1 = RSmin<unsigned long>(ulZ1, ulZ);
     ulX2 = RSmax<unsigned long>(ulX2, ulX); ulY2 = RSmax<unsigned long>(ulY2, ulY); ulZ2 = RSmax<unsigned long>(ulZ2, ulZ);
   }
@@ -460,7 +533,7 @@ inline void MeshFacetGrid::AddFacet (const MeshGeomFacet &rclFacet, unsigned lon
         for (ulZ = ulZ1; ulZ <= ulZ2; ulZ++)
         {
           if (CMeshFacetFunc::BBoxContainFacet(GetBoundBox(ulX, ulY, ulZ), rclFacet) == TRUE)
-            _aulGrid[ulX][ulY][ulZ].insert(ulFacetIndex);
+            AddElement(ulX, ulY, ulZ, ulFacetIndex);
         }
       }
     }
@@ -503,13 +576,13 @@ inline void MeshFacetGrid::AddFacet (const MeshGeomFacet &rclFacet, unsigned lon
         for (ulZ = ulZ1; ulZ <= ulZ2; ulZ++)
         {
           if ( rclFacet.IntersectBoundingBox( GetBoundBox(ulX, ulY, ulZ) ) )
-            _aulGrid[ulX][ulY][ulZ].insert(ulFacetIndex);
+            AddElement(ulX, ulY, ulZ, ulFacetIndex);
         }
       }
     }
   }
   else
-    _aulGrid[ulX1][ulY1][ulZ1].insert(ulFacetIndex);
+    AddElement(ulX1, ulY1, ulZ1, ulFacetIndex);
 
 #endif
 }
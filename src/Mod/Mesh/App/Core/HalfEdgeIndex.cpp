@@ -0,0 +1,139 @@
+/***************************************************************************
+ *   Copyright (c) 2012 Imetric 3D GmbH                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+#endif
+
+#include "HalfEdgeIndex.h"
+
+using namespace MeshCore;
+
+MeshHalfEdgeIndex::MeshHalfEdgeIndex (const MeshFacetArray &rclFacets, unsigned long ulCtPoints)
+    : _aulFirst(ulCtPoints, ULONG_MAX), _aulNext(3 * rclFacets.size(), ULONG_MAX)
+{
+    unsigned long ulFacet = 0;
+    for (MeshFacetArray::_TConstIterator it = rclFacets.begin(); it != rclFacets.end(); ++it, ulFacet++)
+        AddFacet(ulFacet, *it);
+}
+
+void MeshHalfEdgeIndex::ResizePoints (unsigned long ulCtPoints)
+{
+    _aulFirst.resize(ulCtPoints, ULONG_MAX);
+}
+
+void MeshHalfEdgeIndex::ResizeFacets (unsigned long ulCtFacets)
+{
+    _aulNext.resize(3 * ulCtFacets, ULONG_MAX);
+}
+
+void MeshHalfEdgeIndex::AddFacet (unsigned long ulFacet, const MeshFacet &rclFacet)
+{
+    if (_aulNext.size() < 3 * (ulFacet + 1))
+        _aulNext.resize(3 * (ulFacet + 1), ULONG_MAX);
+    for (int i = 0; i < 3; i++) {
+        unsigned long ulPoint = rclFacet._aulPoints[i];
+        _aulNext[3 * ulFacet + i] = _aulFirst[ulPoint];
+        _aulFirst[ulPoint] = 3 * ulFacet + i;
+    }
+}
+
+void MeshHalfEdgeIndex::RemoveFacet (unsigned long ulFacet, const MeshFacet &rclFacet)
+{
+    for (int i = 0; i < 3; i++)
+        Unlink(rclFacet._aulPoints[i], 3 * ulFacet + i);
+}
+
+void MeshHalfEdgeIndex::MoveFacet (unsigned long ulFrom, unsigned long ulTo, MeshFacetArray &rclFacets)
+{
+    const MeshFacet& rclFacet = rclFacets[ulFrom];
+    for (int i = 0; i < 3; i++) {
+        Relink(rclFacet._aulPoints[i], 3 * ulFrom + i, 3 * ulTo + i);
+        unsigned long ulNeighbour = rclFacet._aulNeighbours[i];
+        if (ulNeighbour != ULONG_MAX)
+            rclFacets[ulNeighbour].ReplaceNeighbour(ulFrom, ulTo);
+    }
+
+    rclFacets[ulTo] = rclFacet;
+}
+
+void MeshHalfEdgeIndex::MovePoint (unsigned long ulFrom, unsigned long ulTo, MeshPointArray &rclPoints,
+                                   MeshFacetArray &rclFacets)
+{
+    for (unsigned long h = _aulFirst[ulFrom]; h != ULONG_MAX; h = _aulNext[h])
+        rclFacets[h / 3]._aulPoints[h % 3] = ulTo;
+    _aulFirst[ulTo] = _aulFirst[ulFrom];
+    _aulFirst[ulFrom] = ULONG_MAX;
+    rclPoints[ulTo] = rclPoints[ulFrom];
+}
+
+void MeshHalfEdgeIndex::GetEdgeFacets (unsigned long ulP, unsigned long ulQ, const MeshFacetArray &rclFacets,
+                                       std::vector<unsigned long> &raulFacets) const
+{
+    // the half-edges starting at P contain the half-edge (P,Q) and the
+    // preceding one of (Q,P) of the same facet
+    raulFacets.clear();
+    for (unsigned long h = _aulFirst[ulP]; h != ULONG_MAX; h = _aulNext[h]) {
+        const MeshFacet& rclFacet = rclFacets[h / 3];
+        int i = h % 3;
+        if (rclFacet._aulPoints[(i + 1) % 3] == ulQ || rclFacet._aulPoints[(i + 2) % 3] == ulQ)
+            raulFacets.push_back(h / 3);
+    }
+}
+
+void MeshHalfEdgeIndex::LinkEdge (unsigned long ulP, unsigned long ulQ, MeshFacetArray &rclFacets) const
+{
+    std::vector<unsigned long> aulFacets;
+    GetEdgeFacets(ulP, ulQ, rclFacets, aulFacets);
+    if (aulFacets.size() == 2) {
+        MeshFacet& rclFacet0 = rclFacets[aulFacets[0]];
+        MeshFacet& rclFacet1 = rclFacets[aulFacets[1]];
+        rclFacet0._aulNeighbours[rclFacet0.Side(ulP, ulQ)] = aulFacets[1];
+        rclFacet1._aulNeighbours[rclFacet1.Side(ulP, ulQ)] = aulFacets[0];
+    }
+    else if (aulFacets.size() == 1) {
+        MeshFacet& rclFacet = rclFacets[aulFacets[0]];
+        rclFacet._aulNeighbours[rclFacet.Side(ulP, ulQ)] = ULONG_MAX;
+    }
+}
+
+void MeshHalfEdgeIndex::Unlink (unsigned long ulPoint, unsigned long ulHalfEdge)
+{
+    unsigned long* pulLink = &_aulFirst[ulPoint];
+    while (*pulLink != ulHalfEdge)
+        pulLink = &_aulNext[*pulLink];
+      *pulLink = _aulNext[ulHalfEdge];
+    _aulNext[ulHalfEdge] = ULONG_MAX;
+}
+
+void MeshHalfEdgeIndex::Relink (unsigned long ulPoint, unsigned long ulFrom, unsigned long ulTo)
+{
+    unsigned long* pulLink = &_aulFirst[ulPoint];
+    while (*pulLink != ulFrom)
+        pulLink = &_aulNext[*pulLink];
+      *pulLink = ulTo;
+    _aulNext[ulTo] = _aulNext[ulFrom];
+    _aulNext[ulFrom] = ULONG_MAX;
+}
@@ -0,0 +1,89 @@
+/***************************************************************************
+ *   Copyright (c) 2012 Imetric 3D GmbH                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef MESH_HALFEDGEINDEX_H
+#define MESH_HALFEDGEINDEX_H
+
+#include <vector>
+
+#include "Elements.h"
+
+namespace MeshCore {
+
+/**
+ * The MeshHalfEdgeIndex class lists for each point the half-edges starting
+ * at it. The half-edge \a i of a facet \a f goes from its i-th to its
+ * (i+1)-th corner point and has the number 3*f+i. The lists are singly
+ * linked through an array, hence facets and points can be added, removed and
+ * renumbered by only visiting the half-edges of the affected points. This
+ * allows to keep the neighbourhood of a large mesh up to date while it gets
+ * edited.
+ * @see MeshKernel::BeginEdit()
+ */
+class MeshExport MeshHalfEdgeIndex
+{
+public:
+    /// Construction
+    MeshHalfEdgeIndex (const MeshFacetArray &rclFacets, unsigned long ulCtPoints);
+    /// Destruction
+    ~MeshHalfEdgeIndex (void) { }
+
+    /** Sets the number of points, new points have no half-edges. */
+    void ResizePoints (unsigned long ulCtPoints);
+    /** Sets the number of facets, new facets have no half-edges. */
+    void ResizeFacets (unsigned long ulCtFacets);
+    /** Adds the half-edges of the facet \a ulFacet. */
+    void AddFacet (unsigned long ulFacet, const MeshFacet &rclFacet);
+    /** Removes the half-edges of the facet \a ulFacet. */
+    void RemoveFacet (unsigned long ulFacet, const MeshFacet &rclFacet);
+    /** Moves the facet \a ulFrom to the removed facet \a ulTo. The index and the
+     * neighbour indices of the neighbour facets are adjusted.
+     */
+    void MoveFacet (unsigned long ulFrom, unsigned long ulTo, MeshFacetArray &rclFacets);
+    /** Moves the point \a ulFrom to the point \a ulTo that has no half-edges. The
+     * point indices of the facets are adjusted.
+     */
+    void MovePoint (unsigned long ulFrom, unsigned long ulTo, MeshPointArray &rclPoints, MeshFacetArray &rclFacets);
+    /** Returns true if at least one facet references the point \a ulPoint. */
+    bool IsReferenced (unsigned long ulPoint) const
+    { return _aulFirst[ulPoint] != ULONG_MAX; }
+    /** Returns the facets having the edge (\a ulP, \a ulQ) in either direction. */
+    void GetEdgeFacets (unsigned long ulP, unsigned long ulQ, const MeshFacetArray &rclFacets,
+                        std::vector<unsigned long> &raulFacets) const;
+    /** Sets the neighbour indices of the facets sharing the edge (\a ulP, \a ulQ).
+     * As RebuildNeighbours() does non-manifold edges are ignored.
+     */
+    void LinkEdge (unsigned long ulP, unsigned long ulQ, MeshFacetArray &rclFacets) const;
+
+private:
+    void Unlink (unsigned long ulPoint, unsigned long ulHalfEdge);
+    void Relink (unsigned long ulPoint, unsigned long ulFrom, unsigned long ulTo);
+
+private:
+    std::vector<unsigned long> _aulFirst; /**< First half-edge of each point. */
+    std::vector<unsigned long> _aulNext;  /**< Next half-edge with the same start point. */
+};
+
+} // namespace MeshCore
+
+#endif // MESH_HALFEDGEINDEX_H
@@ -0,0 +1,288 @@
+/***************************************************************************
+ *   Copyright (c) 2012 Imetric 3D GmbH                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <algorithm>
+# include <cmath>
+#endif
+
+#include "LevelOfDetail.h"
+#include "MeshKernel.h"
+
+using namespace MeshCore;
+
+namespace MeshCore {
+
+/** A point and the grid cell it lies in. */
+struct LevelOfDetailCell
+{
+  int i, j, k;
+  unsigned long ulPoint;
+
+  bool operator < (const LevelOfDetailCell &rclC) const
+  {
+    if (i != rclC.i) return i < rclC.i;
+    if (j != rclC.j) return j < rclC.j;
+    return k < rclC.k;
+  }
+};
+
+/** A facet whose smallest point index comes first, so that equal facets with the same orientation compare equal. */
+struct LevelOfDetailFacet
+{
+  unsigned long p[3];
+
+  bool operator < (const LevelOfDetailFacet &rclF) const
+  {
+    if (p[0] != rclF.p[0]) return p[0] < rclF.p[0];
+    if (p[1] != rclF.p[1]) return p[1] < rclF.p[1];
+    return p[2] < rclF.p[2];
+  }
+  bool operator == (const LevelOfDetailFacet &rclF) const
+  {
+    return p[0] == rclF.p[0] && p[1] == rclF.p[1] && p[2] == rclF.p[2];
+  }
+};
+
+} // namespace MeshCore
+
+MeshLevelOfDetail::MeshLevelOfDetail (void)
+  : _ulMinFacets(1000), _bCancel(false)
+{
+}
+
+MeshLevelOfDetail::~MeshLevelOfDetail (void)
+{
+}
+
+void MeshLevelOfDetail::SetMesh (const MeshKernel &rclMesh)
+{
+  const MeshPointArray &rclPAry = rclMesh.GetPoints();
+  const MeshFacetArray &rclFAry = rclMesh.GetFacets();
+
+  _clMesh.aclPoints.assign(rclPAry.begin(), rclPAry.end());
+  _clMesh.aulIndices.resize(3 * rclFAry.size());
+  std::vector<unsigned long>::iterator pI = _clMesh.aulIndices.begin();
+  for (MeshFacetArray::_TConstIterator it = rclFAry.begin(); it != rclFAry.end(); ++it) {
+    *pI++ = it->_aulPoints[0];
+    *pI++ = it->_aulPoints[1];
+    *pI++ = it->_aulPoints[2];
+  }
+  _clMesh.fError = 0.0f;
+}
+
+void MeshLevelOfDetail::Clear (void)
+{
+  _aclLevels.clear();
+}
+
+void MeshLevelOfDetail::Build (void)
+{
+  _aclLevels.clear();
+
+  // each original point represents itself
+  Clusters clData;
+  clData.aulWeights.resize(_clMesh.aclPoints.size(), 1);
+  clData.afErrors.resize(_clMesh.aclPoints.size(), 0.0f);
+
+  Base::BoundBox3f clBox;
+  for (std::vector<Base::Vector3f>::const_iterator it = _clMesh.aclPoints.begin(); it != _clMesh.aclPoints.end(); ++it)
+    clBox &= *it;
+
+  float fCellSize = 2.0f * AverageEdgeLength(_clMesh);
+  float fMaxCellSize = clBox.CalcDiagonalLength();
+
+  // the levels are kept in a vector, so make sure it won't copy them
+  _aclLevels.reserve(32);
+  const Level* pclFine = &_clMesh;
+  while (!_bCancel && pclFine->CountFacets() > _ulMinFacets && fCellSize > 0.0f && fCellSize < fMaxCellSize &&
+         _aclLevels.size() < _aclLevels.capacity()) {
+    Level clCoarse;
+    Clusters clCoarseData;
+    Simplify(*pclFine, clData, fCellSize, clCoarse, clCoarseData);
+    if (_bCancel)
+      break;
+    fCellSize *= 2.0f;
+
+    // if only a few facets disappear try again with larger cells
+    if (10 * clCoarse.CountFacets() > 9 * pclFine->CountFacets())
+      continue;
+
+    _aclLevels.push_back(Level());
+    Level &rclLevel = _aclLevels.back();
+    rclLevel.aclPoints.swap(clCoarse.aclPoints);
+    rclLevel.aulIndices.swap(clCoarse.aulIndices);
+    rclLevel.fError = clCoarse.fError;
+    clData.aulWeights.swap(clCoarseData.aulWeights);
+    clData.afErrors.swap(clCoarseData.afErrors);
+    pclFine = &rclLevel;
+  }
+
+  // a canceled hierarchy may be incomplete
+  if (_bCancel)
+    _aclLevels.clear();
+
+  // release the copy of the mesh
+  Level clEmpty;
+  _clMesh.aclPoints.swap(clEmpty.aclPoints);
+  _clMesh.aulIndices.swap(clEmpty.aulIndices);
+}
+
+int MeshLevelOfDetail::FindLevel (float fMaxError) const
+{
+  // the errors grow with the level
+  int iLevel = -1;
+  for (unsigned long i = 0; i < _aclLevels.size(); i++) {
+    if (_aclLevels[i].fError > fMaxError)
+      break;
+    iLevel = (int)i;
+  }
+  return iLevel;
+}
+
+void MeshLevelOfDetail::Simplify (const Level &rclFine, const Clusters &rclFineData, float fCellSize,
+                                  Level &rclCoarse, Clusters &rclCoarseData) const
+{
+  const std::vector<Base::Vector3f> &rclPoints = rclFine.aclPoints;
+  unsigned long ulCtPoints = rclPoints.size();
+
+  // sort the points by their cells
+  Base::BoundBox3f clBox;
+  for (std::vector<Base::Vector3f>::const_iterator it = rclPoints.begin(); it != rclPoints.end(); ++it)
+    clBox &= *it;
+
+  std::vector<LevelOfDetailCell> aclCells(ulCtPoints);
+  for (unsigned long i = 0; i < ulCtPoints; i++) {
+    const Base::Vector3f &rclP = rclPoints[i];
+    LevelOfDetailCell &rclC = aclCells[i];
+    rclC.i = (int)((rclP.x - clBox.MinX) / fCellSize);
+    rclC.j = (int)((rclP.y - clBox.MinY) / fCellSize);
+    rclC.k = (int)((rclP.z - clBox.MinZ) / fCellSize);
+    rclC.ulPoint = i;
+  }
+  std::sort(aclCells.begin(), aclCells.end());
+  if (_bCancel)
+    return;
+
+  // replace the points of each cell by their weighted average
+  std::vector<unsigned long> aulCluster(ulCtPoints);
+  rclCoarse.aclPoints.clear();
+  rclCoarseData.aulWeights.clear();
+  rclCoarseData.afErrors.clear();
+  rclCoarse.fError = 0.0f;
+  std::vector<LevelOfDetailCell>::iterator pB = aclCells.begin();
+  while (pB != aclCells.end()) {
+    std::vector<LevelOfDetailCell>::iterator pE = pB + 1;
+    while (pE != aclCells.end() && !(*pB < *pE))
+      ++pE;
+
+    unsigned long ulCluster = rclCoarse.aclPoints.size();
+    unsigned long ulWeight = 0;
+    double dSum[3] = { 0.0, 0.0, 0.0 };
+    for (std::vector<LevelOfDetailCell>::iterator it = pB; it != pE; ++it) {
+      unsigned long w = rclFineData.aulWeights[it->ulPoint];
+      const Base::Vector3f &rclP = rclPoints[it->ulPoint];
+      dSum[0] += (double)w * rclP.x;
+      dSum[1] += (double)w * rclP.y;
+      dSum[2] += (double)w * rclP.z;
+      ulWeight += w;
+      aulCluster[it->ulPoint] = ulCluster;
+    }
+    Base::Vector3f clCenter((float)(dSum[0] / ulWeight), (float)(dSum[1] / ulWeight), (float)(dSum[2] / ulWeight));
+
+    // an original point is at most the error of its fine point away from it
+    float fError = 0.0f;
+    for (std::vector<LevelOfDetailCell>::iterator it = pB; it != pE; ++it) {
+      float fDist = rclFineData.afErrors[it->ulPoint] + Base::Distance(rclPoints[it->ulPoint], clCenter);
+      fError = std::max<float>(fError, fDist);
+    }
+
+    rclCoarse.aclPoints.push_back(clCenter);
+    rclCoarseData.aulWeights.push_back(ulWeight);
+    rclCoarseData.afErrors.push_back(fError);
+    rclCoarse.fError = std::max<float>(rclCoarse.fError, fError);
+    pB = pE;
+  }
+  if (_bCancel)
+    return;
+
+  // map the facets, remove the degenerated ones and the duplicates
+  std::vector<LevelOfDetailFacet> aclFacets;
+  aclFacets.reserve(rclFine.CountFacets());
+  const std::vector<unsigned long> &raulIndices = rclFine.aulIndices;
+  for (unsigned long i = 0; i < raulIndices.size(); i += 3) {
+    unsigned long p0 = aulCluster[raulIndices[i]];
+    unsigned long p1 = aulCluster[raulIndices[i+1]];
+    unsigned long p2 = aulCluster[raulIndices[i+2]];
+    if (p0 == p1 || p1 == p2 || p2 == p0)
+      continue;
+
+    // keep the orientation
+    LevelOfDetailFacet clF;
+    if (p0 < p1 && p0 < p2) {
+      clF.p[0] = p0; clF.p[1] = p1; clF.p[2] = p2;
+    }
+    else if (p1 < p2) {
+      clF.p[0] = p1; clF.p[1] = p2; clF.p[2] = p0;
+    }
+    else {
+      clF.p[0] = p2; clF.p[1] = p0; clF.p[2] = p1;
+    }
+    aclFacets.push_back(clF);
+  }
+  std::sort(aclFacets.begin(), aclFacets.end());
+  aclFacets.erase(std::unique(aclFacets.begin(), aclFacets.end()), aclFacets.end());
+
+  rclCoarse.aulIndices.resize(3 * aclFacets.size());
+  std::vector<unsigned long>::iterator pI = rclCoarse.aulIndices.begin();
+  for (std::vector<LevelOfDetailFacet>::iterator it = aclFacets.begin(); it != aclFacets.end(); ++it) {
+    *pI++ = it->p[0];
+    *pI++ = it->p[1];
+    *pI++ = it->p[2];
+  }
+}
+
+float MeshLevelOfDetail::AverageEdgeLength (const Level &rclLevel)
+{
+  const std::vector<unsigned long> &raulIndices = rclLevel.aulIndices;
+  const std::vector<Base::Vector3f> &rclPoints = rclLevel.aclPoints;
+  if (raulIndices.empty())
+    return 0.0f;
+
+  // a sample of the facets is sufficient
+  unsigned long ulCtFacets = raulIndices.size() / 3;
+  unsigned long ulStep = std::max<unsigned long>(ulCtFacets / 10000, 1);
+  double dSum = 0.0;
+  unsigned long ulCount = 0;
+  for (unsigned long i = 0; i < ulCtFacets; i += ulStep) {
+    const Base::Vector3f &p0 = rclPoints[raulIndices[3*i]];
+    const Base::Vector3f &p1 = rclPoints[raulIndices[3*i+1]];
+    const Base::Vector3f &p2 = rclPoints[raulIndices[3*i+2]];
+    dSum += Base::Distance(p0, p1) + Base::Distance(p1, p2) + Base::Distance(p2, p0);
+    ulCount += 3;
+  }
+  return (float)(dSum / ulCount);
+}
@@ -0,0 +1,133 @@
+/***************************************************************************
+ *   Copyright (c) 2012 Imetric 3D GmbH                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#ifndef MESH_LEVELOFDETAIL_H
+#define MESH_LEVELOFDETAIL_H
+
+#include <vector>
+
+#include <Base/Vector3D.h>
+
+namespace MeshCore {
+
+class MeshKernel;
+
+/**
+ * The MeshLevelOfDetail class builds a hierarchy of simplified versions of a
+ * mesh that can be rendered instead of the mesh when it is so far away that
+ * the difference is hardly visible.
+ *
+ * The levels are computed by vertex clustering: the points are sorted into the
+ * cells of a regular grid and all points of a cell are replaced by their
+ * average. Facets whose points end up in less than three different cells
+ * disappear, as well as facets that become duplicates. The first level uses
+ * cells with twice the average edge length of the mesh, each further level is
+ * computed from the previous one with cells of twice the size. This is done
+ * until the number of facets falls below a given minimum.
+ *
+ * Each level knows an upper bound for the distance of an original point to
+ * the point representing it, so a viewer can pick the coarsest level whose
+ * error projected to the screen is below a pixel threshold.
+ *
+ * The hierarchy is built from a copy of the points and facets made by
+ * SetMesh(), so Build() can run in a worker thread while the mesh is
+ * modified or destroyed. Another thread can stop the build with Cancel().
+ */
+class MeshExport MeshLevelOfDetail
+{
+public:
+  /** A simplified mesh. */
+  struct Level
+  {
+    std::vector<Base::Vector3f> aclPoints; /**< The points. */
+    std::vector<unsigned long> aulIndices; /**< Three point indices per facet. */
+    float fError;                          /**< Maximum distance of an original point to its representative. */
+
+    /** Returns the number of facets. */
+    unsigned long CountFacets (void) const
+    { return aulIndices.size() / 3; }
+  };
+
+  /// Construction
+  MeshLevelOfDetail (void);
+  /// Destruction
+  ~MeshLevelOfDetail (void);
+
+  /** Sets the minimum number of facets of the coarsest level. The default is 1000. */
+  void SetMinimumFacets (unsigned long ulCtFacets)
+  { _ulMinFacets = ulCtFacets; }
+  /** Copies the points and facets of \a rclMesh. */
+  void SetMesh (const MeshKernel &rclMesh);
+  /** Builds the hierarchy from the mesh set by SetMesh() and releases the copy. */
+  void Build (void);
+  /** Removes all levels. */
+  void Clear (void);
+  /**
+   * Makes a running or future call of Build() return as soon as possible
+   * without any levels. This may be called from another thread.
+   */
+  void Cancel (void)
+  { _bCancel = true; }
+  /** Returns true if Cancel() was called. */
+  bool IsCanceled (void) const
+  { return _bCancel; }
+
+  /** Returns the number of levels. */
+  unsigned long CountLevels (void) const
+  { return _aclLevels.size(); }
+  /** Returns the level \a ulLevel where level 0 is the finest one. */
+  const Level& GetLevel (unsigned long ulLevel) const
+  { return _aclLevels[ulLevel]; }
+  /**
+   * Returns the coarsest level whose error doesn't exceed \a fMaxError or -1
+   * if there is none, i.e. the original mesh must be used.
+   */
+  int FindLevel (float fMaxError) const;
+
+protected:
+  /** The points of a level with the data of the clusters they represent. */
+  struct Clusters
+  {
+    std::vector<unsigned long> aulWeights; /**< Number of original points. */
+    std::vector<float> afErrors;           /**< Maximum distance of an original point. */
+  };
+
+  /**
+   * Computes the level \a rclCoarse from \a rclFine using cells of size \a fCellSize.
+   */
+  void Simplify (const Level &rclFine, const Clusters &rclFineData, float fCellSize,
+                 Level &rclCoarse, Clusters &rclCoarseData) const;
+  /** Returns the average edge length of the level \a rclLevel. */
+  static float AverageEdgeLength (const Level &rclLevel);
+
+private:
+  unsigned long _ulMinFacets;
+  Level _clMesh;                   /**< The copy of the mesh. */
+  std::vector<Level> _aclLevels;
+  volatile bool _bCancel;
+};
+
+} // namespace MeshCore
+
+#endif // MESH_LEVELOFDETAIL_H
@@ -36,6 +36,8 @@
 #include <Base/FileInfo.h>
 #include <Base/Sequencer.h>
 #include <Base/Stream.h>
+#include <Base/Swap.h>
+#include <Base/TimeInfo.h>
 #include <zipios++/gzipoutputstream.h>
 
 #include <math.h>
@@ -44,6 +46,12 @@
 #include <boost/regex.hpp>
 #include <boost/algorithm/string.hpp>
 
+#include <QFile>
+#include <QFuture>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+
 
 using namespace MeshCore;
 
@@ -308,6 +316,22 @@ bool MeshInput::LoadAny(const char* FileName)
     if (!fi.isReadable())
         throw Base::FileException("No permission on the file",FileName);
 
+    if (fi.hasExtension("bms")) {
+        // A file in the current binary format can be read directly from
+        // the memory mapped file. So, only the pages get loaded instead of
+        // parsing the whole file.
+        QFile file(QString::fromUtf8(fi.filePath().c_str()));
+        if (file.open(QIODevice::ReadOnly)) {
+            uchar* data = file.map(0, file.size());
+            if (data) {
+                bool ok = _rclMesh.Read((const char*)data, (std::size_t)file.size());
+                file.unmap(data);
+                if (ok)
+                    return true;
+            }
+        }
+    }
+
     Base::ifstream str(fi, std::ios::in | std::ios::binary);
 
     if (fi.hasExtension("bms")) {
@@ -345,15 +369,23 @@ bool MeshInput::LoadAny(const char* FileName)
     }
 }
 
-/** Loads an STL file either in binary or ASCII format. 
- * Therefore the file header gets checked to decide if the file is binary or not.
+namespace MeshCore {
+enum STLType {
+    STL_INVALID,
+    STL_EMPTY,
+    STL_BINARY,
+    STL_ASCII
+};
+
+/** Checks the file header to decide if the STL file is binary or not and
+ * rewinds the stream.
  */
-bool MeshInput::LoadSTL (std::istream &rstrIn)
+static STLType GetSTLType (std::istream &rstrIn)
 {
     char szBuf[200];
 
     if (!rstrIn || rstrIn.bad() == true)
-        return false;
+        return STL_INVALID;
 
     // Read in 50 characters from position 80 on and check for keywords like 'SOLID', 'FACET', 'NORMAL',
     // 'VERTEX', 'ENDFACET' or 'ENDLOOP'.
@@ -361,7 +393,7 @@ bool MeshInput::LoadSTL (std::istream &rstrIn)
     // the file size has only 134 bytes in this case. On the other hand we must overread the first 80 bytes
     // because it can happen that the file is binary but contains one of these keywords.
     std::streambuf* buf = rstrIn.rdbuf();
-    if (!buf) return false;
+    if (!buf) return STL_INVALID;
     buf->pubseekoff(80, std::ios::beg, std::ios::in);
     uint32_t ulCt, ulBytes=50;
     rstrIn.read((char*)&ulCt, sizeof(ulCt));
@@ -370,22 +402,81 @@ bool MeshInput::LoadSTL (std::istream &rstrIn)
         ulBytes = 100;
     // Either it's really an invalid STL file or it's just empty. In this case the number of facets must be 0.
     if (!rstrIn.read(szBuf, ulBytes))
-        return (ulCt==0);
+        return (ulCt==0) ? STL_EMPTY : STL_INVALID;
     szBuf[ulBytes] = 0;
     upper(szBuf);
 
+    buf->pubseekoff(0, std::ios::beg, std::ios::in);
+    if ((strstr(szBuf, "SOLID") == NULL)  && (strstr(szBuf, "FACET") == NULL)    && (strstr(szBuf, "NORMAL") == NULL) &&
+        (strstr(szBuf, "VERTEX") == NULL) && (strstr(szBuf, "ENDFACET") == NULL) && (strstr(szBuf, "ENDLOOP") == NULL)) {
+        // probably binary STL
+        return STL_BINARY;
+    }
+    else {
+        // Ascii STL
+        return STL_ASCII;
+    }
+}
+
+/** Helper class to parse the lines of an ASCII STL file. */
+class MeshSTLLineParser
+{
+public:
+    enum Token {
+        NONE,
+        NORMAL,
+        VERTEX
+    };
+
+    MeshSTLLineParser()
+      : rx_p("^\\s*VERTEX\\s+([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)"
+             "\\s+([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)"
+             "\\s+([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)\\s*$")
+      , rx_f("^\\s*FACET\\s+NORMAL\\s+([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)"
+             "\\s+([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)"
+             "\\s+([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)\\s*$")
+    {
+    }
+    /** Converts \a line to upper case and returns the vector of a normal or vertex line. */
+    Token parse(std::string& line, Base::Vector3f& vec)
+    {
+        for (std::string::iterator it = line.begin(); it != line.end(); ++it)
+            *it = toupper(*it);
+        Token token;
+        if (boost::regex_match(line.c_str(), what, rx_f))
+            token = NORMAL;
+        else if (boost::regex_match(line.c_str(), what, rx_p))
+            token = VERTEX;
+        else
+            return NONE;
+        vec.x = (float)std::atof(what[1].first);
+        vec.y = (float)std::atof(what[4].first);
+        vec.z = (float)std::atof(what[7].first);
+        return token;
+    }
+
+private:
+    boost::regex rx_p, rx_f;
+    boost::cmatch what;
+};
+}
+
+/** Loads an STL file either in binary or ASCII format. 
+ * Therefore the file header gets checked to decide if the file is binary or not.
+ */
+bool MeshInput::LoadSTL (std::istream &rstrIn)
+{
+    STLType type = GetSTLType(rstrIn);
+    if (type == STL_INVALID)
+        return false;
+    if (type == STL_EMPTY)
+        return true;
+
     try {
-        if ((strstr(szBuf, "SOLID") == NULL)  && (strstr(szBuf, "FACET") == NULL)    && (strstr(szBuf, "NORMAL") == NULL) &&
-            (strstr(szBuf, "VERTEX") == NULL) && (strstr(szBuf, "ENDFACET") == NULL) && (strstr(szBuf, "ENDLOOP") == NULL)) {
-            // probably binary STL
-            buf->pubseekoff(0, std::ios::beg, std::ios::in);
+        if (type == STL_BINARY)
             return LoadBinarySTL(rstrIn);
-        }
-        else {
-            // Ascii STL
-            buf->pubseekoff(0, std::ios::beg, std::ios::in);
+        else
             return LoadAsciiSTL(rstrIn);
-        }
     }
     catch (const Base::MemoryException&) {
         _rclMesh.Clear();
@@ -639,6 +730,44 @@ bool MeshInput::LoadOFF (std::istream &rstrIn)
     return true;
 }
 
+namespace MeshCore {
+/** Helper class to read a binary stream in chunks of a fixed size. */
+class MeshChunkReader
+{
+public:
+    MeshChunkReader(std::istream& in, std::size_t size)
+        : _in(in), _buffer(size), _pos(0), _end(0)
+    {
+    }
+    bool read(char* dst, std::size_t len)
+    {
+        while (len > 0) {
+            if (_pos == _end && !refill())
+                return false;
+            std::size_t num = std::min<std::size_t>(len, _end - _pos);
+            memcpy(dst, &(_buffer[_pos]), num);
+            _pos += num;
+            dst += num;
+            len -= num;
+        }
+        return true;
+    }
+
+private:
+    bool refill()
+    {
+        _in.read(&(_buffer[0]), _buffer.size());
+        _pos = 0;
+        _end = (std::size_t)_in.gcount();
+        return _end > 0;
+    }
+
+    std::istream& _in;
+    std::vector<char> _buffer;
+    std::size_t _pos, _end;
+};
+}
+
 bool MeshInput::LoadPLY (std::istream &inp)
 {
     // http://local.wasp.uwa.edu.au/~pbourke/dataformats/ply/
@@ -667,6 +796,7 @@ bool MeshInput::LoadPLY (std::istream &inp)
 
     std::string line, element;
     bool xyz_float=false,xyz_double=false;
+    int v_props=0;
     MeshIO::Binding rgb_value = MeshIO::OVERALL;
     while (std::getline(inp, line)) {
         std::istringstream str(line);
@@ -735,6 +865,7 @@ bool MeshInput::LoadPLY (std::istream &inp)
             std::string type, name;
             char space;
             if (element == "vertex") {
+                v_props++;
                 str >> space >> std::ws
                     >> type >> space >> std::ws >> name >> std::ws;
                 if (name == "x") {
@@ -817,6 +948,43 @@ bool MeshInput::LoadPLY (std::istream &inp)
             }
         }
     }
+    // binary with plain float coordinates, read in chunks
+    else if (xyz_float && v_props == 3 && rgb_value == MeshIO::OVERALL) {
+        MeshChunkReader reader(inp, MESH_IO_PLY_CHUNK_SIZE);
+        bool swap = (format == binary_big_endian) != (Base::SwapOrder() == HIGH_ENDIAN);
+        float xyz[3];
+        for (std::size_t i = 0; i < v_count; i++) {
+            if (!reader.read((char*)xyz, sizeof(xyz)))
+                return false;
+            if (swap) {
+                Base::SwapEndian(xyz[0]);
+                Base::SwapEndian(xyz[1]);
+                Base::SwapEndian(xyz[2]);
+            }
+            meshPoints.push_back(Base::Vector3f(xyz[0], xyz[1], xyz[2]));
+        }
+        unsigned char n;
+        int32_t f[3], skip;
+        for (std::size_t i = 0; i < f_count; i++) {
+            if (!reader.read((char*)&n, sizeof(n)))
+                return false;
+            if (n==3) {
+                if (!reader.read((char*)f, sizeof(f)))
+                    return false;
+                if (swap) {
+                    Base::SwapEndian(f[0]);
+                    Base::SwapEndian(f[1]);
+                    Base::SwapEndian(f[2]);
+                }
+                meshFacets.push_back(MeshFacet(f[0],f[1],f[2]));
+            }
+            else {
+                // only triangles are supported, skip other polygons
+                for (unsigned char j = 0; j < n; j++)
+                    reader.read((char*)&skip, sizeof(skip));
+            }
+        }
+    }
     // binary
     else {
         Base::InputStream is(inp);
@@ -869,11 +1037,30 @@ bool MeshInput::LoadPLY (std::istream &inp)
     }
 
     this->_rclMesh.Clear(); // remove all data before
-    // Don't use Assign() because Merge() checks which points are really needed.
-    // This method sets already the correct neighbourhood
-    MeshKernel tmp;
-    tmp.Adopt(meshPoints,meshFacets);
-    this->_rclMesh.Merge(tmp);
+    if (rgb_value == MeshIO::PER_VERTEX) {
+        // the colors belong to the points, so they must not be welded
+        // Don't use Assign() because Merge() checks which points are really needed.
+        // This method sets already the correct neighbourhood
+        MeshKernel tmp;
+        tmp.Adopt(meshPoints,meshFacets);
+        this->_rclMesh.Merge(tmp);
+    }
+    else {
+        // weld duplicated points as done for STL files
+        MeshFastBuilder builder(this->_rclMesh);
+        builder.Initialize(meshFacets.size());
+        Base::Vector3f facetPoints[4];
+        unsigned long ctPoints = meshPoints.size();
+        for (MeshFacetArray::_TConstIterator it = meshFacets.begin(); it != meshFacets.end(); ++it) {
+            if (it->_aulPoints[0] >= ctPoints || it->_aulPoints[1] >= ctPoints || it->_aulPoints[2] >= ctPoints)
+                continue;
+            for (int i = 0; i < 3; i++)
+                facetPoints[i] = meshPoints[it->_aulPoints[i]];
+            facetPoints[3] = (facetPoints[1] - facetPoints[0]) % (facetPoints[2] - facetPoints[0]);
+            builder.AddFacet(facetPoints);
+        }
+        builder.Finish();
+    }
 
     return true;
 }
@@ -935,16 +1122,10 @@ bool MeshInput::LoadMeshNode (std::istream &rstrIn)
 /** Loads an ASCII STL file. */
 bool MeshInput::LoadAsciiSTL (std::istream &rstrIn)
 {
-    boost::regex rx_p("^\\s*VERTEX\\s+([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)"
-                      "\\s+([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)"
-                      "\\s+([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)\\s*$");
-    boost::regex rx_f("^\\s*FACET\\s+NORMAL\\s+([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)"
-                      "\\s+([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)"
-                      "\\s+([-+]?[0-9]*)\\.?([0-9]+([eE][-+]?[0-9]+)?)\\s*$");
-    boost::cmatch what;
+    MeshSTLLineParser parser;
+    Base::Vector3f clVec;
 
     std::string line;
-    float fX, fY, fZ;
     unsigned long ulVertexCt, ulFacetCt=0;
     MeshGeomFacet clFacet;
 
@@ -978,19 +1159,12 @@ bool MeshInput::LoadAsciiSTL (std::istream &rstrIn)
 
     ulVertexCt = 0;
     while (std::getline(rstrIn, line)) {
-        for (std::string::iterator it = line.begin(); it != line.end(); ++it)
-            *it = toupper(*it);
-        if (boost::regex_match(line.c_str(), what, rx_f)) {
-            fX = (float)std::atof(what[1].first);
-            fY = (float)std::atof(what[4].first);
-            fZ = (float)std::atof(what[7].first);
-            clFacet.SetNormal(Base::Vector3f(fX, fY, fZ));
+        MeshSTLLineParser::Token token = parser.parse(line, clVec);
+        if (token == MeshSTLLineParser::NORMAL) {
+            clFacet.SetNormal(clVec);
         }
-        else if (boost::regex_match(line.c_str(), what, rx_p)) {
-            fX = (float)std::atof(what[1].first);
-            fY = (float)std::atof(what[4].first);
-            fZ = (float)std::atof(what[7].first);
-            clFacet._aclPoints[ulVertexCt++].Set(fX, fY, fZ);
+        else if (token == MeshSTLLineParser::VERTEX) {
+            clFacet._aclPoints[ulVertexCt++] = clVec;
             if (ulVertexCt == 3) {
                 ulVertexCt = 0;
                 builder.AddFacet(clFacet);
@@ -1037,22 +1211,50 @@ bool MeshInput::LoadBinarySTL (std::istream &rstrIn)
     // compare the calculated with the read value
     if (ulCt > ulFac)
         return false;// not a valid STL file
- 
-    MeshBuilder builder(this->_rclMesh);
+
+    // Each record consists of the normal, the three points and 2 bytes
+    // attribute. The records are read in chunks of a fixed size so that
+    // even huge files need only a small buffer.
+    float afRecord[12];
+    const uint32_t ulRecord = sizeof(afRecord) + sizeof(usAtt);
+    const uint32_t ulChunk = MESH_IO_STL_CHUNK_SIZE;
+    std::vector<char> chunk(ulChunk * ulRecord);
+
+    MeshFastBuilder builder(this->_rclMesh);
     builder.Initialize(ulCt);
 
-    for (uint32_t i = 0; i < ulCt; i++) {
-        // read normal, points
-        rstrIn.read((char*)&clVects, sizeof(clVects));
+    Base::SequencerLauncher seq("Loading STL...", (ulCt + ulChunk - 1) / ulChunk + 1);
+    Base::TimeInfo start;
+    char szText[100];
 
-        std::swap(clVects[0], clVects[3]);
-        builder.AddFacet(clVects);
+    for (uint32_t i = 0; i < ulCt; i += ulChunk) {
+        uint32_t ulRead = std::min<uint32_t>(ulChunk, ulCt - i);
+        if (!rstrIn.read(&(chunk[0]), ulRead * ulRecord)) {
+            this->_rclMesh.Clear();
+            return false;
+        }
 
-        // overread 2 bytes attribute
-        rstrIn.read((char*)&usAtt, sizeof(usAtt));
+        const char* pRecord = &(chunk[0]);
+        for (uint32_t j = 0; j < ulRead; j++, pRecord += ulRecord) {
+            // read normal, points
+            memcpy(afRecord, pRecord, sizeof(afRecord));
+            for (int k = 0; k < 4; k++)
+                clVects[(k + 3) % 4].Set(afRecord[3*k], afRecord[3*k+1], afRecord[3*k+2]);
+            builder.AddFacet(clVects);
+        }
+
+        // show the throughput
+        float fSec = Base::TimeInfo::diffTimeF(start);
+        if (fSec > 0.0f) {
+            float fMB = float(i + ulRead) * float(ulRecord) / (1024.0f * 1024.0f);
+            sprintf(szText, "Loading STL (%.1f MB/s)...", fMB / fSec);
+            seq.setText(szText);
+        }
+        seq.next(true); // allow to cancel
     }
 
     builder.Finish();
+    seq.next();
 
     return true;
 }
@@ -1375,6 +1577,189 @@ bool MeshInput::LoadCadmouldFE (std::ifstream &rstrIn)
 
 // --------------------------------------------------------------
 
+namespace MeshCore {
+/**
+ * Helper class to format numbers into a text buffer. The output is the same as
+ * with the stream operators and a precision of 6 but it doesn't depend on the
+ * locale and is much faster. Floats are scaled by a power of ten, which is exact
+ * in double precision for the common range of values, and then printed as
+ * integers. Other values are passed to sprintf.
+ */
+class MeshTextWriter
+{
+public:
+    MeshTextWriter(std::string& str) : _str(str)
+    {
+    }
+    void text(const char* s)
+    {
+        _str.append(s);
+    }
+    void space()
+    {
+        _str.push_back(' ');
+    }
+    void newline()
+    {
+        _str.push_back('\n');
+    }
+    /** Appends \a value like printf("%lu"). */
+    void number(unsigned long value)
+    {
+        char buf[24];
+        char* end = buf + sizeof(buf);
+        char* pos = end;
+        do {
+            *--pos = char('0' + value % 10);
+            value /= 10;
+        }
+        while (value > 0);
+        _str.append(pos, end);
+    }
+    /** Appends \a value like printf("%.6f"). */
+    void fixed(float value)
+    {
+        double scaled = fabs((double)value) * 1.0e6;
+        if (!(scaled < 1.0e15)) { // also NaN
+            sprintf(_buf, "%.6f", value);
+            _str.append(_buf);
+            return;
+        }
+
+        double digits = round(scaled);
+        double ip = floor(digits / 1.0e6);
+        unsigned long fp = (unsigned long)(digits - ip * 1.0e6);
+        if (negative(value))
+            _str.push_back('-');
+        number((unsigned long)ip);
+        _str.push_back('.');
+        char buf[6];
+        for (int i = 5; i >= 0; i--) {
+            buf[i] = char('0' + fp % 10);
+            fp /= 10;
+        }
+        _str.append(buf, 6);
+    }
+    /** Appends \a value like printf("%.6g"). */
+    void general(float value)
+    {
+        static const double pow10[] = {1.0e0, 1.0e1, 1.0e2, 1.0e3, 1.0e4, 1.0e5,
+                                       1.0e6, 1.0e7, 1.0e8, 1.0e9, 1.0e10};
+        double absval = fabs((double)value);
+        if (absval == 0.0) {
+            _str.append(negative(value) ? "-0" : "0");
+            return;
+        }
+        // values which are printed in exponential notation, NaN or infinity
+        if (!(absval >= 1.0e-4 && absval < 999999.5)) {
+            sprintf(_buf, "%g", value);
+            _str.append(_buf);
+            return;
+        }
+
+        // find the exponent so that the value is rounded to six significant digits
+        int exp = (int)floor(log10(absval));
+        exp = std::max<int>(-4, std::min<int>(5, exp));
+        double digits = round(absval * pow10[5 - exp]);
+        if (digits >= 1.0e6 && exp < 5) {
+            exp++;
+            digits = round(absval * pow10[5 - exp]);
+        }
+        else if (digits < 1.0e5 && exp > -4) {
+            exp--;
+            digits = round(absval * pow10[5 - exp]);
+        }
+
+        // the six digits, the decimal point is after the digit with index 'exp'
+        char buf[6];
+        unsigned long ds = (unsigned long)digits;
+        for (int i = 5; i >= 0; i--) {
+            buf[i] = char('0' + ds % 10);
+            ds /= 10;
+        }
+        int len = 6;
+        while (len > 0 && len > exp + 1 && buf[len - 1] == '0')
+            len--;
+
+        if (negative(value))
+            _str.push_back('-');
+        if (exp >= 0) {
+            _str.append(buf, std::min<int>(len, exp + 1));
+            if (len > exp + 1) {
+                _str.push_back('.');
+                _str.append(buf + exp + 1, len - exp - 1);
+            }
+        }
+        else {
+            _str.append("0.");
+            _str.append(-exp - 1, '0');
+            _str.append(buf, len);
+        }
+    }
+
+private:
+    /** Rounds to the nearest integer and halfway cases to even as printf does. */
+    static double round(double value)
+    {
+        double r = floor(value);
+        double d = value - r;
+        if (d > 0.5 || (d == 0.5 && fmod(r, 2.0) != 0.0))
+            r += 1.0;
+        return r;
+    }
+    static bool negative(float value)
+    {
+        return value < 0.0f || (value == 0.0f && 1.0f / value < 0.0f);
+    }
+
+    std::string& _str;
+    char _buf[64];
+};
+
+/** Appends a facet in the format of an ASCII STL file. */
+static void FormatAsciiSTLFacet (MeshTextWriter& clText, const MeshGeomFacet& rclFacet)
+{
+    // normal
+    Base::Vector3f clNormal = rclFacet.GetNormal();
+    clText.text("  facet normal ");
+    clText.fixed(clNormal.x); clText.space();
+    clText.fixed(clNormal.y); clText.space();
+    clText.fixed(clNormal.z); clText.newline();
+    clText.text("    outer loop\n");
+
+    // vertices
+    for (int i = 0; i < 3; i++) {
+        clText.text("      vertex ");
+        clText.fixed(rclFacet._aclPoints[i].x); clText.space();
+        clText.fixed(rclFacet._aclPoints[i].y); clText.space();
+        clText.fixed(rclFacet._aclPoints[i].z); clText.newline();
+    }
+
+    clText.text("    endloop\n");
+    clText.text("  endfacet\n");
+}
+
+#define STL_RECORD_SIZE 50 // Number of bytes of a facet in a binary STL file
+
+/** Writes the record of a binary STL file to \a pRecord, i.e. the normal, the three points and 2 bytes attribute. */
+static void FormatBinarySTLFacet (char* pRecord, const MeshGeomFacet& rclFacet)
+{
+    float afRecord[12];
+    const uint16_t usAtt = 0;
+    Base::Vector3f clNormal = rclFacet.GetNormal();
+    afRecord[0] = clNormal.x;
+    afRecord[1] = clNormal.y;
+    afRecord[2] = clNormal.z;
+    for (int i = 0; i < 3; i++) {
+        afRecord[3*i+3] = rclFacet._aclPoints[i].x;
+        afRecord[3*i+4] = rclFacet._aclPoints[i].y;
+        afRecord[3*i+5] = rclFacet._aclPoints[i].z;
+    }
+    memcpy(pRecord, afRecord, sizeof(afRecord));
+    memcpy(pRecord + sizeof(afRecord), &usAtt, sizeof(usAtt));
+}
+}
+
 std::string MeshOutput::stl_header = "MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-"
                                      "MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH\n";
 
@@ -1536,45 +1921,12 @@ bool MeshOutput::SaveAny(const char* FileName, MeshIO::Format format) const
 /** Saves the mesh object into an ASCII file. */
 bool MeshOutput::SaveAsciiSTL (std::ostream &rstrOut) const
 {
-    MeshFacetIterator clIter(_rclMesh), clEnd(_rclMesh);
-    clIter.Transform(this->_transform);
-    const MeshGeomFacet *pclFacet;
-    unsigned long i;
-
     if (!rstrOut || rstrOut.bad() == true || _rclMesh.CountFacets() == 0)
         return false;
 
-    rstrOut.precision(6);
-    rstrOut.setf(std::ios::fixed | std::ios::showpoint);
-    Base::SequencerLauncher seq("saving...", _rclMesh.CountFacets() + 1);
-
     rstrOut << "solid Mesh" << std::endl;
-
-    clIter.Begin();
-    clEnd.End();
-    while (clIter < clEnd) {
-        pclFacet = &(*clIter);
-      
-        // normal
-        rstrOut << "  facet normal " << pclFacet->GetNormal().x << " " 
-                                     << pclFacet->GetNormal().y << " "
-                                     << pclFacet->GetNormal().z << std::endl;
-        rstrOut << "    outer loop" << std::endl;
-
-        // vertices
-        for (i = 0; i < 3; i++) {
-            rstrOut << "      vertex "  << pclFacet->_aclPoints[i].x << " "
-                                        << pclFacet->_aclPoints[i].y << " "
-                                        << pclFacet->_aclPoints[i].z << std::endl;
-        }
-
-        rstrOut << "    endloop" << std::endl;
-        rstrOut << "  endfacet" << std::endl;
-
-        ++clIter; 
-        seq.next(true);// allow to cancel
-    }
-
+    if (!WriteRanges(rstrOut, _rclMesh.CountFacets(), &MeshOutput::FormatAsciiSTL))
+        return false;
     rstrOut << "endsolid Mesh" << std::endl;
  
     return true;
@@ -1583,140 +1935,54 @@ bool MeshOutput::SaveAsciiSTL (std::ostream &rstrOut) const
 /** Saves the mesh object into a binary file. */
 bool MeshOutput::SaveBinarySTL (std::ostream &rstrOut) const
 {
-    MeshFacetIterator clIter(_rclMesh), clEnd(_rclMesh);
-    clIter.Transform(this->_transform);
-    const MeshGeomFacet *pclFacet;
-    uint32_t i;
-    uint16_t usAtt;
     char szInfo[81];
 
     if (!rstrOut || rstrOut.bad() == true /*|| _rclMesh.CountFacets() == 0*/)
         return false;
 
-    Base::SequencerLauncher seq("saving...", _rclMesh.CountFacets() + 1);  
- 
     strcpy(szInfo, stl_header.c_str());
     rstrOut.write(szInfo, std::strlen(szInfo));
 
     uint32_t uCtFts = (uint32_t)_rclMesh.CountFacets();
     rstrOut.write((const char*)&uCtFts, sizeof(uCtFts));
 
-    usAtt = 0;
-    clIter.Begin();
-    clEnd.End();
-    while (clIter < clEnd) {
-        pclFacet = &(*clIter);
-        // normal
-        Base::Vector3f normal = pclFacet->GetNormal();
-        rstrOut.write((const char*)&(normal.x), sizeof(float));
-        rstrOut.write((const char*)&(normal.y), sizeof(float));
-        rstrOut.write((const char*)&(normal.z), sizeof(float));
-
-        // vertices
-        for (i = 0; i < 3; i++) {
-            rstrOut.write((const char*)&(pclFacet->_aclPoints[i].x), sizeof(float));
-            rstrOut.write((const char*)&(pclFacet->_aclPoints[i].y), sizeof(float));
-            rstrOut.write((const char*)&(pclFacet->_aclPoints[i].z), sizeof(float));
-        }
-
-        // attribute 
-        rstrOut.write((const char*)&usAtt, sizeof(usAtt));
-
-        ++clIter;
-        seq.next(true); // allow to cancel
-    }
-
-    return true;
+    return WriteRanges(rstrOut, _rclMesh.CountFacets(), &MeshOutput::FormatBinarySTL);
 }
 
 /** Saves an OBJ file. */
 bool MeshOutput::SaveOBJ (std::ostream &rstrOut) const
 {
-    const MeshPointArray& rPoints = _rclMesh.GetPoints();
-    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
-
     if (!rstrOut || rstrOut.bad() == true)
         return false;
 
-    Base::SequencerLauncher seq("saving...", _rclMesh.CountPoints() + _rclMesh.CountFacets());  
-
-    // vertices
-    if (this->apply_transform) {
-        Base::Vector3f pt;
-        for (MeshPointArray::_TConstIterator it = rPoints.begin(); it != rPoints.end(); ++it) {
-            pt = this->_transform * *it;
-            rstrOut << "v " << pt.x << " " << pt.y << " " << pt.z << std::endl;
-            seq.next(true); // allow to cancel
-        }
-    }
-    else {
-        for (MeshPointArray::_TConstIterator it = rPoints.begin(); it != rPoints.end(); ++it) {
-            rstrOut << "v " << it->x << " " << it->y << " " << it->z << std::endl;
-            seq.next(true); // allow to cancel
-        }
-    }
-    // facet indices (no texture and normal indices)
-    for (MeshFacetArray::_TConstIterator it = rFacets.begin(); it != rFacets.end(); ++it) {
-        rstrOut << "f " << it->_aulPoints[0]+1 << " "
-                        << it->_aulPoints[1]+1 << " "
-                        << it->_aulPoints[2]+1 << std::endl;
-        seq.next(true); // allow to cancel
-    }
-
-    return true;
+    // vertices and facet indices (no texture and normal indices)
+    if (!WriteRanges(rstrOut, _rclMesh.CountPoints(), &MeshOutput::FormatPointsOBJ))
+        return false;
+    return WriteRanges(rstrOut, _rclMesh.CountFacets(), &MeshOutput::FormatFacetsOBJ);
 }
 
 /** Saves an OFF file. */
 bool MeshOutput::SaveOFF (std::ostream &out) const
 {
-    const MeshPointArray& rPoints = _rclMesh.GetPoints();
-    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
-
     if (!out || out.bad() == true)
         return false;
 
-    Base::SequencerLauncher seq("saving...", _rclMesh.CountPoints() + _rclMesh.CountFacets());  
-
     out << "OFF" << std::endl;
-    out << rPoints.size() << " " << rFacets.size() << " 0" << std::endl;
+    out << _rclMesh.CountPoints() << " " << _rclMesh.CountFacets() << " 0" << std::endl;
 
-    // vertices
-    if (this->apply_transform) {
-        Base::Vector3f pt;
-        for (MeshPointArray::_TConstIterator it = rPoints.begin(); it != rPoints.end(); ++it) {
-            pt = this->_transform * *it;
-            out << pt.x << " " << pt.y << " " << pt.z << std::endl;
-            seq.next(true); // allow to cancel
-        }
-    }
-    else {
-        for (MeshPointArray::_TConstIterator it = rPoints.begin(); it != rPoints.end(); ++it) {
-            out << it->x << " " << it->y << " " << it->z << std::endl;
-            seq.next(true); // allow to cancel
-        }
-    }
-
-    // facet indices (no texture and normal indices)
-    for (MeshFacetArray::_TConstIterator it = rFacets.begin(); it != rFacets.end(); ++it) {
-        out << "3 " << it->_aulPoints[0] 
-            << " " << it->_aulPoints[1]
-            << " " << it->_aulPoints[2] << std::endl;
-        seq.next(true); // allow to cancel
-    }
-
-    return true;
+    // vertices and facet indices (no texture and normal indices)
+    if (!WriteRanges(out, _rclMesh.CountPoints(), &MeshOutput::FormatPointsOFF))
+        return false;
+    return WriteRanges(out, _rclMesh.CountFacets(), &MeshOutput::FormatFacetsOFF);
 }
 
 bool MeshOutput::SaveBinaryPLY (std::ostream &out) const
 {
-    const MeshPointArray& rPoints = _rclMesh.GetPoints();
-    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
-    std::size_t v_count = rPoints.size();
-    std::size_t f_count = rFacets.size();
+    std::size_t v_count = _rclMesh.CountPoints();
+    std::size_t f_count = _rclMesh.CountFacets();
     if (!out || out.bad() == true)
         return false;
-    bool saveVertexColor = (_material && _material->binding == MeshIO::PER_VERTEX
-        && _material->diffuseColor.size() == rPoints.size());
+    bool saveVertexColor = HasVertexColors();
     out << "ply" << std::endl
         << "format binary_little_endian 1.0" << std::endl
         << "comment Created by FreeCAD <http://www.freecadweb.org>" << std::endl
@@ -1733,51 +1999,19 @@ bool MeshOutput::SaveBinaryPLY (std::ostream &out) const
         << "property list uchar int vertex_index" << std::endl
         << "end_header" << std::endl;
 
-    Base::OutputStream os(out);
-    os.setByteOrder(Base::Stream::LittleEndian);
-    Base::Vector3f pt;
-    for (std::size_t i = 0; i < v_count; i++) {
-        const MeshPoint& p = rPoints[i];
-        if (this->apply_transform) {
-            Base::Vector3f pt = this->_transform * p;
-            os << pt.x << pt.y << pt.z;
-        }
-        else {
-            os << p.x << p.y << p.z;
-        }
-        if (saveVertexColor) {
-            const App::Color& c = _material->diffuseColor[i];
-            int r = (int)(255.0f * c.r);
-            int g = (int)(255.0f * c.g);
-            int b = (int)(255.0f * c.b);
-            os << r << g << b;
-        }
-    }
-    unsigned char n = 3;
-    int f1, f2, f3;
-    for (std::size_t i = 0; i < f_count; i++) {
-        const MeshFacet& f = rFacets[i];
-        f1 = (int)f._aulPoints[0];
-        f2 = (int)f._aulPoints[1];
-        f3 = (int)f._aulPoints[2];
-        os << n;
-        os << f1 << f2 << f3;
-    }
-
-    return true;
+    if (!WriteRanges(out, v_count, &MeshOutput::FormatPointsBinaryPLY))
+        return false;
+    return WriteRanges(out, f_count, &MeshOutput::FormatFacetsBinaryPLY);
 }
 
 bool MeshOutput::SaveAsciiPLY (std::ostream &out) const
 {
-    const MeshPointArray& rPoints = _rclMesh.GetPoints();
-    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
-    std::size_t v_count = rPoints.size();
-    std::size_t f_count = rFacets.size();
+    std::size_t v_count = _rclMesh.CountPoints();
+    std::size_t f_count = _rclMesh.CountFacets();
     if (!out || out.bad() == true)
         return false;
 
-    bool saveVertexColor = (_material && _material->binding == MeshIO::PER_VERTEX
-        && _material->diffuseColor.size() == rPoints.size());
+    bool saveVertexColor = HasVertexColors();
     out << "ply" << std::endl
         << "format ascii 1.0" << std::endl
         << "comment Created by FreeCAD <http://www.freecadweb.org>" << std::endl
@@ -1794,52 +2028,217 @@ bool MeshOutput::SaveAsciiPLY (std::ostream &out) const
         << "property list uchar int vertex_index" << std::endl
         << "end_header" << std::endl;
 
-    Base::Vector3f pt;
+    if (!WriteRanges(out, v_count, &MeshOutput::FormatPointsAsciiPLY))
+        return false;
+    return WriteRanges(out, f_count, &MeshOutput::FormatFacetsOFF);
+}
 
-    out.precision(6);
-    out.setf(std::ios::fixed | std::ios::showpoint);
-    if (saveVertexColor) {
-        for (std::size_t i = 0; i < v_count; i++) {
-            const MeshPoint& p = rPoints[i];
-            if (this->apply_transform) {
-                Base::Vector3f pt = this->_transform * p;
-                out << pt.x << " " << pt.y << " " << pt.z;
-            }
-            else {
-                out << p.x << " " << p.y << " " << p.z;
-            }
+bool MeshOutput::WriteRanges (std::ostream &rstrOut, unsigned long ulCount, RangeFormatter pFormat) const
+{
+    // use more ranges than threads to balance the work load
+    int iThreads = QThread::idealThreadCount();
+    unsigned long ulRanges = 1;
+    if (ulCount >= MESH_CT_PARALLEL_WRITE && iThreads > 1)
+        ulRanges = 4 * iThreads;
+
+    const unsigned long ulRangeSize = MESH_IO_WRITE_RANGE_SIZE;
+    const unsigned long ulBlockSize = ulRanges * ulRangeSize;
+    std::vector<OutputRange> aclRanges(ulRanges);
+
+    Base::SequencerLauncher seq("Saving...", (ulCount + ulBlockSize - 1) / ulBlockSize + 1);
+    Base::TimeInfo start;
+    float fMB = 0.0f;
+    char szText[100];
+
+    for (unsigned long ulBlock = 0; ulBlock < ulCount; ulBlock += ulBlockSize) {
+        std::vector<OutputRange>::iterator it, end = aclRanges.begin();
+        for (unsigned long ul = ulBlock; ul < ulCount && ul < ulBlock + ulBlockSize; ul += ulRangeSize, ++end) {
+            end->ulBegin = ul;
+            end->ulEnd = std::min<unsigned long>(ul + ulRangeSize, ulCount);
+            end->clBuffer.clear();
+        }
+
+        if (ulRanges > 1) {
+            QFuture<void> future = QtConcurrent::map(aclRanges.begin(), end, boost::bind(pFormat, this, _1));
+            future.waitForFinished();
+        }
+        else {
+            (this->*pFormat)(aclRanges.front());
+        }
+
+        // write the buffers in order
+        for (it = aclRanges.begin(); it != end; ++it) {
+            rstrOut.write(it->clBuffer.data(), it->clBuffer.size());
+            fMB += float(it->clBuffer.size()) / (1024.0f * 1024.0f);
+        }
+        if (!rstrOut)
+            return false;
 
-            const App::Color& c = _material->diffuseColor[i];
-            int r = (int)(255.0f * c.r);
-            int g = (int)(255.0f * c.g);
-            int b = (int)(255.0f * c.b);
-            out << " " << r << " " << g << " " << b << std::endl;
+        // show the throughput
+        float fSec = Base::TimeInfo::diffTimeF(start);
+        if (fSec > 0.0f) {
+            sprintf(szText, "Saving (%.1f MB/s)...", fMB / fSec);
+            seq.setText(szText);
         }
+        seq.next(true); // allow to cancel
     }
-    else {
-        for (std::size_t i = 0; i < v_count; i++) {
-            const MeshPoint& p = rPoints[i];
-            if (this->apply_transform) {
-                Base::Vector3f pt = this->_transform * p;
-                out << pt.x << " " << pt.y << " " << pt.z << std::endl;
-            }
-            else {
-                out << p.x << " " << p.y << " " << p.z << std::endl;
-            }
+
+    return true;
+}
+
+Base::Vector3f MeshOutput::GetPoint (unsigned long ulIndex) const
+{
+    const MeshPoint& p = _rclMesh.GetPoints()[ulIndex];
+    if (this->apply_transform)
+        return this->_transform * p;
+    return p;
+}
+
+bool MeshOutput::HasVertexColors (void) const
+{
+    return (_material && _material->binding == MeshIO::PER_VERTEX
+        && _material->diffuseColor.size() == _rclMesh.CountPoints());
+}
+
+void MeshOutput::FormatAsciiSTL (OutputRange &rclRange) const
+{
+    MeshFacetIterator clIter(_rclMesh);
+    clIter.Transform(this->_transform);
+    MeshTextWriter clText(rclRange.clBuffer);
+
+    for (unsigned long ul = rclRange.ulBegin; ul < rclRange.ulEnd; ul++) {
+        clIter.Set(ul);
+        FormatAsciiSTLFacet(clText, *clIter);
+    }
+}
+
+void MeshOutput::FormatBinarySTL (OutputRange &rclRange) const
+{
+    MeshFacetIterator clIter(_rclMesh);
+    clIter.Transform(this->_transform);
+
+    rclRange.clBuffer.resize((rclRange.ulEnd - rclRange.ulBegin) * STL_RECORD_SIZE);
+    char* pRecord = &(rclRange.clBuffer[0]);
+
+    for (unsigned long ul = rclRange.ulBegin; ul < rclRange.ulEnd; ul++, pRecord += STL_RECORD_SIZE) {
+        clIter.Set(ul);
+        FormatBinarySTLFacet(pRecord, *clIter);
+    }
+}
+
+void MeshOutput::FormatPointsOBJ (OutputRange &rclRange) const
+{
+    MeshTextWriter clText(rclRange.clBuffer);
+    for (unsigned long ul = rclRange.ulBegin; ul < rclRange.ulEnd; ul++) {
+        Base::Vector3f pt = GetPoint(ul);
+        clText.text("v ");
+        clText.general(pt.x); clText.space();
+        clText.general(pt.y); clText.space();
+        clText.general(pt.z); clText.newline();
+    }
+}
+
+void MeshOutput::FormatFacetsOBJ (OutputRange &rclRange) const
+{
+    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
+    MeshTextWriter clText(rclRange.clBuffer);
+    for (unsigned long ul = rclRange.ulBegin; ul < rclRange.ulEnd; ul++) {
+        const MeshFacet& rFacet = rFacets[ul];
+        clText.text("f ");
+        clText.number(rFacet._aulPoints[0]+1); clText.space();
+        clText.number(rFacet._aulPoints[1]+1); clText.space();
+        clText.number(rFacet._aulPoints[2]+1); clText.newline();
+    }
+}
+
+void MeshOutput::FormatPointsOFF (OutputRange &rclRange) const
+{
+    MeshTextWriter clText(rclRange.clBuffer);
+    for (unsigned long ul = rclRange.ulBegin; ul < rclRange.ulEnd; ul++) {
+        Base::Vector3f pt = GetPoint(ul);
+        clText.general(pt.x); clText.space();
+        clText.general(pt.y); clText.space();
+        clText.general(pt.z); clText.newline();
+    }
+}
+
+void MeshOutput::FormatFacetsOFF (OutputRange &rclRange) const
+{
+    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
+    MeshTextWriter clText(rclRange.clBuffer);
+    for (unsigned long ul = rclRange.ulBegin; ul < rclRange.ulEnd; ul++) {
+        const MeshFacet& rFacet = rFacets[ul];
+        clText.text("3 ");
+        clText.number(rFacet._aulPoints[0]); clText.space();
+        clText.number(rFacet._aulPoints[1]); clText.space();
+        clText.number(rFacet._aulPoints[2]); clText.newline();
+    }
+}
+
+void MeshOutput::FormatPointsAsciiPLY (OutputRange &rclRange) const
+{
+    bool saveVertexColor = HasVertexColors();
+    MeshTextWriter clText(rclRange.clBuffer);
+    for (unsigned long ul = rclRange.ulBegin; ul < rclRange.ulEnd; ul++) {
+        Base::Vector3f pt = GetPoint(ul);
+        clText.fixed(pt.x); clText.space();
+        clText.fixed(pt.y); clText.space();
+        clText.fixed(pt.z);
+        if (saveVertexColor) {
+            const App::Color& c = _material->diffuseColor[ul];
+            clText.space(); clText.number((unsigned long)(255.0f * c.r));
+            clText.space(); clText.number((unsigned long)(255.0f * c.g));
+            clText.space(); clText.number((unsigned long)(255.0f * c.b));
         }
+        clText.newline();
     }
+}
 
-    unsigned int n = 3;
-    int f1, f2, f3;
-    for (std::size_t i = 0; i < f_count; i++) {
-        const MeshFacet& f = rFacets[i];
-        f1 = (int)f._aulPoints[0];
-        f2 = (int)f._aulPoints[1];
-        f3 = (int)f._aulPoints[2];
-        out << n << " " << f1 << " " << f2 << " " << f3 << std::endl;
+void MeshOutput::FormatPointsBinaryPLY (OutputRange &rclRange) const
+{
+    bool saveVertexColor = HasVertexColors();
+    bool swap = (Base::SwapOrder() == HIGH_ENDIAN);
+    const std::size_t ulVertex = 3 * sizeof(float) + (saveVertexColor ? 3 : 0);
+    rclRange.clBuffer.resize((rclRange.ulEnd - rclRange.ulBegin) * ulVertex);
+    char* pVertex = &(rclRange.clBuffer[0]);
+
+    for (unsigned long ul = rclRange.ulBegin; ul < rclRange.ulEnd; ul++, pVertex += ulVertex) {
+        Base::Vector3f pt = GetPoint(ul);
+        float xyz[3] = { pt.x, pt.y, pt.z };
+        if (swap) {
+            Base::SwapEndian(xyz[0]);
+            Base::SwapEndian(xyz[1]);
+            Base::SwapEndian(xyz[2]);
+        }
+        memcpy(pVertex, xyz, sizeof(xyz));
+        if (saveVertexColor) {
+            const App::Color& c = _material->diffuseColor[ul];
+            pVertex[12] = (char)(unsigned char)(255.0f * c.r);
+            pVertex[13] = (char)(unsigned char)(255.0f * c.g);
+            pVertex[14] = (char)(unsigned char)(255.0f * c.b);
+        }
     }
+}
 
-    return true;
+void MeshOutput::FormatFacetsBinaryPLY (OutputRange &rclRange) const
+{
+    const MeshFacetArray& rFacets = _rclMesh.GetFacets();
+    bool swap = (Base::SwapOrder() == HIGH_ENDIAN);
+    const std::size_t ulFace = 1 + 3 * sizeof(int32_t);
+    rclRange.clBuffer.resize((rclRange.ulEnd - rclRange.ulBegin) * ulFace);
+    char* pFace = &(rclRange.clBuffer[0]);
+
+    for (unsigned long ul = rclRange.ulBegin; ul < rclRange.ulEnd; ul++, pFace += ulFace) {
+        const MeshFacet& rFacet = rFacets[ul];
+        int32_t f[3] = { (int32_t)rFacet._aulPoints[0], (int32_t)rFacet._aulPoints[1], (int32_t)rFacet._aulPoints[2] };
+        if (swap) {
+            Base::SwapEndian(f[0]);
+            Base::SwapEndian(f[1]);
+            Base::SwapEndian(f[2]);
+        }
+        pFace[0] = 3;
+        memcpy(pFace + 1, f, sizeof(f));
+    }
 }
 
 bool MeshOutput::SaveMeshNode (std::ostream &rstrOut)
@@ -2127,6 +2526,328 @@ bool MeshOutput::SavePython (std::ostream &str) const
 
 // --------------------------------------------------------------
 
+bool MeshFacetStage::Finish (void)
+{
+    return _pclNext ? _pclNext->Finish() : true;
+}
+
+void MeshTransformStage::AddFacet (const MeshGeomFacet& rclFacet)
+{
+    MeshGeomFacet clFacet(_clMat * rclFacet._aclPoints[0],
+                          _clMat * rclFacet._aclPoints[1],
+                          _clMat * rclFacet._aclPoints[2]);
+    Forward(clFacet);
+}
+
+void MeshBoundBoxStage::AddFacet (const MeshGeomFacet& rclFacet)
+{
+    if (_clBox.IsInBox(rclFacet.GetGravityPoint()) == _bInside)
+        Forward(rclFacet);
+}
+
+MeshNormalStage::MeshNormalStage (const Base::Vector3f& rclDir, float fAngle)
+  : _clDir(rclDir), _fCosAngle((float)cos(fAngle))
+{
+    _clDir.Normalize();
+}
+
+void MeshNormalStage::AddFacet (const MeshGeomFacet& rclFacet)
+{
+    Base::Vector3f clNormal = rclFacet.GetNormal();
+    clNormal.Normalize();
+    if (clNormal * _clDir >= _fCosAngle)
+        Forward(rclFacet);
+}
+
+bool MeshClusterStage::CellKey::operator < (const CellKey& rclKey) const
+{
+    if (x != rclKey.x)
+        return x < rclKey.x;
+    if (y != rclKey.y)
+        return y < rclKey.y;
+    return z < rclKey.z;
+}
+
+bool MeshClusterStage::Triangle::operator < (const Triangle& rclTria) const
+{
+    for (int i = 0; i < 3; i++) {
+        if (aulPoints[i] != rclTria.aulPoints[i])
+            return aulPoints[i] < rclTria.aulPoints[i];
+    }
+    return false;
+}
+
+unsigned long MeshClusterStage::GetCluster (const Base::Vector3f& rclPt)
+{
+    CellKey clKey;
+    clKey.x = (int)floor(rclPt.x / _fCellSize);
+    clKey.y = (int)floor(rclPt.y / _fCellSize);
+    clKey.z = (int)floor(rclPt.z / _fCellSize);
+
+    std::pair<std::map<CellKey, unsigned long>::iterator, bool> clIns =
+        _clCells.insert(std::make_pair(clKey, (unsigned long)_aclPoints.size()));
+    if (clIns.second)
+        _aclPoints.push_back(std::make_pair(Base::Vector3d(), 0));
+
+    std::pair<Base::Vector3d, unsigned long>& rclSum = _aclPoints[clIns.first->second];
+    rclSum.first += Base::Vector3d(rclPt.x, rclPt.y, rclPt.z);
+    rclSum.second++;
+    return clIns.first->second;
+}
+
+void MeshClusterStage::AddFacet (const MeshGeomFacet& rclFacet)
+{
+    Triangle clTria;
+    for (int i = 0; i < 3; i++)
+        clTria.aulPoints[i] = GetCluster(rclFacet._aclPoints[i]);
+    if (clTria.aulPoints[0] == clTria.aulPoints[1] ||
+        clTria.aulPoints[1] == clTria.aulPoints[2] ||
+        clTria.aulPoints[2] == clTria.aulPoints[0])
+        return; // collapsed
+
+    // rotate the smallest index to the front to keep the orientation
+    while (clTria.aulPoints[0] > clTria.aulPoints[1] || clTria.aulPoints[0] > clTria.aulPoints[2]) {
+        unsigned long ulFirst = clTria.aulPoints[0];
+        clTria.aulPoints[0] = clTria.aulPoints[1];
+        clTria.aulPoints[1] = clTria.aulPoints[2];
+        clTria.aulPoints[2] = ulFirst;
+    }
+    _clTriangles.insert(clTria);
+}
+
+bool MeshClusterStage::Finish (void)
+{
+    // the representative of a cluster is the average of its points
+    std::vector<Base::Vector3f> aclPoints;
+    aclPoints.reserve(_aclPoints.size());
+    for (std::vector<std::pair<Base::Vector3d, unsigned long> >::iterator it = _aclPoints.begin(); it != _aclPoints.end(); ++it) {
+        Base::Vector3d clMean = it->first / (double)it->second;
+        aclPoints.push_back(Base::Vector3f((float)clMean.x, (float)clMean.y, (float)clMean.z));
+    }
+
+    for (std::set<Triangle>::iterator it = _clTriangles.begin(); it != _clTriangles.end(); ++it) {
+        MeshGeomFacet clFacet(aclPoints[it->aulPoints[0]],
+                              aclPoints[it->aulPoints[1]],
+                              aclPoints[it->aulPoints[2]]);
+        Forward(clFacet);
+    }
+
+    _ulClusters = _aclPoints.size();
+    _clCells.clear();
+    _clTriangles.clear();
+    std::vector<std::pair<Base::Vector3d, unsigned long> >().swap(_aclPoints);
+    return MeshFacetStage::Finish();
+}
+
+void MeshStatisticsStage::AddFacet (const MeshGeomFacet& rclFacet)
+{
+    _ulFacets++;
+    if (rclFacet.IsDegenerated())
+        _ulDegenerated++;
+    _dArea += rclFacet.Area();
+    for (int i = 0; i < 3; i++)
+        _clBox.Add(rclFacet._aclPoints[i]);
+    Forward(rclFacet);
+}
+
+MeshSTLWriterStage::MeshSTLWriterStage (std::ostream& rstrOut, bool bAscii)
+  : _rstrOut(rstrOut), _bAscii(bAscii), _ulFacets(0)
+{
+    _clBuffer.reserve(MESH_IO_STREAM_BUFFER_SIZE);
+    if (_bAscii) {
+        _rstrOut << "solid Mesh" << std::endl;
+    }
+    else {
+        // the number of facets is updated when finishing
+        const std::string& header = MeshOutput::GetSTLHeaderData();
+        _rstrOut.write(header.c_str(), header.size());
+        _ulCountPos = _rstrOut.tellp();
+        uint32_t uCtFts = 0;
+        _rstrOut.write((const char*)&uCtFts, sizeof(uCtFts));
+    }
+}
+
+void MeshSTLWriterStage::AddFacet (const MeshGeomFacet& rclFacet)
+{
+    if (_bAscii) {
+        MeshTextWriter clText(_clBuffer);
+        FormatAsciiSTLFacet(clText, rclFacet);
+    }
+    else {
+        std::size_t ulSize = _clBuffer.size();
+        _clBuffer.resize(ulSize + STL_RECORD_SIZE);
+        FormatBinarySTLFacet(&(_clBuffer[ulSize]), rclFacet);
+    }
+
+    _ulFacets++;
+    if (_clBuffer.size() >= MESH_IO_STREAM_BUFFER_SIZE)
+        Flush();
+    Forward(rclFacet);
+}
+
+void MeshSTLWriterStage::Flush (void)
+{
+    _rstrOut.write(_clBuffer.c_str(), _clBuffer.size());
+    _clBuffer.clear();
+}
+
+bool MeshSTLWriterStage::Finish (void)
+{
+    Flush();
+    if (_bAscii) {
+        _rstrOut << "endsolid Mesh" << std::endl;
+    }
+    else {
+        std::streampos ulEnd = _rstrOut.tellp();
+        uint32_t uCtFts = (uint32_t)_ulFacets;
+        _rstrOut.seekp(_ulCountPos);
+        _rstrOut.write((const char*)&uCtFts, sizeof(uCtFts));
+        _rstrOut.seekp(ulEnd);
+    }
+
+    bool ok = MeshFacetStage::Finish();
+    return ok && _rstrOut.good();
+}
+
+void MeshStreamPipeline::AddStage (MeshFacetStage* pclStage)
+{
+    if (!_aclStages.empty())
+        _aclStages.back()->SetNext(pclStage);
+    _aclStages.push_back(pclStage);
+}
+
+bool MeshStreamPipeline::Process (std::istream &rstrIn)
+{
+    _ulFacets = 0;
+    STLType type = GetSTLType(rstrIn);
+    if (type == STL_INVALID)
+        return false;
+
+    try {
+        bool ok = true;
+        if (type == STL_BINARY)
+            ok = ProcessBinary(rstrIn);
+        else if (type == STL_ASCII)
+            ok = ProcessAscii(rstrIn);
+        if (!ok)
+            return false;
+    }
+    catch (const Base::AbortException&) {
+        return false;
+    }
+
+    if (_aclStages.empty())
+        return true;
+    return _aclStages.front()->Finish();
+}
+
+bool MeshStreamPipeline::ProcessBinary (std::istream &rstrIn)
+{
+    char szInfo[80];
+    float afRecord[12];
+    uint32_t ulCt;
+
+    // skip the header and read the number of facets
+    rstrIn.read(szInfo, sizeof(szInfo));
+    rstrIn.read((char*)&ulCt, sizeof(ulCt));
+    if (rstrIn.bad() == true)
+        return false;
+
+    // compare the number of facets with the file size
+    std::streambuf* buf = rstrIn.rdbuf();
+    std::streamoff ulCurr = buf->pubseekoff(0, std::ios::cur, std::ios::in);
+    std::streamoff ulSize = buf->pubseekoff(0, std::ios::end, std::ios::in);
+    buf->pubseekoff(ulCurr, std::ios::beg, std::ios::in);
+    if ((std::streamoff)ulCt > (ulSize - ulCurr) / STL_RECORD_SIZE)
+        return false;
+
+    const uint32_t ulChunk = MESH_IO_STL_CHUNK_SIZE;
+    std::vector<char> chunk(ulChunk * STL_RECORD_SIZE);
+    MeshFacetStage* pclFirst = _aclStages.empty() ? 0 : _aclStages.front();
+
+    Base::SequencerLauncher seq("Processing STL...", (ulCt + ulChunk - 1) / ulChunk + 1);
+    Base::TimeInfo start;
+    char szText[100];
+
+    for (uint32_t i = 0; i < ulCt; i += ulChunk) {
+        uint32_t ulRead = std::min<uint32_t>(ulChunk, ulCt - i);
+        if (!rstrIn.read(&(chunk[0]), ulRead * STL_RECORD_SIZE))
+            return false;
+
+        const char* pRecord = &(chunk[0]);
+        for (uint32_t j = 0; j < ulRead; j++, pRecord += STL_RECORD_SIZE) {
+            // the normal is recomputed from the points
+            memcpy(afRecord, pRecord, sizeof(afRecord));
+            MeshGeomFacet clFacet(Base::Vector3f(afRecord[3], afRecord[4], afRecord[5]),
+                                  Base::Vector3f(afRecord[6], afRecord[7], afRecord[8]),
+                                  Base::Vector3f(afRecord[9], afRecord[10], afRecord[11]));
+            if (pclFirst)
+                pclFirst->AddFacet(clFacet);
+        }
+        _ulFacets += ulRead;
+
+        // show the throughput
+        float fSec = Base::TimeInfo::diffTimeF(start);
+        if (fSec > 0.0f) {
+            float fMB = float(i + ulRead) * float(STL_RECORD_SIZE) / (1024.0f * 1024.0f);
+            sprintf(szText, "Processing STL (%.1f MB/s)...", fMB / fSec);
+            seq.setText(szText);
+        }
+        seq.next(true); // allow to cancel
+    }
+
+    seq.next();
+    return true;
+}
+
+bool MeshStreamPipeline::ProcessAscii (std::istream &rstrIn)
+{
+    MeshSTLLineParser parser;
+    Base::Vector3f clVec;
+    MeshGeomFacet clFacet;
+    int iVertex = 0;
+    std::string line;
+    MeshFacetStage* pclFirst = _aclStages.empty() ? 0 : _aclStages.front();
+
+    // the progress is shown for each block of MESH_IO_STREAM_BUFFER_SIZE bytes
+    std::streambuf* buf = rstrIn.rdbuf();
+    std::streamoff ulSize = buf->pubseekoff(0, std::ios::end, std::ios::in);
+    buf->pubseekoff(0, std::ios::beg, std::ios::in);
+    Base::SequencerLauncher seq("Processing STL...", (std::size_t)(ulSize / MESH_IO_STREAM_BUFFER_SIZE) + 1);
+    Base::TimeInfo start;
+    char szText[100];
+    std::streamoff ulBytes = 0, ulNextStep = MESH_IO_STREAM_BUFFER_SIZE;
+
+    while (std::getline(rstrIn, line)) {
+        ulBytes += line.size() + 1;
+        if (parser.parse(line, clVec) == MeshSTLLineParser::VERTEX) {
+            clFacet._aclPoints[iVertex++] = clVec;
+            if (iVertex == 3) {
+                iVertex = 0;
+                clFacet.NormalInvalid();
+                if (pclFirst)
+                    pclFirst->AddFacet(clFacet);
+                _ulFacets++;
+            }
+        }
+
+        if (ulBytes >= ulNextStep) {
+            ulNextStep += MESH_IO_STREAM_BUFFER_SIZE;
+            float fSec = Base::TimeInfo::diffTimeF(start);
+            if (fSec > 0.0f) {
+                float fMB = float(ulBytes) / (1024.0f * 1024.0f);
+                sprintf(szText, "Processing STL (%.1f MB/s)...", fMB / fSec);
+                seq.setText(szText);
+            }
+            seq.next(true); // allow to cancel
+        }
+    }
+
+    return true;
+}
+
+// --------------------------------------------------------------
+
 class MeshVRML
 {
 public:
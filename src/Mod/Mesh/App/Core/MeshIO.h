@@ -25,6 +25,8 @@
 #define MESH_IO_H
 
 #include "MeshKernel.h"
+#include <map>
+#include <set>
 #include <Base/Vector3D.h>
 #include <Base/Matrix.h>
 #include <App/Material.h>
@@ -34,6 +36,12 @@ class XMLReader;
 class Writer;
 }
 
+#define MESH_IO_STL_CHUNK_SIZE 65536    // Number of facets of a binary STL file read at once
+#define MESH_IO_PLY_CHUNK_SIZE 4194304  // Number of bytes of a binary PLY file read at once
+#define MESH_IO_WRITE_RANGE_SIZE 16384  // Number of points or facets formatted into one buffer when saving
+#define MESH_CT_PARALLEL_WRITE 100000   // Minimum number of points or facets to format in parallel
+#define MESH_IO_STREAM_BUFFER_SIZE 1048576 // Number of bytes buffered by a streaming writer
+
 namespace MeshCore {
 
 class MeshKernel;
@@ -132,6 +140,9 @@ public:
      * automatically filled up with spaces.
      */
     static void SetSTLHeaderData(const std::string&);
+    /// Returns the 80 bytes header of binary STL files
+    static const std::string& GetSTLHeaderData()
+    { return stl_header; }
     /// Saves the file, decided by extension if not explicitly given
     bool SaveAny(const char* FileName, MeshIO::Format f=MeshIO::Undefined) const;
 
@@ -163,6 +174,36 @@ public:
     bool SavePython (std::ostream &rstrOut) const;
 
 protected:
+    /** A range of points or facets that is formatted into a buffer. */
+    struct OutputRange
+    {
+        unsigned long ulBegin, ulEnd;
+        std::string clBuffer;
+    };
+    typedef void (MeshOutput::*RangeFormatter)(OutputRange&) const;
+
+    /**
+     * Formats \a ulCount points or facets with \a pFormat and writes them to \a rstrOut.
+     * Blocks of several ranges are formatted on all cores and then written in order, so
+     * the memory needed for the buffers doesn't depend on the size of the mesh.
+     */
+    bool WriteRanges (std::ostream &rstrOut, unsigned long ulCount, RangeFormatter pFormat) const;
+    /** @name Formatters */
+    //@{
+    void FormatAsciiSTL (OutputRange &rclRange) const;
+    void FormatBinarySTL (OutputRange &rclRange) const;
+    void FormatPointsOBJ (OutputRange &rclRange) const;
+    void FormatFacetsOBJ (OutputRange &rclRange) const;
+    void FormatPointsOFF (OutputRange &rclRange) const;
+    /** Writes the facets as used by OFF and ASCII PLY files. */
+    void FormatFacetsOFF (OutputRange &rclRange) const;
+    void FormatPointsAsciiPLY (OutputRange &rclRange) const;
+    void FormatPointsBinaryPLY (OutputRange &rclRange) const;
+    void FormatFacetsBinaryPLY (OutputRange &rclRange) const;
+    //@}
+    Base::Vector3f GetPoint (unsigned long ulIndex) const;
+    bool HasVertexColors (void) const;
+
     const MeshKernel &_rclMesh;   /**< reference to mesh data structure */
     const Material* _material;
     Base::Matrix4D _transform;
@@ -170,6 +211,197 @@ protected:
     static std::string stl_header;
 };
 
+/**
+ * The MeshFacetStage class is the base class of the stages of a streaming
+ * pipeline. In contrast to MeshInput and MeshOutput a pipeline never builds a
+ * mesh kernel, the facets are read one after another and passed through a
+ * chain of stages. So, even huge files can be processed with a small amount
+ * of memory.
+ * @see MeshStreamPipeline
+ */
+class MeshExport MeshFacetStage
+{
+public:
+    MeshFacetStage (void) : _pclNext(0) {}
+    virtual ~MeshFacetStage (void) {}
+
+    /** Sets the stage the facets are passed to. */
+    void SetNext (MeshFacetStage* pclNext)
+    { _pclNext = pclNext; }
+    /** Processes a single facet. */
+    virtual void AddFacet (const MeshGeomFacet& rclFacet) = 0;
+    /**
+     * Is called after the last facet. Stages that hold back facets pass them
+     * on now. The default implementation notifies the next stage.
+     */
+    virtual bool Finish (void);
+
+protected:
+    /** Passes \a rclFacet to the next stage. */
+    void Forward (const MeshGeomFacet& rclFacet)
+    { if (_pclNext) _pclNext->AddFacet(rclFacet); }
+
+    MeshFacetStage* _pclNext;
+};
+
+/** Transforms the facets. */
+class MeshExport MeshTransformStage : public MeshFacetStage
+{
+public:
+    MeshTransformStage (const Base::Matrix4D& rclMat) : _clMat(rclMat) {}
+    void AddFacet (const MeshGeomFacet& rclFacet);
+
+private:
+    Base::Matrix4D _clMat;
+};
+
+/** Passes only the facets whose center of gravity lies inside (or outside) a box. */
+class MeshExport MeshBoundBoxStage : public MeshFacetStage
+{
+public:
+    MeshBoundBoxStage (const Base::BoundBox3f& rclBox, bool bInside = true)
+      : _clBox(rclBox), _bInside(bInside) {}
+    void AddFacet (const MeshGeomFacet& rclFacet);
+
+private:
+    Base::BoundBox3f _clBox;
+    bool _bInside;
+};
+
+/** Passes only the facets whose normal deviates at most \a fAngle (in radian) from a direction. */
+class MeshExport MeshNormalStage : public MeshFacetStage
+{
+public:
+    MeshNormalStage (const Base::Vector3f& rclDir, float fAngle);
+    void AddFacet (const MeshGeomFacet& rclFacet);
+
+private:
+    Base::Vector3f _clDir;
+    float _fCosAngle;
+};
+
+/**
+ * The MeshClusterStage class decimates the facets by vertex clustering. The
+ * space is divided into cubes of the given size and all points inside a cube
+ * are replaced by their average. Facets whose points fall into less than three
+ * different cubes vanish, and so do duplicates. Since the result is only known
+ * after the last facet this stage passes all facets in Finish(). The memory
+ * needed depends on the number of occupied cubes and thus only on the cube
+ * size and the extent of the surface, not on the number of input facets.
+ */
+class MeshExport MeshClusterStage : public MeshFacetStage
+{
+public:
+    MeshClusterStage (float fCellSize) : _fCellSize(fCellSize), _ulClusters(0) {}
+    void AddFacet (const MeshGeomFacet& rclFacet);
+    bool Finish (void);
+    /** Returns the number of occupied cubes of the last run. */
+    unsigned long CountClusters (void) const
+    { return _ulClusters; }
+
+protected:
+    struct CellKey
+    {
+        int x, y, z;
+        bool operator < (const CellKey& rclKey) const;
+    };
+    struct Triangle
+    {
+        unsigned long aulPoints[3];
+        bool operator < (const Triangle& rclTria) const;
+    };
+    unsigned long GetCluster (const Base::Vector3f& rclPt);
+
+private:
+    float _fCellSize;
+    unsigned long _ulClusters;
+    std::map<CellKey, unsigned long> _clCells;
+    std::vector<std::pair<Base::Vector3d, unsigned long> > _aclPoints; /**< Sum and count of the points of a cluster. */
+    std::set<Triangle> _clTriangles;
+};
+
+/** Collects some numbers of the facets passing, similar to MeshInfo. */
+class MeshExport MeshStatisticsStage : public MeshFacetStage
+{
+public:
+    MeshStatisticsStage (void) : _ulFacets(0), _ulDegenerated(0), _dArea(0.0) {}
+    void AddFacet (const MeshGeomFacet& rclFacet);
+
+    unsigned long CountFacets (void) const
+    { return _ulFacets; }
+    unsigned long CountDegenerated (void) const
+    { return _ulDegenerated; }
+    double GetArea (void) const
+    { return _dArea; }
+    const Base::BoundBox3f& GetBoundBox (void) const
+    { return _clBox; }
+
+private:
+    unsigned long _ulFacets, _ulDegenerated;
+    double _dArea;
+    Base::BoundBox3f _clBox;
+};
+
+/**
+ * Writes the facets to an ASCII or binary STL file. For binary files the
+ * number of facets is written into the header when finishing, hence the
+ * stream must be seekable.
+ */
+class MeshExport MeshSTLWriterStage : public MeshFacetStage
+{
+public:
+    MeshSTLWriterStage (std::ostream& rstrOut, bool bAscii = false);
+    void AddFacet (const MeshGeomFacet& rclFacet);
+    bool Finish (void);
+    unsigned long CountFacets (void) const
+    { return _ulFacets; }
+
+private:
+    void Flush (void);
+
+    std::ostream& _rstrOut;
+    bool _bAscii;
+    std::streampos _ulCountPos;
+    unsigned long _ulFacets;
+    std::string _clBuffer;
+};
+
+/**
+ * The MeshStreamPipeline class reads the facets of an ASCII or binary STL file
+ * and passes them through a chain of stages. Only one chunk of the file is held
+ * in memory at a time.
+ * \code
+ * MeshStreamPipeline pipe;
+ * MeshBoundBoxStage box(clBox);
+ * MeshSTLWriterStage writer(str);
+ * pipe.AddStage(&box);
+ * pipe.AddStage(&writer);
+ * pipe.Process(input);
+ * \endcode
+ * The pipeline doesn't take ownership of the stages.
+ */
+class MeshExport MeshStreamPipeline
+{
+public:
+    MeshStreamPipeline (void) : _ulFacets(0) {}
+
+    /** Appends \a pclStage to the chain. */
+    void AddStage (MeshFacetStage* pclStage);
+    /** Reads the STL file from \a rstrIn and passes the facets through the stages. */
+    bool Process (std::istream &rstrIn);
+    /** Returns the number of facets read by the last call of Process(). */
+    unsigned long CountFacets (void) const
+    { return _ulFacets; }
+
+protected:
+    bool ProcessAscii (std::istream &rstrIn);
+    bool ProcessBinary (std::istream &rstrIn);
+
+private:
+    std::vector<MeshFacetStage*> _aclStages;
+    unsigned long _ulFacets;
+};
+
 struct MeshExport VRMLViewpointData
 {
     Base::Vector3f clVRefPln;
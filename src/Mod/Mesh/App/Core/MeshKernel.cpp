@@ -35,6 +35,8 @@
 #include <Base/Stream.h>
 #include <Base/Swap.h>
 
+#include <QAtomicInt>
+
 #include "Algorithm.h"
 #include "Approximation.h"
 #include "Helpers.h"
@@ -42,17 +44,24 @@
 #include "Iterator.h"
 #include "Evaluation.h"
 #include "Builder.h"
+#include "HalfEdgeIndex.h"
 #include "Smoothing.h"
+#include "Simd.h"
 
 using namespace MeshCore;
 
+// the revisions are unique among all meshes
+static QAtomicInt MeshRevision(0);
+
 MeshKernel::MeshKernel (void)
-: _bValid(true)
+: _bValid(true), _pclHalfEdges(0), _ulRevision(0)
 {
     _clBoundBox.Flush();
+    Touch();
 }
 
 MeshKernel::MeshKernel (const MeshKernel &rclMesh)
+: _pclHalfEdges(0), _ulRevision(0)
 {
     *this = rclMesh;
 }
@@ -60,10 +69,12 @@ MeshKernel::MeshKernel (const MeshKernel &rclMesh)
 MeshKernel& MeshKernel::operator = (const MeshKernel &rclMesh)
 {
     if (this != &rclMesh) { // must be a different instance
+        EndEdit();
         this->_aclPointArray  = rclMesh._aclPointArray;
         this->_aclFacetArray  = rclMesh._aclFacetArray;
         this->_clBoundBox     = rclMesh._clBoundBox;
         this->_bValid         = rclMesh._bValid;
+        Touch();
     }
     return *this;
 }
@@ -83,6 +94,8 @@ MeshKernel& MeshKernel::operator = (const std::vector<MeshGeomFacet> &rclFAry)
 
 void MeshKernel::Assign(const MeshPointArray& rPoints, const MeshFacetArray& rFacets, bool checkNeighbourHood)
 {
+    Touch();
+    EndEdit();
     _aclPointArray = rPoints;
     _aclFacetArray = rFacets;
     RecalcBoundBox();
@@ -92,6 +105,8 @@ void MeshKernel::Assign(const MeshPointArray& rPoints, const MeshFacetArray& rFa
 
 void MeshKernel::Adopt(MeshPointArray& rPoints, MeshFacetArray& rFacets, bool checkNeighbourHood)
 {
+    Touch();
+    EndEdit();
     _aclPointArray.swap(rPoints);
     _aclFacetArray.swap(rFacets);
     RecalcBoundBox();
@@ -104,6 +119,26 @@ void MeshKernel::Swap(MeshKernel& mesh)
     this->_aclPointArray.swap(mesh._aclPointArray);
     this->_aclFacetArray.swap(mesh._aclFacetArray);
     this->_clBoundBox = mesh._clBoundBox;
+    std::swap(this->_pclHalfEdges, mesh._pclHalfEdges);
+    this->Touch();
+    mesh.Touch();
+}
+
+void MeshKernel::Touch (void)
+{
+    _ulRevision = (unsigned int)MeshRevision.fetchAndAddRelaxed(1) + 1;
+}
+
+void MeshKernel::BeginEdit (void)
+{
+    if (!_pclHalfEdges)
+        _pclHalfEdges = new MeshHalfEdgeIndex(_aclFacetArray, _aclPointArray.size());
+}
+
+void MeshKernel::EndEdit (void)
+{
+    delete _pclHalfEdges;
+    _pclHalfEdges = 0;
 }
 
 MeshKernel& MeshKernel::operator += (const MeshGeomFacet &rclSFacet)
@@ -114,6 +149,7 @@ MeshKernel& MeshKernel::operator += (const MeshGeomFacet &rclSFacet)
 
 void MeshKernel::AddFacet(const MeshGeomFacet &rclSFacet)
 {
+    Touch();
     unsigned long i;
     MeshFacet clFacet;
 
@@ -128,6 +164,15 @@ void MeshKernel::AddFacet(const MeshGeomFacet &rclSFacet)
 
     unsigned long ulCt = _aclFacetArray.size();
 
+    if (_pclHalfEdges) {
+        _aclFacetArray.push_back(clFacet);
+        _pclHalfEdges->ResizePoints(CountPoints());
+        _pclHalfEdges->AddFacet(ulCt, clFacet);
+        for (int i=0; i<3; i++)
+            _pclHalfEdges->LinkEdge(clFacet._aulPoints[i], clFacet._aulPoints[(i+1)%3], _aclFacetArray);
+        return;
+    }
+
     // set neighbourhood
     unsigned long ulP0 = clFacet._aulPoints[0];
     unsigned long ulP1 = clFacet._aulPoints[1];
@@ -164,6 +209,7 @@ MeshKernel& MeshKernel::operator += (const std::vector<MeshGeomFacet> &rclFAry)
 
 void MeshKernel::AddFacets(const std::vector<MeshGeomFacet> &rclFAry)
 {
+    Touch();
     // Create a temp. kernel to get the topology of the passed triangles
     // and merge them with this kernel. This keeps properties and flags 
     // of this mesh.
@@ -174,6 +220,10 @@ void MeshKernel::AddFacets(const std::vector<MeshGeomFacet> &rclFAry)
 
 unsigned long MeshKernel::AddFacets(const std::vector<MeshFacet> &rclFAry)
 {
+    Touch();
+    if (_pclHalfEdges)
+        return AddFacetsIndexed(rclFAry);
+
     // Build map of edges of the referencing facets we want to append
 #ifdef FC_DEBUG
     unsigned long countPoints = CountPoints();
@@ -315,6 +365,55 @@ unsigned long MeshKernel::AddFacets(const std::vector<MeshFacet> &rclFAry)
     return _aclFacetArray.size();
 }
 
+unsigned long MeshKernel::AddFacetsIndexed(const std::vector<MeshFacet> &rclFAry)
+{
+    _pclHalfEdges->ResizePoints(CountPoints());
+
+    // Count the facets of each edge of the candidates, those which would
+    // create non-manifolds are not inserted
+    std::map<std::pair<unsigned long, unsigned long>, unsigned long> edgeCount;
+    for (std::vector<MeshFacet>::const_iterator pF = rclFAry.begin(); pF != rclFAry.end(); ++pF) {
+        pF->ResetFlag(MeshFacet::INVALID);
+        for (int i=0; i<3; i++) {
+            unsigned long ulP0 = std::min<unsigned long>(pF->_aulPoints[i], pF->_aulPoints[(i+1)%3]);
+            unsigned long ulP1 = std::max<unsigned long>(pF->_aulPoints[i], pF->_aulPoints[(i+1)%3]);
+            edgeCount[std::make_pair(ulP0, ulP1)]++;
+        }
+    }
+
+    std::vector<unsigned long> edgeFacets;
+    std::map<std::pair<unsigned long, unsigned long>, unsigned long>::iterator pE;
+    for (pE = edgeCount.begin(); pE != edgeCount.end(); ++pE) {
+        _pclHalfEdges->GetEdgeFacets(pE->first.first, pE->first.second, _aclFacetArray, edgeFacets);
+        pE->second += edgeFacets.size();
+    }
+
+    for (std::vector<MeshFacet>::const_iterator pF = rclFAry.begin(); pF != rclFAry.end(); ++pF) {
+        for (int i=0; i<3; i++) {
+            unsigned long ulP0 = std::min<unsigned long>(pF->_aulPoints[i], pF->_aulPoints[(i+1)%3]);
+            unsigned long ulP1 = std::max<unsigned long>(pF->_aulPoints[i], pF->_aulPoints[(i+1)%3]);
+            if (edgeCount[std::make_pair(ulP0, ulP1)] > 2)
+                pF->SetFlag(MeshFacet::INVALID);
+        }
+    }
+
+    // append the facets and set the neighbourhood along their edges
+    unsigned long startIndex = CountFacets();
+    for (std::vector<MeshFacet>::const_iterator pF = rclFAry.begin(); pF != rclFAry.end(); ++pF) {
+        if (!pF->IsFlag(MeshFacet::INVALID)) {
+            _pclHalfEdges->AddFacet(_aclFacetArray.size(), *pF);
+            _aclFacetArray.push_back(*pF);
+        }
+    }
+    for (unsigned long k = startIndex; k < CountFacets(); k++) {
+        const MeshFacet& rclFacet = _aclFacetArray[k];
+        for (int i=0; i<3; i++)
+            _pclHalfEdges->LinkEdge(rclFacet._aulPoints[i], rclFacet._aulPoints[(i+1)%3], _aclFacetArray);
+    }
+
+    return _aclFacetArray.size();
+}
+
 unsigned long MeshKernel::AddFacets(const std::vector<MeshFacet> &rclFAry, const std::vector<Base::Vector3f>& rclPAry)
 {
     for (std::vector<Base::Vector3f>::const_iterator it = rclPAry.begin(); it != rclPAry.end(); ++it)
@@ -325,6 +424,7 @@ unsigned long MeshKernel::AddFacets(const std::vector<MeshFacet> &rclFAry, const
 
 void MeshKernel::Merge(const MeshKernel& rKernel)
 {
+    Touch();
     if (this != &rKernel) {
         const MeshPointArray& rPoints = rKernel._aclPointArray;
         const MeshFacetArray& rFacets  = rKernel._aclFacetArray;
@@ -334,6 +434,7 @@ void MeshKernel::Merge(const MeshKernel& rKernel)
 
 void MeshKernel::Merge(const MeshPointArray& rPoints, const MeshFacetArray& rFaces)
 {
+    Touch();
     if (rPoints.empty() || rFaces.empty())
         return; // nothing to do
     std::vector<unsigned long> increments(rPoints.size());
@@ -383,10 +484,18 @@ void MeshKernel::Merge(const MeshPointArray& rPoints, const MeshFacetArray& rFac
     // scratch. Fortunately, this needs only to be done for the newly inserted
     // facets -- not for all
     RebuildNeighbours(countFacets);
+
+    if (_pclHalfEdges) {
+        _pclHalfEdges->ResizePoints(CountPoints());
+        for (unsigned long i = countFacets; i < CountFacets(); i++)
+            _pclHalfEdges->AddFacet(i, _aclFacetArray[i]);
+    }
 }
 
 void MeshKernel::Clear (void)
 {
+    Touch();
+    EndEdit();
     _aclPointArray.clear();
     _aclFacetArray.clear();
 
@@ -399,6 +508,7 @@ void MeshKernel::Clear (void)
 
 bool MeshKernel::DeleteFacet (const MeshFacetIterator &rclIter)
 {
+    Touch();
     unsigned long i, j, ulNFacet, ulInd;
 
     if (rclIter._clIter >= _aclFacetArray.end())
@@ -407,6 +517,11 @@ bool MeshKernel::DeleteFacet (const MeshFacetIterator &rclIter)
     // index of the facet to delete
     ulInd = rclIter._clIter - _aclFacetArray.begin(); 
 
+    if (_pclHalfEdges) {
+        DeleteFacetsIndexed(std::vector<unsigned long>(1, ulInd));
+        return true;
+    }
+
     // invalidate neighbour indices of the neighbour facet to this facet
     for (i = 0; i < 3; i++) {
         ulNFacet = rclIter._clIter->_aulNeighbours[i];
@@ -448,6 +563,12 @@ bool MeshKernel::DeleteFacet (unsigned long ulInd)
 
 void MeshKernel::DeleteFacets (const std::vector<unsigned long> &raulFacets)
 {
+    Touch();
+    if (_pclHalfEdges) {
+        DeleteFacetsIndexed(raulFacets);
+        return;
+    }
+
     _aclPointArray.SetProperty(0);
 
     // number of referencing facets per point
@@ -478,6 +599,56 @@ void MeshKernel::DeleteFacets (const std::vector<unsigned long> &raulFacets)
     RecalcBoundBox();
 }
 
+void MeshKernel::DeleteFacetsIndexed (const std::vector<unsigned long> &raulFacets)
+{
+    std::vector<unsigned long> facets(raulFacets);
+    std::sort(facets.begin(), facets.end());
+    facets.erase(std::unique(facets.begin(), facets.end()), facets.end());
+
+    // remove the facets from the index and their neighbours
+    std::vector<unsigned long> points;
+    for (std::vector<unsigned long>::iterator it = facets.begin(); it != facets.end(); ++it) {
+        const MeshFacet& rclFacet = _aclFacetArray[*it];
+        _pclHalfEdges->RemoveFacet(*it, rclFacet);
+        for (int i=0; i<3; i++) {
+            unsigned long ulNFacet = rclFacet._aulNeighbours[i];
+            if (ulNFacet != ULONG_MAX)
+                _aclFacetArray[ulNFacet].ReplaceNeighbour(*it, ULONG_MAX);
+            points.push_back(rclFacet._aulPoints[i]);
+        }
+    }
+
+    // a non-manifold edge may become a regular edge now
+    for (std::vector<unsigned long>::iterator it = facets.begin(); it != facets.end(); ++it) {
+        const MeshFacet& rclFacet = _aclFacetArray[*it];
+        for (int i=0; i<3; i++)
+            _pclHalfEdges->LinkEdge(rclFacet._aulPoints[i], rclFacet._aulPoints[(i+1)%3], _aclFacetArray);
+    }
+
+    // fill the gaps with the last facets, start from the end so that the
+    // last facet is never one to be removed
+    for (std::vector<unsigned long>::reverse_iterator it = facets.rbegin(); it != facets.rend(); ++it) {
+        unsigned long ulLast = _aclFacetArray.size() - 1;
+        if (*it != ulLast)
+            _pclHalfEdges->MoveFacet(ulLast, *it, _aclFacetArray);
+        _aclFacetArray.pop_back();
+    }
+    _pclHalfEdges->ResizeFacets(_aclFacetArray.size());
+
+    // the same for the points that are no longer referenced
+    std::sort(points.begin(), points.end());
+    points.erase(std::unique(points.begin(), points.end()), points.end());
+    for (std::vector<unsigned long>::reverse_iterator it = points.rbegin(); it != points.rend(); ++it) {
+        if (_pclHalfEdges->IsReferenced(*it))
+            continue;
+        unsigned long ulLast = _aclPointArray.size() - 1;
+        if (*it != ulLast)
+            _pclHalfEdges->MovePoint(ulLast, *it, _aclPointArray, _aclFacetArray);
+        _aclPointArray.pop_back();
+    }
+    _pclHalfEdges->ResizePoints(_aclPointArray.size());
+}
+
 bool MeshKernel::DeletePoint (unsigned long ulInd)
 {
     if (ulInd >= _aclPointArray.size())
@@ -491,6 +662,7 @@ bool MeshKernel::DeletePoint (unsigned long ulInd)
 
 bool MeshKernel::DeletePoint (const MeshPointIterator &rclIter)
 {
+    Touch();
     MeshFacetIterator pFIter(*this), pFEnd(*this);
     std::vector<MeshFacetIterator>  clToDel; 
     unsigned long i, ulInd;
@@ -522,6 +694,7 @@ bool MeshKernel::DeletePoint (const MeshPointIterator &rclIter)
 
 void MeshKernel::DeletePoints (const std::vector<unsigned long> &raulPoints)
 {
+    Touch();
     _aclPointArray.ResetInvalid();
     for (std::vector<unsigned long>::const_iterator pI = raulPoints.begin(); pI != raulPoints.end(); pI++)
         _aclPointArray[*pI].SetInvalid();
@@ -602,6 +775,10 @@ void MeshKernel::ErasePoint (unsigned long ulIndex, unsigned long ulFacetIndex,
 
 void MeshKernel::RemoveInvalids ()
 {
+    Touch();
+    // all indices change
+    EndEdit();
+
     std::vector<unsigned long> aulDecrements;
     std::vector<unsigned long>::iterator pDIter;
     unsigned long ulDec, i, k;
@@ -756,6 +933,92 @@ MeshFacetArray MeshKernel::GetFacets(const std::vector<unsigned long>& indices)
     return ary;
 }
 
+namespace MeshCore {
+
+#define MESH_BINARY_MAGIC       0xA0B0C0D0
+#define MESH_BINARY_VERSION_1   0x010000
+#define MESH_BINARY_VERSION_2   0x020000
+#define MESH_BINARY_ALIGNMENT   64      // Alignment of the header and the arrays in bytes
+#define MESH_BINARY_CHUNK_SIZE  65536   // Number of elements converted at once
+
+/**
+ * Header of the binary format of version 2. It's followed by the points
+ * as 3 floats and the facets as 3 point and 3 neighbour indices of 32 bit.
+ * The header and both arrays are padded to a multiple of
+ * MESH_BINARY_ALIGNMENT bytes, so the arrays of a memory mapped file are
+ * properly aligned. The data is written in the byte order of the machine
+ * and gets swapped when read on a machine with different byte order.
+ */
+struct MeshBinaryHeader
+{
+    uint32_t magic, version;
+    uint32_t countPoints, countFacets;
+    float boundBox[6];
+    uint32_t reserved[6];
+
+    void swap()
+    {
+        Base::SwapEndian(magic);
+        Base::SwapEndian(version);
+        Base::SwapEndian(countPoints);
+        Base::SwapEndian(countFacets);
+        for (int i=0; i<6; i++)
+            Base::SwapEndian(boundBox[i]);
+    }
+};
+
+static inline std::size_t PaddedSize(std::size_t size)
+{
+    return (size + MESH_BINARY_ALIGNMENT - 1) / MESH_BINARY_ALIGNMENT * MESH_BINARY_ALIGNMENT;
+}
+
+static void CopyPoints(const char* src, bool swap, MeshPointArray::_TIterator dst, unsigned long count)
+{
+    float xyz[3];
+    for (unsigned long i = 0; i < count; i++, ++dst, src += sizeof(xyz)) {
+        memcpy(xyz, src, sizeof(xyz));
+        if (swap) {
+            Base::SwapEndian(xyz[0]);
+            Base::SwapEndian(xyz[1]);
+            Base::SwapEndian(xyz[2]);
+        }
+        dst->Set(xyz[0], xyz[1], xyz[2]);
+    }
+}
+
+static void CopyFacets(const char* src, bool swap, MeshFacetArray::_TIterator dst, unsigned long count)
+{
+    uint32_t ind[6];
+    for (unsigned long i = 0; i < count; i++, ++dst, src += sizeof(ind)) {
+        memcpy(ind, src, sizeof(ind));
+        for (int j = 0; j < 6; j++) {
+            if (swap)
+                Base::SwapEndian(ind[j]);
+        }
+        for (int j = 0; j < 3; j++) {
+            dst->_aulPoints[j] = ind[j];
+            dst->_aulNeighbours[j] = (ind[j+3] == 0xFFFFFFFF ? ULONG_MAX : ind[j+3]);
+        }
+    }
+}
+
+static bool CheckIndices(const MeshPointArray& points, const MeshFacetArray& facets)
+{
+    unsigned long countPoints = points.size();
+    unsigned long countFacets = facets.size();
+    for (MeshFacetArray::_TConstIterator it = facets.begin(); it != facets.end(); ++it) {
+        for (int i = 0; i < 3; i++) {
+            if (it->_aulPoints[i] >= countPoints)
+                return false;
+            if (it->_aulNeighbours[i] >= countFacets && it->_aulNeighbours[i] != ULONG_MAX)
+                return false;
+        }
+    }
+    return true;
+}
+
+}
+
 void MeshKernel::Write (std::ostream &rclOut) const 
 {
     if (!rclOut || rclOut.bad())
@@ -764,8 +1027,8 @@ void MeshKernel::Write (std::ostream &rclOut) const
     Base::OutputStream str(rclOut);
 
     // Write a header with a "magic number" and a version
-    str << (uint32_t)0xA0B0C0D0;
-    str << (uint32_t)0x010000;
+    str << (uint32_t)MESH_BINARY_MAGIC;
+    str << (uint32_t)MESH_BINARY_VERSION_1;
 
     char szInfo[257]; // needs an additional byte for zero-termination
     strcpy(szInfo, "MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-MESH-"
@@ -796,17 +1059,182 @@ void MeshKernel::Write (std::ostream &rclOut) const
     str << _clBoundBox.MinZ << _clBoundBox.MaxZ;
 }
 
+void MeshKernel::WriteAligned (std::ostream &rclOut) const
+{
+    if (!rclOut || rclOut.bad())
+        return;
+
+    MeshBinaryHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = MESH_BINARY_MAGIC;
+    header.version = MESH_BINARY_VERSION_2;
+    header.countPoints = (uint32_t)CountPoints();
+    header.countFacets = (uint32_t)CountFacets();
+    header.boundBox[0] = _clBoundBox.MinX;
+    header.boundBox[1] = _clBoundBox.MaxX;
+    header.boundBox[2] = _clBoundBox.MinY;
+    header.boundBox[3] = _clBoundBox.MaxY;
+    header.boundBox[4] = _clBoundBox.MinZ;
+    header.boundBox[5] = _clBoundBox.MaxZ;
+    rclOut.write((const char*)&header, sizeof(header));
+
+    const char padding[MESH_BINARY_ALIGNMENT] = {0};
+
+    // write the points in chunks
+    std::vector<float> points;
+    points.reserve(3 * MESH_BINARY_CHUNK_SIZE);
+    for (MeshPointArray::_TConstIterator it = _aclPointArray.begin(); it != _aclPointArray.end(); ++it) {
+        points.push_back(it->x);
+        points.push_back(it->y);
+        points.push_back(it->z);
+        if (points.size() == points.capacity()) {
+            rclOut.write((const char*)&(points[0]), points.size() * sizeof(float));
+            points.clear();
+        }
+    }
+    if (!points.empty())
+        rclOut.write((const char*)&(points[0]), points.size() * sizeof(float));
+    std::size_t size = 3 * sizeof(float) * CountPoints();
+    rclOut.write(padding, PaddedSize(size) - size);
+
+    // write the facets in chunks
+    std::vector<uint32_t> facets;
+    facets.reserve(6 * MESH_BINARY_CHUNK_SIZE);
+    for (MeshFacetArray::_TConstIterator it = _aclFacetArray.begin(); it != _aclFacetArray.end(); ++it) {
+        facets.push_back((uint32_t)it->_aulPoints[0]);
+        facets.push_back((uint32_t)it->_aulPoints[1]);
+        facets.push_back((uint32_t)it->_aulPoints[2]);
+        facets.push_back((uint32_t)it->_aulNeighbours[0]);
+        facets.push_back((uint32_t)it->_aulNeighbours[1]);
+        facets.push_back((uint32_t)it->_aulNeighbours[2]);
+        if (facets.size() == facets.capacity()) {
+            rclOut.write((const char*)&(facets[0]), facets.size() * sizeof(uint32_t));
+            facets.clear();
+        }
+    }
+    if (!facets.empty())
+        rclOut.write((const char*)&(facets[0]), facets.size() * sizeof(uint32_t));
+    size = 6 * sizeof(uint32_t) * CountFacets();
+    rclOut.write(padding, PaddedSize(size) - size);
+}
+
+bool MeshKernel::Read (const char* pData, std::size_t ulSize)
+{
+    MeshBinaryHeader header;
+    if (ulSize < sizeof(header))
+        return false;
+    memcpy(&header, pData, sizeof(header));
+
+    bool swap = false;
+    if (header.magic != MESH_BINARY_MAGIC) {
+        header.swap();
+        swap = true;
+    }
+    if (header.magic != MESH_BINARY_MAGIC || header.version != MESH_BINARY_VERSION_2)
+        return false;
+
+    // the counts are checked before computing the sizes to avoid an overflow
+    if (header.countPoints > ulSize / (3 * sizeof(float)) ||
+        header.countFacets > ulSize / (6 * sizeof(uint32_t)))
+        return false;
+    std::size_t ptSize = PaddedSize(3 * sizeof(float) * header.countPoints);
+    std::size_t ftSize = PaddedSize(6 * sizeof(uint32_t) * header.countFacets);
+    if (ulSize < sizeof(header) + ptSize + ftSize)
+        return false;
+
+    try {
+        // the arrays are converted directly from the memory block
+        MeshPointArray pointArray(header.countPoints);
+        CopyPoints(pData + sizeof(header), swap, pointArray.begin(), header.countPoints);
+        MeshFacetArray facetArray(header.countFacets);
+        CopyFacets(pData + sizeof(header) + ptSize, swap, facetArray.begin(), header.countFacets);
+        if (!CheckIndices(pointArray, facetArray))
+            throw Base::Exception("Invalid point or neighbour index in mesh data");
+
+        EndEdit();
+        Touch();
+        _aclPointArray.swap(pointArray);
+        _aclFacetArray.swap(facetArray);
+    }
+    catch (std::exception&) {
+        // Special handling of std::length_error
+        throw Base::Exception("Reading from memory failed");
+    }
+
+    _clBoundBox.MinX = header.boundBox[0];
+    _clBoundBox.MaxX = header.boundBox[1];
+    _clBoundBox.MinY = header.boundBox[2];
+    _clBoundBox.MaxY = header.boundBox[3];
+    _clBoundBox.MinZ = header.boundBox[4];
+    _clBoundBox.MaxZ = header.boundBox[5];
+    return true;
+}
+
+void MeshKernel::ReadAligned (std::istream &rclIn, const MeshBinaryHeader& header, bool swap)
+{
+    Touch();
+    try {
+        std::vector<char> chunk;
+
+        // read the points in chunks
+        MeshPointArray pointArray(header.countPoints);
+        chunk.resize(3 * sizeof(float) * MESH_BINARY_CHUNK_SIZE);
+        for (unsigned long i = 0; i < header.countPoints; i += MESH_BINARY_CHUNK_SIZE) {
+            unsigned long count = std::min<unsigned long>(MESH_BINARY_CHUNK_SIZE, header.countPoints - i);
+            if (!rclIn.read(&(chunk[0]), 3 * sizeof(float) * count))
+                throw Base::Exception("Reading from stream failed");
+            CopyPoints(&(chunk[0]), swap, pointArray.begin() + i, count);
+        }
+        std::size_t size = 3 * sizeof(float) * header.countPoints;
+        rclIn.ignore(PaddedSize(size) - size);
+
+        // read the facets in chunks
+        MeshFacetArray facetArray(header.countFacets);
+        chunk.resize(6 * sizeof(uint32_t) * MESH_BINARY_CHUNK_SIZE);
+        for (unsigned long i = 0; i < header.countFacets; i += MESH_BINARY_CHUNK_SIZE) {
+            unsigned long count = std::min<unsigned long>(MESH_BINARY_CHUNK_SIZE, header.countFacets - i);
+            if (!rclIn.read(&(chunk[0]), 6 * sizeof(uint32_t) * count))
+                throw Base::Exception("Reading from stream failed");
+            CopyFacets(&(chunk[0]), swap, facetArray.begin() + i, count);
+        }
+        size = 6 * sizeof(uint32_t) * header.countFacets;
+        rclIn.ignore(PaddedSize(size) - size);
+        if (!CheckIndices(pointArray, facetArray))
+            throw Base::Exception("Invalid point or neighbour index in mesh data");
+
+        // If we reach this block no exception occurred and we can safely assign the mesh
+        _aclPointArray.swap(pointArray);
+        _aclFacetArray.swap(facetArray);
+    }
+    catch (std::exception&) {
+        // Special handling of std::length_error
+        throw Base::Exception("Reading from stream failed");
+    }
+
+    _clBoundBox.MinX = header.boundBox[0];
+    _clBoundBox.MaxX = header.boundBox[1];
+    _clBoundBox.MinY = header.boundBox[2];
+    _clBoundBox.MaxY = header.boundBox[3];
+    _clBoundBox.MinZ = header.boundBox[4];
+    _clBoundBox.MaxZ = header.boundBox[5];
+}
+
 void MeshKernel::Read (std::istream &rclIn)
 {
+    Touch();
     if (!rclIn || rclIn.bad())
         return;
 
+    EndEdit();
+
     // get header
     Base::InputStream str(rclIn);
 
     // Read the header with a "magic number" and a version
-    uint32_t magic, version, swap_magic, swap_version;
+    uint32_t magic=0, version=0, swap_magic, swap_version;
     str >> magic >> version;
+    if (!rclIn)
+        throw Base::Exception("Reading mesh header from stream failed");
     swap_magic = magic; Base::SwapEndian(swap_magic);
     swap_version = version; Base::SwapEndian(swap_version);
 
@@ -820,6 +1248,21 @@ void MeshKernel::Read (std::istream &rclIn)
         str.setByteOrder(Base::Stream::BigEndian);
     }
 
+    // the aligned format of version 2
+    if ((magic == MESH_BINARY_MAGIC && version == MESH_BINARY_VERSION_2) ||
+        (swap_magic == MESH_BINARY_MAGIC && swap_version == MESH_BINARY_VERSION_2)) {
+        MeshBinaryHeader header;
+        header.magic = magic;
+        header.version = version;
+        if (!rclIn.read((char*)&header + 2 * sizeof(uint32_t), sizeof(header) - 2 * sizeof(uint32_t)))
+            throw Base::Exception("Reading mesh header from stream failed");
+        bool swap = (magic != MESH_BINARY_MAGIC);
+        if (swap)
+            header.swap();
+        ReadAligned(rclIn, header, swap);
+        return;
+    }
+
     if (new_format) {
         char szInfo[256];
         rclIn.read(szInfo, 256);
@@ -827,6 +1270,8 @@ void MeshKernel::Read (std::istream &rclIn)
         // read the number of points and facets
         uint32_t uCtPts=0, uCtFts=0;
         str >> uCtPts >> uCtFts;
+        if (!rclIn)
+            throw Base::Exception("Reading mesh header from stream failed");
 
         try {
             // read the data
@@ -889,27 +1334,19 @@ void MeshKernel::operator *= (const Base::Matrix4D &rclMat)
 
 void MeshKernel::Transform (const Base::Matrix4D &rclMat)
 {
-    MeshPointArray::_TIterator  clPIter = _aclPointArray.begin(), clPEIter = _aclPointArray.end();
-    Base::Matrix4D clMatrix(rclMat);
-
-    _clBoundBox.Flush();
-    while (clPIter < clPEIter) {
-        *clPIter *= clMatrix;
-        _clBoundBox &= *clPIter;
-        clPIter++;
-    }
+    Touch();
+    MeshSimdKernels::Transform(_aclPointArray, rclMat, _clBoundBox);
 }
 
 void MeshKernel::Smooth(int iterations, float stepsize)
 {
+    Touch();
     LaplaceSmoothing(*this).Smooth(iterations);
 }
 
 void MeshKernel::RecalcBoundBox (void)
 {
-    _clBoundBox.Flush();
-    for (MeshPointArray::_TConstIterator pI = _aclPointArray.begin(); pI != _aclPointArray.end(); pI++)
-        _clBoundBox &= *pI;
+    MeshSimdKernels::BoundBox(_aclPointArray, _clBoundBox);
 }
 
 std::vector<Base::Vector3f> MeshKernel::CalcVertexNormals() const
@@ -918,27 +1355,39 @@ std::vector<Base::Vector3f> MeshKernel::CalcVertexNormals() const
 
     normals.resize(CountPoints());
 
-    unsigned long p1,p2,p3;
-    unsigned int ct = CountFacets();
-    for (unsigned int pFIter = 0;pFIter < ct; pFIter++) {
-        GetFacetPoints(pFIter,p1,p2,p3);
-        Base::Vector3f Norm = (GetPoint(p2)-GetPoint(p1)) % (GetPoint(p3)-GetPoint(p1));
+    // the facet normals are not normalized, so they are weighted by the area
+    std::vector<Base::Vector3f> facetNormals;
+    MeshSimdKernels::FacetNormals(_aclPointArray, _aclFacetArray, &facetNormals, 0, false);
+
+    unsigned long ct = CountFacets();
+    for (unsigned long pFIter = 0;pFIter < ct; pFIter++) {
+        const unsigned long* p = _aclFacetArray[pFIter]._aulPoints;
+        const Base::Vector3f& Norm = facetNormals[pFIter];
 
-        normals[p1] += Norm;
-        normals[p2] += Norm;
-        normals[p3] += Norm;
+        normals[p[0]] += Norm;
+        normals[p[1]] += Norm;
+        normals[p[2]] += Norm;
     }
 
     return normals;
 }
 
+std::vector<Base::Vector3f> MeshKernel::CalcFacetNormals() const
+{
+    std::vector<Base::Vector3f> normals;
+    MeshSimdKernels::FacetNormals(_aclPointArray, _aclFacetArray, &normals, 0);
+    return normals;
+}
+
 // Evaluation
 float MeshKernel::GetSurface() const
 {
+    std::vector<float> areas;
+    MeshSimdKernels::FacetNormals(_aclPointArray, _aclFacetArray, 0, &areas);
+
     float fSurface = 0.0;
-    MeshFacetIterator cIter(*this);
-    for (cIter.Init(); cIter.More(); cIter.Next())
-        fSurface += cIter->Area();
+    for (std::vector<float>::const_iterator it = areas.begin(); it != areas.end(); ++it)
+        fSurface += *it;
 
     return fSurface;
 }
@@ -49,6 +49,8 @@ class MeshFacet;
 class MeshFacetVisitor;
 class MeshPointVisitor;
 class MeshFacetGrid;
+class MeshHalfEdgeIndex;
+struct MeshBinaryHeader;
 
 
 /** 
@@ -76,7 +78,22 @@ public:
     //@{
     /// Binary streaming of data
     void Write (std::ostream &rclOut) const;
+    /** Writes the mesh in the aligned binary format of version 2 whose arrays
+     * can be read directly from a memory mapped file. Versions before this
+     * format was introduced cannot read it, so Write() is the default.
+     */
+    void WriteAligned (std::ostream &rclOut) const;
+    /** Reads the mesh in any of the binary formats. A stream that doesn't
+     * start with a valid header or contains invalid indices raises an exception.
+     */
     void Read (std::istream &rclIn);
+    /** Reads the mesh from a memory block, e.g. a memory mapped file, that
+     * has been written by WriteAligned(). The arrays are converted directly from
+     * the memory block without going through a stream. If the block doesn't
+     * contain a mesh in the current aligned format false is returned and
+     * the mesh is left unchanged.
+     */
+    bool Read (const char* pData, std::size_t ulSize);
     //@}
 
     /** @name Querying */
@@ -96,6 +113,12 @@ public:
     /// Determines the bounding box
     const Base::BoundBox3f& GetBoundBox (void) const
     { return _clBoundBox; }
+    /** Returns the revision of the mesh. Every modification assigns a new revision
+     * that is unique among all meshes, so data derived from the mesh, e.g. a grid,
+     * can check whether it is outdated.
+     */
+    unsigned long GetRevision (void) const
+    { return _ulRevision; }
 
     /** Forces a recalculation of the bounding box. This method should be called after
      * the removal of points.or after a transformation of the data structure.
@@ -113,6 +136,9 @@ public:
      */
     std::vector<Base::Vector3f> CalcVertexNormals() const;
 
+    /** Returns an array of the normalized facet normals of the mesh. */
+    std::vector<Base::Vector3f> CalcFacetNormals() const;
+
     /** Returns the facet at the given index. This method is rather slow and should be
      * called occassionally only. For fast access the MeshFacetIterator interface should
      * be used.
@@ -252,8 +278,35 @@ public:
     MeshPointIterator PointIterator() const;
     //@}
 
+    /** @name Incremental editing
+     * Normally adding or removing facets needs to go over the whole mesh to
+     * fix the neighbourhood and the indices. For many small edits of a large
+     * mesh an index of the half-edges can be kept instead. While it exists
+     * AddFacet(), AddFacets(), Merge(), DeleteFacet() and DeleteFacets() only
+     * visit the facets around the touched points:
+     * \li Removed facets and points are replaced by the last ones of the arrays,
+     * so the order of the remaining elements is not kept.
+     * \li The bounding box isn't recalculated after removal of facets.
+     * \li Other modifications of the kernel drop the index. MeshTopoAlgorithm,
+     * MeshTrimming and the MeshValidation classes modify the arrays directly
+     * and end the edit when they get constructed.
+     */
+    //@{
+    /** Builds the half-edge index. */
+    void BeginEdit (void);
+    /** Releases the half-edge index. */
+    void EndEdit (void);
+    /** Returns true if the half-edge index exists. */
+    bool IsEditing (void) const
+    { return _pclHalfEdges != 0; }
+    //@}
+
     /** @name Modification */
     //@{
+    /** Assigns a new revision to the mesh. Classes that modify the arrays
+     * directly must call this method.
+     */
+    void Touch (void);
     /** Adds a single facet to the data structure. This method is very slow and should
      * be called occassionally only.
      */
@@ -403,10 +456,16 @@ public:
     //@}
 
 protected:
+    /** Reads the arrays of the aligned binary format after its \a header from the stream. */
+    void ReadAligned (std::istream &rclIn, const MeshBinaryHeader& header, bool swap);
     /** Rebuilds the neighbour indices for subset of all facets from index \a index on. */
     void RebuildNeighbours (unsigned long);
     /** Removes all as INVALID marked points and facets from the structure. */
     void RemoveInvalids ();
+    /** Appends the facets \a rclFAry using the half-edge index. */
+    unsigned long AddFacetsIndexed (const std::vector<MeshFacet> &rclFAry);
+    /** Removes the facets \a raulFacets using the half-edge index. */
+    void DeleteFacetsIndexed (const std::vector<unsigned long> &raulFacets);
     /** Checks if this point is associated to no other facet and deletes if so.
      * The point indices of the facets get adjusted.
      * \a ulIndex is the index of the point to be deleted. \a ulFacetIndex is the index
@@ -426,6 +485,8 @@ protected:
     MeshFacetArray   _aclFacetArray; /**< Holds the array of facets. */
     Base::BoundBox3f _clBoundBox;    /**< The current calculated bounding box. */
     bool            _bValid; /**< Current state of validality. */
+    MeshHalfEdgeIndex* _pclHalfEdges; /**< Half-edges while editing, may be 0. */
+    unsigned long    _ulRevision; /**< Revision of the last modification. */
 
     // friends
     friend class MeshPointIterator;
@@ -440,6 +501,7 @@ protected:
     friend class MeshFixDegeneratedFacets;
     friend class MeshFixDuplicatePoints;
     friend class MeshBuilder;
+    friend class MeshFastBuilder;
     friend class MeshTrimming;
 };
 
@@ -493,16 +555,19 @@ inline void MeshKernel::GetFacetNeighbours (unsigned long ulIndex, unsigned long
 
 inline void MeshKernel::MovePoint (unsigned long ulPtIndex, const Base::Vector3f &rclTrans)
 {
+    Touch();
     _aclPointArray[ulPtIndex] += rclTrans;
 }
 
 inline void MeshKernel::SetPoint (unsigned long ulPtIndex, const Base::Vector3f &rPoint)
 {
+    Touch();
     _aclPointArray[ulPtIndex] = rPoint;
 }
 
 inline void MeshKernel::SetPoint (unsigned long ulPtIndex, float x, float y, float z)
 {
+    Touch();
     _aclPointArray[ulPtIndex].Set(x,y,z);
 }
 
@@ -23,14 +23,116 @@
 #include "PreCompiled.h"
 #ifndef _PreComp_
 #include <algorithm>
+#include <functional>
 #endif
 
+#include <QFuture>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+
 #include "Segmentation.h"
 #include "Algorithm.h"
 #include "Approximation.h"
 
 using namespace MeshCore;
 
+void RegionMoments::Clear()
+{
+    n = 0.0;
+    for (int i=0; i<3; i++)
+        s[i] = 0.0;
+    for (int i=0; i<6; i++)
+        ss[i] = 0.0;
+}
+
+void RegionMoments::Add(const Base::Vector3f& p)
+{
+    n += 1.0;
+    s[0] += p.x; s[1] += p.y; s[2] += p.z;
+    ss[0] += (double)p.x*p.x; ss[1] += (double)p.x*p.y; ss[2] += (double)p.x*p.z;
+    ss[3] += (double)p.y*p.y; ss[4] += (double)p.y*p.z; ss[5] += (double)p.z*p.z;
+}
+
+RegionMoments& RegionMoments::operator += (const RegionMoments& m)
+{
+    n += m.n;
+    for (int i=0; i<3; i++)
+        s[i] += m.s[i];
+    for (int i=0; i<6; i++)
+        ss[i] += m.ss[i];
+    return *this;
+}
+
+double RegionMoments::GetPlaneDeviation() const
+{
+    if (n < 1.0)
+        return 0.0;
+
+    // covariance matrix of the points
+    double mx = s[0]/n, my = s[1]/n, mz = s[2]/n;
+    double c00 = ss[0]/n - mx*mx, c01 = ss[1]/n - mx*my, c02 = ss[2]/n - mx*mz;
+    double c11 = ss[3]/n - my*my, c12 = ss[4]/n - my*mz, c22 = ss[5]/n - mz*mz;
+
+    // its smallest eigenvalue is the mean squared distance to the best-fit plane
+    double q = (c00 + c11 + c22) / 3.0;
+    double p1 = c01*c01 + c02*c02 + c12*c12;
+    double p2 = (c00-q)*(c00-q) + (c11-q)*(c11-q) + (c22-q)*(c22-q) + 2.0*p1;
+    double p = sqrt(p2 / 6.0);
+    double eig = q;
+    if (p > 0.0) {
+        double b00 = (c00-q)/p, b11 = (c11-q)/p, b22 = (c22-q)/p;
+        double b01 = c01/p, b02 = c02/p, b12 = c12/p;
+        double r = 0.5 * (b00*(b11*b22 - b12*b12) - b01*(b01*b22 - b12*b02) + b02*(b01*b12 - b11*b02));
+        r = std::max<double>(-1.0, std::min<double>(1.0, r));
+        double phi = acos(r) / 3.0;
+        eig = q + 2.0 * p * cos(phi + 2.0 * D_PI / 3.0);
+    }
+
+    return sqrt(std::max<double>(eig, 0.0));
+}
+
+namespace MeshCore {
+/** A disjoint-set forest over the facets with path halving and union by size. */
+class FacetUnionFind
+{
+public:
+    FacetUnionFind(unsigned long count) : parent(count), size(count, 1)
+    {
+        for (unsigned long i=0; i<count; i++)
+            parent[i] = i;
+    }
+    unsigned long Find(unsigned long i)
+    {
+        while (parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    }
+    unsigned long Union(unsigned long a, unsigned long b)
+    {
+        a = Find(a);
+        b = Find(b);
+        if (a == b)
+            return a;
+        if (size[a] < size[b])
+            std::swap(a, b);
+        parent[b] = a;
+        size[a] += size[b];
+        return a;
+    }
+    unsigned long Size(unsigned long i)
+    {
+        return size[Find(i)];
+    }
+
+private:
+    std::vector<unsigned long> parent;
+    std::vector<unsigned long> size;
+};
+}
+
 void MeshSurfaceSegment::Initialize(unsigned long)
 {
 }
@@ -99,6 +201,13 @@ void MeshDistancePlanarSegment::AddFacet(const MeshFacet& face)
     fitter->AddPoint(triangle.GetGravityPoint());
 }
 
+bool MeshDistancePlanarSegment::TestMerge(const RegionMoments& m1, const RegionMoments& m2) const
+{
+    RegionMoments m = m1;
+    m += m2;
+    return m.GetPlaneDeviation() <= tolerance;
+}
+
 // --------------------------------------------------------
 
 bool MeshCurvaturePlanarSegment::TestFacet (const MeshFacet &rclFacet) const
@@ -235,4 +344,141 @@ void MeshSegmentAlgorithm::FindSegments(std::vector<MeshSurfaceSegment*>& segm)
                 startFacet = ULONG_MAX;
         }
     }
-}
+}
+
+void MeshSegmentAlgorithm::FindSegmentsParallel(std::vector<MeshSurfaceSegment*>& segm)
+{
+    const MeshCore::MeshFacetArray& rFAry = myKernel.GetFacets();
+    unsigned long ulCtFacets = rFAry.size();
+
+    // 0: rejected, 1: accepted by the current type, 2: part of a segment of a previous type
+    std::vector<char> flags(ulCtFacets, 0);
+    std::vector<Base::Vector3f> normals;
+    std::vector<RegionMoments> moments;
+
+    for (std::vector<MeshSurfaceSegment*>::iterator it = segm.begin(); it != segm.end(); ++it) {
+        bool growing = (*it)->IsGrowing();
+        if (growing) {
+            normals.resize(ulCtFacets);
+            moments.resize(ulCtFacets);
+        }
+
+        // classify all facets
+        FacetRange range;
+        range.segm = *it;
+        range.flags = &flags;
+        range.normals = growing ? &normals : 0;
+        range.moments = growing ? &moments : 0;
+        int threads = QThread::idealThreadCount();
+        if (ulCtFacets < MESH_CT_PARALLEL_SEGMENTATION || threads <= 1) {
+            range.ulBegin = 0;
+            range.ulEnd = ulCtFacets;
+            ClassifyRange(range);
+        }
+        else {
+            // use more ranges than threads to balance the work load
+            std::vector<FacetRange> ranges;
+            unsigned long ulCtRanges = 4 * (unsigned long)threads;
+            unsigned long ulStep = (ulCtFacets + ulCtRanges - 1) / ulCtRanges;
+            for (unsigned long i = 0; i < ulCtFacets; i += ulStep) {
+                range.ulBegin = i;
+                range.ulEnd = std::min<unsigned long>(i + ulStep, ulCtFacets);
+                ranges.push_back(range);
+            }
+
+            QFuture<void> future = QtConcurrent::map(ranges, boost::bind(&MeshSegmentAlgorithm::ClassifyRange, this, _1));
+            future.waitForFinished();
+        }
+
+        // join adjacent accepted facets
+        FacetUnionFind regions(ulCtFacets);
+        if (!growing) {
+            for (unsigned long i = 0; i < ulCtFacets; i++) {
+                if (flags[i] != 1)
+                    continue;
+                for (int j=0; j<3; j++) {
+                    unsigned long n = rFAry[i]._aulNeighbours[j];
+                    if (n != ULONG_MAX && n > i && flags[n] == 1)
+                        regions.Union(i, n);
+                }
+            }
+        }
+        else {
+            // merge the flattest edges first and refit the merged regions
+            std::vector<std::pair<float, std::pair<unsigned long, unsigned long> > > edges;
+            for (unsigned long i = 0; i < ulCtFacets; i++) {
+                if (flags[i] != 1)
+                    continue;
+                for (int j=0; j<3; j++) {
+                    unsigned long n = rFAry[i]._aulNeighbours[j];
+                    if (n != ULONG_MAX && n > i && flags[n] == 1)
+                        edges.push_back(std::make_pair(normals[i] * normals[n], std::make_pair(i, n)));
+                }
+            }
+            std::sort(edges.begin(), edges.end(),
+                std::greater<std::pair<float, std::pair<unsigned long, unsigned long> > >());
+
+            for (std::vector<std::pair<float, std::pair<unsigned long, unsigned long> > >::iterator jt =
+                 edges.begin(); jt != edges.end(); ++jt) {
+                unsigned long r1 = regions.Find(jt->second.first);
+                unsigned long r2 = regions.Find(jt->second.second);
+                if (r1 != r2 && (*it)->TestMerge(moments[r1], moments[r2])) {
+                    RegionMoments m = moments[r1];
+                    m += moments[r2];
+                    moments[regions.Union(r1, r2)] = m;
+                }
+            }
+        }
+
+        // regions with more than one facet become segments, single facets
+        // are left to the next type
+        std::vector<unsigned long> segmentOf(ulCtFacets, ULONG_MAX);
+        std::vector<MeshSegment> found;
+        for (unsigned long i = 0; i < ulCtFacets; i++) {
+            if (flags[i] != 1)
+                continue;
+            unsigned long root = regions.Find(i);
+            if (regions.Size(root) < 2)
+                continue;
+            if (segmentOf[root] == ULONG_MAX) {
+                segmentOf[root] = found.size();
+                found.push_back(MeshSegment());
+            }
+            found[segmentOf[root]].push_back(i);
+            flags[i] = 2;
+        }
+
+        for (std::vector<MeshSegment>::iterator jt = found.begin(); jt != found.end(); ++jt)
+            (*it)->AddSegment(*jt);
+    }
+}
+
+void MeshSegmentAlgorithm::ClassifyRange(FacetRange& range) const
+{
+    const MeshCore::MeshFacetArray& rFAry = myKernel.GetFacets();
+    const MeshCore::MeshPointArray& rPAry = myKernel.GetPoints();
+    std::vector<char>& flags = *range.flags;
+    for (unsigned long i = range.ulBegin; i < range.ulEnd; i++) {
+        if (flags[i] == 2)
+            continue;
+        const MeshFacet& face = rFAry[i];
+        if (range.moments) {
+            // each facet starts as a region of its own
+            const Base::Vector3f& p0 = rPAry[face._aulPoints[0]];
+            const Base::Vector3f& p1 = rPAry[face._aulPoints[1]];
+            const Base::Vector3f& p2 = rPAry[face._aulPoints[2]];
+            RegionMoments& m = (*range.moments)[i];
+            m.Clear();
+            m.Add(p0);
+            m.Add(p1);
+            m.Add(p2);
+            Base::Vector3f normal = (p1 - p0) % (p2 - p0);
+            normal.Normalize();
+            (*range.normals)[i] = normal;
+            flags[i] = 1;
+        }
+        else {
+            flags[i] = range.segm->TestFacet(face) ? 1 : 0;
+        }
+    }
+}
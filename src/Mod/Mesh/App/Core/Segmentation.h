@@ -28,12 +28,32 @@
 #include "Visitor.h"
 #include <vector>
 
+#define  MESH_CT_PARALLEL_SEGMENTATION 50000  // Minimum number of facets to classify in parallel
+
 namespace MeshCore {
 
 class PlaneFit;
 class MeshFacet;
 typedef std::vector<unsigned long> MeshSegment;
 
+/**
+ * The sums of the coordinates and their products of a set of points. The sums
+ * of two sets can be added, so a fit can be updated incrementally when two
+ * regions are merged.
+ */
+struct MeshExport RegionMoments
+{
+    double n;     /**< Number of points. */
+    double s[3];  /**< Sum of the coordinates. */
+    double ss[6]; /**< Sum of the products xx, xy, xz, yy, yz, zz. */
+
+    void Clear();
+    void Add(const Base::Vector3f&);
+    RegionMoments& operator += (const RegionMoments&);
+    /** Returns the root mean square distance of the points to their best-fit plane. */
+    double GetPlaneDeviation() const;
+};
+
 class MeshExport MeshSurfaceSegment
 {
 public:
@@ -48,6 +68,15 @@ public:
     const std::vector<MeshSegment>& GetSegments() const { return segments; }
     MeshSegment FindSegment(unsigned long) const;
 
+    /** @name Parallel segmentation */
+    //@{
+    /** Returns true if TestFacet() depends on the facets added so far. Then
+     * the regions are merged as long as TestMerge() holds. */
+    virtual bool IsGrowing() const { return false; }
+    /** Returns true if two regions with the given moments of their facet points may be merged. */
+    virtual bool TestMerge(const RegionMoments&, const RegionMoments&) const { return true; }
+    //@}
+
 protected:
     std::vector<MeshSegment> segments;
     unsigned long minFacets;
@@ -75,6 +104,8 @@ public:
     const char* GetType() const { return "Plane"; }
     void Initialize(unsigned long);
     void AddFacet(const MeshFacet& rclFacet);
+    bool IsGrowing() const { return true; }
+    bool TestMerge(const RegionMoments&, const RegionMoments&) const;
 
 protected:
     Base::Vector3f basepoint;
@@ -170,6 +201,29 @@ class MeshExport MeshSegmentAlgorithm
 public:
     MeshSegmentAlgorithm(const MeshKernel& kernel) : myKernel(kernel) {}
     void FindSegments(std::vector<MeshSurfaceSegment*>&);
+    /**
+     * Finds the same kind of segments as FindSegments() but instead of growing
+     * one segment after the other from a seed facet all facets are classified
+     * on all cores up front. Adjacent facets accepted by a segment type are
+     * then joined with a union-find structure. Segment types that grow with
+     * the facets added so far (e.g. MeshDistancePlanarSegment) merge adjacent
+     * regions in the order of the angle between the facets as long as the
+     * fit of the merged region is within the tolerance.
+     * The facets of each segment are sorted by index.
+     */
+    void FindSegmentsParallel(std::vector<MeshSurfaceSegment*>&);
+
+protected:
+    /** A range of facets to classify for a segment type. */
+    struct FacetRange
+    {
+        unsigned long ulBegin, ulEnd;
+        const MeshSurfaceSegment* segm;
+        std::vector<char>* flags;
+        std::vector<Base::Vector3f>* normals;
+        std::vector<RegionMoments>* moments;
+    };
+    void ClassifyRange(FacetRange&) const;
 
 private:
     const MeshKernel& myKernel;
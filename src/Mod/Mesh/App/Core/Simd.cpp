@@ -0,0 +1,304 @@
+/***************************************************************************
+ *   Copyright (c) 2012 Imetric 3D GmbH                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <cmath>
+#endif
+
+#include "Simd.h"
+
+#if defined (MESH_HAVE_SSE2)
+# include <emmintrin.h>
+# if defined (_MSC_VER)
+#  include <intrin.h>
+# elif defined (__GNUC__)
+#  include <cpuid.h>
+# endif
+#endif
+
+using namespace MeshCore;
+
+int MeshSimdKernels::_iInstructions = -1;
+
+MeshSimdKernels::InstructionSet MeshSimdKernels::GetSupportedInstructions (void)
+{
+#if defined (MESH_HAVE_SSE2)
+  // bit 26 of edx of cpuid function 1 signals SSE2
+# if defined (_MSC_VER)
+  int aiInfo[4];
+  __cpuid(aiInfo, 1);
+  if (aiInfo[3] & (1 << 26))
+    return SSE2;
+# elif defined (__GNUC__)
+  unsigned int eax, ebx, ecx, edx;
+  if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) && (edx & (1 << 26)))
+    return SSE2;
+# endif
+#endif
+  return Scalar;
+}
+
+MeshSimdKernels::InstructionSet MeshSimdKernels::GetInstructions (void)
+{
+  if (_iInstructions < 0)
+    _iInstructions = GetSupportedInstructions();
+  return static_cast<InstructionSet>(_iInstructions);
+}
+
+void MeshSimdKernels::SetInstructions (InstructionSet eSet)
+{
+  if (eSet > GetSupportedInstructions())
+    eSet = Scalar;
+  _iInstructions = eSet;
+}
+
+void MeshSimdKernels::Transform (MeshPointArray &rclPoints, const Base::Matrix4D &rclMat, Base::BoundBox3f &rclBox)
+{
+#if defined (MESH_HAVE_SSE2)
+  if (GetInstructions() == SSE2) {
+    TransformSSE2(rclPoints, rclMat, rclBox);
+    return;
+  }
+#endif
+  TransformScalar(rclPoints, rclMat, rclBox);
+}
+
+void MeshSimdKernels::BoundBox (const MeshPointArray &rclPoints, Base::BoundBox3f &rclBox)
+{
+#if defined (MESH_HAVE_SSE2)
+  if (GetInstructions() == SSE2) {
+    BoundBoxSSE2(rclPoints, rclBox);
+    return;
+  }
+#endif
+  BoundBoxScalar(rclPoints, rclBox);
+}
+
+void MeshSimdKernels::FacetNormals (const MeshPointArray &rclPoints, const MeshFacetArray &rclFacets,
+                                    std::vector<Base::Vector3f> *pclNormals, std::vector<float> *pfAreas,
+                                    bool bNormalize)
+{
+  Base::Vector3f* pclN = 0;
+  float* pfA = 0;
+  if (pclNormals) {
+    pclNormals->resize(rclFacets.size());
+    if (!rclFacets.empty())
+      pclN = &(*pclNormals)[0];
+  }
+  if (pfAreas) {
+    pfAreas->resize(rclFacets.size());
+    if (!rclFacets.empty())
+      pfA = &(*pfAreas)[0];
+  }
+
+#if defined (MESH_HAVE_SSE2)
+  if (GetInstructions() == SSE2) {
+    FacetNormalsSSE2(rclPoints, rclFacets, pclN, pfA, bNormalize);
+    return;
+  }
+#endif
+  FacetNormalsScalar(rclPoints, rclFacets, 0, rclFacets.size(), pclN, pfA, bNormalize);
+}
+
+// ----------------------------------------------------------------------------
+
+void MeshSimdKernels::TransformScalar (MeshPointArray &rclPoints, const Base::Matrix4D &rclMat, Base::BoundBox3f &rclBox)
+{
+  rclBox.Flush();
+  for (MeshPointArray::_TIterator it = rclPoints.begin(); it != rclPoints.end(); ++it) {
+    *it *= rclMat;
+    rclBox &= *it;
+  }
+}
+
+void MeshSimdKernels::BoundBoxScalar (const MeshPointArray &rclPoints, Base::BoundBox3f &rclBox)
+{
+  rclBox.Flush();
+  for (MeshPointArray::_TConstIterator it = rclPoints.begin(); it != rclPoints.end(); ++it)
+    rclBox &= *it;
+}
+
+void MeshSimdKernels::FacetNormalsScalar (const MeshPointArray &rclPoints, const MeshFacetArray &rclFacets,
+                                          unsigned long ulBegin, unsigned long ulEnd,
+                                          Base::Vector3f *pclNormals, float *pfAreas, bool bNormalize)
+{
+  for (unsigned long i = ulBegin; i < ulEnd; i++) {
+    const MeshFacet& rclF = rclFacets[i];
+    const Base::Vector3f& p0 = rclPoints[rclF._aulPoints[0]];
+    Base::Vector3f clN = (rclPoints[rclF._aulPoints[1]] - p0) % (rclPoints[rclF._aulPoints[2]] - p0);
+    float fLen = clN.Length();
+    if (pfAreas)
+      pfAreas[i] = fLen / 2.0f;
+    if (pclNormals) {
+      if (bNormalize && fLen != 0.0f && fLen != 1.0f)
+        clN.Set(clN.x / fLen, clN.y / fLen, clN.z / fLen);
+      pclNormals[i] = clN;
+    }
+  }
+}
+
+// ----------------------------------------------------------------------------
+
+#if defined (MESH_HAVE_SSE2)
+
+namespace MeshCore {
+
+/** Loads the three coordinates of a point, the fourth component is 0. */
+static inline __m128 LoadPoint (const Base::Vector3f &rclPt)
+{
+  __m128 xy = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(&rclPt.x)));
+  return _mm_movelh_ps(xy, _mm_load_ss(&rclPt.z));
+}
+
+/** Stores the first three components of \a v. */
+static inline void StorePoint (Base::Vector3f &rclPt, __m128 v)
+{
+  _mm_storel_pi(reinterpret_cast<__m64*>(&rclPt.x), v);
+  _mm_store_ss(&rclPt.z, _mm_movehl_ps(v, v));
+}
+
+}
+
+void MeshSimdKernels::TransformSSE2 (MeshPointArray &rclPoints, const Base::Matrix4D &rclMat, Base::BoundBox3f &rclBox)
+{
+  // The matrix is applied in double precision like Matrix4D does: each column
+  // is split into its (x,y) and z part so that a point needs two registers.
+  __m128d c0xy = _mm_set_pd(rclMat[1][0], rclMat[0][0]), c0z = _mm_set_sd(rclMat[2][0]);
+  __m128d c1xy = _mm_set_pd(rclMat[1][1], rclMat[0][1]), c1z = _mm_set_sd(rclMat[2][1]);
+  __m128d c2xy = _mm_set_pd(rclMat[1][2], rclMat[0][2]), c2z = _mm_set_sd(rclMat[2][2]);
+  __m128d c3xy = _mm_set_pd(rclMat[1][3], rclMat[0][3]), c3z = _mm_set_sd(rclMat[2][3]);
+
+  __m128 vmin = _mm_set1_ps( FLOAT_MAX);
+  __m128 vmax = _mm_set1_ps(-FLOAT_MAX);
+
+  for (MeshPointArray::_TIterator it = rclPoints.begin(); it != rclPoints.end(); ++it) {
+    __m128d x = _mm_set1_pd(it->x);
+    __m128d y = _mm_set1_pd(it->y);
+    __m128d z = _mm_set1_pd(it->z);
+
+    __m128d rxy = _mm_add_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(c0xy, x), _mm_mul_pd(c1xy, y)),
+                                        _mm_mul_pd(c2xy, z)), c3xy);
+    __m128d rz  = _mm_add_sd(_mm_add_sd(_mm_add_sd(_mm_mul_sd(c0z, x), _mm_mul_sd(c1z, y)),
+                                        _mm_mul_sd(c2z, z)), c3z);
+
+    __m128 v = _mm_movelh_ps(_mm_cvtpd_ps(rxy), _mm_cvtpd_ps(rz));
+    StorePoint(*it, v);
+    vmin = _mm_min_ps(vmin, v);
+    vmax = _mm_max_ps(vmax, v);
+  }
+
+  float afMin[4], afMax[4];
+  _mm_storeu_ps(afMin, vmin);
+  _mm_storeu_ps(afMax, vmax);
+  rclBox = Base::BoundBox3f(afMin[0], afMin[1], afMin[2], afMax[0], afMax[1], afMax[2]);
+}
+
+void MeshSimdKernels::BoundBoxSSE2 (const MeshPointArray &rclPoints, Base::BoundBox3f &rclBox)
+{
+  // two independent accumulators to hide the latency of min/max
+  __m128 vmin0 = _mm_set1_ps( FLOAT_MAX), vmin1 = vmin0;
+  __m128 vmax0 = _mm_set1_ps(-FLOAT_MAX), vmax1 = vmax0;
+
+  unsigned long ulCtPoints = rclPoints.size();
+  unsigned long i = 0;
+  for (; i + 1 < ulCtPoints; i += 2) {
+    __m128 v0 = LoadPoint(rclPoints[i]);
+    __m128 v1 = LoadPoint(rclPoints[i+1]);
+    vmin0 = _mm_min_ps(vmin0, v0);
+    vmax0 = _mm_max_ps(vmax0, v0);
+    vmin1 = _mm_min_ps(vmin1, v1);
+    vmax1 = _mm_max_ps(vmax1, v1);
+  }
+  if (i < ulCtPoints) {
+    __m128 v0 = LoadPoint(rclPoints[i]);
+    vmin0 = _mm_min_ps(vmin0, v0);
+    vmax0 = _mm_max_ps(vmax0, v0);
+  }
+
+  float afMin[4], afMax[4];
+  _mm_storeu_ps(afMin, _mm_min_ps(vmin0, vmin1));
+  _mm_storeu_ps(afMax, _mm_max_ps(vmax0, vmax1));
+  rclBox = Base::BoundBox3f(afMin[0], afMin[1], afMin[2], afMax[0], afMax[1], afMax[2]);
+}
+
+void MeshSimdKernels::FacetNormalsSSE2 (const MeshPointArray &rclPoints, const MeshFacetArray &rclFacets,
+                                        Base::Vector3f *pclNormals, float *pfAreas, bool bNormalize)
+{
+  // Four facets are processed at once. The edge vectors are computed per facet
+  // and then transposed so that each register holds one coordinate of four
+  // facets (struct of arrays). The cross product, the length and the
+  // normalization then work on four facets without any shuffling.
+  unsigned long ulCtFacets = rclFacets.size();
+  unsigned long ulCtBlock = ulCtFacets & ~3UL;
+  const __m128 zero = _mm_setzero_ps();
+  const __m128 one  = _mm_set1_ps(1.0f);
+  const __m128 half = _mm_set1_ps(0.5f);
+
+  for (unsigned long i = 0; i < ulCtBlock; i += 4) {
+    __m128 e1[4], e2[4];
+    for (int j = 0; j < 4; j++) {
+      const MeshFacet& rclF = rclFacets[i+j];
+      __m128 p0 = LoadPoint(rclPoints[rclF._aulPoints[0]]);
+      e1[j] = _mm_sub_ps(LoadPoint(rclPoints[rclF._aulPoints[1]]), p0);
+      e2[j] = _mm_sub_ps(LoadPoint(rclPoints[rclF._aulPoints[2]]), p0);
+    }
+
+    _MM_TRANSPOSE4_PS(e1[0], e1[1], e1[2], e1[3]);
+    _MM_TRANSPOSE4_PS(e2[0], e2[1], e2[2], e2[3]);
+
+    // cross product e1 % e2
+    __m128 nx = _mm_sub_ps(_mm_mul_ps(e1[1], e2[2]), _mm_mul_ps(e1[2], e2[1]));
+    __m128 ny = _mm_sub_ps(_mm_mul_ps(e1[2], e2[0]), _mm_mul_ps(e1[0], e2[2]));
+    __m128 nz = _mm_sub_ps(_mm_mul_ps(e1[0], e2[1]), _mm_mul_ps(e1[1], e2[0]));
+    __m128 len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)),
+                                        _mm_mul_ps(nz, nz)));
+
+    if (pfAreas)
+      _mm_storeu_ps(pfAreas + i, _mm_mul_ps(len, half));
+
+    if (pclNormals) {
+      if (bNormalize) {
+        // like Vector3f::Normalize() keep vectors of length 0 or 1 unchanged
+        __m128 mask = _mm_or_ps(_mm_cmpeq_ps(len, zero), _mm_cmpeq_ps(len, one));
+        __m128 div = _mm_or_ps(_mm_and_ps(mask, one), _mm_andnot_ps(mask, len));
+        nx = _mm_div_ps(nx, div);
+        ny = _mm_div_ps(ny, div);
+        nz = _mm_div_ps(nz, div);
+      }
+
+      __m128 nw = zero;
+      _MM_TRANSPOSE4_PS(nx, ny, nz, nw);
+      StorePoint(pclNormals[i  ], nx);
+      StorePoint(pclNormals[i+1], ny);
+      StorePoint(pclNormals[i+2], nz);
+      StorePoint(pclNormals[i+3], nw);
+    }
+  }
+
+  // the remaining facets
+  FacetNormalsScalar(rclPoints, rclFacets, ulCtBlock, ulCtFacets, pclNormals, pfAreas, bNormalize);
+}
+
+#endif
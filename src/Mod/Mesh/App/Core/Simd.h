@@ -0,0 +1,107 @@
+/***************************************************************************
+ *   Copyright (c) 2012 Imetric 3D GmbH                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+#ifndef MESH_SIMD_H
+#define MESH_SIMD_H
+
+#include <vector>
+
+#include "Elements.h"
+#include <Base/Vector3D.h>
+#include <Base/BoundBox.h>
+#include <Base/Matrix.h>
+
+// The SSE2 kernels are only compiled if the compiler may generate SSE2 code
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define MESH_HAVE_SSE2
+#endif
+
+namespace MeshCore {
+
+/**
+ * The MeshSimdKernels class provides vectorized versions of the loops that
+ * run over all points or facets of a mesh. Which implementation is used is
+ * decided at runtime: the SSE2 kernels are taken if they were compiled in and
+ * the processor supports them, otherwise the scalar fallback is used.
+ *
+ * All kernels produce exactly the same results as the scalar code of
+ * Base::Vector3f and Base::Matrix4D because the operations are done in the
+ * same order and precision.
+ */
+class MeshExport MeshSimdKernels
+{
+public:
+  /** The instruction sets the kernels can use. */
+  enum InstructionSet {
+    Scalar, /**< Plain C++ */
+    SSE2    /**< Streaming SIMD extensions 2 */
+  };
+
+  /** @name Dispatching */
+  //@{
+  /** Returns the best instruction set supported by the compiled kernels and the processor. */
+  static InstructionSet GetSupportedInstructions (void);
+  /** Returns the instruction set which is currently used. */
+  static InstructionSet GetInstructions (void);
+  /** Sets the instruction set to use. If \a eSet is not supported the scalar
+   * kernels are used. This is mainly meant to compare the implementations.
+   */
+  static void SetInstructions (InstructionSet eSet);
+  //@}
+
+  /** @name Kernels */
+  //@{
+  /** Transforms all points with \a rclMat and returns the bounding box of
+   * the transformed points in \a rclBox.
+   */
+  static void Transform (MeshPointArray &rclPoints, const Base::Matrix4D &rclMat, Base::BoundBox3f &rclBox);
+  /** Computes the bounding box of all points. */
+  static void BoundBox (const MeshPointArray &rclPoints, Base::BoundBox3f &rclBox);
+  /** Computes the normals and the areas of all facets. If \a bNormalize is
+   * false the normals keep the length of the cross product of two edges.
+   * Either \a pclNormals or \a pfAreas can be 0 if the result isn't needed.
+   */
+  static void FacetNormals (const MeshPointArray &rclPoints, const MeshFacetArray &rclFacets,
+                            std::vector<Base::Vector3f> *pclNormals, std::vector<float> *pfAreas,
+                            bool bNormalize = true);
+  //@}
+
+private:
+  static void TransformScalar (MeshPointArray &rclPoints, const Base::Matrix4D &rclMat, Base::BoundBox3f &rclBox);
+  static void BoundBoxScalar (const MeshPointArray &rclPoints, Base::BoundBox3f &rclBox);
+  static void FacetNormalsScalar (const MeshPointArray &rclPoints, const MeshFacetArray &rclFacets,
+                                  unsigned long ulBegin, unsigned long ulEnd,
+                                  Base::Vector3f *pclNormals, float *pfAreas, bool bNormalize);
+#if defined (MESH_HAVE_SSE2)
+  static void TransformSSE2 (MeshPointArray &rclPoints, const Base::Matrix4D &rclMat, Base::BoundBox3f &rclBox);
+  static void BoundBoxSSE2 (const MeshPointArray &rclPoints, Base::BoundBox3f &rclBox);
+  static void FacetNormalsSSE2 (const MeshPointArray &rclPoints, const MeshFacetArray &rclFacets,
+                                Base::Vector3f *pclNormals, float *pfAreas, bool bNormalize);
+#endif
+
+  static int _iInstructions; /**< The selected instruction set, -1 if not yet detected. */
+};
+
+} // namespace MeshCore
+
+#endif // MESH_SIMD_H
@@ -23,8 +23,14 @@
 
 #include "PreCompiled.h"
 #ifndef _PreComp_
+# include <algorithm>
 #endif
 
+#include <QFuture>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+
 #include "Smoothing.h"
 #include "MeshKernel.h"
 #include "Algorithm.h"
@@ -167,7 +173,7 @@ void PlaneFitSmoothing::SmoothPoints(unsigned int iterations, const std::vector<
 }
 
 LaplaceSmoothing::LaplaceSmoothing(MeshKernel& m)
-  : AbstractSmoothing(m), lambda(0.6307)
+  : AbstractSmoothing(m), lambda(0.6307), pointToPoints(0), step(0.0)
 {
 }
 
@@ -175,130 +181,142 @@ LaplaceSmoothing::~LaplaceSmoothing()
 {
 }
 
-void LaplaceSmoothing::Umbrella(const MeshRefPointToPoints& vv_it,
-                                const MeshRefPointToFacets& vf_it, double stepsize)
+void LaplaceSmoothing::Smooth(unsigned int iterations)
 {
-    const MeshCore::MeshPointArray& points = kernel.GetPoints();
-    MeshCore::MeshPointArray::_TConstIterator v_it,
-    v_beg = points.begin(), v_end = points.end();
-
-    unsigned long pos = 0;
-    for (v_it = points.begin(); v_it != v_end; ++v_it,++pos) {
-        const std::set<unsigned long>& cv = vv_it[pos];
-        if (cv.size() < 3)
-            continue;
-        if (cv.size() != vf_it[pos].size()) {
-            // do nothing for border points
-            continue;
-        }
-
-        unsigned int n_count = cv.size();
-        double w;
-        w=1.0/double(n_count);
-
-        double delx=0.0,dely=0.0,delz=0.0;
-        std::set<unsigned long>::const_iterator cv_it;
-        for (cv_it = cv.begin(); cv_it !=cv.end(); ++cv_it) {
-            delx += w*((v_beg[*cv_it]).x-v_it->x);
-            dely += w*((v_beg[*cv_it]).y-v_it->y);
-            delz += w*((v_beg[*cv_it]).z-v_it->z);
-        }
+    Run(iterations, 0);
+}
 
-        float x = (float)(v_it->x+stepsize*delx);
-        float y = (float)(v_it->y+stepsize*dely);
-        float z = (float)(v_it->z+stepsize*delz);
-        kernel.SetPoint(pos,x,y,z);
+void LaplaceSmoothing::SmoothPoints(unsigned int iterations, const std::vector<unsigned long>& point_indices)
+{
+    std::vector<bool> mask(kernel.CountPoints(), false);
+    for (std::vector<unsigned long>::const_iterator it = point_indices.begin(); it != point_indices.end(); ++it) {
+        if (*it < mask.size())
+            mask[*it] = true;
     }
+    Run(iterations, &mask);
 }
 
-void LaplaceSmoothing::Umbrella(const MeshRefPointToPoints& vv_it,
-                                const MeshRefPointToFacets& vf_it, double stepsize,
-                                const std::vector<unsigned long>& point_indices)
+void LaplaceSmoothing::SmoothPoints(unsigned int iterations, const std::vector<bool>& mask)
 {
-    const MeshCore::MeshPointArray& points = kernel.GetPoints();
-    MeshCore::MeshPointArray::_TConstIterator v_beg = points.begin();
+    Run(iterations, &mask);
+}
 
-    for (std::vector<unsigned long>::const_iterator pos = point_indices.begin(); pos != point_indices.end(); ++pos) {
-        const std::set<unsigned long>& cv = vv_it[*pos];
-        if (cv.size() < 3)
-            continue;
-        if (cv.size() != vf_it[*pos].size()) {
-            // do nothing for border points
-            continue;
-        }
+void LaplaceSmoothing::Run(unsigned int iterations, const std::vector<bool>* mask)
+{
+    const MeshPointArray& rPoints = kernel.GetPoints();
+    const MeshFacetArray& rFacets = kernel.GetFacets();
+    unsigned long ulCtPoints = rPoints.size();
+
+    // border points have more neighbour points than facets
+    std::vector<unsigned long> facets(ulCtPoints, 0);
+    for (MeshFacetArray::_TConstIterator it = rFacets.begin(); it != rFacets.end(); ++it) {
+        for (int i=0; i<3; i++)
+            facets[it->_aulPoints[i]]++;
+    }
 
-        unsigned int n_count = cv.size();
-        double w;
-        w=1.0/double(n_count);
+    MeshCompactPointToPoints vv_it(kernel);
+    weights.resize(ulCtPoints);
+    for (unsigned long i=0; i<ulCtPoints; i++) {
+        std::size_t n_count = vv_it[i].size();
+        if (n_count < 3 || n_count != facets[i] || (mask && (i >= mask->size() || !(*mask)[i])))
+            weights[i] = 0.0;
+        else
+            weights[i] = 1.0/double(n_count);
+    }
 
-        double delx=0.0,dely=0.0,delz=0.0;
-        std::set<unsigned long>::const_iterator cv_it;
-        for (cv_it = cv.begin(); cv_it !=cv.end(); ++cv_it) {
-            delx += w*((v_beg[*cv_it]).x-(v_beg[*pos]).x);
-            dely += w*((v_beg[*cv_it]).y-(v_beg[*pos]).y);
-            delz += w*((v_beg[*cv_it]).z-(v_beg[*pos]).z);
-        }
+    pointToPoints = &vv_it;
+    points.assign(rPoints.begin(), rPoints.end());
+    result = points;
+    Iterate(iterations);
+    pointToPoints = 0;
 
-        float x = (float)((v_beg[*pos]).x+stepsize*delx);
-        float y = (float)((v_beg[*pos]).y+stepsize*dely);
-        float z = (float)((v_beg[*pos]).z+stepsize*delz);
-        kernel.SetPoint(*pos,x,y,z);
+    for (unsigned long i=0; i<ulCtPoints; i++) {
+        if (weights[i] != 0.0)
+            kernel.SetPoint(i, points[i].x, points[i].y, points[i].z);
     }
+
+    std::vector<double>().swap(weights);
+    std::vector<Base::Vector3f>().swap(points);
+    std::vector<Base::Vector3f>().swap(result);
 }
 
-void LaplaceSmoothing::Smooth(unsigned int iterations)
+void LaplaceSmoothing::Iterate(unsigned int iterations)
 {
-    MeshCore::MeshRefPointToPoints vv_it(kernel);
-    MeshCore::MeshRefPointToFacets vf_it(kernel);
-
     for (unsigned int i=0; i<iterations; i++) {
-        Umbrella(vv_it, vf_it, lambda);
+        Umbrella(lambda);
     }
 }
 
-void LaplaceSmoothing::SmoothPoints(unsigned int iterations, const std::vector<unsigned long>& point_indices)
+void LaplaceSmoothing::Umbrella(double stepsize)
 {
-    MeshCore::MeshRefPointToPoints vv_it(kernel);
-    MeshCore::MeshRefPointToFacets vf_it(kernel);
+    step = stepsize;
+    unsigned long ulCtPoints = points.size();
+    int threads = QThread::idealThreadCount();
+    if (ulCtPoints < MESH_CT_PARALLEL_SMOOTHING || threads <= 1) {
+        PointRange range;
+        range.ulBegin = 0;
+        range.ulEnd = ulCtPoints;
+        UmbrellaRange(range);
+    }
+    else {
+        // use more ranges than threads to balance the work load
+        std::vector<PointRange> ranges;
+        unsigned long ulCtRanges = 4 * (unsigned long)threads;
+        unsigned long ulStep = (ulCtPoints + ulCtRanges - 1) / ulCtRanges;
+        for (unsigned long i = 0; i < ulCtPoints; i += ulStep) {
+            PointRange range;
+            range.ulBegin = i;
+            range.ulEnd = std::min<unsigned long>(i + ulStep, ulCtPoints);
+            ranges.push_back(range);
+        }
 
-    for (unsigned int i=0; i<iterations; i++) {
-        Umbrella(vv_it, vf_it, lambda, point_indices);
+        QFuture<void> future = QtConcurrent::map(ranges, boost::bind(&LaplaceSmoothing::UmbrellaRange, this, _1));
+        future.waitForFinished();
     }
+
+    // the new positions are the input of the next step
+    points.swap(result);
 }
 
-TaubinSmoothing::TaubinSmoothing(MeshKernel& m)
-  : LaplaceSmoothing(m), micro(0.0424)
+void LaplaceSmoothing::UmbrellaRange(PointRange& range)
 {
+    const MeshCompactPointToPoints& vv_it = *pointToPoints;
+    for (unsigned long pos = range.ulBegin; pos < range.ulEnd; pos++) {
+        double w = weights[pos];
+        if (w == 0.0)
+            continue;
+
+        const Base::Vector3f& v = points[pos];
+        double delx=0.0,dely=0.0,delz=0.0;
+        MeshNeighbourRange cv = vv_it[pos];
+        for (MeshNeighbourRange::const_iterator cv_it = cv.begin(); cv_it != cv.end(); ++cv_it) {
+            const Base::Vector3f& n = points[*cv_it];
+            delx += n.x-v.x;
+            dely += n.y-v.y;
+            delz += n.z-v.z;
+        }
+
+        result[pos].Set((float)(v.x+step*w*delx),
+                        (float)(v.y+step*w*dely),
+                        (float)(v.z+step*w*delz));
+    }
 }
 
-TaubinSmoothing::~TaubinSmoothing()
+TaubinSmoothing::TaubinSmoothing(MeshKernel& m)
+  : LaplaceSmoothing(m), micro(0.0424)
 {
 }
 
-void TaubinSmoothing::Smooth(unsigned int iterations)
+TaubinSmoothing::~TaubinSmoothing()
 {
-    MeshCore::MeshPointArray::_TConstIterator v_it;
-    MeshCore::MeshRefPointToPoints vv_it(kernel);
-    MeshCore::MeshRefPointToFacets vf_it(kernel);
-
-    // Theoretically Taubin does not shrink the surface
-    iterations = (iterations+1)/2; // two steps per iteration
-    for (unsigned int i=0; i<iterations; i++) {
-        Umbrella(vv_it, vf_it, lambda);
-        Umbrella(vv_it, vf_it, -(lambda+micro));
-    }
 }
 
-void TaubinSmoothing::SmoothPoints(unsigned int iterations, const std::vector<unsigned long>& point_indices)
+void TaubinSmoothing::Iterate(unsigned int iterations)
 {
-    MeshCore::MeshPointArray::_TConstIterator v_it;
-    MeshCore::MeshRefPointToPoints vv_it(kernel);
-    MeshCore::MeshRefPointToFacets vf_it(kernel);
-
     // Theoretically Taubin does not shrink the surface
     iterations = (iterations+1)/2; // two steps per iteration
     for (unsigned int i=0; i<iterations; i++) {
-        Umbrella(vv_it, vf_it, lambda, point_indices);
-        Umbrella(vv_it, vf_it, -(lambda+micro), point_indices);
+        Umbrella(lambda);
+        Umbrella(-(lambda+micro));
     }
 }
@@ -26,11 +26,14 @@
 
 #include <vector>
 
+#include <Base/Vector3D.h>
+
+#define  MESH_CT_PARALLEL_SMOOTHING 50000  // Minimum number of points to smooth in parallel
+
 namespace MeshCore
 {
 class MeshKernel;
-class MeshRefPointToPoints;
-class MeshRefPointToFacets;
+class MeshCompactPointToPoints;
 
 /** Base class for smoothing algorithms. */
 class MeshExport AbstractSmoothing
@@ -73,6 +76,15 @@ public:
     void SmoothPoints(unsigned int, const std::vector<unsigned long>&);
 };
 
+/**
+ * The LaplaceSmoothing class moves each point towards the average of its
+ * neighbours (umbrella operator). The neighbours and the weight of each point
+ * are computed once, then all points are moved at the same time by reading
+ * the positions of the last step from one array and writing the new positions
+ * to another one. This way the points can be processed on all cores.
+ * Border points and points whose flag in the mask is not set keep their
+ * position.
+ */
 class MeshExport LaplaceSmoothing : public AbstractSmoothing
 {
 public:
@@ -80,17 +92,33 @@ public:
     virtual ~LaplaceSmoothing();
     void Smooth(unsigned int);
     void SmoothPoints(unsigned int, const std::vector<unsigned long>&);
+    /** Smoothes the points whose flag in \a mask is set. */
+    void SmoothPoints(unsigned int, const std::vector<bool>& mask);
     void SetLambda(double l) { lambda = l;}
 
 protected:
-    void Umbrella(const MeshRefPointToPoints&,
-                  const MeshRefPointToFacets&, double);
-    void Umbrella(const MeshRefPointToPoints&,
-                  const MeshRefPointToFacets&, double,
-                  const std::vector<unsigned long>&);
+    /** A range of points to process in one step. */
+    struct PointRange
+    {
+        unsigned long ulBegin, ulEnd;
+    };
+
+    void Run(unsigned int, const std::vector<bool>*);
+    /** Does the given number of smoothing steps, see Umbrella(). */
+    virtual void Iterate(unsigned int);
+    /** Moves all points by \a stepsize times the umbrella vector. */
+    void Umbrella(double stepsize);
+    void UmbrellaRange(PointRange&);
 
 protected:
     double lambda;
+
+private:
+    const MeshCompactPointToPoints* pointToPoints;
+    std::vector<double> weights;        /**< 1/number of neighbours, or 0 for fixed points. */
+    std::vector<Base::Vector3f> points; /**< The positions of the last step. */
+    std::vector<Base::Vector3f> result; /**< The positions of the current step. */
+    double step;
 };
 
 class MeshExport TaubinSmoothing : public LaplaceSmoothing
@@ -98,10 +126,11 @@ class MeshExport TaubinSmoothing : public LaplaceSmoothing
 public:
     TaubinSmoothing(MeshKernel&);
     virtual ~TaubinSmoothing();
-    void Smooth(unsigned int);
-    void SmoothPoints(unsigned int, const std::vector<unsigned long>&);
     void SetMicro(double m) { micro = m;}
 
+protected:
+    void Iterate(unsigned int);
+
 protected:
     double micro;
 };
@@ -29,6 +29,11 @@
 # include <queue>
 #endif
 
+#include <QFuture>
+#include <QThread>
+#include <QtConcurrentMap>
+#include <boost/bind.hpp>
+
 #include <Mod/Mesh/App/WildMagic4/Wm4MeshCurvature.h>
 #include <Mod/Mesh/App/WildMagic4/Wm4Vector3.h>
 
@@ -45,6 +50,9 @@ using namespace MeshCore;
 MeshTopoAlgorithm::MeshTopoAlgorithm (MeshKernel &rclM)
 : _rclMesh(rclM), _needsCleanup(false), _cache(0)
 {
+  // the arrays of the mesh are modified directly
+  _rclMesh.EndEdit();
+  _rclMesh.Touch();
 }
 
 MeshTopoAlgorithm::~MeshTopoAlgorithm (void)
@@ -52,6 +60,7 @@ MeshTopoAlgorithm::~MeshTopoAlgorithm (void)
   if ( _needsCleanup )
     Cleanup();
   EndCache();
+  _rclMesh.Touch();
 }
 
 bool MeshTopoAlgorithm::InsertVertex(unsigned long ulFacetPos, const Base::Vector3f&  rclPoint)
@@ -1345,6 +1354,136 @@ void MeshTopoAlgorithm::FillupHoles(int level, AbstractPolygonTriangulator& cTri
     }
 }
 
+void MeshTopoAlgorithm::FillupHolesParallel(unsigned long length, int level,
+                                            AbstractPolygonTriangulator& cTria,
+                                            std::list<std::vector<unsigned long> >& aFailed)
+{
+    // get the mesh boundaries in one pass
+    std::list<std::vector<unsigned long> > aBorders, aFillBorders;
+    MeshAlgorithm cAlgo(_rclMesh);
+    cAlgo.GetBoundaryLoops(aBorders);
+
+    // split boundary loops if needed
+    cAlgo.SplitBoundaryLoops(aBorders);
+
+    for (std::list<std::vector<unsigned long> >::iterator it = aBorders.begin(); it != aBorders.end(); ++it) {
+        if (it->size()-1 <= length) // ignore boundary with too many edges
+            aFillBorders.push_back(*it);
+    }
+
+    if (!aFillBorders.empty())
+        FillupHolesParallel(level, cTria, aFillBorders, aFailed);
+}
+
+void MeshTopoAlgorithm::FillupHolesParallel(int level, AbstractPolygonTriangulator& cTria,
+                                            const std::list<std::vector<unsigned long> >& aBorders,
+                                            std::list<std::vector<unsigned long> >& aFailed)
+{
+    // get the facets to a point
+    MeshRefPointToFacets cPt2Fac(_rclMesh);
+    std::vector<std::vector<unsigned long> > borders(aBorders.begin(), aBorders.end());
+    std::vector<HoleFilling> fillings(borders.size());
+
+    HoleRange range;
+    range.level = level;
+    range.tria = &cTria;
+    range.borders = &borders;
+    range.pt2fac = &cPt2Fac;
+    range.fillings = &fillings;
+    unsigned long ulCtHoles = borders.size();
+    int threads = QThread::idealThreadCount();
+    if (ulCtHoles < MESH_CT_PARALLEL_HOLES || threads <= 1) {
+        range.ulBegin = 0;
+        range.ulEnd = ulCtHoles;
+        FillupHoleRange(range);
+    }
+    else {
+        // use more ranges than threads to balance the work load, each range
+        // needs its own triangulator
+        std::vector<HoleRange> ranges;
+        unsigned long ulCtRanges = 4 * (unsigned long)threads;
+        unsigned long ulStep = (ulCtHoles + ulCtRanges - 1) / ulCtRanges;
+        for (unsigned long i = 0; i < ulCtHoles; i += ulStep) {
+            range.ulBegin = i;
+            range.ulEnd = std::min<unsigned long>(i + ulStep, ulCtHoles);
+            range.tria = cTria.Clone();
+            ranges.push_back(range);
+        }
+
+        QFuture<void> future = QtConcurrent::map(ranges, boost::bind(&MeshTopoAlgorithm::FillupHoleRange, this, _1));
+        future.waitForFinished();
+
+        for (std::vector<HoleRange>::iterator it = ranges.begin(); it != ranges.end(); ++it)
+            delete it->tria;
+    }
+
+    // collect the new points and facets in the order of the holes
+    MeshFacetArray newFacets;
+    MeshPointArray newPoints;
+    unsigned long numberOfOldPoints = _rclMesh._aclPointArray.size();
+    for (unsigned long i = 0; i < ulCtHoles; i++) {
+        HoleFilling& hole = fillings[i];
+        if (!hole.ok) {
+            aFailed.push_back(borders[i]);
+            continue;
+        }
+
+        std::vector<unsigned long>& bound = borders[i];
+        if (bound.front() == bound.back())
+            bound.pop_back();
+        // the triangulation may produce additional points which we must take into account when appending to the mesh
+        if (hole.points.size() > bound.size()) {
+            MeshPointArray::_TIterator pt = hole.points.begin() + bound.size();
+            for (; pt != hole.points.end(); ++pt) {
+                bound.push_back(numberOfOldPoints++);
+                newPoints.push_back(*pt);
+            }
+        }
+        if (cTria.NeedsReindexing()) {
+            for (MeshFacetArray::_TIterator kt = hole.facets.begin(); kt != hole.facets.end(); ++kt) {
+                kt->_aulPoints[0] = bound[kt->_aulPoints[0]];
+                kt->_aulPoints[1] = bound[kt->_aulPoints[1]];
+                kt->_aulPoints[2] = bound[kt->_aulPoints[2]];
+            }
+        }
+        newFacets.insert(newFacets.end(), hole.facets.begin(), hole.facets.end());
+    }
+
+    // insert new points and faces into the mesh structure
+    _rclMesh._aclPointArray.insert(_rclMesh._aclPointArray.end(), newPoints.begin(), newPoints.end());
+    for (MeshPointArray::_TIterator it = newPoints.begin(); it != newPoints.end(); ++it)
+        _rclMesh._clBoundBox &= *it;
+    if (!newFacets.empty()) {
+        // Do some checks for invalid point indices
+        MeshFacetArray addFacets;
+        addFacets.reserve(newFacets.size());
+        unsigned long ctPoints = _rclMesh.CountPoints();
+        for (MeshFacetArray::_TIterator it = newFacets.begin(); it != newFacets.end(); ++it) {
+            if (it->_aulPoints[0] >= ctPoints || 
+                it->_aulPoints[1] >= ctPoints || 
+                it->_aulPoints[2] >= ctPoints) {
+                Base::Console().Log("Ignore invalid face <%d, %d, %d> (%d vertices)\n", 
+                    it->_aulPoints[0], it->_aulPoints[1], it->_aulPoints[2], ctPoints);
+            }
+            else {
+                addFacets.push_back(*it);
+            }
+        }
+        // a single update of the neighbourhood for all holes
+        _rclMesh.AddFacets(addFacets);
+    }
+}
+
+void MeshTopoAlgorithm::FillupHoleRange(HoleRange& range) const
+{
+    MeshAlgorithm cAlgo(_rclMesh);
+    for (unsigned long i = range.ulBegin; i < range.ulEnd; i++) {
+        HoleFilling& hole = (*range.fillings)[i];
+        hole.ok = cAlgo.FillupHole((*range.borders)[i], *range.tria, hole.facets,
+                                   hole.points, range.level, range.pt2fac);
+    }
+}
+
 void MeshTopoAlgorithm::FindHoles(unsigned long length,
                                   std::list<std::vector<unsigned long> >& aBorders) const
 {
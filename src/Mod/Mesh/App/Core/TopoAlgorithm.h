@@ -37,6 +37,8 @@
 #include <Base/Vector3D.h>
 #include <Base/Sequencer.h>
 
+#define  MESH_CT_PARALLEL_HOLES 100  // Minimum number of holes to fill in parallel
+
 namespace MeshCore {
 class AbstractPolygonTriangulator;
 
@@ -245,6 +247,22 @@ public:
     void FillupHoles(int level, AbstractPolygonTriangulator&,
         const std::list<std::vector<unsigned long> >& aBorders,
         std::list<std::vector<unsigned long> >& aFailed);
+    /**
+     * Does the same as FillupHoles() but in a batched mode which is much faster for meshes
+     * with many holes. All boundary loops are collected in one pass, the holes are triangulated
+     * on all cores with clones of the given triangulator and the new facets are added to the
+     * mesh in one go, i.e. the neighbourhood is updated only once.
+     */
+    void FillupHolesParallel(unsigned long length, int level,
+        AbstractPolygonTriangulator&,
+        std::list<std::vector<unsigned long> >& aFailed);
+    /**
+     * This is an overloaded method provided for convenience. It takes as first argument
+     * the boundaries which must be filled up.
+     */
+    void FillupHolesParallel(int level, AbstractPolygonTriangulator&,
+        const std::list<std::vector<unsigned long> >& aBorders,
+        std::list<std::vector<unsigned long> >& aFailed);
     /**
      * Find holes which consists of up to \a length edges.
      */
@@ -288,6 +306,28 @@ private:
     /** \internal */
     unsigned long GetOrAddIndex (const MeshPoint &rclPoint);
 
+    /** The triangulation of a hole. */
+    struct HoleFilling
+    {
+        bool ok;
+        MeshFacetArray facets;
+        MeshPointArray points;
+    };
+    /** A range of holes to triangulate. */
+    struct HoleRange
+    {
+        unsigned long ulBegin, ulEnd;
+        int level;
+        AbstractPolygonTriangulator* tria;
+        const std::vector<std::vector<unsigned long> >* borders;
+        const MeshRefPointToFacets* pt2fac;
+        std::vector<HoleFilling>* fillings;
+    };
+    /**
+     * Triangulates the holes of the range \a range.
+     */
+    void FillupHoleRange(HoleRange& range) const;
+
 private:
     MeshKernel& _rclMesh;
     bool _needsCleanup;
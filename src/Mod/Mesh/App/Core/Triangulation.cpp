@@ -212,6 +212,11 @@ EarClippingTriangulator::~EarClippingTriangulator()
 {
 }
 
+AbstractPolygonTriangulator* EarClippingTriangulator::Clone() const
+{
+    return new EarClippingTriangulator();
+}
+
 bool EarClippingTriangulator::Triangulate()
 {
     _facets.clear();
@@ -222,6 +227,8 @@ bool EarClippingTriangulator::Triangulate()
 
     //  Invoke the triangulator to triangulate this polygon.
     Triangulate::Process(pts,result);
+    // a counter-clockwise polygon is processed in reverse order
+    bool invert = (0.0f < Triangulate::Area(pts));
 
     // print out the results.
     unsigned long tcount = result.size()/3;
@@ -233,7 +240,7 @@ bool EarClippingTriangulator::Triangulate()
     MeshGeomFacet clFacet;
     MeshFacet clTopFacet;
     for (unsigned long i=0; i<tcount; i++) {
-        if (Triangulate::_invert) {
+        if (invert) {
             clFacet._aclPoints[0] = _points[result[i*3+0]];
             clFacet._aclPoints[2] = _points[result[i*3+1]];
             clFacet._aclPoints[1] = _points[result[i*3+2]];
@@ -321,8 +328,6 @@ bool EarClippingTriangulator::Triangulate::Snip(const std::vector<Base::Vector3f
     return true;
 }
 
-bool EarClippingTriangulator::Triangulate::_invert = false;
-
 bool EarClippingTriangulator::Triangulate::Process(const std::vector<Base::Vector3f> &contour,
                                                    std::vector<unsigned long> &result)
 {
@@ -337,12 +342,10 @@ bool EarClippingTriangulator::Triangulate::Process(const std::vector<Base::Vecto
 
     if (0.0f < Area(contour)) {
         for (int v=0; v<n; v++) V[v] = v;
-        _invert = true;
     }
 //    for(int v=0; v<n; v++) V[v] = (n-1)-v;
     else {
         for(int v=0; v<n; v++) V[v] = (n-1)-v;
-        _invert = false;
     }
 
     int nv = n;
@@ -354,6 +357,7 @@ bool EarClippingTriangulator::Triangulate::Process(const std::vector<Base::Vecto
         /* if we loop, it is probably a non-simple polygon */
         if (0 >= (count--)) {
             //** Triangulate: ERROR - probable bad polygon!
+            delete [] V;
             return false;
         }
 
@@ -398,6 +402,11 @@ QuasiDelaunayTriangulator::~QuasiDelaunayTriangulator()
 {
 }
 
+AbstractPolygonTriangulator* QuasiDelaunayTriangulator::Clone() const
+{
+    return new QuasiDelaunayTriangulator();
+}
+
 bool QuasiDelaunayTriangulator::Triangulate()
 {
     if (EarClippingTriangulator::Triangulate() == false)
@@ -550,6 +559,11 @@ DelaunayTriangulator::~DelaunayTriangulator()
 {
 }
 
+AbstractPolygonTriangulator* DelaunayTriangulator::Clone() const
+{
+    return new DelaunayTriangulator();
+}
+
 bool DelaunayTriangulator::Triangulate()
 {
     // before starting the triangulation we must make sure that all polygon 
@@ -617,6 +631,11 @@ FlatTriangulator::~FlatTriangulator()
 {
 }
 
+AbstractPolygonTriangulator* FlatTriangulator::Clone() const
+{
+    return new FlatTriangulator();
+}
+
 bool FlatTriangulator::Triangulate()
 {
     _newpoints.clear();
@@ -659,6 +678,11 @@ ConstraintDelaunayTriangulator::~ConstraintDelaunayTriangulator()
 {
 }
 
+AbstractPolygonTriangulator* ConstraintDelaunayTriangulator::Clone() const
+{
+    return new ConstraintDelaunayTriangulator(fMaxArea);
+}
+
 bool ConstraintDelaunayTriangulator::Triangulate()
 {
     _newpoints.clear();
@@ -91,6 +91,11 @@ public:
     virtual void Discard();
     /** Resets some internals. The default implementation does nothing.*/
     virtual void Reset();
+    /** Returns a new triangulator of the same type and with the same settings.
+     * Since a triangulator keeps the state of the current polygon each thread
+     * needs its own instance to triangulate several polygons in parallel.
+     */
+    virtual AbstractPolygonTriangulator* Clone() const = 0;
 
 protected:
     /** Computes the triangulation of a polygon. The resulting facets can
@@ -120,6 +125,8 @@ public:
     EarClippingTriangulator();
     ~EarClippingTriangulator();
 
+    AbstractPolygonTriangulator* Clone() const;
+
 protected:
     bool Triangulate();
 
@@ -149,7 +156,6 @@ private:
         static bool InsideTriangle(float Ax, float Ay, float Bx, float By,
             float Cx, float Cy, float Px, float Py);
 
-        static bool _invert;
     private:
         static bool Snip(const std::vector<Base::Vector3f> &contour,
             int u,int v,int w,int n,int *V);
@@ -162,6 +168,8 @@ public:
     QuasiDelaunayTriangulator();
     ~QuasiDelaunayTriangulator();
 
+    AbstractPolygonTriangulator* Clone() const;
+
 protected:
     bool Triangulate();
 };
@@ -172,6 +180,8 @@ public:
     DelaunayTriangulator();
     ~DelaunayTriangulator();
 
+    AbstractPolygonTriangulator* Clone() const;
+
 protected:
     bool Triangulate();
 };
@@ -182,6 +192,7 @@ public:
     FlatTriangulator();
     ~FlatTriangulator();
 
+    AbstractPolygonTriangulator* Clone() const;
     void PostProcessing(const std::vector<Base::Vector3f>&);
 
 protected:
@@ -194,6 +205,8 @@ public:
     ConstraintDelaunayTriangulator(float area);
     ~ConstraintDelaunayTriangulator();
 
+    AbstractPolygonTriangulator* Clone() const;
+
 protected:
     bool Triangulate();
 
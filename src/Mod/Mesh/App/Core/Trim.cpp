@@ -34,6 +34,8 @@ MeshTrimming::MeshTrimming(MeshKernel &rclM, const Base::ViewProjMethod* pclProj
                            const Base::Polygon2D& rclPoly)
   : myMesh(rclM), myInner(true), myProj(pclProj), myPoly(rclPoly)
 {
+  // the facets of the mesh are modified directly
+  myMesh.EndEdit();
 }
 
 MeshTrimming::~MeshTrimming()
@@ -38,6 +38,10 @@
 
 
 
+namespace Mesh {
+    const App::PropertyIntegerConstraint::Constraints ringsRange = {1,10,1};
+}
+
 using namespace Mesh;
 
 PROPERTY_SOURCE(Mesh::Curvature, App::DocumentObject)
@@ -46,6 +50,9 @@ PROPERTY_SOURCE(Mesh::Curvature, App::DocumentObject)
 Curvature::Curvature(void)
 {
     ADD_PROPERTY(Source,(0));
+    ADD_PROPERTY_TYPE(Rings, (2), "Curvature", App::Prop_None,
+        "Size of the neighbourhood of a point used to estimate its curvature");
+    Rings.setConstraints(&ringsRange);
     ADD_PROPERTY(CurvInfo, (CurvatureInfo()));
 }
 
@@ -53,6 +60,8 @@ short Curvature::mustExecute() const
 {
     if (Source.isTouched())
         return 1;
+    if (Rings.isTouched())
+        return 1;
     if (Source.getValue() && Source.getValue()->isTouched())
         return 1;
     return 0;
@@ -65,24 +74,11 @@ App::DocumentObjectExecReturn *Curvature::execute(void)
         return new App::DocumentObjectExecReturn("No mesh object attached.");
     }
  
-    // get all points
+    // compute the curvature directly into the property
     const MeshCore::MeshKernel& rMesh = pcFeat->Mesh.getValue().getKernel();
-    MeshCore::MeshCurvature meshCurv(rMesh);
-    meshCurv.ComputePerVertex();
-    const std::vector<MeshCore::CurvatureInfo>& curv = meshCurv.GetCurvature();
-
-    std::vector<CurvatureInfo> values;
-    values.reserve(curv.size());
-    for (std::vector<MeshCore::CurvatureInfo>::const_iterator it = curv.begin(); it != curv.end(); ++it) {
-        CurvatureInfo ci;
-        ci.cMaxCurvDir = it->cMaxCurvDir;
-        ci.cMinCurvDir = it->cMinCurvDir;
-        ci.fMaxCurvature = it->fMaxCurvature;
-        ci.fMinCurvature = it->fMinCurvature;
-        values.push_back(ci);
-    }
-
-    CurvInfo.setValues(values);
+    MeshCore::MeshPointCurvature meshCurv(rMesh, (unsigned short)Rings.getValue());
+    meshCurv.Compute(CurvInfo.startEditing());
+    CurvInfo.finishEditing();
 
     return App::DocumentObject::StdReturn;
 }
@@ -27,6 +27,7 @@
 #include <App/DocumentObject.h>
 #include <App/PropertyLinks.h>
 #include <App/PropertyGeo.h>
+#include <App/PropertyStandard.h>
 
 #include "Mesh.h"
 #include "MeshProperties.h"
@@ -46,6 +47,7 @@ public:
     Curvature();
 
     App::PropertyLink Source;
+    App::PropertyIntegerConstraint Rings;
     PropertyCurvatureList CurvInfo;
 
     /** @name methods overide Feature */
@@ -0,0 +1,109 @@
+/***************************************************************************
+ *   Copyright (c) 2012 Imetric 3D GmbH                                    *
+ *                                                                         *
+ *   This file is part of the FreeCAD CAx development system.              *
+ *                                                                         *
+ *   This library is free software; you can redistribute it and/or         *
+ *   modify it under the terms of the GNU Library General Public           *
+ *   License as published by the Free Software Foundation; either          *
+ *   version 2 of the License, or (at your option) any later version.      *
+ *                                                                         *
+ *   This library  is distributed in the hope that it will be useful,      *
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of        *
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the         *
+ *   GNU Library General Public License for more details.                  *
+ *                                                                         *
+ *   You should have received a copy of the GNU Library General Public     *
+ *   License along with this library; see the file COPYING.LIB. If not,    *
+ *   write to the Free Software Foundation, Inc., 59 Temple Place,         *
+ *   Suite 330, Boston, MA  02111-1307, USA                                *
+ *                                                                         *
+ ***************************************************************************/
+
+
+
+#include "PreCompiled.h"
+
+#ifndef _PreComp_
+# include <algorithm>
+#endif
+
+#include <Base/Console.h>
+
+#include "FeatureMeshDecimation.h"
+#include "Core/Decimation.h"
+#include "Core/MeshKernel.h"
+
+using namespace Mesh;
+
+namespace Mesh {
+    const App::PropertyFloatConstraint::Constraints reductionRange = {0.0,1.0,0.05};
+    const App::PropertyFloatConstraint::Constraints toleranceRange = {0.0,FLOAT_MAX,0.1};
+}
+
+PROPERTY_SOURCE(Mesh::Decimation, Mesh::Feature)
+
+Decimation::Decimation()
+{
+    ADD_PROPERTY(Source  ,(0));
+    ADD_PROPERTY_TYPE(TargetSize, (0), "Decimation", App::Prop_None,
+        "The number of facets to keep, if 0 the reduction is used");
+    ADD_PROPERTY_TYPE(Reduction, (0.5), "Decimation", App::Prop_None,
+        "The portion of facets to remove");
+    ADD_PROPERTY_TYPE(Tolerance, (0.1), "Decimation", App::Prop_None,
+        "The maximum deviation from the original mesh, if 0 there is no limit");
+    ADD_PROPERTY_TYPE(PreserveBoundary, (true), "Decimation", App::Prop_None,
+        "Keep the boundary points unchanged");
+    ADD_PROPERTY_TYPE(FeatureAngle, (45.0), "Decimation", App::Prop_None,
+        "Edges with a greater angle between the adjacent facets are preserved");
+    Reduction.setConstraints(&reductionRange);
+    Tolerance.setConstraints(&toleranceRange);
+}
+
+Decimation::~Decimation()
+{
+}
+
+short Decimation::mustExecute() const
+{
+    if (Source.isTouched() ||
+        TargetSize.isTouched() ||
+        Reduction.isTouched() ||
+        Tolerance.isTouched() ||
+        PreserveBoundary.isTouched() ||
+        FeatureAngle.isTouched())
+        return 1;
+    return 0;
+}
+
+App::DocumentObjectExecReturn *Decimation::execute(void)
+{
+    App::DocumentObject* link = Source.getValue();
+    if (!link) return new App::DocumentObjectExecReturn("No mesh linked");
+    App::Property* prop = link->getPropertyByName("Mesh");
+    if (prop && prop->getTypeId() == Mesh::PropertyMeshKernel::getClassTypeId()) {
+        Mesh::PropertyMeshKernel* kernel = static_cast<Mesh::PropertyMeshKernel*>(prop);
+        std::auto_ptr<MeshObject> mesh(new MeshObject);
+        *mesh = kernel->getValue();
+
+        MeshCore::MeshKernel& rMesh = mesh->getKernel();
+        unsigned long target = (unsigned long)std::max<long>(TargetSize.getValue(), 0);
+        if (target == 0)
+            target = (unsigned long)((1.0 - Reduction.getValue()) * rMesh.CountFacets());
+
+        MeshCore::MeshDecimation dm(rMesh);
+        dm.SetTargetSize(target);
+        if (Tolerance.getValue() > 0.0)
+            dm.SetTolerance((float)Tolerance.getValue());
+        dm.SetPreserveBoundary(PreserveBoundary.getValue());
+        dm.SetFeatureAngle((float)(FeatureAngle.getValue() * F_PI / 180.0));
+        dm.Decimate();
+
+        const MeshCore::MeshDecimation::Statistics& stats = dm.GetStatistics();
+        Base::Console().Log("Decimation: %lu facets removed, max. error %g\n",
+            stats.ulRemoved, stats.fMaxError);
+        this->Mesh.setValuePtr(mesh.release());
+    }
+
+    return App::DocumentObject::StdReturn;
+}
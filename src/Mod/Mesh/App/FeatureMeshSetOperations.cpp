@@ -36,6 +36,7 @@
 #include "Core/Visitor.h"
 
 #include "Core/SetOperations.h"
+#include "Core/Boolean.h"
 
 #include "FeatureMeshSetOperations.h"
 
@@ -45,12 +46,16 @@ using namespace std;
 
 PROPERTY_SOURCE(Mesh::SetOperations, Mesh::Feature)
 
+const char* SetOperations::AlgorithmEnums[] = {"Standard","Exact",NULL};
 
 SetOperations::SetOperations(void)
 {
     ADD_PROPERTY(Source1  ,(0));
     ADD_PROPERTY(Source2  ,(0));
     ADD_PROPERTY(OperationType, ("union"));
+    ADD_PROPERTY_TYPE(Algorithm, ((long)0), "", App::Prop_None,
+        "'Exact' uses exact predicates and is faster on large meshes");
+    Algorithm.setEnums(AlgorithmEnums);
 }
 
 short SetOperations::mustExecute() const
@@ -62,6 +67,8 @@ short SetOperations::mustExecute() const
             return 1;
         if (OperationType.isTouched())
             return 1;
+        if (Algorithm.isTouched())
+            return 1;
     }
 
     return 0;
@@ -94,9 +101,16 @@ App::DocumentObjectExecReturn *SetOperations::execute(void)
             throw new Base::Exception("Operation type must either be 'union' or 'intersection'"
                                       " or 'difference' or 'inner' or 'outer'");
 
-        MeshCore::SetOperations setOp(meshKernel1.getKernel(), meshKernel2.getKernel(), 
-            pcKernel->getKernel(), type, 1.0e-5f);
-        setOp.Do();
+        if (Algorithm.isValue("Exact")) {
+            MeshCore::MeshBoolean boolOp(meshKernel1.getKernel(), meshKernel2.getKernel(),
+                pcKernel->getKernel(), type);
+            boolOp.Do();
+        }
+        else {
+            MeshCore::SetOperations setOp(meshKernel1.getKernel(), meshKernel2.getKernel(), 
+                pcKernel->getKernel(), type, 1.0e-5f);
+            setOp.Do();
+        }
         Mesh.setValuePtr(pcKernel.release());
     }
     else { 
@@ -50,6 +50,7 @@ public:
     App::PropertyLink   Source1;
     App::PropertyLink   Source2;
     App::PropertyString OperationType;
+    App::PropertyEnumeration Algorithm;
 
     /** @name methods overide Feature */
     //@{
@@ -57,6 +58,9 @@ public:
     App::DocumentObjectExecReturn *execute(void);
     short mustExecute() const;
     //@}
+
+private:
+    static const char* AlgorithmEnums[];
 };
 
 }
@@ -38,6 +38,7 @@
 #include <Base/ViewProj.h>
 
 #include "Core/Builder.h"
+#include "Core/Decimation.h"
 #include "Core/MeshKernel.h"
 #include "Core/Grid.h"
 #include "Core/Iterator.h"
@@ -45,8 +46,10 @@
 #include "Core/TopoAlgorithm.h"
 #include "Core/Evaluation.h"
 #include "Core/Degeneration.h"
+#include "Core/BatchEvaluation.h"
 #include "Core/Segmentation.h"
 #include "Core/SetOperations.h"
+#include "Core/Smoothing.h"
 #include "Core/Triangulation.h"
 #include "Core/Trim.h"
 #include "Core/Visitor.h"
@@ -57,27 +60,29 @@
 using namespace Mesh;
 
 float MeshObject::Epsilon = 1.0e-5f;
+bool MeshObject::AlignedBinaryFormat = false;
 
 TYPESYSTEM_SOURCE(Mesh::MeshObject, Data::ComplexGeoData);
 
 MeshObject::MeshObject()
+  : _facetGrid(0), _facetGridRevision(0)
 {
 }
 
 MeshObject::MeshObject(const MeshCore::MeshKernel& Kernel)
-  : _kernel(Kernel)
+  : _kernel(Kernel), _facetGrid(0), _facetGridRevision(0)
 {
     // copy the mesh structure
 }
 
 MeshObject::MeshObject(const MeshCore::MeshKernel& Kernel, const Base::Matrix4D &Mtrx)
-  : _Mtrx(Mtrx),_kernel(Kernel)
+  : _Mtrx(Mtrx),_kernel(Kernel),_facetGrid(0),_facetGridRevision(0)
 {
     // copy the mesh structure
 }
 
 MeshObject::MeshObject(const MeshObject& mesh)
-  : _Mtrx(mesh._Mtrx),_kernel(mesh._kernel)
+  : _Mtrx(mesh._Mtrx),_kernel(mesh._kernel),_facetGrid(0),_facetGridRevision(0)
 {
     // copy the mesh structure
     this->_segments = mesh._segments;
@@ -85,6 +90,28 @@ MeshObject::MeshObject(const MeshObject& mesh)
 
 MeshObject::~MeshObject()
 {
+    delete _facetGrid;
+}
+
+const MeshCore::MeshFacetGrid& MeshObject::getFacetGrid(void) const
+{
+    QMutexLocker locker(&_facetGridMutex);
+    if (_facetGrid && _facetGridRevision != _kernel.GetRevision()) {
+        delete _facetGrid;
+        _facetGrid = 0;
+    }
+    if (!_facetGrid) {
+        _facetGrid = new MeshCore::MeshFacetGrid(_kernel);
+        _facetGridRevision = _kernel.GetRevision();
+    }
+    return *_facetGrid;
+}
+
+void MeshObject::invalidateFacetGrid(void)
+{
+    QMutexLocker locker(&_facetGridMutex);
+    delete _facetGrid;
+    _facetGrid = 0;
 }
 
 std::vector<const char*> MeshObject::getElementTypes(void) const
@@ -128,6 +155,7 @@ void MeshObject::getFacesFromSubelement(const Data::Segment* segm,
 
 void MeshObject::transformGeometry(const Base::Matrix4D &rclMat)
 {
+    invalidateFacetGrid();
     MeshCore::MeshKernel kernel;
     swap(kernel);
     kernel.Transform(rclMat);
@@ -158,6 +186,7 @@ Base::BoundBox3d MeshObject::getBoundBox(void)const
 
 void MeshObject::operator = (const MeshObject& mesh)
 {
+    invalidateFacetGrid();
     if (this != &mesh) {
         // copy the mesh structure
         setTransform(mesh._Mtrx);
@@ -168,12 +197,14 @@ void MeshObject::operator = (const MeshObject& mesh)
 
 void MeshObject::setKernel(const MeshCore::MeshKernel& m)
 {
+    invalidateFacetGrid();
     this->_kernel = m;
     this->_segments.clear();
 }
 
 void MeshObject::swap(MeshCore::MeshKernel& Kernel)
 {
+    invalidateFacetGrid();
     this->_kernel.Swap(Kernel);
     // clear the segments because we don't know how the new
     // topology looks like
@@ -182,6 +213,8 @@ void MeshObject::swap(MeshCore::MeshKernel& Kernel)
 
 void MeshObject::swap(MeshObject& mesh)
 {
+    invalidateFacetGrid();
+    mesh.invalidateFacetGrid();
     this->_kernel.Swap(mesh._kernel);
     this->_segments.swap(mesh._segments);
     Base::Matrix4D tmp=this->_Mtrx;
@@ -289,7 +322,7 @@ void MeshObject::Save (Base::Writer &writer) const
 
 void MeshObject::SaveDocFile (Base::Writer &writer) const
 {
-    _kernel.Write(writer.Stream());
+    save(writer.Stream());
 }
 
 void MeshObject::Restore(Base::XMLReader &reader)
@@ -312,11 +345,25 @@ void MeshObject::save(const char* file, MeshCore::MeshIO::Format f,
 
 void MeshObject::save(std::ostream& out) const
 {
-    _kernel.Write(out);
+    if (AlignedBinaryFormat)
+        _kernel.WriteAligned(out);
+    else
+        _kernel.Write(out);
+}
+
+void MeshObject::setAlignedBinaryFormat(bool on)
+{
+    AlignedBinaryFormat = on;
+}
+
+bool MeshObject::isAlignedBinaryFormat()
+{
+    return AlignedBinaryFormat;
 }
 
 bool MeshObject::load(const char* file, MeshCore::Material* mat)
 {
+    invalidateFacetGrid();
     MeshCore::MeshKernel kernel;
     MeshCore::MeshInput aReader(kernel, mat);
     if (!aReader.LoadAny(file))
@@ -375,6 +422,7 @@ bool MeshObject::load(const char* file, MeshCore::Material* mat)
 
 void MeshObject::load(std::istream& in)
 {
+    invalidateFacetGrid();
     _kernel.Read(in);
     this->_segments.clear();
 
@@ -401,28 +449,33 @@ void MeshObject::load(std::istream& in)
 
 void MeshObject::addFacet(const MeshCore::MeshGeomFacet& facet)
 {
+    invalidateFacetGrid();
     _kernel.AddFacet(facet);
 }
 
 void MeshObject::addFacets(const std::vector<MeshCore::MeshGeomFacet>& facets)
 {
+    invalidateFacetGrid();
     _kernel.AddFacets(facets);
 }
 
 void MeshObject::addFacets(const std::vector<MeshCore::MeshFacet> &facets)
 {
+    invalidateFacetGrid();
     _kernel.AddFacets(facets);
 }
 
 void MeshObject::addFacets(const std::vector<MeshCore::MeshFacet> &facets,
                            const std::vector<Base::Vector3f>& points)
 {
+    invalidateFacetGrid();
     _kernel.AddFacets(facets, points);
 }
 
 void MeshObject::addFacets(const std::vector<Data::ComplexGeoData::Facet> &facets,
                            const std::vector<Base::Vector3d>& points)
 {
+    invalidateFacetGrid();
     std::vector<MeshCore::MeshFacet> facet_v;
     facet_v.reserve(facets.size());
     for (std::vector<Data::ComplexGeoData::Facet>::const_iterator it = facets.begin(); it != facets.end(); ++it) {
@@ -445,12 +498,14 @@ void MeshObject::addFacets(const std::vector<Data::ComplexGeoData::Facet> &facet
 
 void MeshObject::setFacets(const std::vector<MeshCore::MeshGeomFacet>& facets)
 {
+    invalidateFacetGrid();
     _kernel = facets;
 }
 
 void MeshObject::setFacets(const std::vector<Data::ComplexGeoData::Facet> &facets,
                            const std::vector<Base::Vector3d>& points)
 {
+    invalidateFacetGrid();
     MeshCore::MeshFacetArray facet_v;
     facet_v.reserve(facets.size());
     for (std::vector<Data::ComplexGeoData::Facet>::const_iterator it = facets.begin(); it != facets.end(); ++it) {
@@ -473,32 +528,51 @@ void MeshObject::setFacets(const std::vector<Data::ComplexGeoData::Facet> &facet
 
 void MeshObject::addMesh(const MeshObject& mesh)
 {
+    invalidateFacetGrid();
     _kernel.Merge(mesh._kernel);
 }
 
 void MeshObject::addMesh(const MeshCore::MeshKernel& kernel)
 {
+    invalidateFacetGrid();
     _kernel.Merge(kernel);
 }
 
 void MeshObject::deleteFacets(const std::vector<unsigned long>& removeIndices)
 {
+    invalidateFacetGrid();
     _kernel.DeleteFacets(removeIndices);
     deletedFacets(removeIndices);
 }
 
 void MeshObject::deletePoints(const std::vector<unsigned long>& removeIndices)
 {
+    invalidateFacetGrid();
     _kernel.DeletePoints(removeIndices);
     this->_segments.clear();
 }
 
+void MeshObject::beginEdit()
+{
+    _kernel.BeginEdit();
+}
+
+void MeshObject::endEdit()
+{
+    _kernel.EndEdit();
+}
+
 void MeshObject::deletedFacets(const std::vector<unsigned long>& remFacets)
 {
     if (remFacets.empty())
         return; // nothing has changed
     if (this->_segments.empty())
         return; // nothing to do
+    if (_kernel.IsEditing()) {
+        // the removed facets have been replaced by the last ones
+        this->_segments.clear();
+        return;
+    }
     // set an array with the original indices and mark the removed as ULONG_MAX
     std::vector<unsigned long> f_indices(_kernel.CountFacets()+remFacets.size());
     for (std::vector<unsigned long>::const_iterator it = remFacets.begin();
@@ -646,6 +720,7 @@ unsigned long MeshObject::countComponents() const
 
 void MeshObject::removeComponents(unsigned long count)
 {
+    invalidateFacetGrid();
     std::vector<unsigned long> removeIndices;
     MeshCore::MeshTopoAlgorithm(_kernel).FindComponents(count, removeIndices);
     _kernel.DeleteFacets(removeIndices);
@@ -681,13 +756,15 @@ unsigned long MeshObject::getPointDegree(const std::vector<unsigned long>& indic
 void MeshObject::fillupHoles(unsigned long length, int level,
                              MeshCore::AbstractPolygonTriangulator& cTria)
 {
+    invalidateFacetGrid();
     std::list<std::vector<unsigned long> > aFailed;
     MeshCore::MeshTopoAlgorithm topalg(_kernel);
-    topalg.FillupHoles(length, level, cTria, aFailed);
+    topalg.FillupHolesParallel(length, level, cTria, aFailed);
 }
 
 void MeshObject::offset(float fSize)
 {
+    invalidateFacetGrid();
     std::vector<Base::Vector3f> normals = _kernel.CalcVertexNormals();
 
     unsigned int i = 0;
@@ -700,6 +777,7 @@ void MeshObject::offset(float fSize)
 
 void MeshObject::offsetSpecial2(float fSize)
 {
+    invalidateFacetGrid();
     Base::Builder3D builder;  
     std::vector<Base::Vector3f> PointNormals= _kernel.CalcVertexNormals();
     std::vector<Base::Vector3f> FaceNormals;
@@ -754,6 +832,7 @@ void MeshObject::offsetSpecial2(float fSize)
 
 void MeshObject::offsetSpecial(float fSize, float zmax, float zmin)
 {
+    invalidateFacetGrid();
     std::vector<Base::Vector3f> normals = _kernel.CalcVertexNormals();
 
     unsigned int i = 0;
@@ -773,6 +852,7 @@ void MeshObject::offsetSpecial(float fSize, float zmax, float zmin)
 
 void MeshObject::clear(void)
 {
+    invalidateFacetGrid();
     _kernel.Clear();
     this->_segments.clear();
     setTransform(Base::Matrix4D());
@@ -787,6 +867,7 @@ void MeshObject::transformToEigenSystem()
 
 void MeshObject::movePoint(unsigned long index, const Base::Vector3d& v)
 {
+    invalidateFacetGrid();
     // v is a vector, hence we must not apply the translation part
     // of the transformation to the vector
     Base::Vector3d vec(v);
@@ -798,14 +879,22 @@ void MeshObject::movePoint(unsigned long index, const Base::Vector3d& v)
 
 void MeshObject::setPoint(unsigned long index, const Base::Vector3d& p)
 {
+    invalidateFacetGrid();
     _kernel.SetPoint(index,transformToInside(p));
 }
 
 void MeshObject::smooth(int iterations, float d_max)
 {
+    invalidateFacetGrid();
     _kernel.Smooth(iterations, d_max);
 }
 
+void MeshObject::smoothPoints(int iterations, const std::vector<unsigned long>& points)
+{
+    invalidateFacetGrid();
+    MeshCore::LaplaceSmoothing(_kernel).SmoothPoints(iterations, points);
+}
+
 Base::Vector3d MeshObject::getPointNormal(unsigned long index) const
 {
     std::vector<Base::Vector3f> temp = _kernel.CalcVertexNormals();
@@ -823,7 +912,7 @@ Base::Vector3d MeshObject::getPointNormal(unsigned long index) const
 void MeshObject::crossSections(const std::vector<MeshObject::TPlane>& planes, std::vector<MeshObject::TPolylines> &sections,
                                float fMinEps, bool bConnectPolygons) const
 {
-    MeshCore::MeshFacetGrid grid(_kernel);
+    const MeshCore::MeshFacetGrid& grid = getFacetGrid();
     MeshCore::MeshAlgorithm algo(_kernel);
     for (std::vector<MeshObject::TPlane>::const_iterator it = planes.begin(); it != planes.end(); ++it) {
         MeshObject::TPolylines polylines;
@@ -848,7 +937,7 @@ void MeshObject::cut(const Base::Polygon2D& polygon2d,
         break;
     }
 
-    MeshCore::MeshFacetGrid meshGrid(this->_kernel);
+    const MeshCore::MeshFacetGrid& meshGrid = getFacetGrid();
     meshAlg.CheckFacets(meshGrid, &proj, polygon2d, inner, check);
     if (!check.empty())
         this->deleteFacets(check);
@@ -870,13 +959,15 @@ void MeshObject::trim(const Base::Polygon2D& polygon2d,
         break;
     }
 
-    MeshCore::MeshFacetGrid meshGrid(this->_kernel);
+    const MeshCore::MeshFacetGrid& meshGrid = getFacetGrid();
     trim.CheckFacets(meshGrid, check);
     trim.TrimFacets(check, triangle);
     if (!check.empty())
         this->deleteFacets(check);
-    if (!triangle.empty())
+    if (!triangle.empty()) {
+        invalidateFacetGrid();
         this->_kernel.AddFacets(triangle);
+    }
 }
 
 MeshObject* MeshObject::unite(const MeshObject& mesh) const
@@ -946,6 +1037,7 @@ MeshObject* MeshObject::outer(const MeshObject& mesh) const
 
 void MeshObject::refine()
 {
+    invalidateFacetGrid();
     unsigned long cnt = _kernel.CountFacets();
     MeshCore::MeshFacetIterator cF(_kernel);
     MeshCore::MeshTopoAlgorithm topalg(_kernel);
@@ -960,8 +1052,33 @@ void MeshObject::refine()
     this->_segments.clear();
 }
 
+void MeshObject::decimate(float fTolerance, float fReduction)
+{
+    unsigned long count = _kernel.CountFacets();
+    unsigned long target = (unsigned long)(std::max<float>(1.0f - fReduction, 0.0f) * count);
+
+    MeshCore::MeshDecimation dm(_kernel);
+    dm.SetTolerance(fTolerance);
+    dm.SetTargetSize(target);
+    if (dm.Decimate()) {
+        invalidateFacetGrid();
+        this->_segments.clear();
+    }
+}
+
+void MeshObject::decimate(int targetSize)
+{
+    MeshCore::MeshDecimation dm(_kernel);
+    dm.SetTargetSize((unsigned long)std::max<int>(targetSize, 0));
+    if (dm.Decimate()) {
+        invalidateFacetGrid();
+        this->_segments.clear();
+    }
+}
+
 void MeshObject::optimizeTopology(float fMaxAngle)
 {
+    invalidateFacetGrid();
     MeshCore::MeshTopoAlgorithm topalg(_kernel);
     if (fMaxAngle > 0.0f)
         topalg.OptimizeTopology(fMaxAngle);
@@ -975,12 +1092,14 @@ void MeshObject::optimizeTopology(float fMaxAngle)
 
 void MeshObject::optimizeEdges()
 {
+    invalidateFacetGrid();
     MeshCore::MeshTopoAlgorithm topalg(_kernel);
     topalg.AdjustEdgesToCurvatureDirection();
 }
 
 void MeshObject::splitEdges()
 {
+    invalidateFacetGrid();
     std::vector<std::pair<unsigned long, unsigned long> > adjacentFacet;
     MeshCore::MeshAlgorithm alg(_kernel);
     alg.ResetFacetFlag(MeshCore::MeshFacet::VISIT);
@@ -1012,24 +1131,28 @@ void MeshObject::splitEdges()
 
 void MeshObject::splitEdge(unsigned long facet, unsigned long neighbour, const Base::Vector3f& v)
 {
+    invalidateFacetGrid();
     MeshCore::MeshTopoAlgorithm topalg(_kernel);
     topalg.SplitEdge(facet, neighbour, v);
 }
 
 void MeshObject::splitFacet(unsigned long facet, const Base::Vector3f& v1, const Base::Vector3f& v2)
 {
+    invalidateFacetGrid();
     MeshCore::MeshTopoAlgorithm topalg(_kernel);
     topalg.SplitFacet(facet, v1, v2);
 }
 
 void MeshObject::swapEdge(unsigned long facet, unsigned long neighbour)
 {
+    invalidateFacetGrid();
     MeshCore::MeshTopoAlgorithm topalg(_kernel);
     topalg.SwapEdge(facet, neighbour);
 }
 
 void MeshObject::collapseEdge(unsigned long facet, unsigned long neighbour)
 {
+    invalidateFacetGrid();
     MeshCore::MeshTopoAlgorithm topalg(_kernel);
     topalg.CollapseEdge(facet, neighbour);
 
@@ -1041,6 +1164,7 @@ void MeshObject::collapseEdge(unsigned long facet, unsigned long neighbour)
 
 void MeshObject::collapseFacet(unsigned long facet)
 {
+    invalidateFacetGrid();
     MeshCore::MeshTopoAlgorithm topalg(_kernel);
     topalg.CollapseFacet(facet);
 
@@ -1051,6 +1175,7 @@ void MeshObject::collapseFacet(unsigned long facet)
 
 void MeshObject::collapseFacets(const std::vector<unsigned long>& facets)
 {
+    invalidateFacetGrid();
     MeshCore::MeshTopoAlgorithm alg(_kernel);
     for (std::vector<unsigned long>::const_iterator it = facets.begin(); it != facets.end(); ++it) {
         alg.CollapseFacet(*it);
@@ -1061,12 +1186,14 @@ void MeshObject::collapseFacets(const std::vector<unsigned long>& facets)
 
 void MeshObject::insertVertex(unsigned long facet, const Base::Vector3f& v)
 {
+    invalidateFacetGrid();
     MeshCore::MeshTopoAlgorithm topalg(_kernel);
     topalg.InsertVertex(facet, v);
 }
 
 void MeshObject::snapVertex(unsigned long facet, const Base::Vector3f& v)
 {
+    invalidateFacetGrid();
     MeshCore::MeshTopoAlgorithm topalg(_kernel);
     topalg.SnapVertex(facet, v);
 }
@@ -1098,6 +1225,7 @@ bool MeshObject::hasNonManifolds() const
 
 void MeshObject::removeNonManifolds()
 {
+    invalidateFacetGrid();
     MeshCore::MeshEvalTopology f_eval(_kernel);
     if (!f_eval.Evaluate()) {
         MeshCore::MeshFixTopology f_fix(_kernel, f_eval.GetFacets());
@@ -1120,6 +1248,7 @@ bool MeshObject::hasSelfIntersections() const
 
 void MeshObject::removeSelfIntersections()
 {
+    invalidateFacetGrid();
     std::vector<std::pair<unsigned long, unsigned long> > selfIntersections;
     MeshCore::MeshEvalSelfIntersection cMeshEval(_kernel);
     cMeshEval.GetIntersections(selfIntersections);
@@ -1133,6 +1262,7 @@ void MeshObject::removeSelfIntersections()
 
 void MeshObject::removeSelfIntersections(const std::vector<unsigned long>& indices)
 {
+    invalidateFacetGrid();
     // make sure that the number of indices is even and are in range
     if (indices.size() % 2 != 0)
         return;
@@ -1157,6 +1287,7 @@ void MeshObject::removeSelfIntersections(const std::vector<unsigned long>& indic
 
 void MeshObject::removeFoldsOnSurface()
 {
+    invalidateFacetGrid();
     std::vector<unsigned long> indices;
     MeshCore::MeshEvalFoldsOnSurface s_eval(_kernel);
     MeshCore::MeshEvalFoldOversOnSurface f_eval(_kernel);
@@ -1188,6 +1319,7 @@ void MeshObject::removeFoldsOnSurface()
 
 void MeshObject::removeFullBoundaryFacets()
 {
+    invalidateFacetGrid();
     std::vector<unsigned long> facets;
     if (!MeshCore::MeshEvalBorderFacet(_kernel, facets).Evaluate()) {
         deleteFacets(facets);
@@ -1196,12 +1328,14 @@ void MeshObject::removeFullBoundaryFacets()
 
 void MeshObject::removeInvalidPoints()
 {
+    invalidateFacetGrid();
     MeshCore::MeshEvalNaNPoints nan(_kernel);
     deletePoints(nan.GetIndices());
 }
 
 void MeshObject::validateIndices()
 {
+    invalidateFacetGrid();
     unsigned long count = _kernel.CountFacets();
 
     // for invalid neighbour indices we don't need to check first
@@ -1233,6 +1367,7 @@ void MeshObject::validateIndices()
 
 void MeshObject::validateDeformations(float fMaxAngle)
 {
+    invalidateFacetGrid();
     unsigned long count = _kernel.CountFacets();
     MeshCore::MeshFixDeformedFacets eval(_kernel, fMaxAngle);
     eval.Fixup();
@@ -1242,6 +1377,7 @@ void MeshObject::validateDeformations(float fMaxAngle)
 
 void MeshObject::validateDegenerations()
 {
+    invalidateFacetGrid();
     unsigned long count = _kernel.CountFacets();
     MeshCore::MeshFixDegeneratedFacets eval(_kernel);
     eval.Fixup();
@@ -1251,6 +1387,7 @@ void MeshObject::validateDegenerations()
 
 void MeshObject::removeDuplicatedPoints()
 {
+    invalidateFacetGrid();
     unsigned long count = _kernel.CountFacets();
     MeshCore::MeshFixDuplicatePoints eval(_kernel);
     eval.Fixup();
@@ -1260,6 +1397,7 @@ void MeshObject::removeDuplicatedPoints()
 
 void MeshObject::removeDuplicatedFacets()
 {
+    invalidateFacetGrid();
     unsigned long count = _kernel.CountFacets();
     MeshCore::MeshFixDuplicateFacets eval(_kernel);
     eval.Fixup();
@@ -1267,6 +1405,28 @@ void MeshObject::removeDuplicatedFacets()
         this->_segments.clear();
 }
 
+void MeshObject::analyze(MeshCore::MeshDefectReport& report, int checks) const
+{
+    MeshCore::MeshEvalBatch eval(_kernel, checks);
+    eval.Evaluate();
+    report = eval.GetReport();
+}
+
+bool MeshObject::repair(int checks, float fMaxAngle)
+{
+    invalidateFacetGrid();
+    unsigned long count = _kernel.CountFacets();
+    MeshCore::MeshEvalBatch eval(_kernel, checks);
+    bool ok = true;
+    if (!eval.Evaluate()) {
+        MeshCore::MeshFixBatch fix(_kernel, eval.GetReport(), fMaxAngle);
+        ok = fix.Fixup();
+    }
+    if (_kernel.CountFacets() < count)
+        this->_segments.clear();
+    return ok;
+}
+
 MeshObject* MeshObject::createMeshFromList(Py::List& list)
 {
     std::vector<MeshCore::MeshGeomFacet> facets;
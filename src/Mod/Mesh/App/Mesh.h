@@ -30,6 +30,8 @@
 #include <string>
 #include <map>
 
+#include <QMutex>
+
 #include <Base/Matrix.h>
 #include <Base/Vector3D.h>
 
@@ -56,6 +58,8 @@ namespace Base {
 
 namespace MeshCore {
 class AbstractPolygonTriangulator;
+class MeshFacetGrid;
+struct MeshDefectReport;
 }
 
 namespace Mesh
@@ -133,10 +137,18 @@ public:
     //@}
 
     void setKernel(const MeshCore::MeshKernel& m);
+    /** Gives write access to the kernel. The cached facet grid is rebuilt
+     * as soon as the revision of the kernel has changed.
+     */
     MeshCore::MeshKernel& getKernel(void)
     { return _kernel; }
     const MeshCore::MeshKernel& getKernel(void) const
     { return _kernel; }
+    /** Returns a facet grid of the kernel. The grid is built on demand and
+     * reused by all further calls as long as the revision of the kernel
+     * doesn't change. It may be called from several threads at the same time.
+     */
+    const MeshCore::MeshFacetGrid& getFacetGrid(void) const;
 
     virtual Base::BoundBox3d getBoundBox(void)const;
 
@@ -153,6 +165,11 @@ public:
     void save(std::ostream&) const;
     bool load(const char* file, MeshCore::Material* mat = 0);
     void load(std::istream&);
+    /** Sets whether meshes are saved to documents in the aligned binary
+     * format instead of the one that older versions can read.
+     */
+    static void setAlignedBinaryFormat(bool);
+    static bool isAlignedBinaryFormat();
     //@}
 
     /** @name Manipulation */
@@ -181,6 +198,14 @@ public:
     void addMesh(const MeshCore::MeshKernel&);
     void deleteFacets(const std::vector<unsigned long>& removeIndices);
     void deletePoints(const std::vector<unsigned long>& removeIndices);
+    /**
+     * Speeds up many small additions and removals of facets until endEdit()
+     * is called. While editing the removed facets and points are replaced by
+     * the last ones, so the segments get lost.
+     * @see MeshCore::MeshKernel::BeginEdit()
+     */
+    void beginEdit();
+    void endEdit();
     std::vector<std::vector<unsigned long> > getComponents() const;
     unsigned long countComponents() const;
     void removeComponents(unsigned long);
@@ -202,6 +227,8 @@ public:
     void movePoint(unsigned long, const Base::Vector3d& v);
     void setPoint(unsigned long, const Base::Vector3d& v);
     void smooth(int iterations, float d_max);
+    /** Smoothes only the given points, the other points keep their position. */
+    void smoothPoints(int iterations, const std::vector<unsigned long>& points);
     Base::Vector3d getPointNormal(unsigned long) const;
     void crossSections(const std::vector<TPlane>&, std::vector<TPolylines> &sections,
                        float fMinEps = 1.0e-2f, bool bConnectPolygons = false) const;
@@ -237,6 +264,11 @@ public:
     /** @name Topological operations */
     //@{
     void refine();
+    /** Reduces the number of facets by \a fReduction (0..1) as long as the
+     * deviation stays below \a fTolerance. */
+    void decimate(float fTolerance, float fReduction);
+    /** Reduces the mesh to \a targetSize facets. */
+    void decimate(int targetSize);
     void optimizeTopology(float);
     void optimizeEdges();
     void splitEdges();
@@ -268,6 +300,14 @@ public:
     void removeFoldsOnSurface();
     void removeFullBoundaryFacets();
     void removeInvalidPoints();
+    /** Runs the checks \a checks (a combination of MeshCore::MeshEvalBatch::Check)
+     * in one batch and writes the found defects to \a report.
+     */
+    void analyze(MeshCore::MeshDefectReport& report, int checks) const;
+    /** Runs the checks \a checks in one batch and repairs the found defects.
+     * Returns false if the mesh has defects that cannot be repaired.
+     */
+    bool repair(int checks, float fMaxAngle);
     //@}
 
     /** @name Mesh segments */
@@ -361,12 +401,17 @@ private:
     void deletedFacets(const std::vector<unsigned long>& remFacets);
     void updateMesh(const std::vector<unsigned long>&);
     void updateMesh();
+    void invalidateFacetGrid(void);
 
 private:
     Base::Matrix4D _Mtrx;
     MeshCore::MeshKernel _kernel;
     std::vector<Segment> _segments;
+    mutable MeshCore::MeshFacetGrid* _facetGrid;
+    mutable unsigned long _facetGridRevision;
+    mutable QMutex _facetGridMutex;
     static float Epsilon;
+    static bool AlignedBinaryFormat;
 };
 
 } // namespace Mesh
@@ -161,6 +161,11 @@ void PropertyNormalList::SaveDocFile (Base::Writer &writer) const
     }
 }
 
+bool PropertyNormalList::isSaveDocFileThreadSafe (void) const
+{
+    return true;
+}
+
 void PropertyNormalList::RestoreDocFile(Base::Reader &reader)
 {
     Base::InputStream str(reader);
@@ -252,6 +257,17 @@ void PropertyCurvatureList::setValues(const std::vector<CurvatureInfo>& lValues)
     hasSetValue();
 }
 
+std::vector<CurvatureInfo>& PropertyCurvatureList::startEditing()
+{
+    aboutToSetValue();
+    return _lValueList;
+}
+
+void PropertyCurvatureList::finishEditing()
+{
+    hasSetValue();
+}
+
 std::vector<float> PropertyCurvatureList::getCurvature( int mode ) const
 {
     const std::vector<Mesh::CurvatureInfo>& fCurvInfo = getValues();
@@ -367,6 +383,11 @@ void PropertyCurvatureList::SaveDocFile (Base::Writer &writer) const
     }
 }
 
+bool PropertyCurvatureList::isSaveDocFileThreadSafe (void) const
+{
+    return true;
+}
+
 void PropertyCurvatureList::RestoreDocFile(Base::Reader &reader)
 {
     Base::InputStream str(reader);
@@ -624,6 +645,11 @@ void PropertyMeshKernel::SaveDocFile (Base::Writer &writer) const
     _meshObject->save(writer.Stream());
 }
 
+bool PropertyMeshKernel::isSaveDocFileThreadSafe (void) const
+{
+    return true;
+}
+
 void PropertyMeshKernel::RestoreDocFile(Base::Reader &reader)
 {
     aboutToSetValue();
@@ -38,6 +38,7 @@
 #include <App/PropertyGeo.h>
 
 #include "Core/MeshKernel.h"
+#include "Core/Curvature.h"
 #include "Mesh.h"
 
 
@@ -85,6 +86,7 @@ public:
     virtual void Restore(Base::XMLReader &reader);
 
     virtual void SaveDocFile (Base::Writer &writer) const;
+    virtual bool isSaveDocFileThreadSafe (void) const;
     virtual void RestoreDocFile(Base::Reader &reader);
 
     virtual App::Property *Copy(void) const;
@@ -98,12 +100,10 @@ private:
     std::vector<Base::Vector3f> _lValueList;
 };
 
-/** Curvature information. */
-struct MeshExport CurvatureInfo
-{
-    float fMaxCurvature, fMinCurvature;
-    Base::Vector3f cMaxCurvDir, cMinCurvDir;
-};
+/** Curvature information. It's the same type as used by the curvature algorithms
+ * so that they can write into the property directly.
+ */
+typedef MeshCore::CurvatureInfo CurvatureInfo;
 
 /** The Curvature property class.
  * @author Werner Mayer
@@ -137,10 +137,18 @@ public:
     const std::vector<CurvatureInfo> &getValues(void) const{return _lValueList;}
     void transform(const Base::Matrix4D &rclMat);
 
+    /** @name Modification */
+    //@{
+    /** Gives write access to the values, call finishEditing() afterwards. */
+    std::vector<CurvatureInfo>& startEditing();
+    void finishEditing();
+    //@}
+
     void Save (Base::Writer &writer) const;
     void Restore(Base::XMLReader &reader);
 
     void SaveDocFile (Base::Writer &writer) const;
+    bool isSaveDocFileThreadSafe (void) const;
     void RestoreDocFile(Base::Reader &reader);
 
     /** @name Python interface */
@@ -239,6 +247,7 @@ public:
     void Restore(Base::XMLReader &reader);
 
     void SaveDocFile (Base::Writer &writer) const;
+    bool isSaveDocFileThreadSafe (void) const;
     void RestoreDocFile(Base::Reader &reader);
 
     App::Property *Copy(void) const;
@@ -38,15 +38,57 @@
 #include "Core/Triangulation.h"
 #include "Core/Iterator.h"
 #include "Core/Degeneration.h"
+#include "Core/BatchEvaluation.h"
 #include "Core/Elements.h"
 #include "Core/Grid.h"
+#include "Core/BVH.h"
 #include "Core/MeshKernel.h"
 #include "Core/Segmentation.h"
 #include "Core/Curvature.h"
+#include "Core/LevelOfDetail.h"
 
 using namespace Mesh;
 
 
+namespace {
+std::vector<Base::Vector3f> getVectors(PyObject* seq)
+{
+    Py::Sequence list(seq);
+    std::vector<Base::Vector3f> vecs;
+    vecs.reserve(list.size());
+    for (Py::Sequence::iterator it = list.begin(); it != list.end(); ++it) {
+        Py::Tuple t(*it);
+        vecs.push_back(Base::Vector3f((float)Py::Float(t.getItem(0)),
+                                      (float)Py::Float(t.getItem(1)),
+                                      (float)Py::Float(t.getItem(2))));
+    }
+    return vecs;
+}
+
+Py::Object makeFacetPoint(unsigned long index, const Base::Vector3f& pnt)
+{
+    if (index == ULONG_MAX)
+        return Py::None();
+    Py::Tuple point(3);
+    point.setItem(0, Py::Float(pnt.x));
+    point.setItem(1, Py::Float(pnt.y));
+    point.setItem(2, Py::Float(pnt.z));
+    Py::Tuple tuple(2);
+    tuple.setItem(0, Py::Int((long)index));
+    tuple.setItem(1, point);
+    return tuple;
+}
+
+template <class Table>
+unsigned long countEntries(const Table& table, unsigned long count)
+{
+    unsigned long entries = 0;
+    for (unsigned long i = 0; i < count; i++)
+        entries += (unsigned long)table[i].size();
+    return entries;
+}
+}
+
 struct MeshPropertyLock {
     MeshPropertyLock(PropertyMeshKernel* p) : prop(p)
     { if (prop) prop->startEditing(); }
@@ -149,7 +191,8 @@ PyObject*  MeshPy::write(PyObject *args)
 {
     const char* Name;
     char* Ext=0;
-    if (!PyArg_ParseTuple(args, "s|s",&Name,&Ext))
+    PyObject* List=0;
+    if (!PyArg_ParseTuple(args, "s|sO!",&Name,&Ext,&PyList_Type,&List))
         return NULL;
 
     MeshCore::MeshIO::Format format = MeshCore::MeshIO::Undefined;
@@ -173,8 +216,31 @@ PyObject*  MeshPy::write(PyObject *args)
             format = ext[Ext];
     };
 
+    // optional colors per point or per facet
+    MeshCore::Material mat;
+    if (List) {
+        try {
+            Py::List list(List);
+            for (Py::List::iterator it = list.begin(); it != list.end(); ++it) {
+                Py::Tuple t(*it);
+                float r = (float)Py::Float(t.getItem(0));
+                float g = (float)Py::Float(t.getItem(1));
+                float b = (float)Py::Float(t.getItem(2));
+                mat.diffuseColor.push_back(App::Color(r,g,b));
+            }
+        }
+        catch (const Py::Exception&) {
+            return 0;
+        }
+
+        if (mat.diffuseColor.size() == getMeshObjectPtr()->countPoints())
+            mat.binding = MeshCore::MeshIO::PER_VERTEX;
+        else if (mat.diffuseColor.size() == getMeshObjectPtr()->countFacets())
+            mat.binding = MeshCore::MeshIO::PER_FACE;
+    }
+
     PY_TRY {
-        getMeshObjectPtr()->save(Name, format);
+        getMeshObjectPtr()->save(Name, format, &mat);
     } PY_CATCH;
     
     Py_Return; 
@@ -621,6 +687,24 @@ PyObject* MeshPy::rebuildNeighbourHood(PyObject *args)
     Py_Return;
 }
 
+PyObject* MeshPy::beginEdit(PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ""))
+        return 0;
+
+    getMeshObjectPtr()->beginEdit();
+    Py_Return;
+}
+
+PyObject* MeshPy::endEdit(PyObject *args)
+{
+    if (!PyArg_ParseTuple(args, ""))
+        return 0;
+
+    getMeshObjectPtr()->endEdit();
+    Py_Return;
+}
+
 PyObject*  MeshPy::addMesh(PyObject *args)
 {
     PyObject* mesh;
@@ -775,9 +859,17 @@ PyObject*  MeshPy::removeNonManifolds(PyObject *args)
 
 PyObject*  MeshPy::hasSelfIntersections(PyObject *args)
 {
-    if (!PyArg_ParseTuple(args, ""))
+    PyObject* grid = Py_False;
+    if (!PyArg_ParseTuple(args, "|O!", &PyBool_Type, &grid))
         return NULL;
-    bool ok = getMeshObjectPtr()->hasSelfIntersections();
+    bool ok;
+    if (PyObject_IsTrue(grid)) {
+        MeshCore::MeshEvalSelfIntersection eval(getMeshObjectPtr()->getKernel());
+        ok = !eval.EvaluateByGrid();
+    }
+    else {
+        ok = getMeshObjectPtr()->hasSelfIntersections();
+    }
     return Py_BuildValue("O", (ok ? Py_True : Py_False)); 
 }
 
@@ -965,6 +1057,136 @@ PyObject*  MeshPy::removeDuplicatedFacets(PyObject *args)
     Py_Return; 
 }
 
+namespace Mesh {
+static const struct {
+    const char* name;
+    int check;
+} BatchChecks[] = {
+    {"Invalids", MeshCore::MeshEvalBatch::Invalids},
+    {"NaNPoints", MeshCore::MeshEvalBatch::NaNPoints},
+    {"RangePoints", MeshCore::MeshEvalBatch::RangePoints},
+    {"RangeFacets", MeshCore::MeshEvalBatch::RangeFacets},
+    {"CorruptedFacets", MeshCore::MeshEvalBatch::CorruptedFacets},
+    {"DegeneratedFacets", MeshCore::MeshEvalBatch::DegeneratedFacets},
+    {"DeformedFacets", MeshCore::MeshEvalBatch::DeformedFacets},
+    {"DuplicatedPoints", MeshCore::MeshEvalBatch::DuplicatedPoints},
+    {"DuplicatedFacets", MeshCore::MeshEvalBatch::DuplicatedFacets},
+    {"Neighbourhood", MeshCore::MeshEvalBatch::Neighbourhood},
+    {"NonManifolds", MeshCore::MeshEvalBatch::NonManifolds},
+    {"SelfIntersections", MeshCore::MeshEvalBatch::SelfIntersections}
+};
+
+// returns -1 and sets the Python error if a name is unknown
+static int getBatchChecks(PyObject* names)
+{
+    if (!names)
+        return MeshCore::MeshEvalBatch::Defaults;
+    int checks = 0;
+    Py::Sequence list(names);
+    for (Py::Sequence::iterator it = list.begin(); it != list.end(); ++it) {
+        std::string name = (std::string)Py::String(*it);
+        int i;
+        int count = sizeof(BatchChecks)/sizeof(BatchChecks[0]);
+        for (i = 0; i < count; i++) {
+            if (name == BatchChecks[i].name) {
+                checks |= BatchChecks[i].check;
+                break;
+            }
+        }
+        if (i == count) {
+            PyErr_Format(PyExc_ValueError, "unknown check '%s'", name.c_str());
+            return -1;
+        }
+    }
+    return checks;
+}
+
+static Py::List indicesToList(const std::vector<unsigned long>& inds)
+{
+    Py::List ary;
+    for (std::vector<unsigned long>::const_iterator it = inds.begin(); it != inds.end(); ++it)
+        ary.append(Py::Int((int)*it));
+    return ary;
+}
+
+static Py::List pairsToList(const std::vector<std::pair<unsigned long, unsigned long> >& inds)
+{
+    Py::List ary;
+    for (std::vector<std::pair<unsigned long, unsigned long> >::const_iterator it = inds.begin(); it != inds.end(); ++it) {
+        Py::Tuple pair(2);
+        pair.setItem(0, Py::Int((int)it->first));
+        pair.setItem(1, Py::Int((int)it->second));
+        ary.append(pair);
+    }
+    return ary;
+}
+}
+
+PyObject*  MeshPy::analyze(PyObject *args)
+{
+    PyObject* names = 0;
+    if (!PyArg_ParseTuple(args, "|O!", &PyList_Type, &names))
+        return NULL;
+
+    int checks = getBatchChecks(names);
+    if (checks < 0)
+        return NULL;
+
+    MeshCore::MeshDefectReport report;
+    PY_TRY {
+        getMeshObjectPtr()->analyze(report, checks);
+    } PY_CATCH;
+
+    Py::Dict dict;
+    if (checks & MeshCore::MeshEvalBatch::Invalids) {
+        dict.setItem("InvalidPoints", indicesToList(report.invalidPoints));
+        dict.setItem("InvalidFacets", indicesToList(report.invalidFacets));
+    }
+    if (checks & MeshCore::MeshEvalBatch::NaNPoints)
+        dict.setItem("NaNPoints", indicesToList(report.nanPoints));
+    if (checks & MeshCore::MeshEvalBatch::RangePoints)
+        dict.setItem("RangePoints", indicesToList(report.rangePoints));
+    if (checks & MeshCore::MeshEvalBatch::RangeFacets)
+        dict.setItem("RangeFacets", indicesToList(report.rangeFacets));
+    if (checks & MeshCore::MeshEvalBatch::CorruptedFacets)
+        dict.setItem("CorruptedFacets", indicesToList(report.corruptedFacets));
+    if (checks & MeshCore::MeshEvalBatch::DegeneratedFacets)
+        dict.setItem("DegeneratedFacets", indicesToList(report.degeneratedFacets));
+    if (checks & MeshCore::MeshEvalBatch::DeformedFacets)
+        dict.setItem("DeformedFacets", indicesToList(report.deformedFacets));
+    if (checks & MeshCore::MeshEvalBatch::DuplicatedPoints)
+        dict.setItem("DuplicatedPoints", indicesToList(report.duplicatedPoints));
+    if (checks & MeshCore::MeshEvalBatch::DuplicatedFacets)
+        dict.setItem("DuplicatedFacets", indicesToList(report.duplicatedFacets));
+    if (checks & MeshCore::MeshEvalBatch::Neighbourhood)
+        dict.setItem("Neighbourhood", indicesToList(report.neighbourhood));
+    if (checks & MeshCore::MeshEvalBatch::NonManifolds)
+        dict.setItem("NonManifolds", pairsToList(report.nonManifolds));
+    if (checks & MeshCore::MeshEvalBatch::SelfIntersections)
+        dict.setItem("SelfIntersections", pairsToList(report.selfIntersections));
+
+    return Py::new_reference_to(dict);
+}
+
+PyObject*  MeshPy::repair(PyObject *args)
+{
+    PyObject* names = 0;
+    float fMaxAngle = 0.1f;
+    if (!PyArg_ParseTuple(args, "|O!f", &PyList_Type, &names, &fMaxAngle))
+        return NULL;
+
+    int checks = getBatchChecks(names);
+    if (checks < 0)
+        return NULL;
+
+    bool ok = false;
+    PY_TRY {
+        ok = getMeshObjectPtr()->repair(checks, fMaxAngle);
+    } PY_CATCH;
+
+    return Py_BuildValue("O", (ok ? Py_True : Py_False)); 
+}
+
 PyObject*  MeshPy::refine(PyObject *args)
 {
     if (!PyArg_ParseTuple(args, ""))
@@ -977,6 +1199,33 @@ PyObject*  MeshPy::refine(PyObject *args)
     Py_Return; 
 }
 
+PyObject*  MeshPy::decimate(PyObject *args)
+{
+    float fTol, fRed;
+    if (PyArg_ParseTuple(args, "ff", &fTol, &fRed)) {
+        PY_TRY {
+            MeshPropertyLock lock(this->parentProperty);
+            getMeshObjectPtr()->decimate(fTol, fRed);
+        } PY_CATCH;
+
+        Py_Return;
+    }
+
+    PyErr_Clear();
+    int targetSize;
+    if (PyArg_ParseTuple(args, "i", &targetSize)) {
+        PY_TRY {
+            MeshPropertyLock lock(this->parentProperty);
+            getMeshObjectPtr()->decimate(targetSize);
+        } PY_CATCH;
+
+        Py_Return;
+    }
+
+    PyErr_SetString(PyExc_TypeError, "decimate(tolerance, reduction) or decimate(targetSize)");
+    return 0;
+}
+
 PyObject*  MeshPy::optimizeTopology(PyObject *args)
 {
     float fMaxAngle=-1.0f;
@@ -1352,12 +1601,24 @@ PyObject*  MeshPy::smooth(PyObject *args)
 {
     int iter=1;
     float d_max=FLOAT_MAX;
-    if (!PyArg_ParseTuple(args, "|if", &iter,&d_max))
+    PyObject* pts=0;
+    if (!PyArg_ParseTuple(args, "|ifO", &iter,&d_max,&pts))
         return NULL;
 
     PY_TRY {
         MeshPropertyLock lock(this->parentProperty);
-        getMeshObjectPtr()->smooth(iter, d_max);
+        if (pts) {
+            std::vector<unsigned long> indices;
+            Py::Sequence ary(pts);
+            for (Py::Sequence::iterator it = ary.begin(); it != ary.end(); ++it) {
+                Py::Int p(*it);
+                indices.push_back((long)p);
+            }
+            getMeshObjectPtr()->smoothPoints(iter, indices);
+        }
+        else {
+            getMeshObjectPtr()->smooth(iter, d_max);
+        }
     } PY_CATCH;
 
     Py_Return; 
@@ -1426,6 +1687,127 @@ PyObject* MeshPy::nearestFacetOnRay(PyObject *args)
     }
 }
 
+PyObject* MeshPy::nearestFacetsOnRays(PyObject *args)
+{
+    PyObject* pnt_p;
+    PyObject* dir_p;
+    PyObject* grid = Py_False;
+    if (!PyArg_ParseTuple(args, "OO|O!", &pnt_p, &dir_p, &PyBool_Type, &grid))
+        return NULL;
+
+    try {
+        std::vector<Base::Vector3f> pnts = getVectors(pnt_p);
+        std::vector<Base::Vector3f> dirs = getVectors(dir_p);
+        if (pnts.size() != dirs.size()) {
+            PyErr_SetString(PyExc_ValueError, "Number of points and directions differ");
+            return NULL;
+        }
+
+        const MeshCore::MeshKernel& kernel = getMeshObjectPtr()->getKernel();
+        std::vector<Base::Vector3f> res;
+        std::vector<unsigned long> facets;
+        if (PyObject_IsTrue(grid)) {
+            MeshCore::MeshAlgorithm alg(kernel);
+            const MeshCore::MeshFacetGrid& meshGrid = getMeshObjectPtr()->getFacetGrid();
+            res.resize(pnts.size());
+            facets.resize(pnts.size(), ULONG_MAX);
+            for (std::size_t i = 0; i < pnts.size(); i++) {
+                if (!alg.NearestFacetOnRay(pnts[i], dirs[i], meshGrid, res[i], facets[i]))
+                    facets[i] = ULONG_MAX;
+            }
+        }
+        else {
+            MeshCore::MeshFacetBVH bvh(kernel);
+            bvh.NearestFacetsOnRays(pnts, dirs, res, facets);
+        }
+
+        Py::List list;
+        for (std::size_t i = 0; i < facets.size(); i++)
+            list.append(makeFacetPoint(facets[i], res[i]));
+        return Py::new_reference_to(list);
+    }
+    catch (const Py::Exception&) {
+        return 0;
+    }
+}
+
+PyObject* MeshPy::nearestFacetsToPoints(PyObject *args)
+{
+    PyObject* pnt_p;
+    PyObject* grid = Py_False;
+    if (!PyArg_ParseTuple(args, "O|O!", &pnt_p, &PyBool_Type, &grid))
+        return NULL;
+
+    try {
+        std::vector<Base::Vector3f> pnts = getVectors(pnt_p);
+
+        const MeshCore::MeshKernel& kernel = getMeshObjectPtr()->getKernel();
+        std::vector<Base::Vector3f> res;
+        std::vector<unsigned long> facets;
+        if (PyObject_IsTrue(grid)) {
+            MeshCore::MeshAlgorithm alg(kernel);
+            const MeshCore::MeshFacetGrid& meshGrid = getMeshObjectPtr()->getFacetGrid();
+            res.resize(pnts.size());
+            facets.resize(pnts.size(), ULONG_MAX);
+            for (std::size_t i = 0; i < pnts.size(); i++) {
+                if (!alg.NearestPointFromPoint(pnts[i], meshGrid, facets[i], res[i]))
+                    facets[i] = ULONG_MAX;
+            }
+        }
+        else {
+            MeshCore::MeshFacetBVH bvh(kernel);
+            bvh.NearestPointsFromPoints(pnts, FLOAT_MAX, facets, res);
+        }
+
+        Py::List list;
+        for (std::size_t i = 0; i < facets.size(); i++)
+            list.append(makeFacetPoint(facets[i], res[i]));
+        return Py::new_reference_to(list);
+    }
+    catch (const Py::Exception&) {
+        return 0;
+    }
+}
+
+PyObject* MeshPy::countNeighbours(PyObject *args)
+{
+    char* type;
+    PyObject* compact = Py_True;
+    if (!PyArg_ParseTuple(args, "s|O!", &type, &PyBool_Type, &compact))
+        return NULL;
+
+    const MeshCore::MeshKernel& kernel = getMeshObjectPtr()->getKernel();
+    bool useCompact = PyObject_IsTrue(compact) ? true : false;
+    std::string name = type;
+    unsigned long entries = 0;
+    PY_TRY {
+        if (name == "PointToFacets") {
+            if (useCompact)
+                entries = countEntries(MeshCore::MeshCompactPointToFacets(kernel), kernel.CountPoints());
+            else
+                entries = countEntries(MeshCore::MeshRefPointToFacets(kernel), kernel.CountPoints());
+        }
+        else if (name == "FacetToFacets") {
+            if (useCompact)
+                entries = countEntries(MeshCore::MeshCompactFacetToFacets(kernel), kernel.CountFacets());
+            else
+                entries = countEntries(MeshCore::MeshRefFacetToFacets(kernel), kernel.CountFacets());
+        }
+        else if (name == "PointToPoints") {
+            if (useCompact)
+                entries = countEntries(MeshCore::MeshCompactPointToPoints(kernel), kernel.CountPoints());
+            else
+                entries = countEntries(MeshCore::MeshRefPointToPoints(kernel), kernel.CountPoints());
+        }
+        else {
+            PyErr_Format(PyExc_ValueError, "unknown neighbourhood '%s'", type);
+            return NULL;
+        }
+    } PY_CATCH;
+
+    return Py_BuildValue("k", entries);
+}
+
 PyObject*  MeshPy::getPlanarSegments(PyObject *args)
 {
     float dev;
@@ -1453,7 +1835,8 @@ PyObject*  MeshPy::getPlanarSegments(PyObject *args)
 PyObject*  MeshPy::getSegmentsByCurvature(PyObject *args)
 {
     PyObject* l;
-    if (!PyArg_ParseTuple(args, "O",&l))
+    PyObject* parallel = Py_True;
+    if (!PyArg_ParseTuple(args, "O|O!",&l, &PyBool_Type, &parallel))
         return NULL;
 
     const MeshCore::MeshKernel& kernel = getMeshObjectPtr()->getKernel();
@@ -1473,7 +1856,10 @@ PyObject*  MeshPy::getSegmentsByCurvature(PyObject *args)
         segm.push_back(new MeshCore::MeshCurvatureFreeformSegment(meshCurv.GetCurvature(), num, tol1, tol2, c1, c2));
     }
 
-    finder.FindSegments(segm);
+    if (PyObject_IsTrue(parallel))
+        finder.FindSegmentsParallel(segm);
+    else
+        finder.FindSegments(segm);
 
     Py::List list;
     for (std::vector<MeshCore::MeshSurfaceSegment*>::iterator segmIt = segm.begin(); segmIt != segm.end(); ++segmIt) {
@@ -1491,6 +1877,29 @@ PyObject*  MeshPy::getSegmentsByCurvature(PyObject *args)
     return Py::new_reference_to(list);
 }
 
+PyObject*  MeshPy::getLevelsOfDetail(PyObject *args)
+{
+    int minFacets = 1000;
+    if (!PyArg_ParseTuple(args, "|i",&minFacets))
+        return NULL;
+
+    MeshCore::MeshLevelOfDetail lod;
+    lod.SetMinimumFacets((unsigned long)std::max<int>(minFacets, 0));
+    lod.SetMesh(getMeshObjectPtr()->getKernel());
+    lod.Build();
+
+    Py::List list;
+    for (unsigned long i = 0; i < lod.CountLevels(); i++) {
+        const MeshCore::MeshLevelOfDetail::Level& level = lod.GetLevel(i);
+        Py::Tuple t(2);
+        t.setItem(0, Py::Int((long)level.CountFacets()));
+        t.setItem(1, Py::Float(level.fError));
+        list.append(t);
+    }
+
+    return Py::new_reference_to(list);
+}
+
 Py::Int MeshPy::getCountPoints(void) const
 {
     return Py::Int((long)getMeshObjectPtr()->countPoints());
@@ -1,7 +1,7 @@
 #   (c) Juergen Riegel (juergen.riegel@web.de) 2007      LGPL
 
-import FreeCAD, os, sys, unittest, Mesh
-import thread, time, tempfile
+import FreeCAD, os, sys, unittest, Mesh, math
+import thread, time, tempfile, struct
 
 
 #---------------------------------------------------------------------------
@@ -36,6 +36,15 @@ class MeshTopoTestCases(unittest.TestCase):
 		planarMeshObject = Mesh.Mesh(self.planarMesh)
 		planarMeshObject.collapseFacets(range(18))
 
+	def testNeighbours(self):
+		planarMeshObject = Mesh.Mesh(self.planarMesh)
+		for type in ["PointToFacets", "FacetToFacets", "PointToPoints"]:
+			self.failUnless(planarMeshObject.countNeighbours(type) == planarMeshObject.countNeighbours(type, False))
+		# three corners per facet and two directions per edge
+		self.failUnless(planarMeshObject.countNeighbours("PointToFacets") == 54)
+		self.failUnless(planarMeshObject.countNeighbours("PointToPoints") == 66)
+		self.assertRaises(ValueError, planarMeshObject.countNeighbours, "EdgeToFacets")
+
 
 class MeshGeoTestCases(unittest.TestCase):
 	def setUp(self):
@@ -71,6 +80,479 @@ class MeshGeoTestCases(unittest.TestCase):
 		res=f1.intersect(f2)
 		self.failUnless(len(res) == 0)
 
+class MeshValidationTestCases(unittest.TestCase):
+	def setUp(self):
+		# set up a planar face with 2 triangles and a duplicate of the first one
+		self.planarMesh = []
+		self.planarMesh.append( [0.0, 0.0, 0.0] )
+		self.planarMesh.append( [1.0, 1.0, 0.0] )
+		self.planarMesh.append( [0.0, 1.0, 0.0] )
+		self.planarMesh.append( [0.0, 0.0, 0.0] )
+		self.planarMesh.append( [1.0, 0.0, 0.0] )
+		self.planarMesh.append( [1.0, 1.0, 0.0] )
+		self.planarMesh.append( [0.0, 0.0, 0.0] )
+		self.planarMesh.append( [1.0, 1.0, 0.0] )
+		self.planarMesh.append( [0.0, 1.0, 0.0] )
+
+	def testAnalyze(self):
+		planarMeshObject = Mesh.Mesh(self.planarMesh)
+		report = planarMeshObject.analyze()
+		self.failUnless(len(report["DuplicatedFacets"]) == 1)
+		self.failUnless(len(report["DegeneratedFacets"]) == 0)
+		report = planarMeshObject.analyze(["DuplicatedFacets"])
+		self.failUnless(report.keys() == ["DuplicatedFacets"])
+
+	def testRepair(self):
+		planarMeshObject = Mesh.Mesh(self.planarMesh)
+		self.failUnless(planarMeshObject.repair())
+		self.failUnless(planarMeshObject.CountFacets == 2)
+		report = planarMeshObject.analyze()
+		for i in report.values():
+			self.failUnless(len(i) == 0)
+
+	def testSelfIntersections(self):
+		sphere = Mesh.createSphere(10.0, 50)
+		self.failIf(sphere.hasSelfIntersections())
+		self.failIf(sphere.hasSelfIntersections(True))
+		other = Mesh.createSphere(10.0, 50)
+		other.translate(5.0, 1.0, 0.5)
+		sphere.addMesh(other)
+		self.failUnless(sphere.hasSelfIntersections())
+		self.failUnless(sphere.hasSelfIntersections(True))
+
+
+class MeshSetOperationsTestCases(unittest.TestCase):
+	def setUp(self):
+		self.doc = FreeCAD.newDocument("SetOperationsTest")
+		box1 = self.doc.addObject("Mesh::Feature","Box1")
+		box1.Mesh = Mesh.createBox(10.0, 10.0, 10.0)
+		mesh = Mesh.createBox(10.0, 10.0, 10.0)
+		mesh.translate(5.0, 5.0, 5.0)
+		box2 = self.doc.addObject("Mesh::Feature","Box2")
+		box2.Mesh = mesh
+		self.setOp = self.doc.addObject("Mesh::SetOperations","SetOperation")
+		self.setOp.Source1 = box1
+		self.setOp.Source2 = box2
+		self.setOp.Algorithm = "Exact"
+
+	def testExact(self):
+		for op, volume in [("union", 1875.0), ("intersection", 125.0), ("difference", 875.0)]:
+			self.setOp.OperationType = op
+			self.doc.recompute()
+			mesh = self.setOp.Mesh
+			self.failUnless(mesh.isSolid())
+			self.failUnless(abs(mesh.Volume - volume) < 0.01)
+
+	def checkVolumes(self, x, y, z, volumes):
+		mesh = Mesh.createBox(10.0, 10.0, 10.0)
+		mesh.translate(x, y, z)
+		self.setOp.Source2.Mesh = mesh
+		for op, volume in zip(["union", "intersection", "difference"], volumes):
+			self.setOp.OperationType = op
+			self.doc.recompute()
+			mesh = self.setOp.Mesh
+			self.failUnless(mesh.isSolid())
+			self.failUnless(abs(mesh.Volume - volume) < 0.01)
+
+	def testTouching(self):
+		# the boxes share a face, which vanishes in the union
+		self.checkVolumes(10.0, 0.0, 0.0, [2000.0, 0.0, 1000.0])
+		self.setOp.OperationType = "union"
+		self.doc.recompute()
+		self.failUnless(self.setOp.Mesh.CountFacets == 20)
+		self.checkVolumes(0.0, 0.0, 10.0, [2000.0, 0.0, 1000.0])
+		self.checkVolumes(10.0, 5.0, 0.0, [2000.0, 0.0, 1000.0])
+
+	def testCoplanar(self):
+		# the overlapping parts of the boxes have coplanar faces
+		self.checkVolumes(5.0, 0.0, 0.0, [1500.0, 500.0, 500.0])
+		self.checkVolumes(2.5, 2.5, 0.0, [1437.5, 562.5, 437.5])
+
+	def tearDown(self):
+		FreeCAD.closeDocument("SetOperationsTest")
+
+
+class MeshQueryTestCases(unittest.TestCase):
+	def setUp(self):
+		self.mesh = Mesh.createSphere(10.0, 100)
+		self.points = []
+		for i in range(20):
+			for j in range(10):
+				u = 2.0 * math.pi * (i + 0.3) / 20.0
+				v = math.pi * (j + 0.5) / 10.0
+				self.points.append((math.cos(u) * math.sin(v), math.sin(u) * math.sin(v), math.cos(v)))
+
+	def distance(self, p, q):
+		return math.sqrt((p[0]-q[0])**2 + (p[1]-q[1])**2 + (p[2]-q[2])**2)
+
+	def testRays(self):
+		# rays from outside towards the center
+		pnts = [(15.0 * p[0], 15.0 * p[1], 15.0 * p[2]) for p in self.points]
+		dirs = [(-p[0], -p[1], -p[2]) for p in self.points]
+		bvh = self.mesh.nearestFacetsOnRays(pnts, dirs)
+		grid = self.mesh.nearestFacetsOnRays(pnts, dirs, True)
+		self.failUnless(len(bvh) == len(pnts))
+		for b, g in zip(bvh, grid):
+			self.failUnless(b is not None and g is not None)
+			self.failUnless(self.distance(b[1], g[1]) < 1e-4)
+			self.failUnless(abs(self.distance(b[1], (0,0,0)) - 10.0) < 0.02)
+		# rays pointing away from the sphere
+		away = self.mesh.nearestFacetsOnRays(pnts, self.points)
+		self.failUnless(away.count(None) == len(away))
+
+	def testNearestPoints(self):
+		pnts = [(9.0 * p[0], 9.0 * p[1], 9.0 * p[2]) for p in self.points]
+		bvh = self.mesh.nearestFacetsToPoints(pnts)
+		grid = self.mesh.nearestFacetsToPoints(pnts, True)
+		for p, b, g in zip(pnts, bvh, grid):
+			self.failUnless(abs(self.distance(p, b[1]) - self.distance(p, g[1])) < 1e-4)
+			self.failUnless(abs(self.distance(p, b[1]) - 1.0) < 0.01)
+
+
+class MeshDecimationTestCases(unittest.TestCase):
+	def setUp(self):
+		self.mesh = Mesh.createSphere(10.0, 100)
+
+	def testTargetSize(self):
+		solid = self.mesh.isSolid()
+		self.mesh.decimate(1000)
+		self.failUnless(self.mesh.CountFacets <= 1000)
+		self.failUnless(self.mesh.isSolid() == solid)
+
+	def testTolerance(self):
+		solid = self.mesh.isSolid()
+		count = self.mesh.CountFacets
+		self.mesh.decimate(0.01, 0.5)
+		self.failUnless(self.mesh.CountFacets < count)
+		self.failUnless(self.mesh.CountFacets >= count / 2)
+		self.failUnless(self.mesh.isSolid() == solid)
+
+	def testFeature(self):
+		doc = FreeCAD.newDocument("DecimationTest")
+		sphere = doc.addObject("Mesh::Feature","Sphere")
+		sphere.Mesh = self.mesh
+		decimation = doc.addObject("Mesh::Decimation","Decimation")
+		decimation.Source = sphere
+		decimation.Reduction = 0.9
+		decimation.Tolerance = 0.0
+		doc.recompute()
+		self.failUnless(decimation.Mesh.CountFacets <= self.mesh.CountFacets / 10 + 1)
+		self.failUnless(decimation.Mesh.isSolid() == self.mesh.isSolid())
+		FreeCAD.closeDocument("DecimationTest")
+
+
+class MeshHoleFillingTestCases(unittest.TestCase):
+	def setUp(self):
+		self.mesh = Mesh.createSphere(10.0, 100)
+
+	def testFillupHoles(self):
+		solid = self.mesh.isSolid()
+		count = self.mesh.CountFacets
+		self.mesh.removeFacets([0, count / 2])
+		self.failUnless(self.mesh.CountFacets == count - 2)
+		self.mesh.fillupHoles(3)
+		self.failUnless(self.mesh.CountFacets == count)
+		self.failUnless(self.mesh.isSolid() == solid)
+
+
+class MeshSmoothingTestCases(unittest.TestCase):
+	def setUp(self):
+		# enough points to smooth them on several cores
+		self.mesh = Mesh.createSphere(10.0, 250)
+
+	def smoothSerial(self, iterations, mask=None):
+		# moves all points at once towards the average of their neighbours,
+		# border points and points not in the mask are kept
+		points, facets = self.mesh.Topology
+		points = [(p.x, p.y, p.z) for p in points]
+		neighbours = [set() for p in points]
+		count = [0] * len(points)
+		for f in facets:
+			for i in range(3):
+				count[f[i]] += 1
+				neighbours[f[i]].update((f[(i+1)%3], f[(i+2)%3]))
+		for it in range(iterations):
+			result = list(points)
+			for i, n in enumerate(neighbours):
+				if len(n) < 3 or len(n) != count[i] or (mask and not mask[i]):
+					continue
+				w = 0.6307 / len(n)
+				p = points[i]
+				d = [0.0, 0.0, 0.0]
+				for j in n:
+					for k in range(3):
+						d[k] += points[j][k] - p[k]
+				result[i] = (p[0] + w * d[0], p[1] + w * d[1], p[2] + w * d[2])
+			points = result
+		return points
+
+	def distances(self, points):
+		return [math.sqrt((p.x-q[0])**2 + (p.y-q[1])**2 + (p.z-q[2])**2)
+			for p, q in zip(self.mesh.Topology[0], points)]
+
+	def testSmooth(self):
+		serial = self.smoothSerial(3)
+		self.mesh.smooth(3)
+		self.failUnless(max(self.distances(serial)) < 1e-4)
+
+	def testSmoothPoints(self):
+		count = self.mesh.CountPoints
+		mask = [i % 2 == 0 for i in range(count)]
+		serial = self.smoothSerial(3, mask)
+		self.mesh.smooth(3, 0.0, range(0, count, 2))
+		self.failUnless(max(self.distances(serial)) < 1e-4)
+
+
+class MeshSegmentationTestCases(unittest.TestCase):
+	def setUp(self):
+		self.mesh = Mesh.createCylinder(2.0, 10.0, 1, 0.5, 36)
+
+	def testSegmentsByCurvature(self):
+		# the caps and the side with either sign of the curvature
+		types = [(0.0, 0.0, 0.1, 0.1, 10), (0.5, 0.0, 0.1, 0.1, 10), (-0.5, 0.0, 0.1, 0.1, 10)]
+		parallel = self.mesh.getSegmentsByCurvature(types)
+		serial = self.mesh.getSegmentsByCurvature(types, False)
+		self.failUnless(len(parallel) == 3)
+		self.failUnless(len(parallel) == len(serial))
+		for p in parallel:
+			# the serial search also adds the start facet if it doesn't match
+			s = [s for s in serial if set(p).issubset(s)]
+			self.failUnless(len(s) == 1)
+			self.failUnless(len(s[0]) - len(p) <= 1)
+
+
+class MeshLevelOfDetailTestCases(unittest.TestCase):
+	def setUp(self):
+		self.mesh = Mesh.createSphere(10.0, 250)
+
+	def testLevels(self):
+		levels = self.mesh.getLevelsOfDetail(1000)
+		self.failUnless(len(levels) > 0)
+		facets = self.mesh.CountFacets
+		error = 0.0
+		for i in levels:
+			# each level removes at least a tenth of the facets and is less accurate
+			self.failUnless(10 * i[0] <= 9 * facets)
+			self.failUnless(i[1] >= error and i[1] < 10.0)
+			facets = i[0]
+			error = i[1]
+		# only the coarsest level may fall below the minimum
+		for i in levels[:-1]:
+			self.failUnless(i[0] > 1000)
+
+	def testMinimumFacets(self):
+		self.failUnless(len(self.mesh.getLevelsOfDetail(self.mesh.CountFacets)) == 0)
+		self.failUnless(len(self.mesh.getLevelsOfDetail(100)) > len(self.mesh.getLevelsOfDetail(10000)))
+
+class MeshEditingTestCases(unittest.TestCase):
+	def setUp(self):
+		self.mesh = Mesh.createSphere(10.0, 100)
+
+	def neighbours(self, mesh):
+		return [f.NeighbourIndices for f in mesh.Facets]
+
+	def rebuiltNeighbours(self, mesh):
+		copy = mesh.copy()
+		copy.rebuildNeighbourHood()
+		return self.neighbours(copy)
+
+	def testAddRemoveFacets(self):
+		solid = self.mesh.isSolid()
+		count = self.mesh.CountFacets
+		points = self.mesh.CountPoints
+		self.mesh.beginEdit()
+		for i in range(10):
+			# remove facets without common points so that all points are kept
+			topo = self.mesh.Topology[1]
+			indices = []
+			used = set()
+			for k in range(i, count, count / 8):
+				if not used.intersection(topo[k]):
+					indices.append(k)
+					used.update(topo[k])
+			facets = [topo[k] for k in indices]
+			self.mesh.removeFacets(indices)
+			self.failUnless(self.mesh.CountFacets == count - len(indices))
+			self.failUnless(self.mesh.CountPoints == points)
+			self.failUnless(self.neighbours(self.mesh) == self.rebuiltNeighbours(self.mesh))
+			self.mesh.addFacets(([], facets))
+			self.failUnless(self.mesh.CountFacets == count)
+			self.failUnless(self.neighbours(self.mesh) == self.rebuiltNeighbours(self.mesh))
+		self.mesh.endEdit()
+		self.failUnless(self.mesh.isSolid() == solid)
+
+
+class MeshStreamingTestCases(unittest.TestCase):
+	def setUp(self):
+		self.mesh = Mesh.createSphere(10.0, 100)
+		self.input = tempfile.gettempdir() + os.sep + "stream_in.stl"
+		self.output = tempfile.gettempdir() + os.sep + "stream_out.stl"
+		self.mesh.write(self.input)
+
+	def testCopy(self):
+		stat = Mesh.processSTL(self.input, self.output)
+		self.failUnless(stat["Input"] == self.mesh.CountFacets)
+		self.failUnless(stat["Facets"] == self.mesh.CountFacets)
+		self.failUnless(abs(stat["Area"] - self.mesh.Area) < 0.001 * self.mesh.Area)
+		mesh = Mesh.Mesh(self.output)
+		self.failUnless(mesh.CountFacets == self.mesh.CountFacets)
+
+	def testFilter(self):
+		box = FreeCAD.BoundBox(0, -20, -20, 20, 20, 20)
+		stat = Mesh.processSTL(self.input, box=box)
+		self.failUnless(stat["Facets"] > 0)
+		self.failUnless(stat["Facets"] < self.mesh.CountFacets)
+		self.failUnless(stat["BoundBox"].XMin > -1.0)
+		stat = Mesh.processSTL(self.input, normal=FreeCAD.Vector(0,0,1), angle=0.5)
+		self.failUnless(stat["Facets"] < self.mesh.CountFacets / 2)
+
+	def testDecimation(self):
+		mat = FreeCAD.Matrix()
+		mat.move(FreeCAD.Vector(100,0,0))
+		stat = Mesh.processSTL(self.input, self.output, transform=mat, cellSize=2.0)
+		self.failUnless(stat["Facets"] < self.mesh.CountFacets)
+		self.failUnless(stat["BoundBox"].XMin > 85.0)
+		mesh = Mesh.Mesh(self.output)
+		self.failUnless(mesh.CountFacets == stat["Facets"])
+
+	def tearDown(self):
+		os.remove(self.input)
+		if os.path.exists(self.output):
+			os.remove(self.output)
+
+
+class MeshExportTestCases(unittest.TestCase):
+	def setUp(self):
+		# numbers at the limits of the text formatting: signed zero, the switch to the
+		# exponential notation of '%g' and halfway cases of the rounding
+		values = [-0.0, 0.0, 1.0e-4, 9.9999e-5, 1.00001e-4, -2.0e-5, 999999.5, 999999.4, 999998.5,
+			100000.5, 100001.5, 12345.25, -12345.75, 0.5, 2.5, -3.5, 0.125, 1234567.0, 123.456789,
+			-7.25e-7, 1.0e10, 0.1]
+		triangles = []
+		for v in values:
+			triangles += [[v, 0.0, 1.0], [0.0, v, 2.0], [3.0, 4.0, v]]
+		self.special = Mesh.Mesh(triangles)
+		# large enough to be formatted in parallel ranges
+		self.sphere = Mesh.createSphere(10.0, 400)
+		self.sphere.translate(0.1, -0.2, 0.3)
+		self.fileName = tempfile.gettempdir() + os.sep + "MeshExport"
+
+	def export(self, mesh, format, colors=None):
+		name = self.fileName + "." + format.lower()
+		if colors is None:
+			mesh.write(name, format)
+		else:
+			mesh.write(name, format, colors)
+		file = open(name, "rb")
+		data = file.read()
+		file.close()
+		os.remove(name)
+		return data
+
+	def colors(self, mesh):
+		colors = [(1.0, 0.5, 0.25), (0.0, 0.75, 1.0 / 3.0), (0.2, 0.4, 0.6)]
+		return [colors[i % 3] for i in range(mesh.CountPoints)]
+
+	def rgb(self, color):
+		return tuple([int(255.0 * c) for c in color])
+
+	def plyHeader(self, mesh, format):
+		header = "ply\nformat %s 1.0\ncomment Created by FreeCAD <http://www.freecadweb.org>\n" % format
+		header += "element vertex %d\nproperty float32 x\nproperty float32 y\nproperty float32 z\n" % mesh.CountPoints
+		header += "property uchar red\nproperty uchar green\nproperty uchar blue\n"
+		header += "element face %d\nproperty list uchar int vertex_index\nend_header\n" % mesh.CountFacets
+		return header
+
+	def checkText(self, mesh):
+		# the exported numbers must be the same as with printf
+		points, facets = mesh.Topology
+		points = [(p.x, p.y, p.z) for p in points]
+		obj = self.export(mesh, "OBJ")
+		self.failUnless(obj == "".join(["v %g %g %g\n" % p for p in points]) +
+			"".join(["f %d %d %d\n" % (i + 1, j + 1, k + 1) for i, j, k in facets]))
+
+		off = self.export(mesh, "OFF")
+		self.failUnless(off == "OFF\n%d %d 0\n" % (mesh.CountPoints, mesh.CountFacets) +
+			"".join(["%g %g %g\n" % p for p in points]) + "".join(["3 %d %d %d\n" % f for f in facets]))
+
+		colors = self.colors(mesh)
+		ply = self.export(mesh, "APLY", colors)
+		self.failUnless(ply == self.plyHeader(mesh, "ascii") +
+			"".join(["%.6f %.6f %.6f %d %d %d\n" % (p + self.rgb(c)) for p, c in zip(points, colors)]) +
+			"".join(["3 %d %d %d\n" % f for f in facets]))
+
+		lines = self.export(mesh, "AST").split("\n")
+		self.failUnless(lines[0] == "solid Mesh")
+		self.failUnless(lines[-2:] == ["endsolid Mesh", ""])
+		self.failUnless(len(lines) == 7 * mesh.CountFacets + 3)
+		for n, (i, j, k) in enumerate(facets):
+			record = lines[1 + 7 * n : 8 + 7 * n]
+			normal = record[0].split(" ")
+			self.failUnless(normal[:4] == ["", "", "facet", "normal"])
+			self.failUnless(["%.6f" % float(x) for x in normal[4:]] == normal[4:])
+			self.failUnless(record[1:] == ["    outer loop"] +
+				["      vertex %.6f %.6f %.6f" % points[x] for x in (i, j, k)] + ["    endloop", "  endfacet"])
+		return obj
+
+	def testSpecialValues(self):
+		obj = self.checkText(self.special)
+		for s in ["1e+06", "100002", "12345.2", "-12345.8", "1e+10"]:
+			self.failUnless(s in obj)
+
+	def testParallelRanges(self):
+		self.checkText(self.sphere)
+
+	def testBinary(self):
+		mesh = self.special
+		points, facets = mesh.Topology
+		stl = self.export(mesh, "STL")
+		self.failUnless(struct.unpack("<I", stl[80:84])[0] == mesh.CountFacets)
+		self.failUnless(len(stl) == 84 + 50 * mesh.CountFacets)
+		for n, f in enumerate(facets):
+			record = struct.unpack("<12fH", stl[84 + 50 * n : 134 + 50 * n])
+			vertices = ()
+			for x in f:
+				vertices += (points[x].x, points[x].y, points[x].z)
+			self.failUnless(record[3:] == vertices + (0,))
+
+		# the colors are stored as bytes
+		colors = self.colors(mesh)
+		ply = self.export(mesh, "PLY", colors)
+		header = self.plyHeader(mesh, "binary_little_endian")
+		self.failUnless(ply.startswith(header))
+		body = ply[len(header):]
+		self.failUnless(len(body) == 15 * mesh.CountPoints + 13 * mesh.CountFacets)
+		for n, (p, c) in enumerate(zip(points, colors)):
+			record = struct.unpack("<3f3B", body[15 * n : 15 * n + 15])
+			self.failUnless(record == (p.x, p.y, p.z) + self.rgb(c))
+		offset = 15 * mesh.CountPoints
+		for n, f in enumerate(facets):
+			record = struct.unpack("<B3i", body[offset + 13 * n : offset + 13 * n + 13])
+			self.failUnless(record == (3,) + tuple(f))
+
+
+class MeshCurvatureTestCases(unittest.TestCase):
+	def setUp(self):
+		self.doc = FreeCAD.newDocument("CurvatureTest")
+		self.sphere = self.doc.addObject("Mesh::Feature","Sphere")
+		self.sphere.Mesh = Mesh.createSphere(10.0, 100)
+		self.curvature = self.doc.addObject("Mesh::Curvature","Curvature")
+		self.curvature.Source = self.sphere
+
+	def testRings(self):
+		for rings in [1, 2, 3]:
+			self.curvature.Rings = rings
+			self.doc.recompute()
+			info = self.curvature.CurvInfo
+			self.failUnless(len(info) == self.sphere.Mesh.CountPoints)
+			for i in info:
+				self.failUnless(abs(abs(i[0]) - 0.1) < 0.01)
+				self.failUnless(abs(abs(i[1]) - 0.1) < 0.01)
+
+	def tearDown(self):
+		FreeCAD.closeDocument("CurvatureTest")
+
+
 class PivyTestCases(unittest.TestCase):
 	def setUp(self):
 		# set up a planar face with 2 triangles
@@ -122,6 +604,59 @@ class PivyTestCases(unittest.TestCase):
 		self.failUnless(pc.getTriangleCount() == 2)
 		#self.failUnless(pc.getPointCount() == 6)
 
+	def testRenderTime(self):
+		# Renders a scene of many large meshes offscreen. The first frame uploads the
+		# geometry into vertex buffers while the following frames are drawn from there.
+		# Run with LIBGL_ALWAYS_SOFTWARE=1 to measure the software renderer.
+		if not FreeCAD.GuiUp:
+			return
+		from pivy import coin; import FreeCADGui
+		for i in range(16):
+			sphere=Mesh.createSphere(10.0,200)
+			sphere.translate(25.0*(i%4),25.0*(i/4),0.0)
+			Mesh.show(sphere)
+		view=FreeCADGui.ActiveDocument.ActiveView
+		view.fitAll()
+		root=view.getViewer().getSceneManager().getSceneGraph()
+		renderer=coin.SoOffscreenRenderer(coin.SbViewportRegion(800,600))
+		start=time.time()
+		self.failUnless(renderer.render(root))
+		first=time.time()-start
+		frames=5
+		start=time.time()
+		for i in range(frames):
+			self.failUnless(renderer.render(root))
+		redraw=(time.time()-start)/frames
+		FreeCAD.Console.PrintMessage("Render time: first frame %.3f s, redraw %.3f s\n" % (first,redraw))
+
+	def testRenderVertexCache(self):
+		# The first frame uploads the meshes into vertex buffers and the next one is drawn
+		# from there, so both must look the same. Moving a mesh must update its buffer.
+		if not FreeCAD.GuiUp:
+			return
+		from pivy import coin; import FreeCADGui
+		for i in range(4):
+			sphere=Mesh.createSphere(10.0,200)
+			sphere.translate(25.0*i,0.0,0.0)
+			Mesh.show(sphere)
+		view=FreeCADGui.ActiveDocument.ActiveView
+		view.fitAll()
+		root=view.getViewer().getSceneManager().getSceneGraph()
+		renderer=coin.SoOffscreenRenderer(coin.SbViewportRegion(400,300))
+		renderer.setBackgroundColor(coin.SbColor(0.0,0.0,0.0))
+		self.failUnless(renderer.render(root))
+		first=renderer.getBuffer()
+		self.failUnless(first.strip(chr(0)) != "")
+		self.failUnless(renderer.render(root))
+		self.failUnless(renderer.getBuffer() == first)
+
+		obj=FreeCAD.ActiveDocument.Objects[0]
+		mesh=obj.Mesh.copy()
+		mesh.translate(0.0,5.0,0.0)
+		obj.Mesh=mesh
+		self.failUnless(renderer.render(root))
+		self.failUnless(renderer.getBuffer() != first)
+
 	def tearDown(self):
 		#closing doc
 		FreeCAD.closeDocument("MeshTest")
@@ -163,3 +698,156 @@ class LoadMeshInThreadsCases(unittest.TestCase):
 
     def tearDown(self):
         pass
+
+# Benchmarks
+
+def selfIntersectionBenchmark(samplings=(100, 200, 400, 800)):
+	"""Measures the wall-clock time of the self-intersection check with the facet grid
+	and with the bounding volume hierarchy for spheres and for two overlapping spheres"""
+	for s in samplings:
+		sphere = Mesh.createSphere(10.0, s)
+		other = Mesh.createSphere(10.0, s)
+		other.translate(5.0, 1.0, 0.5)
+		overlap = sphere.copy()
+		overlap.addMesh(other)
+		for name, mesh in [("sphere", sphere), ("overlapping", overlap)]:
+			start = time.time()
+			mesh.hasSelfIntersections(True)
+			grid = time.time() - start
+			start = time.time()
+			mesh.hasSelfIntersections()
+			bvh = time.time() - start
+			start = time.time()
+			pairs = len(mesh.analyze(["SelfIntersections"])["SelfIntersections"])
+			full = time.time() - start
+			FreeCAD.Console.PrintMessage("%-11s %8d facets: grid %.3f s, bvh %.3f s (speedup %.2f), all %d pairs %.3f s\n"
+				% (name, mesh.CountFacets, grid, bvh, grid / max(bvh, 1e-6), pairs, full))
+
+def exportBenchmark(sampling=500):
+	"""Measures the throughput of the mesh export in MB/s for each file format"""
+	mesh = Mesh.createSphere(10.0, sampling)
+	name = tempfile.gettempdir() + os.sep + "MeshExportBenchmark"
+	FreeCAD.Console.PrintMessage("%d points, %d facets\n" % (mesh.CountPoints, mesh.CountFacets))
+	for format in ["STL", "AST", "OBJ", "OFF", "PLY", "APLY"]:
+		start = time.time()
+		mesh.write(name, format)
+		elapsed = time.time() - start
+		size = os.path.getsize(name) / (1024.0 * 1024.0)
+		FreeCAD.Console.PrintMessage("%-4s %8.1f MB in %.3f s: %8.1f MB/s\n"
+			% (format, size, elapsed, size / max(elapsed, 1e-6)))
+	os.remove(name)
+
+def gridBenchmark(samplings=(100, 200, 400, 800), queries=20000):
+	"""Measures the time to build the facet grid of spheres and the mean latency of
+	the nearest facet queries that use it"""
+	import random
+	random.seed(0)
+	for s in samplings:
+		mesh = Mesh.createSphere(10.0, s)
+		points = []
+		for i in range(queries):
+			points.append((random.uniform(-12.0, 12.0), random.uniform(-12.0, 12.0), random.uniform(-12.0, 12.0)))
+		# the first call builds the grid, the second one only queries it
+		start = time.time()
+		mesh.nearestFacetsToPoints(points, True)
+		first = time.time() - start
+		start = time.time()
+		mesh.nearestFacetsToPoints(points, True)
+		query = time.time() - start
+		FreeCAD.Console.PrintMessage("%8d facets: build %.3f s, query %.1f us\n"
+			% (mesh.CountFacets, max(first - query, 0.0), 1.0e6 * query / queries))
+
+def adjacencyBenchmark(samplings=(200, 400, 800)):
+	"""Measures the time to build the neighbourhood tables with a set per element
+	and as compact arrays. The memory is estimated from the number of entries for
+	the node based sets of a 64-bit libstdc++ and for the arrays of offsets and indices."""
+	pointer = struct.calcsize("P")
+	index = struct.calcsize("L")
+	for s in samplings:
+		mesh = Mesh.createSphere(10.0, s)
+		FreeCAD.Console.PrintMessage("%d points, %d facets\n" % (mesh.CountPoints, mesh.CountFacets))
+		for type in ["PointToFacets", "FacetToFacets", "PointToPoints"]:
+			if type.startswith("Point"):
+				rows = mesh.CountPoints
+			else:
+				rows = mesh.CountFacets
+			start = time.time()
+			entries = mesh.countNeighbours(type, False)
+			sets = time.time() - start
+			start = time.time()
+			mesh.countNeighbours(type, True)
+			compact = time.time() - start
+			setMemory = (rows * 6 * pointer + entries * (4 * pointer + index)) / (1024.0 * 1024.0)
+			compactMemory = (rows + 1 + entries) * index / (1024.0 * 1024.0)
+			FreeCAD.Console.PrintMessage("  %-13s %.3f s %7.1f MB -> %.3f s %7.1f MB\n"
+				% (type, sets, setMemory, compact, compactMemory))
+
+def booleanBenchmark(samplings=(50, 100, 200)):
+	"""Measures the throughput of the set operations with the standard and the exact
+	algorithm on two overlapping spheres and checks the results. The union and the
+	intersection together must have the volume of both spheres, and the difference and
+	the intersection that of the first one. Then boxes touching or overlapping with
+	coplanar faces are tested."""
+	doc = FreeCAD.newDocument("BooleanBenchmark")
+	try:
+		mesh1 = doc.addObject("Mesh::Feature", "Mesh1")
+		mesh2 = doc.addObject("Mesh::Feature", "Mesh2")
+		setOp = doc.addObject("Mesh::SetOperations", "SetOperation")
+		setOp.Source1 = mesh1
+		setOp.Source2 = mesh2
+
+		def run(algorithm):
+			setOp.Algorithm = algorithm
+			results = {}
+			elapsed = 0.0
+			for op in ["union", "intersection", "difference"]:
+				setOp.OperationType = op
+				start = time.time()
+				doc.recompute()
+				elapsed += time.time() - start
+				results[op] = setOp.Mesh.copy()
+			return results, elapsed
+
+		for s in samplings:
+			mesh1.Mesh = Mesh.createSphere(10.0, s)
+			mesh = Mesh.createSphere(10.0, s)
+			mesh.translate(5.0, 1.0, 0.5)
+			mesh2.Mesh = mesh
+			volume1 = mesh1.Mesh.Volume
+			volume2 = mesh2.Mesh.Volume
+			facets = mesh1.Mesh.CountFacets + mesh2.Mesh.CountFacets
+			for algorithm in ["Standard", "Exact"]:
+				results, elapsed = run(algorithm)
+				solid = len([m for m in results.values() if m.isSolid()])
+				union = abs(results["union"].Volume + results["intersection"].Volume - volume1 - volume2) / (volume1 + volume2)
+				difference = abs(results["difference"].Volume + results["intersection"].Volume - volume1) / volume1
+				FreeCAD.Console.PrintMessage("%8d facets %-8s: %.3f s, %.0f facets/s, %d of 3 solid, volume error %.3f%% / %.3f%%\n"
+					% (facets, algorithm, elapsed, 3 * facets / max(elapsed, 1e-6), solid, 100.0 * union, 100.0 * difference))
+
+		mesh1.Mesh = Mesh.createBox(10.0, 10.0, 10.0)
+		for x, y, z in [(5.0, 5.0, 5.0), (10.0, 0.0, 0.0), (10.0, 5.0, 0.0), (5.0, 0.0, 0.0), (2.5, 2.5, 0.0), (0.0, 0.0, 0.0)]:
+			mesh = Mesh.createBox(10.0, 10.0, 10.0)
+			mesh.translate(x, y, z)
+			mesh2.Mesh = mesh
+			overlap = max(10.0 - abs(x), 0.0) * max(10.0 - abs(y), 0.0) * max(10.0 - abs(z), 0.0)
+			volumes = {"union": 2000.0 - overlap, "intersection": overlap, "difference": 1000.0 - overlap}
+			for algorithm in ["Standard", "Exact"]:
+				results, elapsed = run(algorithm)
+				failed = [op for op, m in results.items() if not m.isSolid() or abs(m.Volume - volumes[op]) > 0.01]
+				FreeCAD.Console.PrintMessage("boxes at (%g, %g, %g) %-8s: %s\n"
+					% (x, y, z, algorithm, failed and "failed " + ", ".join(failed) or "ok"))
+	finally:
+		FreeCAD.closeDocument("BooleanBenchmark")
+
+def decimationBenchmark(samplings=(100, 200, 400, 800), reduction=0.9):
+	"""Measures how many facets per second the decimation removes from spheres
+	of growing size"""
+	for s in samplings:
+		mesh = Mesh.createSphere(10.0, s)
+		count = mesh.CountFacets
+		start = time.time()
+		mesh.decimate(int(count * (1.0 - reduction)))
+		elapsed = time.time() - start
+		removed = count - mesh.CountFacets
+		FreeCAD.Console.PrintMessage("%8d -> %8d facets: %.3f s, %.0f facets removed per second\n"
+			% (count, mesh.CountFacets, elapsed, removed / max(elapsed, 1e-6)))
@@ -88,7 +88,7 @@ void Segmentation::accept()
         segm.push_back(new MeshCore::MeshCurvaturePlanarSegment
             (meshCurv.GetCurvature(), ui->numPln->value(), ui->tolPln->value()));
     }
-    finder.FindSegments(segm);
+    finder.FindSegmentsParallel(segm);
 
     App::Document* document = App::GetApplication().getActiveDocument();
     document->openTransaction("Segmentation");
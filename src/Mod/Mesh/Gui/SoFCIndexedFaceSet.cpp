@@ -34,9 +34,12 @@
 # endif
 # include <Inventor/actions/SoGLRenderAction.h>
 # include <Inventor/bundles/SoMaterialBundle.h>
+# include <Inventor/bundles/SoTextureCoordinateBundle.h>
 # include <Inventor/elements/SoCoordinateElement.h>
 # include <Inventor/elements/SoGLCoordinateElement.h>
 # include <Inventor/elements/SoMaterialBindingElement.h>
+# include <Inventor/elements/SoNormalBindingElement.h>
+# include <Inventor/elements/SoNormalElement.h>
 # include <Inventor/elements/SoProjectionMatrixElement.h>
 # include <Inventor/elements/SoViewingMatrixElement.h>
 #endif
@@ -77,7 +80,8 @@ void SoFCIndexedFaceSet::GLRender(SoGLRenderAction *action)
 
     unsigned int num = this->coordIndex.getNum()/4;
     if (mode == false || num <= this->renderTriangleLimit) {
-        inherited::GLRender(action);
+        if (!drawVertexCache(action))
+            inherited::GLRender(action);
     }
     else {
         SoMaterialBindingElement::Binding matbind =
@@ -111,6 +115,57 @@ void SoFCIndexedFaceSet::GLRender(SoGLRenderAction *action)
     }
 }
 
+/**
+ * Renders the triangles from a vertex buffer object if they have an overall color, no
+ * textures and per-vertex normals. Returns false if the default rendering must be used.
+ */
+bool SoFCIndexedFaceSet::drawVertexCache(SoGLRenderAction *action)
+{
+    SoState * state = action->getState();
+    if (!Gui::SoFCVertexCache::isSupported(state))
+        return false;
+    if (SoMaterialBindingElement::get(state) != SoMaterialBindingElement::OVERALL)
+        return false;
+    if (SoNormalBindingElement::get(state) != SoNormalBindingElement::PER_VERTEX_INDEXED)
+        return false;
+    // only triangles each terminated by -1 are supported
+    if (this->coordIndex.getNum() % 4 != 0)
+        return false;
+
+    SoMaterialBundle mb(action);
+    SoTextureCoordinateBundle tb(action, TRUE, FALSE);
+    if (tb.needCoordinates())
+        return false;
+    SbBool sendNormals = !mb.isColorOnly() || tb.isFunction();
+
+    const SoCoordinateElement * coords;
+    const SbVec3f * normals;
+    const int32_t * cindices;
+    int numindices;
+    const int32_t * nindices;
+    const int32_t * tindices;
+    const int32_t * mindices;
+    SbBool normalCacheUsed;
+
+    // always get the normals so that the buffer can be used with and without lighting
+    this->getVertexData(state, coords, normals, cindices,
+                        nindices, tindices, mindices, numindices,
+                        TRUE, normalCacheUsed);
+    if (!nindices) nindices = cindices;
+
+    vertexCache.setGeometryIds(this->getNodeId(), coords->getNodeId(),
+                               SoNormalElement::getInstance(state)->getNodeId());
+    if (vertexCache.needsUpload(state)) {
+        std::vector<float> data;
+        Gui::SoFCVertexCache::fillTriangles(static_cast<const SoGLCoordinateElement*>(coords)->getArrayPtr3(),
+                                            coords->getNum(), cindices, numindices, normals, nindices, data);
+        vertexCache.upload(state, data);
+    }
+
+    mb.sendFirst(); // make sure we have the correct material
+    return vertexCache.render(state, sendNormals);
+}
+
 void SoFCIndexedFaceSet::drawCoords(const SoGLCoordinateElement * const vertexlist,
                                     const int32_t *vertexindices,
                                     int numindices,
@@ -25,6 +25,7 @@
 
 
 #include <Inventor/nodes/SoIndexedFaceSet.h>
+#include <Gui/SoFCVertexCache.h>
 
 class SoGLCoordinateElement;
 class SoTextureCoordinateBundle;
@@ -40,6 +41,9 @@ namespace MeshGui {
  * \brief The SoFCIndexedFaceSet class is designed to optimize redrawing a mesh
  * during user interaction.
  *
+ * If the triangles are rendered completely with an overall color they are kept in
+ * a vertex buffer object until the coordinates or the indices change.
+ *
  * @author Werner Mayer
  */
 class MeshGuiExport SoFCIndexedFaceSet : public SoIndexedFaceSet {
@@ -71,6 +75,7 @@ protected:
     void doAction(SoAction * action);
 
 private:
+    bool drawVertexCache(SoGLRenderAction *action);
     void startSelection(SoAction * action);
     void stopSelection(SoAction * action);
     void renderSelectionGeometry(const SbVec3f *);
@@ -79,6 +84,7 @@ private:
     void renderVisibleFaces(const SbVec3f *);
 
     GLuint *selectBuf;
+    Gui::SoFCVertexCache vertexCache;
 };
 
 } // namespace MeshGui
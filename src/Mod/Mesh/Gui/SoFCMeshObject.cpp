@@ -42,10 +42,16 @@
 # include <Inventor/actions/SoPickAction.h>
 # include <Inventor/actions/SoWriteAction.h>
 # include <Inventor/details/SoFaceDetail.h>
+# include <Inventor/elements/SoModelMatrixElement.h>
+# include <Inventor/elements/SoViewportRegionElement.h>
+# include <Inventor/elements/SoViewVolumeElement.h>
 # include <Inventor/errors/SoReadError.h>
 # include <Inventor/misc/SoState.h>
 #endif
 
+#include <QMutex>
+#include <QtConcurrentRun>
+
 #include "SoFCMeshObject.h"
 #include <Base/Console.h>
 #include <Base/Exception.h>
@@ -56,6 +62,7 @@
 #include <Mod/Mesh/App/Core/MeshKernel.h>
 #include <Mod/Mesh/App/Core/Elements.h>
 #include <Mod/Mesh/App/Core/Grid.h>
+#include <Mod/Mesh/App/Core/LevelOfDetail.h>
 
 using namespace MeshGui;
 
@@ -588,12 +595,18 @@ void SoFCMeshObjectShape::initClass()
     SO_NODE_INIT_CLASS(SoFCMeshObjectShape, SoShape, "Shape");
 }
 
-SoFCMeshObjectShape::SoFCMeshObjectShape() : renderTriangleLimit(100000), meshChanged(true)
+SoFCMeshObjectShape::SoFCMeshObjectShape() : renderTriangleLimit(100000), screenErrorLimit(2.0f),
+    meshChanged(true), lodMesh(0), lod(0)
 {
     SO_NODE_CONSTRUCTOR(SoFCMeshObjectShape);
     setName(SoFCMeshObjectShape::getClassTypeId().getName());
 }
 
+SoFCMeshObjectShape::~SoFCMeshObjectShape()
+{
+    stopLevelOfDetail();
+}
+
 void SoFCMeshObjectShape::notify(SoNotList * node)
 {
     inherited::notify(node);
@@ -601,7 +614,7 @@ void SoFCMeshObjectShape::notify(SoNotList * node)
 }
 
 /**
- * Either renders the complete mesh or only a subset of the points.
+ * Either renders the complete mesh, a simplified version of it or only a subset of the points.
  */
 void SoFCMeshObjectShape::GLRender(SoGLRenderAction *action)
 {
@@ -630,10 +643,17 @@ void SoFCMeshObjectShape::GLRender(SoGLRenderAction *action)
         if (SoShapeHintsElement::getVertexOrdering(state) == SoShapeHintsElement::CLOCKWISE) 
             ccw = FALSE;
 
-        if (mode == false || mesh->countFacets() <= this->renderTriangleLimit) {
+        int level = -1;
+        if (mbind == OVERALL && mesh->countFacets() > this->renderTriangleLimit)
+            level = findLevelOfDetail(state, mesh, mode);
+
+        if (level >= 0) {
+            drawLevelOfDetail(level, needNormals, ccw);
+        }
+        else if (mode == false || mesh->countFacets() <= this->renderTriangleLimit) {
             if (mbind != OVERALL)
                 drawFaces(mesh, &mb, mbind, needNormals, ccw);
-            else
+            else if (!ccw || !drawVertexCache(state, mesh, needNormals))
                 drawFaces(mesh, 0, mbind, needNormals, ccw);
         }
         else {
@@ -755,6 +775,51 @@ void SoFCMeshObjectShape::drawFaces(const Mesh::MeshObject * mesh, SoMaterialBun
     }
 }
 
+/**
+ * Renders the triangles of the complete mesh from a vertex buffer object. The buffer is filled
+ * if the revision of the mesh has changed since the last upload. Returns false if vertex buffer
+ * objects cannot be used.
+ */
+bool SoFCMeshObjectShape::drawVertexCache(SoState * state, const Mesh::MeshObject * mesh, SbBool needNormals)
+{
+    // the revision is unique among all meshes, so it also tells if another mesh is rendered
+    vertexCache.setGeometryIds(mesh->getKernel().GetRevision());
+    if (vertexCache.needsUpload(state)) {
+        const MeshCore::MeshPointArray & rPoints = mesh->getKernel().GetPoints();
+        const MeshCore::MeshFacetArray & rFacets = mesh->getKernel().GetFacets();
+
+        // each vertex gets the normal of its facet to have the same flat shading as drawFaces()
+        std::vector<float> data;
+        data.reserve(18 * rFacets.size());
+        for (MeshCore::MeshFacetArray::_TConstIterator it = rFacets.begin(); it != rFacets.end(); ++it)
+        {
+            const MeshCore::MeshPoint& v0 = rPoints[it->_aulPoints[0]];
+            const MeshCore::MeshPoint& v1 = rPoints[it->_aulPoints[1]];
+            const MeshCore::MeshPoint& v2 = rPoints[it->_aulPoints[2]];
+
+            // Calculate the normal n = (v1-v0)x(v2-v0)
+            float n[3];
+            n[0] = (v1.y-v0.y)*(v2.z-v0.z)-(v1.z-v0.z)*(v2.y-v0.y);
+            n[1] = (v1.z-v0.z)*(v2.x-v0.x)-(v1.x-v0.x)*(v2.z-v0.z);
+            n[2] = (v1.x-v0.x)*(v2.y-v0.y)-(v1.y-v0.y)*(v2.x-v0.x);
+
+            const MeshCore::MeshPoint* v[3] = { &v0, &v1, &v2 };
+            for (int i=0; i<3; i++) {
+                data.push_back(v[i]->x);
+                data.push_back(v[i]->y);
+                data.push_back(v[i]->z);
+                data.push_back(n[0]);
+                data.push_back(n[1]);
+                data.push_back(n[2]);
+            }
+        }
+
+        vertexCache.upload(state, data);
+    }
+
+    return vertexCache.render(state, needNormals);
+}
+
 /**
  * Renders the gravity points of a subset of triangles.
  */
@@ -842,6 +907,173 @@ void SoFCMeshObjectShape::drawPoints(const Mesh::MeshObject * mesh, SbBool needN
     }
 }
 
+namespace MeshGui {
+
+/**
+ * Builds the hierarchy of simplified meshes of a mesh in a worker thread. The worker
+ * also copies the mesh, so the GUI thread never waits for the job: an abandoned job
+ * is canceled and deletes itself when the worker is done with it.
+ */
+class MeshLevelOfDetailJob
+{
+public:
+    MeshLevelOfDetailJob(const Mesh::MeshObject* mesh)
+      : mesh(mesh), revision(mesh->getKernel().GetRevision()), finished(false), abandoned(false)
+    {
+    }
+
+    void start()
+    {
+        QtConcurrent::run(this, &MeshLevelOfDetailJob::run);
+    }
+
+    void abandon()
+    {
+        lod.Cancel();
+        mutex.lock();
+        bool running = !finished;
+        abandoned = true;
+        mutex.unlock();
+        if (!running)
+            delete this;
+    }
+
+    bool isFinished() const
+    {
+        QMutexLocker locker(&mutex);
+        return finished;
+    }
+
+    const MeshCore::MeshLevelOfDetail& getLevels() const
+    {
+        return lod;
+    }
+
+private:
+    void run()
+    {
+        // the reference keeps the mesh alive during the copy, a copy made while the
+        // mesh was modified is useless
+        lod.SetMesh(mesh->getKernel());
+        if (mesh->getKernel().GetRevision() != revision)
+            lod.Cancel();
+        mesh = 0;
+        lod.Build();
+
+        mutex.lock();
+        finished = true;
+        bool orphan = abandoned;
+        mutex.unlock();
+        if (orphan)
+            delete this;
+    }
+
+private:
+    Base::Reference<const Mesh::MeshObject> mesh;
+    unsigned long revision;
+    MeshCore::MeshLevelOfDetail lod;
+    mutable QMutex mutex;
+    bool finished;
+    bool abandoned;
+};
+
+} // namespace MeshGui
+
+/**
+ * Starts building the hierarchy of simplified meshes in a worker thread.
+ */
+void SoFCMeshObjectShape::startLevelOfDetail(const Mesh::MeshObject * mesh)
+{
+    stopLevelOfDetail();
+    lodMesh = mesh;
+    lod = new MeshLevelOfDetailJob(mesh);
+    lod->start();
+}
+
+void SoFCMeshObjectShape::stopLevelOfDetail()
+{
+    if (lod) {
+        lod->abandon();
+        lod = 0;
+    }
+}
+
+/**
+ * Returns the coarsest level whose error is invisible or, while interacting, doesn't exceed
+ * \a screenErrorLimit pixels. If the full mesh must be rendered or the hierarchy isn't ready
+ * yet -1 is returned.
+ */
+int SoFCMeshObjectShape::findLevelOfDetail(SoState * state, const Mesh::MeshObject * mesh, SbBool interactive)
+{
+    if (meshChanged || mesh != lodMesh) {
+        meshChanged = false;
+        startLevelOfDetail(mesh);
+        return -1;
+    }
+
+    if (!lod || !lod->isFinished())
+        return -1;
+
+    // the error is most visible at the point of the mesh nearest to the viewer
+    const SbViewVolume& vv = SoViewVolumeElement::get(state);
+    const SbViewportRegion& vp = SoViewportRegionElement::get(state);
+    const SbMatrix& mm = SoModelMatrixElement::get(state);
+    Base::BoundBox3f bbox = mesh->getKernel().GetBoundBox();
+    SbBox3f box(bbox.MinX, bbox.MinY, bbox.MinZ, bbox.MaxX, bbox.MaxY, bbox.MaxZ);
+    box.transform(mm);
+    SbVec3f eye = vv.getProjectionPoint();
+    SbVec3f pnt;
+    for (int i=0; i<3; i++)
+        pnt[i] = std::max<float>(box.getMin()[i], std::min<float>(eye[i], box.getMax()[i]));
+
+    // the size of a pixel there in model coordinates
+    SbVec3f t, s;
+    SbRotation r, so;
+    mm.getTransform(t, r, s, so);
+    float scale = std::max<float>(std::max<float>(s[0], s[1]), s[2]);
+    float pixel = vv.getWorldToScreenScale(pnt, 1.0f) / vp.getViewportSizePixels()[1];
+    if (!(pixel > 0.0f) || !(scale > 0.0f))
+        return -1;
+
+    float limit = interactive ? this->screenErrorLimit : 0.5f;
+    return lod->getLevels().FindLevel(limit * pixel / scale);
+}
+
+/**
+ * Renders the triangles of a simplified mesh.
+ */
+void SoFCMeshObjectShape::drawLevelOfDetail(int level, SbBool needNormals, SbBool ccw) const
+{
+    const MeshCore::MeshLevelOfDetail::Level& rLevel = lod->getLevels().GetLevel(level);
+    const std::vector<Base::Vector3f>& rPoints = rLevel.aclPoints;
+    const std::vector<unsigned long>& rIndices = rLevel.aulIndices;
+
+    glBegin(GL_TRIANGLES);
+    for (std::vector<unsigned long>::const_iterator it = rIndices.begin(); it != rIndices.end(); it += 3)
+    {
+        const Base::Vector3f& v0 = rPoints[it[0]];
+        const Base::Vector3f& v1 = rPoints[it[1]];
+        const Base::Vector3f& v2 = rPoints[it[2]];
+
+        if (needNormals) {
+            // Calculate the normal n = (v1-v0)x(v2-v0) and flip it for clockwise ordering
+            float n[3];
+            n[0] = (v1.y-v0.y)*(v2.z-v0.z)-(v1.z-v0.z)*(v2.y-v0.y);
+            n[1] = (v1.z-v0.z)*(v2.x-v0.x)-(v1.x-v0.x)*(v2.z-v0.z);
+            n[2] = (v1.x-v0.x)*(v2.y-v0.y)-(v1.y-v0.y)*(v2.x-v0.x);
+            if (!ccw) {
+                n[0] = -n[0]; n[1] = -n[1]; n[2] = -n[2];
+            }
+            glNormal3fv(n);
+        }
+
+        glVertex3f(v0.x, v0.y, v0.z);
+        glVertex3f(v1.x, v1.y, v1.z);
+        glVertex3f(v2.x, v2.y, v2.z);
+    }
+    glEnd();
+}
+
 void SoFCMeshObjectShape::doAction(SoAction * action)
 {
     if (action->getTypeId() == Gui::SoGLSelectAction::getClassTypeId()) {
@@ -31,6 +31,7 @@
 #include <Inventor/nodes/SoSubNode.h>
 #include <Inventor/nodes/SoShape.h>
 #include <Inventor/elements/SoReplacedElement.h>
+#include <Gui/SoFCVertexCache.h>
 #include <Mod/Mesh/App/Core/Elements.h>
 #include <Mod/Mesh/App/Mesh.h>
 
@@ -38,10 +39,12 @@ typedef unsigned int GLuint;
 typedef int GLint;
 typedef float GLfloat;
 
-namespace MeshCore { class MeshFacetGrid; }
+namespace MeshCore { class MeshFacetGrid; class MeshLevelOfDetail; }
 
 namespace MeshGui {
 
+class MeshLevelOfDetailJob;
+
 class MeshGuiExport SoSFMeshObject : public SoSField {
     typedef SoSField inherited;
 
@@ -152,6 +155,15 @@ protected:
  * The limit of maximum allowed triangles can be specified in \a renderTriangleLimit, the
  * default value is set to 100.000.
  *
+ * For meshes exceeding this limit a hierarchy of simplified meshes is built in a worker
+ * thread. Once it is available GLRender() renders for each frame the coarsest level whose
+ * error projected onto the screen doesn't exceed \a screenErrorLimit pixels while interacting,
+ * or half a pixel otherwise. Until then or if colors are bound per face or vertex the method
+ * falls back to the behaviour described above.
+ *
+ * If the complete mesh is rendered with an overall color its triangles are uploaded once into
+ * a vertex buffer object and redrawn from there until the mesh changes.
+ *
  * The GLRender() method checks the status of the SoFCInteractiveElement to decide to be in
  * interactive mode or not.
  * To take advantage of this facility the client programmer must set the status of the
@@ -170,6 +182,7 @@ public:
     SoFCMeshObjectShape();
 
     unsigned int renderTriangleLimit;
+    float screenErrorLimit;
 
 protected:
     virtual void doAction(SoAction * action);
@@ -194,13 +207,19 @@ private:
 
 private:
     // Force using the reference count mechanism.
-    virtual ~SoFCMeshObjectShape() {};
+    virtual ~SoFCMeshObjectShape();
     virtual void notify(SoNotList * list);
     Binding findMaterialBinding(SoState * const state) const;
     // Draw faces
     void drawFaces(const Mesh::MeshObject *, SoMaterialBundle* mb, Binding bind, 
                    SbBool needNormals, SbBool ccw) const;
     void drawPoints(const Mesh::MeshObject *, SbBool needNormals, SbBool ccw) const;
+    bool drawVertexCache(SoState * state, const Mesh::MeshObject *, SbBool needNormals);
+    // Level of detail
+    void startLevelOfDetail(const Mesh::MeshObject *);
+    void stopLevelOfDetail();
+    int findLevelOfDetail(SoState * state, const Mesh::MeshObject *, SbBool interactive);
+    void drawLevelOfDetail(int level, SbBool needNormals, SbBool ccw) const;
     unsigned int countTriangles(SoAction * action) const;
 
     void startSelection(SoAction * action, const Mesh::MeshObject*);
@@ -212,6 +231,9 @@ private:
     GLuint *selectBuf;
     GLfloat modelview[16];
     GLfloat projection[16];
+    const Mesh::MeshObject* lodMesh;
+    MeshLevelOfDetailJob* lod;
+    Gui::SoFCVertexCache vertexCache;
 };
 
 class MeshGuiExport SoFCMeshSegmentShape : public SoShape {
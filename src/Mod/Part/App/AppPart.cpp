@@ -105,6 +105,12 @@ void PartExport initPart()
     OSD::SetSignal(Standard_False);
 //#endif
 
+    // the primitives can only be executed by the parallel recompute if OpenCascade
+    // is set up for it before any worker thread is started
+    if (App::GetApplication().GetParameterGroupByPath
+        ("User parameter:BaseApp/Preferences/Document")->GetBool("ParallelRecompute",false))
+        Part::Primitive::initThreads();
+
     PyObject* partModule = Py_InitModule3("Part", Part_methods, module_part_doc);   /* mod name, table ptr */
     Base::Console().Log("Loading Part module... done\n");
 
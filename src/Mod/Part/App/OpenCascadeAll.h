@@ -25,6 +25,7 @@
 #define __OpenCascadeAll__
 
 // OpenCASCADE
+#include <Standard.hxx>
 #include <Standard_AbortiveTransaction.hxx>
 #include <Standard_Address.hxx>
 #include <Standard_AncestorIterator.hxx>
@@ -54,6 +54,7 @@
 # include <Handle_Geom2d_Line.hxx>
 # include <Handle_Geom2d_TrimmedCurve.hxx>
 # include <Precision.hxx>
+# include <Standard.hxx>
 # include <Standard_Real.hxx>
 # include <TopoDS.hxx>
 # include <TopoDS_Solid.hxx>
@@ -97,6 +98,21 @@ short Primitive::mustExecute(void) const
     return Feature::mustExecute();
 }
 
+bool Primitive::threadSafe = false;
+
+bool Primitive::isThreadSafe(void) const
+{
+    return threadSafe;
+}
+
+void Primitive::initThreads(void)
+{
+    // the memory manager and the reference counting of OpenCascade must be
+    // made thread-safe before any other thread uses it
+    Standard::SetReentrant(Standard_True);
+    threadSafe = true;
+}
+
 void Primitive::onChanged(const App::Property* prop)
 {
     if (!isRestoring()) {
@@ -43,10 +43,20 @@ public:
     /// recalculate the feature
     App::DocumentObjectExecReturn *execute(void) = 0;
     short mustExecute() const;
+    /// the primitives only depend on their own properties
+    bool isThreadSafe(void) const;
     //@}
 
+    /** Sets up OpenCascade to be used by several threads. Until this is called
+     * the primitives are not executed in worker threads.
+     */
+    static void initThreads(void);
+
 protected:
     void onChanged (const App::Property* prop);
+
+private:
+    static bool threadSafe;
 };
 
 class PartExport Vertex : public Part::Primitive
@@ -49,11 +49,13 @@
 # include <Inventor/elements/SoGLCoordinateElement.h>
 # include <Inventor/elements/SoGLCacheContextElement.h>
 # include <Inventor/elements/SoLineWidthElement.h>
+# include <Inventor/elements/SoNormalElement.h>
 # include <Inventor/elements/SoPointSizeElement.h>
 # include <Inventor/errors/SoReadError.h>
 # include <Inventor/details/SoFaceDetail.h>
 # include <Inventor/details/SoLineDetail.h>
 # include <Inventor/misc/SoState.h>
+# include <Inventor/misc/SoNotification.h>
 #endif
 
 #include "SoBrepShape.h"
@@ -147,6 +149,15 @@ void SoBrepFaceSet::doAction(SoAction* action)
     inherited::doAction(action);
 }
 
+void SoBrepFaceSet::notify(SoNotList * list)
+{
+    // highlighting and selecting parts doesn't change the geometry
+    SoField * field = list->getLastField();
+    if (field != &this->highlightIndex && field != &this->selectionIndex)
+        vertexCache.invalidate();
+    inherited::notify(list);
+}
+
 void SoBrepFaceSet::GLRender(SoGLRenderAction *action)
 {
     if (this->coordIndex.getNum() < 3)
@@ -195,8 +206,11 @@ void SoBrepFaceSet::GLRender(SoGLRenderAction *action)
     if (!nindices) nindices = cindices;
     pindices = this->partIndex.getValues(0);
     numparts = this->partIndex.getNum();
-    renderShape(static_cast<const SoGLCoordinateElement*>(coords), cindices, numindices,
-        pindices, numparts, normals, nindices, &mb, mindices, &tb, tindices, nbind, mbind, doTextures?1:0);
+    if (mbind != OVERALL || nbind != PER_VERTEX_INDEXED || doTextures || !normals ||
+        !renderVertexCache(state, coords, cindices, numindices, normals, nindices, sendNormals)) {
+        renderShape(static_cast<const SoGLCoordinateElement*>(coords), cindices, numindices,
+            pindices, numparts, normals, nindices, &mb, mindices, &tb, tindices, nbind, mbind, doTextures?1:0);
+    }
     // Disable caching for this node
     SoGLCacheContextElement::shouldAutoCache(state, SoGLCacheContextElement::DONT_AUTO_CACHE);
 
@@ -799,6 +813,30 @@ void SoBrepFaceSet::renderShape(const SoGLCoordinateElement * const vertexlist,
     glEnd();
 }
 
+/**
+ * Renders the triangles from a vertex buffer object which is filled if the geometry has changed
+ * since the last upload. Returns false if vertex buffer objects cannot be used.
+ */
+bool SoBrepFaceSet::renderVertexCache(SoState * state,
+                                      const SoCoordinateElement * coords,
+                                      const int32_t *vertexindices,
+                                      int num_vertexindices,
+                                      const SbVec3f *normals,
+                                      const int32_t *normindices,
+                                      SbBool sendNormals)
+{
+    vertexCache.setGeometryIds(coords->getNodeId(), SoNormalElement::getInstance(state)->getNodeId());
+    if (vertexCache.needsUpload(state)) {
+        std::vector<float> data;
+        Gui::SoFCVertexCache::fillTriangles(static_cast<const SoGLCoordinateElement*>(coords)->getArrayPtr3(),
+                                            coords->getNum(), vertexindices, num_vertexindices,
+                                            normals, normindices, data);
+        vertexCache.upload(state, data);
+    }
+
+    return vertexCache.render(state, sendNormals);
+}
+
 SoDetail * SoBrepFaceSet::createTriangleDetail(SoRayPickAction * action,
                                                const SoPrimitiveVertex * v1,
                                                const SoPrimitiveVertex * v2,
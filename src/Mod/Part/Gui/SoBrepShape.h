@@ -32,8 +32,10 @@
 #include <Inventor/nodes/SoPointSet.h>
 #include <Inventor/elements/SoLazyElement.h>
 #include <Inventor/elements/SoReplacedElement.h>
+#include <Gui/SoFCVertexCache.h>
 #include <vector>
 
+class SoCoordinateElement;
 class SoGLCoordinateElement;
 class SoTextureCoordinateBundle;
 
@@ -70,6 +72,11 @@ namespace PartGui {
  * Actually you can access the highlightIndex directly or you can apply a SoHighlightElementAction on it. And don't forget: if you
  * do some mouse picking and you got a SoFaceDetail then use getPartIndex() to get the correct part.
  *
+ * Rendering:
+ * If the shape has an overall color and no textures the triangles are uploaded into a vertex buffer object and
+ * redrawn from there until the coordinates, normals or indices change. Highlighting or selecting a part doesn't
+ * require a new upload because these parts are rendered separately.
+ *
  * As an example how to use the class correctly see ViewProviderPartExt::updateVisual().
  */
 class PartGuiExport SoBrepFaceSet : public SoIndexedFaceSet {
@@ -87,6 +94,7 @@ public:
 
 protected:
     virtual ~SoBrepFaceSet() {};
+    virtual void notify(SoNotList * list);
     virtual void GLRender(SoGLRenderAction *action);
     virtual void GLRenderBelowPath(SoGLRenderAction * action);
     virtual void doAction(SoAction* action); 
@@ -125,6 +133,13 @@ private:
                      const int nbind,
                      const int mbind,
                      const int texture);
+    bool renderVertexCache(SoState * state,
+                           const SoCoordinateElement * coords,
+                           const int32_t *vertexindices,
+                           int num_vertexindices,
+                           const SbVec3f *normals,
+                           const int32_t *normindices,
+                           SbBool sendNormals);
     void renderHighlight(SoGLRenderAction *action);
     void renderSelection(SoGLRenderAction *action);
 
@@ -132,6 +147,7 @@ private:
     SbColor selectionColor;
     SbColor highlightColor;
     SoColorPacker colorpacker;
+    Gui::SoFCVertexCache vertexCache;
 };
 
 // ---------------------------------------------------------------------
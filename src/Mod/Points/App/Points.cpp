@@ -117,6 +117,11 @@ void PointKernel::SaveDocFile (Base::Writer &writer) const
     }
 }
 
+bool PointKernel::isSaveDocFileThreadSafe (void) const
+{
+    return true;
+}
+
 void PointKernel::Restore(Base::XMLReader &reader)
 {
     clear();
@@ -157,6 +157,11 @@ void PropertyGreyValueList::SaveDocFile (Base::Writer &writer) const
     }
 }
 
+bool PropertyGreyValueList::isSaveDocFileThreadSafe (void) const
+{
+    return true;
+}
+
 void PropertyGreyValueList::RestoreDocFile(Base::Reader &reader)
 {
     Base::InputStream str(reader);
@@ -333,6 +338,11 @@ void PropertyNormalList::SaveDocFile (Base::Writer &writer) const
     }
 }
 
+bool PropertyNormalList::isSaveDocFileThreadSafe (void) const
+{
+    return true;
+}
+
 void PropertyNormalList::RestoreDocFile(Base::Reader &reader)
 {
     Base::InputStream str(reader);
@@ -578,6 +588,11 @@ void PropertyCurvatureList::SaveDocFile (Base::Writer &writer) const
     }
 }
 
+bool PropertyCurvatureList::isSaveDocFileThreadSafe (void) const
+{
+    return true;
+}
+
 void PropertyCurvatureList::RestoreDocFile(Base::Reader &reader)
 {
     Base::InputStream str(reader);
@@ -22,7 +22,7 @@
 #*   Juergen Riegel 2003                                                   *
 #***************************************************************************/
 
-import FreeCAD, os, unittest, tempfile
+import FreeCAD, os, unittest, tempfile, time
 
 
 #---------------------------------------------------------------------------
@@ -202,6 +202,29 @@ class DocumentSaveRestoreCases(unittest.TestCase):
     self.failUnless(self.Doc.Label_1.TypeTransient == 4711)
     self.failUnless(self.Doc == FreeCAD.getDocument(self.Doc.Name))
 
+  def testSaveAndRestoreData(self):
+    # the files of the data properties are written by several threads
+    import Mesh, Points
+    SaveName = self.TempPath + os.sep + "SaveRestoreTests.FCStd"
+    self.Doc.addObject("Mesh::Feature","Mesh").Mesh = Mesh.createSphere(5.0, 100)
+    self.Doc.addObject("Points::Feature","Points").Points = Points.Points([(i, 0.5*i, -0.25*i) for i in range(10000)])
+    # images are stored uncompressed
+    file = open(self.Doc.getTempFileName("image"),"wb")
+    file.write(os.urandom(100000))
+    file.close()
+    self.Doc.addObject("App::DocumentObjectFileIncluded","Image").File = (file.name,"Image.png")
+    mesh = self.Doc.Mesh.Mesh.Topology
+    points = [(v.x, v.y, v.z) for v in self.Doc.Points.Points.Points]
+    image = open(self.Doc.Image.File,"rb").read()
+    self.Doc.saveAs(SaveName)
+    FreeCAD.closeDocument("SaveRestoreTests")
+    self.Doc = FreeCAD.open(SaveName)
+    topo = self.Doc.Mesh.Mesh.Topology
+    self.failUnless([(v.x, v.y, v.z) for v in topo[0]] == [(v.x, v.y, v.z) for v in mesh[0]])
+    self.failUnless(topo[1] == mesh[1])
+    self.failUnless([(v.x, v.y, v.z) for v in self.Doc.Points.Points.Points] == points)
+    self.failUnless(open(self.Doc.Image.File,"rb").read() == image)
+
   def testRestore(self):
     Doc = FreeCAD.newDocument("RestoreTests")
     Doc.addObject("App::FeatureTest","Label_1")
@@ -244,6 +267,99 @@ class DocumentRecomputeCases(unittest.TestCase):
     self.L1.Link = self.L2
     self.L2.Link = self.L3
 
+  def testInList(self):
+    # the links are recorded when they are changed
+    self.L1.Link = self.L3
+    self.L2.LinkList = [self.L3, self.L1]
+    self.failUnless(len(self.L3.InList) == 2)
+    self.failUnless(self.L1.InList == [self.L2])
+    self.L1.Link = None
+    self.failUnless(self.L3.InList == [self.L2])
+
+    # removing and restoring an object
+    self.Doc.UndoMode = 1
+    self.Doc.openTransaction("Remove")
+    self.Doc.removeObject(self.L2.Name)
+    self.Doc.commitTransaction()
+    self.failUnless(len(self.L3.InList) == 0)
+    self.failUnless(len(self.L1.InList) == 0)
+    self.Doc.undo()
+    L2 = self.Doc.getObject("Label_2")
+    self.failUnless(self.L3.InList == [L2])
+    self.failUnless(self.L1.InList == [L2])
+
+  def testRecomputeStatistics(self):
+    # only the touched object and the objects depending on it are visited
+    self.L1.Link = self.L2
+    self.Doc.recompute()
+    self.L2.touch()
+    self.Doc.recompute()
+    stats = self.Doc.RecomputeStatistics
+    self.failUnless(stats["Touched"] == 1)
+    self.failUnless(stats["Visited"] == 2)
+    self.failUnless(stats["Executed"] == 2)
+    self.failUnless([name for name, time in stats["Objects"]] == [self.L2.Name, self.L1.Name])
+    self.failUnless(self.L3.ExecCount == 1)
+
+  def testRecomputeProfiler(self):
+    # the first recompute executes the unrelated objects in any order
+    self.Doc.recompute()
+    FreeCAD.clearRecomputeProfile()
+    FreeCAD.setRecomputeProfiler(True, 2)
+    try:
+      # the chain is executed in the order Label_2, Label_1, Label_3
+      self.L1.Link = self.L2
+      self.L1.ExecTime = 20
+      self.L2.touch()
+      self.L3.Link = self.L1
+      self.Doc.recompute()
+      # only the last two objects are kept
+      profile = FreeCAD.getRecomputeProfile()
+      self.failUnless([p["Object"] for p in profile] == [self.L1.Name, self.L3.Name])
+      self.failUnless(profile[0]["Document"] == self.Doc.Name)
+      self.failUnless(profile[0]["Status"] == "Succeeded")
+      self.failUnless(profile[0]["Wall"] >= 0.015)
+      FreeCAD.setRecomputeProfiler(True, 10)
+      self.L2.ExceptionType = 2
+      self.Doc.recompute()
+      status = dict([(p["Object"], p["Status"]) for p in FreeCAD.getRecomputeProfile()])
+      self.failUnless(status[self.L2.Name] == "Exception")
+      self.failUnless(FreeCAD.exportRecomputeProfile().startswith('{"traceEvents":['))
+    finally:
+      FreeCAD.setRecomputeProfiler(False, 1000)
+      FreeCAD.clearRecomputeProfile()
+
+  def testParallelRecompute(self):
+    # independent chains with a Python feature which must run in the main thread
+    ends = []
+    for i in range(4):
+      prev = None
+      for j in range(3):
+        obj = self.Doc.addObject("App::FeatureTest","Chain")
+        obj.Source1 = prev
+        prev = obj
+      py = self.Doc.addObject("App::FeaturePython","Python")
+      py.addProperty("App::PropertyLink","Source")
+      py.Source = prev
+      ends.append(py)
+    join = self.Doc.addObject("App::FeatureTest","Join")
+    join.SourceN = ends
+    self.Doc.recompute()
+    tests = [obj for obj in self.Doc.Objects if obj.isDerivedFrom("App::FeatureTest")]
+    counts = [obj.ExecCount for obj in tests]
+
+    param = FreeCAD.ParamGet("User parameter:BaseApp/Preferences/Document")
+    oldParallel = param.GetBool("ParallelRecompute",False)
+    param.SetBool("ParallelRecompute",True)
+    try:
+      for obj in self.Doc.Objects:
+        obj.touch()
+      self.Doc.recompute()
+    finally:
+      param.SetBool("ParallelRecompute",oldParallel)
+    for obj, count in zip(tests, counts):
+      self.failUnless(obj.ExecCount == count + 1, "Object '%s' executed %d times" % (obj.Name, obj.ExecCount - count))
+      self.failUnless(obj.ExecResult == "Exec")
 
   def tearDown(self):
     #closing doc
@@ -759,3 +875,75 @@ class DocumentPropertyCases(unittest.TestCase):
   def tearDown(self):
     #closing doc
     FreeCAD.closeDocument("PropertyTests")
+
+
+def recomputeBenchmark(chains=16, length=4, exectime=50):
+  """Measures the wall-clock time of the serial and the parallel recompute of a
+  document with independent chains of objects for an increasing number of threads"""
+  import multiprocessing
+  doc = FreeCAD.newDocument("RecomputeBenchmark")
+  for i in range(chains):
+    prev = None
+    for j in range(length):
+      obj = doc.addObject("App::FeatureTest","Chain")
+      obj.ExecTime = exectime
+      obj.Source1 = prev
+      prev = obj
+
+  param = FreeCAD.ParamGet("User parameter:BaseApp/Preferences/Document")
+  oldParallel = param.GetBool("ParallelRecompute", False)
+  oldThreads = param.GetInt("RecomputeThreads", 0)
+  threads = [0]
+  while threads[-1] < multiprocessing.cpu_count():
+    threads.append(max(1, 2 * threads[-1]))
+  try:
+    for num in threads:
+      param.SetBool("ParallelRecompute", num > 0)
+      param.SetInt("RecomputeThreads", num)
+      for obj in doc.Objects:
+        obj.touch()
+      start = time.time()
+      doc.recompute()
+      elapsed = time.time() - start
+      if num == 0:
+        serial = elapsed
+        FreeCAD.Console.PrintMessage("serial:     %.3f s\n" % elapsed)
+      else:
+        FreeCAD.Console.PrintMessage("%2d threads: %.3f s (speedup %.2f)\n" % (num, elapsed, serial / elapsed))
+  finally:
+    param.SetBool("ParallelRecompute", oldParallel)
+    param.SetInt("RecomputeThreads", oldThreads)
+    FreeCAD.closeDocument("RecomputeBenchmark")
+
+def saveBenchmark(meshes=8, samples=200, level=3):
+  """Measures the wall-clock time of saving a document with large meshes
+  serially and with an increasing number of threads"""
+  import multiprocessing, Mesh
+  doc = FreeCAD.newDocument("SaveBenchmark")
+  for i in range(meshes):
+    doc.addObject("Mesh::Feature","Mesh").Mesh = Mesh.createSphere(10.0 + i, samples)
+  name = tempfile.gettempdir() + os.sep + "SaveBenchmark.FCStd"
+
+  param = FreeCAD.ParamGet("User parameter:BaseApp/Preferences/Document")
+  oldLevel = param.GetInt("CompressionLevel", 3)
+  oldThreads = param.GetInt("SaveThreads", 0)
+  threads = [1]
+  while threads[-1] < multiprocessing.cpu_count():
+    threads.append(2 * threads[-1])
+  try:
+    param.SetInt("CompressionLevel", level)
+    for num in threads:
+      param.SetInt("SaveThreads", num)
+      start = time.time()
+      doc.saveAs(name)
+      elapsed = time.time() - start
+      if num == 1:
+        serial = elapsed
+        FreeCAD.Console.PrintMessage("serial:     %.3f s (%d bytes)\n" % (elapsed, os.path.getsize(name)))
+      else:
+        FreeCAD.Console.PrintMessage("%2d threads: %.3f s (speedup %.2f)\n" % (num, elapsed, serial / elapsed))
+  finally:
+    param.SetInt("CompressionLevel", oldLevel)
+    param.SetInt("SaveThreads", oldThreads)
+    FreeCAD.closeDocument("SaveBenchmark")
+    os.remove(name)
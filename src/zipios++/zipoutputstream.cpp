@@ -55,6 +55,10 @@ void ZipOutputStream::putNextEntry(const std::string& entryName) {
   putNextEntry( ZipCDirEntry(entryName));
 }
 
+void ZipOutputStream::putCompressedEntry( const ZipCDirEntry &entry, const char *data ) {
+  ozf->putCompressedEntry( entry, data ) ;
+}
+
 
 void ZipOutputStream::setComment( const std::string &comment ) {
   ozf->setComment( comment ) ;
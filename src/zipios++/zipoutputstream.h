@@ -54,6 +54,11 @@ public:
   */
   void putNextEntry(const std::string& entryName);
 
+  /** Writes an entry whose data is compressed already.
+      @see ZipOutputStreambuf::putCompressedEntry()
+  */
+  void putCompressedEntry( const ZipCDirEntry &entry, const char *data ) ;
+
   /** Sets the global comment for the Zip archive. */
   void setComment( const std::string& comment ) ;
 
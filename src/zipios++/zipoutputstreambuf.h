@@ -49,6 +49,11 @@ public:
       entry. */
   void putNextEntry( const ZipCDirEntry &entry ) ;
 
+  /** Writes an entry whose data is compressed already, e.g. by another
+      thread. The method, size, compressed size and crc of entry must be
+      set and data must hold the compressed size bytes of the entry. */
+  void putCompressedEntry( const ZipCDirEntry &entry, const char *data ) ;
+
   /** Sets the global comment for the Zip archive. */
   void setComment( const string &comment ) ;
 